@@ -1,11 +1,13 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
 
 namespace VoxelRT
 {
+	// Block ids are 16 bit, 0 is air
 	struct Block
 	{
-		uint8_t block;
+		uint16_t block;
 	};
 }
\ No newline at end of file
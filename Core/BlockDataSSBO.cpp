@@ -6,27 +6,31 @@ namespace VoxelRT
 	{
 		m_SSBO = 0;
 
-		std::array<int, 128> AlbedoData;
-		std::array<int, 128> NormalData;
-		std::array<int, 128> PBRData;
-		std::array<int, 128> EmissiveData;
-		std::array<int, 128> Transparent;
-		std::array<int, 128> SSS;
+		// One table per property, each sized to hold every id in the database (BLOCK_DATA_SIZE in the shaders)
+		const int TableSize = BlockDatabase::GetBlockDataTableSize();
+
+		std::vector<int> AlbedoData(TableSize);
+		std::vector<int> NormalData(TableSize);
+		std::vector<int> PBRData(TableSize);
+		std::vector<int> EmissiveData(TableSize);
+		std::vector<int> Transparent(TableSize);
+		std::vector<int> SSS(TableSize);
 		std::vector<int> TotalData;
 
-		for (int b = 0; b < 128; b++)
+		for (int b = 0; b < TableSize; b++)
 		{
-			uint8_t i = static_cast<uint8_t>(b);
-			AlbedoData[i] = BlockDatabase::GetBlockTexture({ i }, BlockDatabase::BlockFaceType::Front);
-			NormalData[i] = BlockDatabase::GetBlockNormalTexture({ i }, BlockDatabase::BlockFaceType::Front);
-			PBRData[i] = BlockDatabase::GetBlockPBRTexture({ i }, BlockDatabase::BlockFaceType::Front);
-			EmissiveData[i] = BlockDatabase::GetBlockEmissiveTexture({ i });
-			Transparent[i] = BlockDatabase::IsBlockTransparent({ i }) ? 1 : 0;
-			SSS[i] = BlockDatabase::IsBlockSSS({ i }) ? 1 : 0;
+			BlockDatabase::BlockIDType i = static_cast<BlockDatabase::BlockIDType>(b);
+			AlbedoData[b] = BlockDatabase::GetBlockTexture(i, BlockDatabase::BlockFaceType::Front);
+			NormalData[b] = BlockDatabase::GetBlockNormalTexture(i, BlockDatabase::BlockFaceType::Front);
+			PBRData[b] = BlockDatabase::GetBlockPBRTexture(i, BlockDatabase::BlockFaceType::Front);
+			EmissiveData[b] = BlockDatabase::GetBlockEmissiveTexture(i);
+			Transparent[b] = BlockDatabase::IsBlockTransparent(i) ? 1 : 0;
+			SSS[b] = BlockDatabase::IsBlockSSS(i) ? 1 : 0;
 		}
 		
-		int TotalSize = (128 * sizeof(int)) * 6;
+		int TotalSize = (TableSize * sizeof(int)) * 6;
 
+		TotalData.reserve((size_t)TableSize * 6);
 		TotalData.insert(TotalData.end(), std::begin(AlbedoData), std::end(AlbedoData));
 		TotalData.insert(TotalData.end(), std::begin(NormalData), std::end(NormalData));
 		TotalData.insert(TotalData.end(), std::begin(PBRData), std::end(PBRData));
@@ -3,8 +3,8 @@
 namespace VoxelRT
 {
 	extern std::unordered_map<std::string, BlockDatabaseParser::ParsedBlockData> ParsedBlockDataList;
-	std::unordered_map<uint8_t, BlockDatabaseParser::ParsedBlockData> ParsedBlockDataListID;
-	std::unordered_map<uint8_t, uint8_t> MinecraftIDLUT;
+	std::unordered_map<BlockDatabase::BlockIDType, BlockDatabaseParser::ParsedBlockData> ParsedBlockDataListID;
+	std::unordered_map<uint16_t, BlockDatabase::BlockIDType> MinecraftIDLUT;
 	GLClasses::TextureArray BlockTextureArray;
 	GLClasses::TextureArray BlockNormalTextureArray;
 	GLClasses::TextureArray BlockPBRTextureArray;
@@ -18,7 +18,7 @@ namespace VoxelRT
 
 		for (auto& e : ParsedBlockDataList)
 		{
-			uint8_t id = e.second.ID;
+			BlockIDType id = e.second.ID;
 			const BlockDatabaseParser::ParsedBlockData& data = e.second;
 
 			ParsedBlockDataListID[id] = data;
@@ -94,16 +94,16 @@ namespace VoxelRT
 
 		auto& MCIDMap = BlockDatabaseParser::GetParsedMCIDs();
 		for (auto& e : MCIDMap) {
-			int BaseBlockID = static_cast<uint8_t>(BlockDatabase::GetBlockID(e.first.c_str()));
+			int BaseBlockID = BlockDatabase::GetBlockID(e.first.c_str());
 			
 			for (auto& ve : e.second) {
-				int IDAt = static_cast<uint8_t>(ve);
+				int IDAt = static_cast<uint16_t>(ve);
 				MinecraftIDLUT[IDAt] = BaseBlockID;
 			}
 		}
 	}
 
-	uint8_t BlockDatabase::GetBlockID(const std::string& block_name)
+	BlockDatabase::BlockIDType BlockDatabase::GetBlockID(const std::string& block_name)
 	{
 		return ParsedBlockDataList[block_name].ID;
 	}
@@ -557,6 +557,16 @@ namespace VoxelRT
 		return ParsedBlockDataList.size();
 	}
 
+	int BlockDatabase::GetBlockDataTableSize()
+	{
+		return ((GetNumberOfBlocksInDatabase() + 1 + 127) / 128) * 128;
+	}
+
+	bool BlockDatabase::UsesWideBlockIDs()
+	{
+		return GetNumberOfBlocksInDatabase() > 0xFF;
+	}
+
 	GLuint BlockDatabase::GetTextureArray()
 	{
 		return BlockTextureArray.GetTextureArray();
@@ -596,7 +606,7 @@ namespace VoxelRT
 		return false;
 	}
 
-	uint8_t BlockDatabase::GetIDFromMCID(uint8_t MCID)
+	BlockDatabase::BlockIDType BlockDatabase::GetIDFromMCID(uint16_t MCID)
 	{
 		if (MCID == 0) {
 			return 0;
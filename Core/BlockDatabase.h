@@ -14,7 +14,7 @@ namespace VoxelRT
 {
 	namespace BlockDatabase
 	{
-		typedef uint8_t BlockIDType;
+		typedef uint16_t BlockIDType;
 
 		enum BlockFaceType
 		{
@@ -27,7 +27,7 @@ namespace VoxelRT
 		};
 
 		void Initialize();
-		uint8_t GetBlockID(const std::string& block_name);
+		BlockIDType GetBlockID(const std::string& block_name);
 		int GetBlockTexture(const std::string& block_name, const BlockFaceType type);
 		int GetBlockTexture(BlockIDType block_id, const BlockFaceType type);
 		int GetBlockNormalTexture(const std::string& block_name, const BlockFaceType type);
@@ -46,6 +46,12 @@ namespace VoxelRT
 
 		int GetNumberOfBlocksInDatabase();
 
+		// Entries in the per block gpu tables (BlockDataSSBO, BLOCK_DATA_SIZE in the shaders), ids 0 to N rounded up to 128
+		int GetBlockDataTableSize();
+
+		// The gpu copies of the voxel data stay 8 bit while every id fits in a byte (BLOCK_ID_SCALE in the shaders)
+		bool UsesWideBlockIDs();
+
 		GLuint GetTextureArray();
 		GLuint GetNormalTextureArray();
 		GLuint GetPBRTextureArray();
@@ -53,7 +59,7 @@ namespace VoxelRT
 
 		bool HasEmissiveTexture(BlockIDType block_id);
 
-		uint8_t GetIDFromMCID(uint8_t MCID);
+		BlockIDType GetIDFromMCID(uint16_t MCID);
 
 	}
 }
\ No newline at end of file
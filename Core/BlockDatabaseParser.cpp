@@ -28,12 +28,12 @@ namespace VoxelRT
 
 
 
-	uint8_t GenerateBlockID()
+	uint16_t GenerateBlockID()
 	{
-		static uint8_t v = 0;
+		static int v = 0;
 		v++;
 
-		if (v >= 128)
+		if (v > 0xFFFF)
 		{
 			throw "Too many blocks in the block database! Unable to generate more blocks!";
 		}
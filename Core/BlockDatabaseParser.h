@@ -32,7 +32,7 @@ namespace VoxelRT
 			BlockTexture AlbedoMap;
 			std::string EmissiveMap = "";
 			std::string BlockName = "";
-			uint8_t ID = 0;
+			uint16_t ID = 0;
 			bool transparent = false;
 			bool sss = false;
 			std::string snd_step = "";
@@ -0,0 +1,254 @@
+#include "BrickPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+uint32_t VoxelRT::BrickPool::ClassifyBrick(const WorldData& data, const glm::ivec3& brick, uint8_t* voxels) const
+{
+	const glm::ivec3 Origin = brick * BRICK_SIZE;
+	const OccupancyMask& Occupancy = data.GetOccupancy();
+
+	// Most bricks are air, the occupancy mask answers that without touching the voxels (8 cells of 4^3)
+	bool Empty = true;
+
+	for (int z = 0; z < BRICK_SIZE && Empty; z += 4)
+	{
+		for (int y = 0; y < BRICK_SIZE && Empty; y += 4)
+		{
+			for (int x = 0; x < BRICK_SIZE && Empty; x += 4)
+			{
+				Empty = Occupancy.IsCellEmpty(Origin.x + x, Origin.y + y, Origin.z + z);
+			}
+		}
+	}
+
+	if (Empty)
+	{
+		return 0;
+	}
+
+	const int Stride = GetBytesPerVoxel();
+
+	if (m_WideIDs)
+	{
+		data.ReadRegion(Origin, glm::ivec3(BRICK_SIZE), reinterpret_cast<uint16_t*>(voxels));
+	}
+
+	else
+	{
+		data.ReadRegion(Origin, glm::ivec3(BRICK_SIZE), voxels);
+	}
+
+	// Every voxel matches the first one if the brick equals itself shifted by one voxel
+	if (std::memcmp(voxels, voxels + Stride, (size_t)(BRICK_VOLUME - 1) * Stride) == 0)
+	{
+		return BRICK_UNIFORM | (m_WideIDs ? reinterpret_cast<const uint16_t*>(voxels)[0] : voxels[0]);
+	}
+
+	return BRICK_STORED;
+}
+
+void VoxelRT::BrickPool::Build(const WorldData& data, bool wide_ids)
+{
+	m_WideIDs = wide_ids;
+	m_Bricks = data.GetDimensions() >> BRICK_SHIFT;
+	m_Indirection.assign((size_t)m_Bricks.x * m_Bricks.y * m_Bricks.z, 0);
+	m_UniformBricks = 0;
+	m_StoredBricks = 0;
+
+	// Voxels of the stored bricks in slot order
+	const int Stride = GetBytesPerVoxel();
+	const int BrickBytes = BRICK_VOLUME * Stride;
+	std::vector<uint8_t> Stored;
+
+	for (int z = 0; z < m_Bricks.z; z++)
+	{
+		for (int y = 0; y < m_Bricks.y; y++)
+		{
+			for (int x = 0; x < m_Bricks.x; x++)
+			{
+				alignas(uint16_t) uint8_t Voxels[BRICK_VOLUME * 2];
+				uint32_t Code = ClassifyBrick(data, glm::ivec3(x, y, z), Voxels);
+
+				if (Code == BRICK_STORED)
+				{
+					Code = EncodeSlot((uint32_t)m_StoredBricks);
+					Stored.insert(Stored.end(), Voxels, Voxels + BrickBytes);
+					m_StoredBricks++;
+				}
+
+				else if (Code != 0)
+				{
+					m_UniformBricks++;
+				}
+
+				m_Indirection[GetIndirectionIndex(x, y, z)] = Code;
+			}
+		}
+	}
+
+	// Leave room for edits, the atlas is rebuilt (and grows) if it ever fills up
+	GLint MaxTextureSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &MaxTextureSize);
+
+	const int MaxLayers = std::min(MaxTextureSize / BRICK_SIZE, 1024);
+	const int Capacity = std::min(GetBrickCount(), m_StoredBricks + m_StoredBricks / 4 + ATLAS_LAYER_BRICKS);
+	m_AtlasLayers = std::max((Capacity + ATLAS_LAYER_BRICKS - 1) / ATLAS_LAYER_BRICKS, 1);
+
+	if (m_AtlasLayers > MaxLayers)
+	{
+		throw "Brick pool atlas doesn't fit in a 3D texture!";
+	}
+
+	m_FreeSlots.clear();
+
+	for (int i = GetAtlasCapacity() - 1; i >= m_StoredBricks; i--)
+	{
+		m_FreeSlots.push_back((uint32_t)i);
+	}
+
+	// Textures
+	m_IndirectionTexture.CreateTexture(m_Bricks.x, m_Bricks.y, m_Bricks.z, m_Indirection.data(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+	m_AtlasTexture.CreateTexture(ATLAS_BRICKS_X * BRICK_SIZE, ATLAS_BRICKS_Y * BRICK_SIZE, m_AtlasLayers * BRICK_SIZE, nullptr,
+		m_WideIDs ? GL_R16 : GL_RED, GL_RED, m_WideIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE);
+
+	// Upload one layer of bricks at a time
+	const glm::ivec3 LayerSize = glm::ivec3(ATLAS_BRICKS_X, ATLAS_BRICKS_Y, 1) * BRICK_SIZE;
+	std::vector<uint8_t> Layer((size_t)LayerSize.x * LayerSize.y * LayerSize.z * Stride);
+
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int FirstSlot = 0; FirstSlot < m_StoredBricks; FirstSlot += ATLAS_LAYER_BRICKS)
+	{
+		std::fill(Layer.begin(), Layer.end(), 0);
+
+		for (int Slot = FirstSlot; Slot < std::min(FirstSlot + ATLAS_LAYER_BRICKS, m_StoredBricks); Slot++)
+		{
+			const glm::ivec3 Origin = GetSlotCoord((uint32_t)Slot) * BRICK_SIZE;
+			const uint8_t* Voxels = &Stored[(size_t)Slot * BrickBytes];
+
+			for (int z = 0; z < BRICK_SIZE; z++)
+			{
+				for (int y = 0; y < BRICK_SIZE; y++)
+				{
+					const size_t Row = (size_t)Origin.x + (size_t)(Origin.y + y) * LayerSize.x + (size_t)z * LayerSize.x * LayerSize.y;
+					std::memcpy(&Layer[Row * Stride], Voxels + (y + z * BRICK_SIZE) * BRICK_SIZE * Stride, BRICK_SIZE * Stride);
+				}
+			}
+		}
+
+		const int LayerZ = (FirstSlot / ATLAS_LAYER_BRICKS) * BRICK_SIZE;
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, LayerZ, LayerSize.x, LayerSize.y, LayerSize.z, GL_RED, m_WideIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, Layer.data());
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::BrickPool::Update(const WorldData& data, const std::vector<DirtyBox>& boxes)
+{
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (const DirtyBox& box : boxes)
+	{
+		const glm::ivec3 Min = box.Min >> BRICK_SHIFT;
+		const glm::ivec3 Max = ((box.Max - 1) >> BRICK_SHIFT) + 1;
+
+		for (int z = Min.z; z < Max.z; z++)
+		{
+			for (int y = Min.y; y < Max.y; y++)
+			{
+				for (int x = Min.x; x < Max.x; x++)
+				{
+					uint32_t& Entry = m_Indirection[GetIndirectionIndex(x, y, z)];
+					const uint32_t Old = Entry;
+
+					alignas(uint16_t) uint8_t Voxels[BRICK_VOLUME * 2];
+					uint32_t Code = ClassifyBrick(data, glm::ivec3(x, y, z), Voxels);
+
+					if (Code == BRICK_STORED)
+					{
+						uint32_t Slot;
+
+						if (Old & BRICK_STORED)
+						{
+							Slot = DecodeSlot(Old);
+						}
+
+						else if (m_FreeSlots.empty())
+						{
+							// Out of space, rebuilding classifies (and uploads) every brick so there's nothing left to do
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+							glBindTexture(GL_TEXTURE_3D, 0);
+							Build(data, m_WideIDs);
+							return;
+						}
+
+						else
+						{
+							Slot = m_FreeSlots.back();
+							m_FreeSlots.pop_back();
+							m_StoredBricks++;
+						}
+
+						const glm::ivec3 Origin = GetSlotCoord(Slot) * BRICK_SIZE;
+						glTexSubImage3D(GL_TEXTURE_3D, 0, Origin.x, Origin.y, Origin.z, BRICK_SIZE, BRICK_SIZE, BRICK_SIZE, GL_RED, m_WideIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, Voxels);
+						Code = EncodeSlot(Slot);
+					}
+
+					else if (Old & BRICK_STORED)
+					{
+						m_FreeSlots.push_back(DecodeSlot(Old));
+						m_StoredBricks--;
+					}
+
+					m_UniformBricks += ((Code & BRICK_UNIFORM) != 0) - ((Old & BRICK_UNIFORM) != 0);
+					Entry = Code;
+				}
+			}
+		}
+
+		UploadIndirection(Min, Max);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::BrickPool::UploadIndirection(const glm::ivec3& min, const glm::ivec3& max)
+{
+	const glm::ivec3 Size = max - min;
+	m_UploadBuffer.resize((size_t)Size.x * Size.y * Size.z);
+
+	size_t i = 0;
+
+	for (int z = min.z; z < max.z; z++)
+	{
+		for (int y = min.y; y < max.y; y++)
+		{
+			const uint32_t* Row = &m_Indirection[GetIndirectionIndex(min.x, y, z)];
+			std::copy(Row, Row + Size.x, &m_UploadBuffer[i]);
+			i += Size.x;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_IndirectionTexture.GetTextureID());
+	glTexSubImage3D(GL_TEXTURE_3D, 0, min.x, min.y, min.z, Size.x, Size.y, Size.z, GL_RED_INTEGER, GL_UNSIGNED_INT, m_UploadBuffer.data());
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+}
+
+void VoxelRT::BrickPool::Bind(int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + ATLAS_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, m_IndirectionTexture.GetTextureID());
+}
+
+size_t VoxelRT::BrickPool::GetVideoMemoryUsage() const noexcept
+{
+	return m_Indirection.size() * sizeof(uint32_t) + (size_t)GetAtlasCapacity() * BRICK_VOLUME * GetBytesPerVoxel();
+}
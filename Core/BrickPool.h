@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+#include "DirtyRegion.h"
+#include "Texture3D.h"
+
+namespace VoxelRT
+{
+	// Sparse gpu copy of the voxel data, used instead of the dense volume texture when VOXEL_RT_BRICK_POOL is defined
+	// A coarse indirection volume (one R32UI texel per 8^3 brick) points into an atlas of 8^3 bricks, empty and uniform
+	// bricks are stored in the indirection texel itself and take no space in the atlas.
+	// The atlas is R8, or R16 when the block ids don't fit in a byte (wide ids).
+	//
+	// Indirection texel :
+	// 0                                      -> empty brick
+	// BRICK_UNIFORM | block                  -> every voxel of the brick is block
+	// BRICK_STORED | x | y << 10 | z << 20   -> coordinate of the brick in the atlas (in bricks)
+	//
+	// The shaders decode it in GetVoxel() and use it to cross empty bricks in a single step.
+	// (The pool bricks are 8^3, not the 16^3 bricks of the occupancy mask)
+
+	class BrickPool
+	{
+	public :
+
+		static constexpr int BRICK_SIZE = 8;
+		static constexpr int BRICK_SHIFT = 3;
+		static constexpr int BRICK_VOLUME = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+		static constexpr uint32_t BRICK_UNIFORM = 0x40000000u;
+		static constexpr uint32_t BRICK_STORED = 0x80000000u;
+
+		// The atlas is 32x32 bricks wide and grows in layers of bricks along z
+		static constexpr int ATLAS_BRICKS_X = 32;
+		static constexpr int ATLAS_BRICKS_Y = 32;
+		static constexpr int ATLAS_LAYER_BRICKS = ATLAS_BRICKS_X * ATLAS_BRICKS_Y;
+
+		// u_VoxelBrickAtlas, the indirection is bound wherever the dense volume used to be
+		static constexpr int ATLAS_TEXTURE_UNIT = 27;
+
+		// Classifies every brick and (re)creates both textures
+		void Build(const WorldData& data, bool wide_ids);
+
+		// Reclassifies and reuploads the bricks the boxes touch
+		void Update(const WorldData& data, const std::vector<DirtyBox>& boxes);
+
+		// Binds the indirection to the unit and the atlas to ATLAS_TEXTURE_UNIT
+		void Bind(int unit) const;
+
+		inline int GetBrickCount() const noexcept { return (int)m_Indirection.size(); }
+		inline int GetUniformBrickCount() const noexcept { return m_UniformBricks; }
+		inline int GetStoredBrickCount() const noexcept { return m_StoredBricks; }
+		inline int GetEmptyBrickCount() const noexcept { return GetBrickCount() - m_UniformBricks - m_StoredBricks; }
+		inline int GetAtlasCapacity() const noexcept { return m_AtlasLayers * ATLAS_LAYER_BRICKS; }
+		inline int GetBytesPerVoxel() const noexcept { return m_WideIDs ? 2 : 1; }
+
+		// Indirection + atlas
+		size_t GetVideoMemoryUsage() const noexcept;
+
+		// Atlas slots, also used by the voxel state atlas (VoxelStatePool)
+		static inline glm::ivec3 GetSlotCoord(uint32_t slot) noexcept
+		{
+			return glm::ivec3(slot % ATLAS_BRICKS_X, (slot / ATLAS_BRICKS_X) % ATLAS_BRICKS_Y, slot / ATLAS_LAYER_BRICKS);
+		}
+
+		static inline uint32_t EncodeSlot(uint32_t slot) noexcept
+		{
+			const glm::ivec3 Coord = GetSlotCoord(slot);
+			return BRICK_STORED | (uint32_t)Coord.x | ((uint32_t)Coord.y << 10) | ((uint32_t)Coord.z << 20);
+		}
+
+		static inline uint32_t DecodeSlot(uint32_t code) noexcept
+		{
+			return (code & 0x3FFu) + ((code >> 10) & 0x3FFu) * ATLAS_BRICKS_X + ((code >> 20) & 0x3FFu) * ATLAS_LAYER_BRICKS;
+		}
+
+	private :
+
+		// Returns 0, a uniform code or BRICK_STORED (without a slot), voxels is only written to for stored bricks
+		// voxels holds BRICK_VOLUME voxels in the atlas format (GetBytesPerVoxel())
+		uint32_t ClassifyBrick(const WorldData& data, const glm::ivec3& brick, uint8_t* voxels) const;
+
+		inline size_t GetIndirectionIndex(int x, int y, int z) const noexcept
+		{
+			return (size_t)x + (size_t)y * m_Bricks.x + (size_t)z * m_Bricks.x * m_Bricks.y;
+		}
+
+		void UploadIndirection(const glm::ivec3& min, const glm::ivec3& max);
+
+		glm::ivec3 m_Bricks = glm::ivec3(0);
+		std::vector<uint32_t> m_Indirection;
+		std::vector<uint32_t> m_FreeSlots;
+		std::vector<uint32_t> m_UploadBuffer;
+
+		bool m_WideIDs = false;
+		int m_AtlasLayers = 0;
+		int m_UniformBricks = 0;
+		int m_StoredBricks = 0;
+
+		Texture3D m_IndirectionTexture;
+		Texture3D m_AtlasTexture;
+	};
+}
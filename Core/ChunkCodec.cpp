@@ -0,0 +1,208 @@
+#include "ChunkCodec.h"
+
+#include <algorithm>
+
+static void WriteUint16(std::vector<uint8_t>& output, uint16_t v)
+{
+	output.push_back((uint8_t)(v & 0xFF));
+	output.push_back((uint8_t)(v >> 8));
+}
+
+void VoxelRT::ChunkCodec::Encode(const VoxelChunk& chunk, std::vector<uint8_t>& output)
+{
+	if (chunk.IsUniform())
+	{
+		WriteUint16(output, 1);
+		WriteUint16(output, chunk.GetUniformBlock().block);
+		return;
+	}
+
+	// Only the entries that are used are written, in the order they appear
+	const std::vector<Block>& Palette = chunk.GetPalette();
+	std::vector<int> Remap(Palette.size(), -1);
+	std::vector<uint16_t> Used;
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		const uint32_t Index = chunk.GetPaletteIndex(i);
+
+		if (Remap[Index] < 0)
+		{
+			Remap[Index] = (int)Used.size();
+			Used.push_back(Palette[Index].block);
+		}
+	}
+
+	WriteUint16(output, (uint16_t)Used.size());
+
+	for (uint16_t id : Used)
+	{
+		WriteUint16(output, id);
+	}
+
+	if (Used.size() == 1)
+	{
+		return;
+	}
+
+	const bool WideIndices = Used.size() > 256;
+	int i = 0;
+
+	while (i < CHUNK_VOLUME)
+	{
+		const uint32_t Index = chunk.GetPaletteIndex(i);
+		int Length = 1;
+
+		while (i + Length < CHUNK_VOLUME && chunk.GetPaletteIndex(i + Length) == Index)
+		{
+			Length++;
+		}
+
+		if (WideIndices)
+		{
+			WriteUint16(output, (uint16_t)Remap[Index]);
+		}
+
+		else
+		{
+			output.push_back((uint8_t)Remap[Index]);
+		}
+
+		for (uint32_t v = (uint32_t)Length; ; v >>= 7)
+		{
+			if (v < 0x80)
+			{
+				output.push_back((uint8_t)v);
+				break;
+			}
+
+			output.push_back((uint8_t)(v & 0x7F) | 0x80);
+		}
+
+		i += Length;
+	}
+}
+
+bool VoxelRT::ChunkCodec::Decode(const uint8_t* data, size_t size, const std::vector<uint16_t>& remap, VoxelChunk& chunk)
+{
+	size_t Position = 0;
+
+	auto ReadUint16 = [&](uint16_t& v)
+	{
+		if (Position + 2 > size)
+		{
+			return false;
+		}
+
+		v = (uint16_t)(data[Position] | (data[Position + 1] << 8));
+		Position += 2;
+		return true;
+	};
+
+	uint16_t PaletteSize = 0;
+
+	if (!ReadUint16(PaletteSize) || PaletteSize == 0 || PaletteSize > CHUNK_VOLUME)
+	{
+		return false;
+	}
+
+	std::vector<Block> Palette(PaletteSize);
+
+	for (Block& e : Palette)
+	{
+		if (!ReadUint16(e.block))
+		{
+			return false;
+		}
+
+		if (e.block < remap.size())
+		{
+			e.block = remap[e.block];
+		}
+	}
+
+	if (PaletteSize == 1)
+	{
+		chunk.Fill(Palette[0]);
+		return true;
+	}
+
+	const bool WideIndices = PaletteSize > 256;
+	std::vector<uint16_t> Indices(CHUNK_VOLUME);
+	int i = 0;
+
+	while (i < CHUNK_VOLUME)
+	{
+		uint16_t Index = 0;
+
+		if (WideIndices)
+		{
+			if (!ReadUint16(Index))
+			{
+				return false;
+			}
+		}
+
+		else
+		{
+			if (Position >= size)
+			{
+				return false;
+			}
+
+			Index = data[Position++];
+		}
+
+		uint32_t Length = 0;
+
+		for (int shift = 0; ; shift += 7)
+		{
+			if (Position >= size || shift > 14)
+			{
+				return false;
+			}
+
+			const uint8_t Byte = data[Position++];
+			Length |= (uint32_t)(Byte & 0x7F) << shift;
+
+			if (!(Byte & 0x80))
+			{
+				break;
+			}
+		}
+
+		if (Index >= PaletteSize || Length == 0 || Length > (uint32_t)(CHUNK_VOLUME - i))
+		{
+			return false;
+		}
+
+		std::fill(Indices.begin() + i, Indices.begin() + i + Length, Index);
+		i += (int)Length;
+	}
+
+	// Two ids of the file can map to the same block of the database
+	std::vector<Block> Unique;
+	std::vector<uint16_t> Merge(PaletteSize);
+
+	for (int e = 0; e < PaletteSize; e++)
+	{
+		auto it = std::find_if(Unique.begin(), Unique.end(), [&](const Block& b) { return b.block == Palette[e].block; });
+		Merge[e] = (uint16_t)(it - Unique.begin());
+
+		if (it == Unique.end())
+		{
+			Unique.push_back(Palette[e]);
+		}
+	}
+
+	if (Unique.size() != Palette.size())
+	{
+		for (uint16_t& e : Indices)
+		{
+			e = Merge[e];
+		}
+	}
+
+	chunk.Assign(Unique, Indices.data());
+	return true;
+}
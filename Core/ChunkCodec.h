@@ -0,0 +1,29 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include "WorldData.h"
+
+namespace VoxelRT
+{
+	// Save file encoding of a single chunk (see WorldFileHandler.h), little endian :
+	//  - uint16 palette size N, then N uint16 block ids (only the blocks the chunk has, a uniform chunk ends here)
+	//  - runs of palette indices over the voxels in morton order until every voxel is covered, each run is the index
+	//    (uint8, or uint16 when N > 256) followed by the run length as a LEB128 varint
+	// Morton order keeps every aligned 2^3/4^3/8^3 block contiguous, so layers of terrain and the insides of buildings
+	// are long runs. Most chunks of a world are uniform and take 4 bytes.
+	//
+	// Chunks are independent, the save and load code encode and decode them on several threads.
+
+	namespace ChunkCodec
+	{
+		// Appends the encoded chunk to output
+		void Encode(const VoxelChunk& chunk, std::vector<uint8_t>& output);
+
+		// remap maps the ids of the file to the ids of the block database (ids past its end are kept), it can be empty
+		// Returns false if the data is truncated or invalid, the chunk is left untouched then
+		bool Decode(const uint8_t* data, size_t size, const std::vector<uint16_t>& remap, VoxelChunk& chunk);
+	}
+}
@@ -0,0 +1,698 @@
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "World.h"
+#include "BlockDatabase.h"
+#include "VolumetricFloodFill.h"
+
+static const uint32_t COLUMN_MAGIC = 0x434C4F43; // "COLC"
+static const uint32_t COLUMN_VERSION = 1;
+
+// One structure per this many candidate positions (the 8x8 center of a column), about as dense as GenerateWorld()
+static const uint32_t STRUCTURE_FREQUENCY = 160;
+
+static uint32_t HashColumn(int x, int z, int seed)
+{
+	uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)z * 19349663u ^ (uint32_t)seed * 83492791u;
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	h ^= h >> 15;
+	return h;
+}
+
+static glm::ivec2 GetColumnPosition(uint64_t key)
+{
+	return glm::ivec2((int32_t)(uint32_t)(key >> 32), (int32_t)(uint32_t)(key & 0xFFFFFFFFu));
+}
+
+VoxelRT::ChunkStreamer::~ChunkStreamer()
+{
+	Stop();
+}
+
+void VoxelRT::ChunkStreamer::Start(World* world, const ChunkStreamerSettings& settings, std::vector<glm::ivec3>& lights)
+{
+	Stop();
+
+	m_Settings = settings;
+	m_Stats = ChunkStreamerStats();
+	m_Height = world->GetDimensions().y / CHUNK_SIZE;
+
+	// Same noise as GenerateWorld(), seeded
+	m_HeightNoise.SetSeed(settings.Seed);
+	m_HeightNoise.SetNoiseType(FastNoise::SimplexFractal);
+	m_HeightNoise.SetFrequency(0.00385);
+	m_HeightNoise.SetFractalOctaves(6);
+
+	m_BiomeNoise.SetSeed(settings.Seed + 1);
+	m_BiomeNoise.SetNoiseType(FastNoise::Simplex);
+
+	m_StoneNoise.SetSeed(settings.Seed + 2);
+	m_StoneNoise.SetNoiseType(FastNoise::Simplex);
+	m_StoneNoise.SetFrequency(0.06f);
+	m_StoneNoise.SetFractalOctaves(16);
+
+	m_GrassID = BlockDatabase::GetBlockID("Grass");
+	m_DirtID = BlockDatabase::GetBlockID("Dirt");
+	m_StoneID = BlockDatabase::GetBlockID("Stone");
+	m_SandID = BlockDatabase::GetBlockID("Sand");
+	m_LogID = BlockDatabase::GetBlockID("oak_log");
+	m_LeafID = BlockDatabase::GetBlockID("oak_leaves");
+	m_CactusID = BlockDatabase::GetBlockID("Cactus");
+	m_CobbleID = BlockDatabase::GetBlockID("Cobblestone");
+
+	if (!m_Settings.CacheDirectory.empty())
+	{
+		std::filesystem::create_directories(m_Settings.CacheDirectory);
+	}
+
+	const int ThreadCount = m_Settings.ThreadCount > 0 ? m_Settings.ThreadCount : std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	m_Stop = false;
+
+	for (int i = 0; i < ThreadCount; i++)
+	{
+		m_Workers.emplace_back(&ChunkStreamer::WorkerThread, this);
+	}
+
+	// Fill the window, the prefetch ring is queued along with it
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, 0, Min, Max);
+	Schedule(world, (Min + Max) / 2);
+
+	const size_t WindowColumns = (size_t)(Max.x - Min.x) * (Max.y - Min.y);
+
+	while (m_Applied.size() < WindowColumns)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_ResultCondition.wait(Lock, [this] { return !m_Results.empty(); });
+		}
+
+		CollectResults(world);
+
+		for (auto it = m_Ready.begin(); it != m_Ready.end();)
+		{
+			const glm::ivec2& Position = it->second.Position;
+
+			if (glm::any(glm::lessThan(Position, Min)) || glm::any(glm::greaterThanEqual(Position, Max)))
+			{
+				it++;
+				continue;
+			}
+
+			const DirtyBox Box = ApplyColumn(world, it->second);
+			it = m_Ready.erase(it);
+			world->m_WorldData.GetLights(Box.Min, Box.Max, lights);
+		}
+	}
+
+	std::cout << "\nStreamed world : " << WindowColumns << " columns in the window (" << m_Stats.ColumnsLoaded << " from the cache), "
+		<< m_Workers.size() << " worker threads\n";
+}
+
+void VoxelRT::ChunkStreamer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Stop = true;
+	}
+
+	m_JobCondition.notify_all();
+
+	for (std::thread& Worker : m_Workers)
+	{
+		Worker.join();
+	}
+
+	m_Workers.clear();
+	m_Jobs.clear();
+	m_Results.clear();
+	m_Pending.clear();
+	m_Ready.clear();
+	m_Applied.clear();
+}
+
+glm::ivec3 VoxelRT::ChunkStreamer::Update(World* world, const glm::vec3& player_position)
+{
+	const glm::ivec3& Dimensions = world->GetDimensions();
+	const glm::ivec2 WindowColumns = glm::ivec2(Dimensions.x, Dimensions.z) / CHUNK_SIZE;
+	const glm::ivec2 PlayerColumn = glm::ivec2(glm::floor(glm::vec2(player_position.x, player_position.z) / (float)CHUNK_SIZE));
+	const glm::ivec2 Offset = PlayerColumn - WindowColumns / 2;
+
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, 0, Min, Max);
+
+	// In the unbounded world
+	const glm::ivec2 PlayerPosition = Min + PlayerColumn;
+
+	glm::ivec3 Delta = glm::ivec3(0);
+	Delta.x = std::abs(Offset.x) >= m_Settings.ShiftThreshold ? Offset.x : 0;
+	Delta.z = std::abs(Offset.y) >= m_Settings.ShiftThreshold ? Offset.y : 0;
+
+	if (Delta != glm::ivec3(0))
+	{
+		Min += glm::ivec2(Delta.x, Delta.z);
+		Max += glm::ivec2(Delta.x, Delta.z);
+
+		// The columns that leave the window are only kept if they were edited
+		for (auto it = m_Applied.begin(); it != m_Applied.end();)
+		{
+			const glm::ivec2 Position = GetColumnPosition(it->first);
+
+			if (glm::all(glm::greaterThanEqual(Position, Min)) && glm::all(glm::lessThan(Position, Max)))
+			{
+				it++;
+				continue;
+			}
+
+			if (IsColumnEdited(world, Position, it->second))
+			{
+				SaveColumn(world, Position);
+			}
+
+			it = m_Applied.erase(it);
+		}
+
+		world->ShiftWindow(Delta);
+		m_Stats.Shifts++;
+	}
+
+	CollectResults(world);
+
+	// Closest columns first, the ones that just came in are usually ready already
+	std::vector<std::pair<int, uint64_t>> Applicable;
+
+	for (const auto& e : m_Ready)
+	{
+		const glm::ivec2& Position = e.second.Position;
+
+		if (glm::all(glm::greaterThanEqual(Position, Min)) && glm::all(glm::lessThan(Position, Max)))
+		{
+			const glm::ivec2 d = Position - PlayerPosition;
+			Applicable.push_back({ d.x * d.x + d.y * d.y, e.first });
+		}
+	}
+
+	std::sort(Applicable.begin(), Applicable.end());
+
+	// The columns that came in with the window are all written at once, the slab they fill is already dirty and its
+	// part of the distance field is recomputed once instead of every frame until they are all there
+	if (Delta == glm::ivec3(0))
+	{
+		Applicable.resize(std::min<size_t>(Applicable.size(), (size_t)std::max(m_Settings.MaxColumnsPerFrame, 1)));
+	}
+
+	std::vector<DirtyBox> Boxes;
+
+	for (const auto& e : Applicable)
+	{
+		Boxes.push_back(ApplyColumn(world, m_Ready.at(e.second)));
+		m_Ready.erase(e.second);
+	}
+
+	if (!Boxes.empty())
+	{
+		world->UpdateLightList(Boxes);
+
+		for (const DirtyBox& Box : Boxes)
+		{
+			Volumetrics::RelightRegion(Box.Min, Box.Max);
+		}
+	}
+
+	Schedule(world, PlayerPosition);
+	return Delta * CHUNK_SIZE;
+}
+
+void VoxelRT::ChunkStreamer::SaveColumns(const World* world)
+{
+	for (auto& e : m_Applied)
+	{
+		const glm::ivec2 Position = GetColumnPosition(e.first);
+
+		if (!IsColumnEdited(world, Position, e.second))
+		{
+			continue;
+		}
+
+		SaveColumn(world, Position);
+
+		glm::ivec2 Min, Max;
+		GetColumnRange(world, 0, Min, Max);
+
+		for (int y = 0; y < m_Height; y++)
+		{
+			e.second[y] = world->m_WorldData.GetChunkVersion(world->m_WorldData.GetChunkIndex(Position.x - Min.x, y, Position.y - Min.y));
+		}
+	}
+}
+
+void VoxelRT::ChunkStreamer::WorkerThread()
+{
+	while (true)
+	{
+		Column Result;
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_JobCondition.wait(Lock, [this] { return m_Stop || !m_Jobs.empty(); });
+
+			if (m_Stop)
+			{
+				return;
+			}
+
+			Result.Position = m_Jobs.front();
+			m_Jobs.pop_front();
+		}
+
+		if (!LoadColumn(Result))
+		{
+			GenerateColumn(Result);
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_Results.push_back(std::move(Result));
+		}
+
+		m_ResultCondition.notify_one();
+	}
+}
+
+void VoxelRT::ChunkStreamer::GenerateColumn(Column& column) const
+{
+	const int Height = m_Height * CHUNK_SIZE;
+	const glm::ivec2 Origin = column.Position * CHUNK_SIZE;
+
+	// Built as a dense column (x + z * 16 + y * 256) first, then packed chunk by chunk
+	std::vector<uint16_t> Blocks((size_t)CHUNK_SIZE * CHUNK_SIZE * Height, 0);
+
+	auto At = [&Blocks](int x, int y, int z) -> uint16_t&
+	{
+		return Blocks[x + z * CHUNK_SIZE + (size_t)y * CHUNK_SIZE * CHUNK_SIZE];
+	};
+
+	bool HasStructure = false;
+
+	for (int z = 0; z < CHUNK_SIZE; z++)
+	{
+		for (int x = 0; x < CHUNK_SIZE; x++)
+		{
+			// Same terrain as the plains of GenerateWorld()
+			const float RealX = (float)(Origin.x + x);
+			const float RealZ = (float)(Origin.y + z);
+			const float Noise = m_HeightNoise.GetNoise(RealX, RealZ);
+			const int Top = std::min((int)(((Noise + 1.0f) / 2.0f) * 40.0f) + 8, Height);
+
+			const bool Grassland = ((m_BiomeNoise.GetNoise(RealX / 2.0f, RealZ / 2.0f) + 1.0f) / 2.0f) * 240.0f >= 90.0f;
+			const bool ConvertStone = m_Settings.Structures && Grassland && std::abs(m_StoneNoise.GetNoise(RealX / 2.0f, RealZ / 2.0f) * 100.0f) > 70.0f;
+			const uint32_t Hash = HashColumn(Origin.x + x, Origin.y + z, m_Settings.Seed);
+
+			for (int y = 0; y < Top; y++)
+			{
+				uint16_t Block = m_StoneID;
+
+				if (Grassland && y == Top - 1)
+				{
+					Block = !ConvertStone ? m_GrassID : (Hash % 8 <= 2 ? m_CobbleID : m_StoneID);
+				}
+
+				else if (Grassland && y >= Top - 5)
+				{
+					Block = m_DirtID;
+				}
+
+				else if (!Grassland && y >= Top - 8)
+				{
+					Block = m_SandID;
+				}
+
+				At(x, y, z) = Block;
+			}
+
+			// Structures stay away from the edges so that a column never needs its neighbours, the random extra leaves
+			// and branches of GenerateTree() are left out
+			const bool Center = x >= 4 && x < CHUNK_SIZE - 4 && z >= 4 && z < CHUNK_SIZE - 4;
+
+			if (!m_Settings.Structures || HasStructure || ConvertStone || !Center || (Hash >> 8) % STRUCTURE_FREQUENCY != 0)
+			{
+				continue;
+			}
+
+			HasStructure = true;
+
+			for (int i = 0; i < 6 && Top + i < Height; i++)
+			{
+				At(x, Top + i, z) = Grassland ? m_LogID : m_CactusID;
+			}
+
+			if (!Grassland)
+			{
+				continue;
+			}
+
+			const glm::vec3 Leaves = glm::vec3(x, Top + 8, z);
+
+			for (int ly = Top + 4; ly <= Top + 12 && ly < Height; ly++)
+			{
+				for (int lz = z - 3; lz <= z + 3; lz++)
+				{
+					for (int lx = x - 3; lx <= x + 3; lx++)
+					{
+						if (glm::distance(glm::vec3(lx, ly, lz), Leaves) <= 3.5f)
+						{
+							At(lx, ly, lz) = m_LeafID;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	column.Chunks.assign(m_Height, VoxelChunk());
+	column.States.assign(m_Height, std::vector<uint32_t>());
+	column.FromCache = false;
+
+	for (int cy = 0; cy < m_Height; cy++)
+	{
+		const uint16_t* ChunkBlocks = &At(0, cy * CHUNK_SIZE, 0);
+		const uint16_t First = ChunkBlocks[0];
+
+		if (std::all_of(ChunkBlocks, ChunkBlocks + CHUNK_VOLUME, [First](uint16_t b) { return b == First; }))
+		{
+			if (First != 0)
+			{
+				column.Chunks[cy].Fill({ First });
+			}
+
+			continue;
+		}
+
+		VoxelChunk& Chunk = column.Chunks[cy];
+
+		for (int i = 0; i < CHUNK_VOLUME; i++)
+		{
+			const glm::ivec3 p = VoxelIndexing::GetBrickLocalPosition(i);
+			const uint16_t Block = ChunkBlocks[p.x + p.z * CHUNK_SIZE + p.y * CHUNK_SIZE * CHUNK_SIZE];
+
+			if (Block != 0)
+			{
+				Chunk.SetBlock(i, { Block });
+			}
+		}
+
+		Chunk.Compact();
+	}
+}
+
+// Column file : magic, version, chunk count, then for each chunk (bottom to top) a uniform flag, the block (uniform) or
+// the 4096 blocks in morton order, the number of state entries and the entries
+bool VoxelRT::ChunkStreamer::LoadColumn(Column& column) const
+{
+	if (m_Settings.CacheDirectory.empty())
+	{
+		return false;
+	}
+
+	FILE* File = fopen(GetColumnPath(column.Position).c_str(), "rb");
+
+	if (!File)
+	{
+		return false;
+	}
+
+	uint32_t Header[3] = { 0, 0, 0 };
+	bool Valid = fread(Header, sizeof(Header), 1, File) == 1 && Header[0] == COLUMN_MAGIC && Header[1] == COLUMN_VERSION && Header[2] == (uint32_t)m_Height;
+
+	column.Chunks.assign(m_Height, VoxelChunk());
+	column.States.assign(m_Height, std::vector<uint32_t>());
+
+	std::vector<uint16_t> Blocks(CHUNK_VOLUME);
+
+	for (int cy = 0; cy < m_Height && Valid; cy++)
+	{
+		uint8_t Uniform = 0;
+		uint32_t StateCount = 0;
+		Valid = fread(&Uniform, 1, 1, File) == 1;
+
+		if (Valid && Uniform)
+		{
+			Valid = fread(Blocks.data(), sizeof(uint16_t), 1, File) == 1;
+			column.Chunks[cy].Fill({ Blocks[0] });
+		}
+
+		else if (Valid)
+		{
+			Valid = fread(Blocks.data(), sizeof(uint16_t), CHUNK_VOLUME, File) == CHUNK_VOLUME;
+
+			for (int i = 0; i < CHUNK_VOLUME && Valid; i++)
+			{
+				if (Blocks[i] != 0)
+				{
+					column.Chunks[cy].SetBlock(i, { Blocks[i] });
+				}
+			}
+
+			column.Chunks[cy].Compact();
+		}
+
+		Valid = Valid && fread(&StateCount, sizeof(uint32_t), 1, File) == 1 && StateCount <= CHUNK_VOLUME;
+
+		if (Valid && StateCount > 0)
+		{
+			column.States[cy].resize(StateCount);
+			Valid = fread(column.States[cy].data(), sizeof(uint32_t), StateCount, File) == StateCount;
+		}
+	}
+
+	fclose(File);
+
+	if (!Valid)
+	{
+		std::cout << "\nColumn " << column.Position.x << " " << column.Position.y << " of the cache is invalid, generating it again\n";
+		return false;
+	}
+
+	column.FromCache = true;
+	return true;
+}
+
+void VoxelRT::ChunkStreamer::SaveColumn(const World* world, const glm::ivec2& position)
+{
+	if (m_Settings.CacheDirectory.empty())
+	{
+		return;
+	}
+
+	FILE* File = fopen(GetColumnPath(position).c_str(), "wb");
+
+	if (!File)
+	{
+		std::cout << "\nCouldn't write column " << position.x << " " << position.y << " to the cache\n";
+		return;
+	}
+
+	const WorldData& Data = world->m_WorldData;
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, 0, Min, Max);
+
+	const uint32_t Header[3] = { COLUMN_MAGIC, COLUMN_VERSION, (uint32_t)m_Height };
+	fwrite(Header, sizeof(Header), 1, File);
+
+	std::vector<uint16_t> Blocks(CHUNK_VOLUME);
+
+	for (int cy = 0; cy < m_Height; cy++)
+	{
+		const int Index = Data.GetChunkIndex(position.x - Min.x, cy, position.y - Min.y);
+		const VoxelChunk& Chunk = Data.GetChunk(Index);
+		const uint8_t Uniform = Chunk.IsUniform();
+
+		fwrite(&Uniform, 1, 1, File);
+
+		if (Uniform)
+		{
+			const uint16_t Block = Chunk.GetUniformBlock().block;
+			fwrite(&Block, sizeof(uint16_t), 1, File);
+		}
+
+		else
+		{
+			for (int i = 0; i < CHUNK_VOLUME; i++)
+			{
+				Blocks[i] = Chunk.GetBlock(i).block;
+			}
+
+			fwrite(Blocks.data(), sizeof(uint16_t), CHUNK_VOLUME, File);
+		}
+
+		const std::vector<uint32_t>* States = Data.GetStates().GetChunkEntries(Index);
+		const uint32_t StateCount = States ? (uint32_t)States->size() : 0;
+		fwrite(&StateCount, sizeof(uint32_t), 1, File);
+
+		if (StateCount > 0)
+		{
+			fwrite(States->data(), sizeof(uint32_t), StateCount, File);
+		}
+	}
+
+	fclose(File);
+	m_Stats.ColumnsSaved++;
+}
+
+std::string VoxelRT::ChunkStreamer::GetColumnPath(const glm::ivec2& position) const
+{
+	return m_Settings.CacheDirectory + "/" + std::to_string(position.x) + "_" + std::to_string(position.y) + ".column";
+}
+
+VoxelRT::DirtyBox VoxelRT::ChunkStreamer::ApplyColumn(World* world, Column& column)
+{
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, 0, Min, Max);
+
+	const glm::ivec2 Local = column.Position - Min;
+	std::vector<uint32_t> Versions(m_Height);
+
+	for (int cy = 0; cy < m_Height; cy++)
+	{
+		const int Index = world->m_WorldData.GetChunkIndex(Local.x, cy, Local.y);
+		world->SetChunk(Index, std::move(column.Chunks[cy]), std::move(column.States[cy]));
+		Versions[cy] = world->m_WorldData.GetChunkVersion(Index);
+	}
+
+	m_Applied[GetKey(column.Position)] = std::move(Versions);
+	m_Stats.ColumnsApplied++;
+
+	const glm::ivec3 BoxMin = glm::ivec3(Local.x, 0, Local.y) * CHUNK_SIZE;
+	return { BoxMin, BoxMin + glm::ivec3(CHUNK_SIZE, m_Height * CHUNK_SIZE, CHUNK_SIZE) };
+}
+
+bool VoxelRT::ChunkStreamer::IsColumnEdited(const World* world, const glm::ivec2& position, const std::vector<uint32_t>& versions) const
+{
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, 0, Min, Max);
+
+	for (int cy = 0; cy < m_Height; cy++)
+	{
+		if (world->m_WorldData.GetChunkVersion(world->m_WorldData.GetChunkIndex(position.x - Min.x, cy, position.y - Min.y)) != versions[cy])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void VoxelRT::ChunkStreamer::GetColumnRange(const World* world, int margin, glm::ivec2& min, glm::ivec2& max) const
+{
+	const glm::ivec3& Origin = world->m_WorldData.GetOrigin();
+	const glm::ivec3& Dimensions = world->GetDimensions();
+
+	min = glm::ivec2(Origin.x, Origin.z) / CHUNK_SIZE - glm::ivec2(margin);
+	max = glm::ivec2(Origin.x + Dimensions.x, Origin.z + Dimensions.z) / CHUNK_SIZE + glm::ivec2(margin);
+}
+
+void VoxelRT::ChunkStreamer::CollectResults(const World* world)
+{
+	std::vector<Column> Results;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		Results.swap(m_Results);
+	}
+
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, m_Settings.PrefetchMargin, Min, Max);
+
+	for (Column& Result : Results)
+	{
+		const uint64_t Key = GetKey(Result.Position);
+		m_Pending.erase(Key);
+		(Result.FromCache ? m_Stats.ColumnsLoaded : m_Stats.ColumnsGenerated)++;
+
+		// The window moved away while it was being built
+		if (glm::any(glm::lessThan(Result.Position, Min)) || glm::any(glm::greaterThanEqual(Result.Position, Max)) || m_Applied.count(Key))
+		{
+			continue;
+		}
+
+		m_Ready[Key] = std::move(Result);
+	}
+}
+
+void VoxelRT::ChunkStreamer::Schedule(const World* world, const glm::ivec2& player_column)
+{
+	glm::ivec2 Min, Max;
+	GetColumnRange(world, m_Settings.PrefetchMargin, Min, Max);
+
+	auto InRange = [&Min, &Max](const glm::ivec2& p)
+	{
+		return glm::all(glm::greaterThanEqual(p, Min)) && glm::all(glm::lessThan(p, Max));
+	};
+
+	auto Closer = [&player_column](const glm::ivec2& a, const glm::ivec2& b)
+	{
+		const glm::ivec2 da = a - player_column;
+		const glm::ivec2 db = b - player_column;
+		return da.x * da.x + da.y * da.y < db.x * db.x + db.y * db.y;
+	};
+
+	for (auto it = m_Ready.begin(); it != m_Ready.end();)
+	{
+		it = InRange(it->second.Position) ? std::next(it) : m_Ready.erase(it);
+	}
+
+	std::vector<glm::ivec2> Wanted;
+
+	for (int z = Min.y; z < Max.y; z++)
+	{
+		for (int x = Min.x; x < Max.x; x++)
+		{
+			const uint64_t Key = GetKey(glm::ivec2(x, z));
+
+			if (!m_Applied.count(Key) && !m_Ready.count(Key) && !m_Pending.count(Key))
+			{
+				Wanted.push_back(glm::ivec2(x, z));
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		// Jobs that left the range are dropped before a worker gets to them
+		for (auto it = m_Jobs.begin(); it != m_Jobs.end();)
+		{
+			if (InRange(*it))
+			{
+				it++;
+				continue;
+			}
+
+			m_Pending.erase(GetKey(*it));
+			it = m_Jobs.erase(it);
+		}
+
+		for (const glm::ivec2& Position : Wanted)
+		{
+			m_Jobs.push_back(Position);
+			m_Pending.insert(GetKey(Position));
+		}
+
+		if (!Wanted.empty())
+		{
+			std::sort(m_Jobs.begin(), m_Jobs.end(), Closer);
+		}
+
+		m_Stats.QueuedColumns = m_Jobs.size();
+	}
+
+	if (!Wanted.empty())
+	{
+		m_JobCondition.notify_all();
+	}
+
+	m_Stats.ReadyColumns = m_Ready.size();
+}
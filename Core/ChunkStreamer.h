@@ -0,0 +1,133 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <FastNoise.h>
+
+#include "WorldData.h"
+#include "DirtyRegion.h"
+
+namespace VoxelRT
+{
+	class World;
+
+	// Streams an unbounded world through a World of fixed dimensions, a window that moves with the player by whole chunks
+	// (World::ShiftWindow()). The world is made of columns of chunks (16 x window height x 16) that are generated (seeded
+	// terrain, the same column always comes out the same) or read from the column cache on worker threads. A ring of
+	// columns around the window is prefetched so that the columns that come in when the window moves are usually ready.
+	// Columns that leave the window are written to the cache if they were edited and dropped otherwise, so memory
+	// doesn't grow with the distance travelled : the window, the prefetch ring and the job queue are all that is kept.
+	//
+	// The gpu volumes are addressed toroidally, moving only uploads the columns that came in and the part of the
+	// distance field around them.
+
+	struct ChunkStreamerSettings
+	{
+		int Seed = 1337;
+		int ThreadCount = 0; // <= 0 -> every core but one
+		int PrefetchMargin = 2; // Columns generated ahead of the window on every side
+		int ShiftThreshold = 2; // The window moves once the player is this many chunks away from its center
+		int MaxColumnsPerFrame = 16; // Columns written to the world per Update(), except when the window moves
+		bool Structures = true;
+		std::string CacheDirectory; // Edited columns, they aren't kept if it's empty
+	};
+
+	struct ChunkStreamerStats
+	{
+		size_t ColumnsGenerated = 0;
+		size_t ColumnsLoaded = 0; // From the cache
+		size_t ColumnsSaved = 0;
+		size_t ColumnsApplied = 0;
+		size_t Shifts = 0;
+		size_t QueuedColumns = 0; // Jobs waiting for a worker, at the last Update()
+		size_t ReadyColumns = 0; // Prefetched, at the last Update()
+	};
+
+	class ChunkStreamer
+	{
+	public :
+
+		~ChunkStreamer();
+
+		// Starts the workers and fills the window (the world has to be resized and marked as streamed), the world is
+		// written directly so it has to be called before it is buffered. The emissive blocks of the window are appended
+		// to lights.
+		void Start(World* world, const ChunkStreamerSettings& settings, std::vector<glm::ivec3>& lights);
+		void Stop();
+
+		// Once per frame, before World::FlushEdits() : moves the window if the player got too far from its center,
+		// writes the columns that are ready to the world and queues the ones around it. Returns how far everything in the
+		// window moved (in voxels), positions in window coordinates (player, camera, matrices...) have to be offset by -delta
+		glm::ivec3 Update(World* world, const glm::vec3& player_position);
+
+		// Writes every edited column of the window to the cache
+		void SaveColumns(const World* world);
+
+		inline bool IsRunning() const noexcept { return !m_Workers.empty(); }
+		inline const ChunkStreamerStats& GetStats() const noexcept { return m_Stats; }
+
+	private :
+
+		struct Column
+		{
+			glm::ivec2 Position = glm::ivec2(0); // In columns, in the unbounded world
+			std::vector<VoxelChunk> Chunks; // Bottom to top
+			std::vector<std::vector<uint32_t>> States; // Sorted state entries of each chunk
+			bool FromCache = false;
+		};
+
+		static inline uint64_t GetKey(const glm::ivec2& column) noexcept
+		{
+			return ((uint64_t)(uint32_t)column.x << 32) | (uint32_t)column.y;
+		}
+
+		void WorkerThread();
+
+		void GenerateColumn(Column& column) const;
+		bool LoadColumn(Column& column) const;
+		void SaveColumn(const World* world, const glm::ivec2& position);
+		std::string GetColumnPath(const glm::ivec2& position) const;
+
+		// Writes the column to the world, returns the box it covers (window coordinates)
+		DirtyBox ApplyColumn(World* world, Column& column);
+
+		bool IsColumnEdited(const World* world, const glm::ivec2& position, const std::vector<uint32_t>& versions) const;
+
+		// Columns of the window grown by margin columns on every side, in the unbounded world (max is exclusive)
+		void GetColumnRange(const World* world, int margin, glm::ivec2& min, glm::ivec2& max) const;
+
+		void CollectResults(const World* world);
+		void Schedule(const World* world, const glm::ivec2& player_column);
+
+		ChunkStreamerSettings m_Settings;
+		ChunkStreamerStats m_Stats;
+		int m_Height = 0; // Chunks per column
+
+		FastNoise m_HeightNoise;
+		FastNoise m_BiomeNoise;
+		FastNoise m_StoneNoise;
+		uint16_t m_GrassID = 0, m_DirtID = 0, m_StoneID = 0, m_SandID = 0, m_LogID = 0, m_LeafID = 0, m_CactusID = 0, m_CobbleID = 0;
+
+		std::vector<std::thread> m_Workers;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobCondition;
+		std::condition_variable m_ResultCondition;
+		std::deque<glm::ivec2> m_Jobs;
+		std::vector<Column> m_Results;
+		bool m_Stop = false;
+
+		// Main thread only
+		std::unordered_set<uint64_t> m_Pending; // Queued or being built
+		std::unordered_map<uint64_t, Column> m_Ready; // Built, waiting to be written to the world
+		std::unordered_map<uint64_t, std::vector<uint32_t>> m_Applied; // Columns of the window, versions of their chunks when they were written
+	};
+}
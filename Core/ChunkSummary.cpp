@@ -0,0 +1,324 @@
+#include "ChunkSummary.h"
+
+#include <algorithm>
+
+#include "WorldData.h"
+
+// Bits of a 64 bit word of a morton ordered chunk mask in each of the 4 layers (y & 3) a word spans
+struct LayerBitTable
+{
+	uint64_t Masks[4];
+
+	constexpr LayerBitTable() : Masks()
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			Masks[((i >> 1) & 1) | ((i >> 3) & 2)] |= 1ull << i;
+		}
+	}
+};
+
+static constexpr LayerBitTable LayerBits;
+
+void VoxelRT::ChunkSummary::Resize(int chunk_count)
+{
+	m_SolidLayers.assign((size_t)chunk_count * LAYERS, 0);
+	m_SolidLayers.shrink_to_fit();
+	m_Lights.assign(chunk_count, std::vector<uint16_t>());
+	m_Lights.shrink_to_fit();
+}
+
+void VoxelRT::ChunkSummary::Clear()
+{
+	std::fill(m_SolidLayers.begin(), m_SolidLayers.end(), 0);
+
+	for (auto& e : m_Lights)
+	{
+		e.clear();
+		e.shrink_to_fit();
+	}
+}
+
+bool VoxelRT::ChunkSummary::SetEmissiveBlocks(const std::vector<uint16_t>& ids)
+{
+	std::vector<uint16_t> Sorted = ids;
+	std::sort(Sorted.begin(), Sorted.end());
+	Sorted.erase(std::unique(Sorted.begin(), Sorted.end()), Sorted.end());
+
+	if (Sorted == m_EmissiveBlocks)
+	{
+		return false;
+	}
+
+	m_EmissiveBlocks = std::move(Sorted);
+	m_EmissiveTable.assign(m_EmissiveBlocks.empty() ? 0 : (size_t)m_EmissiveBlocks.back() + 1, 0);
+
+	for (uint16_t id : m_EmissiveBlocks)
+	{
+		m_EmissiveTable[id] = 1;
+	}
+
+	return true;
+}
+
+void VoxelRT::ChunkSummary::Rebuild(int chunk, const VoxelChunk& data)
+{
+	uint16_t* Layers = &m_SolidLayers[(size_t)chunk * LAYERS];
+	std::vector<uint16_t>& Lights = m_Lights[chunk];
+	Lights.clear();
+
+	if (data.IsUniform())
+	{
+		const uint16_t Block = data.GetUniformBlock().block;
+		std::fill(Layers, Layers + LAYERS, Block != 0 ? CHUNK_SIZE * CHUNK_SIZE : 0);
+
+		if (IsEmissive(Block))
+		{
+			Lights.resize(CHUNK_VOLUME);
+
+			for (int i = 0; i < CHUNK_VOLUME; i++)
+			{
+				Lights[i] = (uint16_t)i;
+			}
+		}
+
+		Lights.shrink_to_fit();
+		return;
+	}
+
+	uint64_t Solid[CHUNK_VOLUME / 64];
+	data.GetVoxelMask([](Block block) { return block.block != 0; }, Solid);
+	Rebuild(chunk, data, Solid);
+}
+
+void VoxelRT::ChunkSummary::Rebuild(int chunk, const VoxelChunk& data, const uint64_t* solid)
+{
+	uint16_t* Layers = &m_SolidLayers[(size_t)chunk * LAYERS];
+	std::vector<uint16_t>& Lights = m_Lights[chunk];
+	Lights.clear();
+	std::fill(Layers, Layers + LAYERS, 0);
+
+	// The low 2 bits of y come from bits 1 and 4 of the morton index (inside of a word), the high 2 from bits 7 and 10
+	for (int w = 0; w < CHUNK_VOLUME / 64; w++)
+	{
+		uint16_t* WordLayers = Layers + (((w >> 1) & 1) | ((w >> 3) & 2)) * 4;
+
+		for (int y = 0; y < 4; y++)
+		{
+			WordLayers[y] += (uint16_t)OccupancyMask::CountBits(solid[w] & LayerBits.Masks[y]);
+		}
+	}
+
+	bool HasLights = false;
+
+	data.ForEachBlockType([&](Block block, int) {
+		HasLights = HasLights || IsEmissive(block.block);
+	});
+
+	if (HasLights)
+	{
+		uint64_t Emissive[CHUNK_VOLUME / 64];
+		data.GetVoxelMask([this](Block block) { return IsEmissive(block.block); }, Emissive);
+
+		for (int w = 0; w < CHUNK_VOLUME / 64; w++)
+		{
+			for (uint64_t Word = Emissive[w]; Word != 0; Word &= Word - 1)
+			{
+				const int i = w * 64 + OccupancyMask::CountBits((Word & (~Word + 1)) - 1);
+				const glm::ivec3 p = VoxelIndexing::GetBrickLocalPosition(i);
+				Lights.push_back(GetLocalIndex(p.x, p.y, p.z));
+			}
+		}
+	}
+
+	Lights.shrink_to_fit();
+}
+
+void VoxelRT::ChunkSummary::Shift(const glm::ivec3& chunks, const glm::ivec3& delta)
+{
+	std::vector<uint16_t> Layers(m_SolidLayers.size(), 0);
+	std::vector<std::vector<uint16_t>> Lights(m_Lights.size());
+
+	for (int z = 0; z < chunks.z; z++)
+	{
+		for (int y = 0; y < chunks.y; y++)
+		{
+			for (int x = 0; x < chunks.x; x++)
+			{
+				const glm::ivec3 Source = glm::ivec3(x, y, z) + delta;
+
+				if (glm::any(glm::lessThan(Source, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Source, chunks)))
+				{
+					continue;
+				}
+
+				const size_t Index = (size_t)x + (size_t)y * chunks.x + (size_t)z * chunks.x * chunks.y;
+				const size_t SourceIndex = (size_t)Source.x + (size_t)Source.y * chunks.x + (size_t)Source.z * chunks.x * chunks.y;
+				std::copy_n(m_SolidLayers.begin() + SourceIndex * LAYERS, LAYERS, Layers.begin() + Index * LAYERS);
+				Lights[Index] = std::move(m_Lights[SourceIndex]);
+			}
+		}
+	}
+
+	m_SolidLayers = std::move(Layers);
+	m_Lights = std::move(Lights);
+}
+
+int VoxelRT::ChunkSummary::GetSolidCount(int chunk) const noexcept
+{
+	int Count = 0;
+
+	for (int i = 0; i < LAYERS; i++)
+	{
+		Count += m_SolidLayers[(size_t)chunk * LAYERS + i];
+	}
+
+	return Count;
+}
+
+bool VoxelRT::ChunkSummary::GetSolidLayers(int chunk, int& lowest, int& highest) const noexcept
+{
+	const uint16_t* Layers = &m_SolidLayers[(size_t)chunk * LAYERS];
+	lowest = 0;
+	highest = LAYERS - 1;
+
+	while (lowest < LAYERS && Layers[lowest] == 0)
+	{
+		lowest++;
+	}
+
+	if (lowest == LAYERS)
+	{
+		return false;
+	}
+
+	while (Layers[highest] == 0)
+	{
+		highest--;
+	}
+
+	return true;
+}
+
+void VoxelRT::ChunkSummary::Update(int chunk, int x, int y, int z, uint16_t previous, uint16_t block)
+{
+	if ((previous != 0) != (block != 0))
+	{
+		m_SolidLayers[(size_t)chunk * LAYERS + (y & 15)] += block != 0 ? 1 : -1;
+	}
+
+	if (IsEmissive(previous))
+	{
+		RemoveLight(chunk, GetLocalIndex(x, y, z));
+	}
+
+	if (IsEmissive(block))
+	{
+		m_Lights[chunk].push_back(GetLocalIndex(x, y, z));
+	}
+}
+
+void VoxelRT::ChunkSummary::RemoveLight(int chunk, uint16_t index)
+{
+	std::vector<uint16_t>& Lights = m_Lights[chunk];
+	auto it = std::find(Lights.begin(), Lights.end(), index);
+
+	if (it != Lights.end())
+	{
+		*it = Lights.back();
+		Lights.pop_back();
+	}
+}
+
+void VoxelRT::ChunkSummary::Write(FILE* file) const
+{
+	const uint32_t EmissiveCount = (uint32_t)m_EmissiveBlocks.size();
+	const uint32_t ChunkCount = (uint32_t)m_Lights.size();
+	fwrite(&EmissiveCount, sizeof(uint32_t), 1, file);
+	fwrite(m_EmissiveBlocks.data(), sizeof(uint16_t), EmissiveCount, file);
+	fwrite(&ChunkCount, sizeof(uint32_t), 1, file);
+	fwrite(m_SolidLayers.data(), sizeof(uint16_t), m_SolidLayers.size(), file);
+
+	std::vector<uint16_t> LightCounts(ChunkCount);
+
+	for (uint32_t i = 0; i < ChunkCount; i++)
+	{
+		LightCounts[i] = (uint16_t)m_Lights[i].size();
+	}
+
+	fwrite(LightCounts.data(), sizeof(uint16_t), ChunkCount, file);
+
+	for (uint32_t i = 0; i < ChunkCount; i++)
+	{
+		fwrite(m_Lights[i].data(), sizeof(uint16_t), LightCounts[i], file);
+	}
+}
+
+bool VoxelRT::ChunkSummary::Read(FILE* file)
+{
+	uint32_t EmissiveCount = 0;
+	uint32_t ChunkCount = 0;
+
+	if (fread(&EmissiveCount, sizeof(uint32_t), 1, file) != 1 || EmissiveCount > 0xFFFF)
+	{
+		return false;
+	}
+
+	std::vector<uint16_t> EmissiveBlocks(EmissiveCount);
+
+	if (fread(EmissiveBlocks.data(), sizeof(uint16_t), EmissiveCount, file) != EmissiveCount || EmissiveBlocks != m_EmissiveBlocks)
+	{
+		return false;
+	}
+
+	if (fread(&ChunkCount, sizeof(uint32_t), 1, file) != 1 || ChunkCount != m_Lights.size())
+	{
+		return false;
+	}
+
+	std::vector<uint16_t> LightCounts(ChunkCount);
+
+	if (fread(m_SolidLayers.data(), sizeof(uint16_t), m_SolidLayers.size(), file) != m_SolidLayers.size() ||
+		fread(LightCounts.data(), sizeof(uint16_t), ChunkCount, file) != ChunkCount)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < ChunkCount; i++)
+	{
+		if (LightCounts[i] > CHUNK_VOLUME)
+		{
+			return false;
+		}
+
+		m_Lights[i].resize(LightCounts[i]);
+
+		if (fread(m_Lights[i].data(), sizeof(uint16_t), LightCounts[i], file) != LightCounts[i])
+		{
+			return false;
+		}
+
+		for (uint16_t e : m_Lights[i])
+		{
+			if (e >= CHUNK_VOLUME)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+size_t VoxelRT::ChunkSummary::GetMemoryUsage() const noexcept
+{
+	size_t Total = m_SolidLayers.capacity() * sizeof(uint16_t) + m_Lights.capacity() * sizeof(std::vector<uint16_t>) +
+		m_EmissiveBlocks.capacity() * sizeof(uint16_t) + m_EmissiveTable.capacity();
+
+	for (auto& e : m_Lights)
+	{
+		Total += e.capacity() * sizeof(uint16_t);
+	}
+
+	return Total;
+}
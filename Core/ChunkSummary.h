@@ -0,0 +1,96 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace VoxelRT
+{
+	class VoxelChunk;
+
+	// Aggregates of every chunk of a WorldData, kept up to date by every write so that the code that used to go
+	// through every voxel of the world works on chunks instead :
+	//  - the number of solid voxels in each of the 16 layers of the chunk, which gives its lowest and highest solid
+	//    voxel (heightmaps, structure placement) and whether it is empty
+	//  - the emissive voxels of the chunk (light discovery, see WorldData::GetLights())
+	// The block histogram of a chunk is its palette, which already keeps a voxel count per block type (see
+	// VoxelChunk::ForEachBlockType()).
+	//
+	// Which blocks are emissive comes from the block database (World::Resize() sets it), a world that was written
+	// before that has no lights in its summary until SetEmissiveBlocks() rebuilds them.
+
+	class ChunkSummary
+	{
+	public :
+
+		static constexpr int LAYERS = 16;
+
+		// Every chunk empty
+		void Resize(int chunk_count);
+		void Clear();
+
+		// Returns false if the ids are the ones that were already set (nothing has to be rebuilt)
+		bool SetEmissiveBlocks(const std::vector<uint16_t>& ids);
+		inline const std::vector<uint16_t>& GetEmissiveBlocks() const noexcept { return m_EmissiveBlocks; }
+
+		inline bool IsEmissive(uint16_t id) const noexcept
+		{
+			return id < m_EmissiveTable.size() && m_EmissiveTable[id];
+		}
+
+		// Voxel (x, y, z) of the chunk went from previous to block, only the low 4 bits of the position are used
+		// O(1), removing a light is O(lights in the chunk). Not inlined so that WorldData::SetBlock() stays small
+		// enough to be inlined into the bulk write loops
+		void Update(int chunk, int x, int y, int z, uint16_t previous, uint16_t block);
+
+		// Recomputes the summary of one chunk from its voxels, for the writes that replace entire chunks
+		// Uniform chunks don't look at their voxels, the others work on 1 bit per voxel masks of their solid and emissive
+		// voxels (VoxelChunk::GetVoxelMask()) and only build the emissive one if one of their blocks is emissive
+		void Rebuild(int chunk, const VoxelChunk& data);
+
+		// Same, with the solid mask of a chunk that isn't uniform (the one WorldData::SetChunk() builds for the occupancy)
+		void Rebuild(int chunk, const VoxelChunk& data, const uint64_t* solid);
+
+		// Chunk p takes the summary of chunk p + delta, the ones that come from outside are empty (see WorldData::ShiftChunks())
+		void Shift(const glm::ivec3& chunks, const glm::ivec3& delta);
+
+		int GetSolidCount(int chunk) const noexcept;
+		inline bool IsEmpty(int chunk) const noexcept { return GetSolidCount(chunk) == 0; }
+
+		// Lowest and highest layer (0 to 15) of the chunk with a solid voxel, false if the chunk is empty
+		bool GetSolidLayers(int chunk, int& lowest, int& highest) const noexcept;
+
+		// Local x | y << 4 | z << 8 indices of the emissive voxels of the chunk, in no particular order
+		inline const std::vector<uint16_t>& GetLights(int chunk) const noexcept { return m_Lights[chunk]; }
+
+		static inline glm::ivec3 GetLocalPosition(uint16_t index) noexcept
+		{
+			return glm::ivec3(index & 15, (index >> 4) & 15, index >> 8);
+		}
+
+		// Save file section (see WorldFileHandler.h) : the emissive block ids it was built with, the layer counts of
+		// every chunk, the light count of every chunk and then every light
+		// Read() returns false if the section is truncated, doesn't match the chunk count or was built with other
+		// emissive blocks, the summary has to be rebuilt then (WorldData::RebuildSummary())
+		void Write(FILE* file) const;
+		bool Read(FILE* file);
+
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		static inline uint16_t GetLocalIndex(int x, int y, int z) noexcept
+		{
+			return (uint16_t)((x & 15) | ((y & 15) << 4) | ((z & 15) << 8));
+		}
+
+		void RemoveLight(int chunk, uint16_t index);
+
+		std::vector<uint16_t> m_SolidLayers; // LAYERS per chunk
+		std::vector<std::vector<uint16_t>> m_Lights;
+		std::vector<uint16_t> m_EmissiveBlocks;
+		std::vector<uint8_t> m_EmissiveTable; // Indexed by block id
+	};
+}
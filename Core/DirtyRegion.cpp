@@ -0,0 +1,80 @@
+#include "DirtyRegion.h"
+
+#include <cstdint>
+
+// Boxes are merged when the union uploads at most this many voxels that weren't modified (a 16^3 chunk)
+// Re-uploading a few kilobytes is a lot cheaper than an extra driver call
+static const int64_t MERGE_SLACK = 4096;
+static const int MAX_BOXES = 8;
+
+static VoxelRT::DirtyBox GetUnion(const VoxelRT::DirtyBox& a, const VoxelRT::DirtyBox& b)
+{
+	return { glm::min(a.Min, b.Min), glm::max(a.Max, b.Max) };
+}
+
+// Number of voxels the union of both boxes uploads that neither of them contain
+static int64_t GetMergeWaste(const VoxelRT::DirtyBox& a, const VoxelRT::DirtyBox& b)
+{
+	return GetUnion(a, b).GetVolume() - a.GetVolume() - b.GetVolume();
+}
+
+void VoxelRT::DirtyRegion::Add(const glm::ivec3& min, const glm::ivec3& max)
+{
+	m_AddCount++;
+
+	DirtyBox box = { min, max };
+
+	for (int i = 0; i < (int)m_Boxes.size(); i++)
+	{
+		if (GetMergeWaste(m_Boxes[i], box) <= MERGE_SLACK)
+		{
+			m_Boxes[i] = GetUnion(m_Boxes[i], box);
+
+			// The grown box might be able to absorb others now
+			for (int j = 0; j < (int)m_Boxes.size(); j++)
+			{
+				if (j != i && GetMergeWaste(m_Boxes[i], m_Boxes[j]) <= MERGE_SLACK)
+				{
+					MergeInto(i, j);
+
+					if (j < i) { i--; }
+					j = -1;
+				}
+			}
+
+			return;
+		}
+	}
+
+	m_Boxes.push_back(box);
+
+	if (m_Boxes.size() > MAX_BOXES)
+	{
+		// Merge the pair that wastes the least
+		int best_a = 0, best_b = 1;
+		int64_t best_waste = INT64_MAX;
+
+		for (int a = 0; a < (int)m_Boxes.size(); a++)
+		{
+			for (int b = a + 1; b < (int)m_Boxes.size(); b++)
+			{
+				int64_t waste = GetMergeWaste(m_Boxes[a], m_Boxes[b]);
+
+				if (waste < best_waste)
+				{
+					best_waste = waste;
+					best_a = a;
+					best_b = b;
+				}
+			}
+		}
+
+		MergeInto(best_a, best_b);
+	}
+}
+
+void VoxelRT::DirtyRegion::MergeInto(int target, int source)
+{
+	m_Boxes[target] = GetUnion(m_Boxes[target], m_Boxes[source]);
+	m_Boxes.erase(m_Boxes.begin() + source);
+}
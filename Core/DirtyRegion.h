@@ -0,0 +1,83 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace VoxelRT
+{
+	struct DirtyBox
+	{
+		glm::ivec3 Min;
+		glm::ivec3 Max; // Exclusive
+
+		inline glm::ivec3 GetSize() const noexcept { return Max - Min; }
+		inline int64_t GetVolume() const noexcept { glm::ivec3 s = Max - Min; return (int64_t)s.x * s.y * s.z; }
+	};
+
+	// Splits a box of a volume whose texels are addressed toroidally, (p + offset) mod dimensions, into the boxes that
+	// don't wrap around the edges of the texture (at most 8). f(min, size, texel) gets each of them with the texel
+	// their min is stored at. offset has to be in [0, dimensions) and the box inside of the volume.
+	template <typename F>
+	void ForEachWrappedBox(const DirtyBox& box, const glm::ivec3& offset, const glm::ivec3& dimensions, F&& f)
+	{
+		glm::ivec3 Split = box.Max;
+		glm::ivec3 Texel = box.Min + offset;
+		glm::ivec3 Count = glm::ivec3(1);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			Texel[axis] %= dimensions[axis];
+
+			// The first part ends at the edge of the texture, the second one starts at texel 0
+			if (Texel[axis] + box.Max[axis] - box.Min[axis] > dimensions[axis])
+			{
+				Split[axis] = box.Min[axis] + dimensions[axis] - Texel[axis];
+				Count[axis] = 2;
+			}
+		}
+
+		for (int z = 0; z < Count.z; z++)
+		{
+			for (int y = 0; y < Count.y; y++)
+			{
+				for (int x = 0; x < Count.x; x++)
+				{
+					const glm::ivec3 Part = glm::ivec3(x, y, z);
+					const glm::ivec3 Min = glm::mix(box.Min, Split, glm::equal(Part, glm::ivec3(1)));
+					const glm::ivec3 Max = glm::mix(Split, box.Max, glm::equal(Part, glm::ivec3(1)));
+					f(Min, Max - Min, glm::mix(Texel, glm::ivec3(0), glm::equal(Part, glm::ivec3(1))));
+				}
+			}
+		}
+	}
+
+	// Accumulates the voxels modified during a frame into a handful of boxes so that they can be uploaded with a few
+	// glTexSubImage3D calls at a single sync point instead of one call per voxel.
+	class DirtyRegion
+	{
+	public :
+
+		inline void Add(const glm::ivec3& p)
+		{
+			Add(p, p + glm::ivec3(1));
+		}
+
+		// max is exclusive
+		void Add(const glm::ivec3& min, const glm::ivec3& max);
+
+		inline void Clear() { m_Boxes.clear(); m_AddCount = 0; }
+		inline bool IsEmpty() const noexcept { return m_Boxes.empty(); }
+		inline const std::vector<DirtyBox>& GetBoxes() const noexcept { return m_Boxes; }
+
+		// Number of Add() calls since the last Clear()
+		inline int GetAddCount() const noexcept { return m_AddCount; }
+
+	private :
+
+		void MergeInto(int target, int source);
+
+		std::vector<DirtyBox> m_Boxes;
+		int m_AddCount = 0;
+	};
+}
@@ -0,0 +1,995 @@
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "ParallelFor.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Same as the ManhattanDistance shaders
+static int GetMaxDistance(const glm::ivec3& dimensions)
+{
+	return std::min(254, dimensions.x + dimensions.y + dimensions.z);
+}
+
+// dst[i] = min(dst[i], src[i] + 1)
+static inline void MinWithNeighbour(uint8_t* dst, const uint8_t* src, size_t count)
+{
+	size_t i = 0;
+
+#ifdef __AVX2__
+	const __m256i One = _mm256_set1_epi8(1);
+
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+		const __m256i b = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(src + i)), One);
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_min_epu8(a, b));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		dst[i] = (uint8_t)std::min((int)dst[i], src[i] + 1);
+	}
+}
+
+#ifdef __AVX2__
+
+// The x pass runs along a row, which is a serial dependency chain, so it's done as a log step scan instead :
+// after the step with stride s every voxel holds the min of (v[x - k] + k) for k < 2s. Distances are capped below 255
+// so strides up to 128 are enough. The row is padded with 255 on both ends so that the shifted loads stay in bounds.
+static const int ROW_PADDING = 128;
+
+static void RowPassAVX2(uint8_t* row, int length, uint8_t* padded)
+{
+	const int Vectors = (length + 31) / 32;
+	uint8_t* data = padded + ROW_PADDING;
+
+	std::memcpy(data, row, length);
+	std::memset(data + length, 255, Vectors * 32 - length);
+
+	// Forward (high to low so that the loads read the values from the previous step)
+	for (int stride = 1; stride <= 128; stride *= 2)
+	{
+		const __m256i Stride = _mm256_set1_epi8((char)stride);
+
+		for (int i = Vectors - 1; i >= 0; i--)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(data + i * 32));
+			const __m256i b = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(data + i * 32 - stride)), Stride);
+			_mm256_storeu_si256((__m256i*)(data + i * 32), _mm256_min_epu8(a, b));
+		}
+	}
+
+	// The voxels past the end of the row picked up values in the forward scan
+	std::memset(data + length, 255, Vectors * 32 - length);
+
+	// Backward (low to high)
+	for (int stride = 1; stride <= 128; stride *= 2)
+	{
+		const __m256i Stride = _mm256_set1_epi8((char)stride);
+
+		for (int i = 0; i < Vectors; i++)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(data + i * 32));
+			const __m256i b = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(data + i * 32 + stride)), Stride);
+			_mm256_storeu_si256((__m256i*)(data + i * 32), _mm256_min_epu8(a, b));
+		}
+	}
+
+	std::memcpy(row, data, length);
+}
+
+// One direction of the scan above, for the directional field (distances are capped at 64 so strides up to 32 do)
+// towards_positive propagates the values of the voxels with larger x to the ones with smaller x
+static void DirectionalRowPassAVX2(uint8_t* row, int length, bool towards_positive, uint8_t* padded)
+{
+	const int Vectors = (length + 31) / 32;
+	uint8_t* data = padded + ROW_PADDING;
+
+	std::memcpy(data, row, length);
+	std::memset(data + length, 255, Vectors * 32 - length);
+
+	for (int stride = 1; stride <= 32; stride *= 2)
+	{
+		const __m256i Stride = _mm256_set1_epi8((char)stride);
+
+		if (towards_positive)
+		{
+			for (int i = 0; i < Vectors; i++)
+			{
+				const __m256i a = _mm256_loadu_si256((const __m256i*)(data + i * 32));
+				const __m256i b = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(data + i * 32 + stride)), Stride);
+				_mm256_storeu_si256((__m256i*)(data + i * 32), _mm256_min_epu8(a, b));
+			}
+		}
+
+		else
+		{
+			for (int i = Vectors - 1; i >= 0; i--)
+			{
+				const __m256i a = _mm256_loadu_si256((const __m256i*)(data + i * 32));
+				const __m256i b = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(data + i * 32 - stride)), Stride);
+				_mm256_storeu_si256((__m256i*)(data + i * 32), _mm256_min_epu8(a, b));
+			}
+		}
+	}
+
+	std::memcpy(row, data, length);
+}
+
+#endif
+
+// Runs the forward and backward passes along each axis over a linear volume
+// Solid voxels have to be 0 and every other voxel has to hold an upper bound of its distance (the max distance, or the
+// distance of a voxel that is known to be correct) which makes the passes compute the distance to the closest seed.
+// X and Y are split across threads by slices, Z by columns.
+static void RunPasses(uint8_t* volume, const glm::ivec3& size, int thread_count)
+{
+	const size_t SliceSize = (size_t)size.x * size.y;
+
+	// X and Y, a slice at a time
+	VoxelRT::ParallelFor(size.z, thread_count, [&](int z_begin, int z_end)
+	{
+#ifdef __AVX2__
+		std::vector<uint8_t> Padded(ROW_PADDING + ((size.x + 31) / 32) * 32 + ROW_PADDING, 255);
+#endif
+
+		for (int z = z_begin; z < z_end; z++)
+		{
+			uint8_t* slice = volume + (size_t)z * SliceSize;
+
+			for (int y = 0; y < size.y; y++)
+			{
+				uint8_t* row = slice + (size_t)y * size.x;
+
+#ifdef __AVX2__
+				RowPassAVX2(row, size.x, Padded.data());
+#else
+				for (int x = 1; x < size.x; x++)
+				{
+					row[x] = (uint8_t)std::min((int)row[x], row[x - 1] + 1);
+				}
+
+				for (int x = size.x - 2; x >= 0; x--)
+				{
+					row[x] = (uint8_t)std::min((int)row[x], row[x + 1] + 1);
+				}
+#endif
+			}
+
+			for (int y = 1; y < size.y; y++)
+			{
+				uint8_t* row = slice + (size_t)y * size.x;
+				MinWithNeighbour(row, row - size.x, size.x);
+			}
+
+			for (int y = size.y - 2; y >= 0; y--)
+			{
+				uint8_t* row = slice + (size_t)y * size.x;
+				MinWithNeighbour(row, row + size.x, size.x);
+			}
+		}
+	});
+
+	// Z, split into 64 byte wide column ranges
+	const int ColumnBlocks = (int)((SliceSize + 63) / 64);
+
+	VoxelRT::ParallelFor(ColumnBlocks, thread_count, [&](int block_begin, int block_end)
+	{
+		const size_t Begin = (size_t)block_begin * 64;
+		const size_t Count = std::min(SliceSize, (size_t)block_end * 64) - Begin;
+
+		for (int z = 1; z < size.z; z++)
+		{
+			uint8_t* slice = volume + (size_t)z * SliceSize + Begin;
+			MinWithNeighbour(slice, slice - SliceSize, Count);
+		}
+
+		for (int z = size.z - 2; z >= 0; z--)
+		{
+			uint8_t* slice = volume + (size_t)z * SliceSize + Begin;
+			MinWithNeighbour(slice, slice + SliceSize, Count);
+		}
+	});
+}
+
+// Manhattan distance from a voxel to the closest voxel of a box
+static int GetDistanceToBox(const glm::ivec3& p, const VoxelRT::DirtyBox& box)
+{
+	glm::ivec3 d = glm::max(glm::max(box.Min - p, p - (box.Max - glm::ivec3(1))), glm::ivec3(0));
+	return d.x + d.y + d.z;
+}
+
+void VoxelRT::DistanceField::Resize(const glm::ivec3& dimensions, int max_distance)
+{
+	m_Dimensions = dimensions;
+	m_MaxDistance = max_distance > 0 ? std::min(max_distance, ::GetMaxDistance(dimensions)) : ::GetMaxDistance(dimensions);
+	m_Data.assign((size_t)dimensions.x * dimensions.y * dimensions.z, (uint8_t)m_MaxDistance);
+	m_Data.shrink_to_fit();
+	m_Scratch.clear();
+	m_Scratch.shrink_to_fit();
+	m_Valid = false;
+}
+
+void VoxelRT::DistanceField::Generate(const WorldData& data, int thread_count)
+{
+	Generate(data, std::vector<DirtyBox>(), thread_count);
+}
+
+void VoxelRT::DistanceField::Generate(const WorldData& data, const std::vector<DirtyBox>& solid_boxes, int thread_count)
+{
+	if (thread_count <= 0)
+	{
+		thread_count = GetDefaultThreadCount();
+	}
+
+	const OccupancyMask& Occupancy = data.GetOccupancy();
+
+	ParallelFor(m_Dimensions.z, thread_count, [&](int z_begin, int z_end)
+	{
+		for (int z = z_begin; z < z_end; z++)
+		{
+			for (int y = 0; y < m_Dimensions.y; y++)
+			{
+				uint8_t* row = m_Data.data() + GetIndex(0, y, z);
+
+				// Most bricks are either entirely air or entirely solid
+				for (int bx = 0; bx < m_Dimensions.x; bx += BRICK_SIZE)
+				{
+					const int SolidCount = Occupancy.GetSolidCount(bx, y, z);
+
+					if (SolidCount == 0 || SolidCount == BRICK_VOLUME)
+					{
+						std::memset(row + bx, SolidCount ? 0 : m_MaxDistance, BRICK_SIZE);
+						continue;
+					}
+
+					for (int x = bx; x < bx + BRICK_SIZE; x++)
+					{
+						row[x] = Occupancy.IsSolid(x, y, z) ? 0 : (uint8_t)m_MaxDistance;
+					}
+				}
+			}
+		}
+	});
+
+	for (const DirtyBox& box : solid_boxes)
+	{
+		const glm::ivec3 Min = glm::max(box.Min, glm::ivec3(0));
+		const glm::ivec3 Max = glm::min(box.Max, m_Dimensions);
+
+		for (int z = Min.z; z < Max.z; z++)
+		{
+			for (int y = Min.y; y < Max.y && Min.x < Max.x; y++)
+			{
+				std::memset(m_Data.data() + GetIndex(Min.x, y, z), 0, Max.x - Min.x);
+			}
+		}
+	}
+
+	RunPasses(m_Data.data(), m_Dimensions, thread_count);
+	m_Valid = true;
+}
+
+int VoxelRT::DistanceField::GetDefaultThreadCount()
+{
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+bool VoxelRT::DistanceField::Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions, size_t max_volume)
+{
+	updated_regions.clear();
+
+	std::vector<DirtyBox> EditBoxes;
+
+	for (const DirtyBox& box : edits)
+	{
+		DirtyBox clipped = { glm::max(box.Min, glm::ivec3(0)), glm::min(box.Max, m_Dimensions) };
+
+		if (glm::all(glm::lessThan(clipped.Min, clipped.Max)))
+		{
+			EditBoxes.push_back(clipped);
+		}
+	}
+
+	// Every region is seeded by the voxels right outside of it, so regions that touch each other are merged and regrown
+	std::vector<DirtyBox> Regions = EditBoxes;
+	bool Merged = true;
+
+	while (Merged)
+	{
+		for (DirtyBox& region : Regions)
+		{
+			GrowRegion(region, EditBoxes);
+		}
+
+		Merged = false;
+
+		for (int i = 0; i < (int)Regions.size() && !Merged; i++)
+		{
+			for (int j = i + 1; j < (int)Regions.size(); j++)
+			{
+				const DirtyBox& a = Regions[i];
+				const DirtyBox& b = Regions[j];
+
+				if (glm::all(glm::lessThanEqual(a.Min, b.Max)) && glm::all(glm::lessThanEqual(b.Min, a.Max)))
+				{
+					Regions[i] = { glm::min(a.Min, b.Min), glm::max(a.Max, b.Max) };
+					Regions.erase(Regions.begin() + j);
+					Merged = true;
+					break;
+				}
+			}
+		}
+	}
+
+	size_t TotalVolume = 0;
+
+	for (const DirtyBox& region : Regions)
+	{
+		TotalVolume += region.GetVolume();
+	}
+
+	if (TotalVolume > max_volume)
+	{
+		return false;
+	}
+
+	for (const DirtyBox& region : Regions)
+	{
+		RecomputeRegion(data, region);
+		updated_regions.push_back(region);
+	}
+
+	return true;
+}
+
+// An edit at e can only change the distance of a voxel q if the old distance of q is >= |q - e|
+// (a new solid voxel is closer than the old closest one, or e was the closest solid voxel of q)
+// The set of voxels that pass that test is star shaped around e for manhattan paths, so if none of the voxels right
+// outside of a region pass it then no voxel further away can either.
+void VoxelRT::DistanceField::GrowRegion(DirtyBox& region, const std::vector<DirtyBox>& edits) const
+{
+	glm::ivec3 NegativeStep = glm::ivec3(1);
+	glm::ivec3 PositiveStep = glm::ivec3(1);
+
+	// A voxel can only be affected by an edit that is within the max distance of it, the doubling steps would
+	// otherwise overshoot by up to twice that
+	const glm::ivec3 Lower = glm::max(region.Min - glm::ivec3(m_MaxDistance), glm::ivec3(0));
+	const glm::ivec3 Upper = glm::min(region.Max + glm::ivec3(m_MaxDistance), m_Dimensions);
+
+	bool Grew = true;
+
+	while (Grew)
+	{
+		Grew = false;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (region.Min[axis] > Lower[axis] && IsFaceAffected(region, axis, false, edits))
+			{
+				region.Min[axis] = std::max(Lower[axis], region.Min[axis] - NegativeStep[axis]);
+				NegativeStep[axis] *= 2;
+				Grew = true;
+			}
+
+			if (region.Max[axis] < Upper[axis] && IsFaceAffected(region, axis, true, edits))
+			{
+				region.Max[axis] = std::min(Upper[axis], region.Max[axis] + PositiveStep[axis]);
+				PositiveStep[axis] *= 2;
+				Grew = true;
+			}
+		}
+	}
+}
+
+bool VoxelRT::DistanceField::IsFaceAffected(const DirtyBox& region, int axis, bool positive, const std::vector<DirtyBox>& edits) const
+{
+	const int u = (axis + 1) % 3;
+	const int v = (axis + 2) % 3;
+
+	glm::ivec3 p;
+	p[axis] = positive ? region.Max[axis] : region.Min[axis] - 1;
+
+	for (p[v] = region.Min[v]; p[v] < region.Max[v]; p[v]++)
+	{
+		for (p[u] = region.Min[u]; p[u] < region.Max[u]; p[u]++)
+		{
+			const int Distance = m_Data[GetIndex(p)];
+
+			for (const DirtyBox& edit : edits)
+			{
+				if (Distance >= GetDistanceToBox(p, edit))
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void VoxelRT::DistanceField::RecomputeRegion(const WorldData& data, const DirtyBox& region)
+{
+	// The region plus a one voxel border of seeds (clipped to the world)
+	const glm::ivec3 Min = glm::max(region.Min - glm::ivec3(1), glm::ivec3(0));
+	const glm::ivec3 Max = glm::min(region.Max + glm::ivec3(1), m_Dimensions);
+	const glm::ivec3 Size = Max - Min;
+
+	const OccupancyMask& Occupancy = data.GetOccupancy();
+	m_Scratch.resize((size_t)Size.x * Size.y * Size.z);
+
+	for (int z = 0; z < Size.z; z++)
+	{
+		for (int y = 0; y < Size.y; y++)
+		{
+			const int wy = Min.y + y;
+			const int wz = Min.z + z;
+
+			uint8_t* row = m_Scratch.data() + (size_t)y * Size.x + (size_t)z * Size.x * Size.y;
+			std::memcpy(row, m_Data.data() + GetIndex(Min.x, wy, wz), Size.x);
+
+			if (wy < region.Min.y || wy >= region.Max.y || wz < region.Min.z || wz >= region.Max.z)
+			{
+				continue;
+			}
+
+			// Same as Generate(), a brick at a time
+			for (int wx = region.Min.x; wx < region.Max.x;)
+			{
+				const int BrickEnd = std::min((wx & ~(BRICK_SIZE - 1)) + BRICK_SIZE, region.Max.x);
+				const int SolidCount = Occupancy.GetSolidCount(wx, wy, wz);
+				uint8_t* seeds = row + (wx - Min.x);
+
+				if (SolidCount == 0 || SolidCount == BRICK_VOLUME)
+				{
+					std::memset(seeds, SolidCount ? 0 : m_MaxDistance, BrickEnd - wx);
+				}
+
+				else
+				{
+					for (int x = wx; x < BrickEnd; x++)
+					{
+						seeds[x - wx] = Occupancy.IsSolid(x, wy, wz) ? 0 : (uint8_t)m_MaxDistance;
+					}
+				}
+
+				wx = BrickEnd;
+			}
+		}
+	}
+
+	// Threads only pay off for big regions
+	const int ThreadCount = m_Scratch.size() >= (1 << 20) ? GetDefaultThreadCount() : 1;
+	RunPasses(m_Scratch.data(), Size, ThreadCount);
+
+	const glm::ivec3 Offset = region.Min - Min;
+	const glm::ivec3 RegionSize = region.GetSize();
+
+	for (int z = 0; z < RegionSize.z; z++)
+	{
+		for (int y = 0; y < RegionSize.y; y++)
+		{
+			const uint8_t* row = m_Scratch.data() + (size_t)Offset.x + (size_t)(Offset.y + y) * Size.x + (size_t)(Offset.z + z) * Size.x * Size.y;
+			std::memcpy(m_Data.data() + GetIndex(region.Min.x, region.Min.y + y, region.Min.z + z), row, RegionSize.x);
+		}
+	}
+}
+
+void VoxelRT::DistanceField::Shift(const glm::ivec3& delta)
+{
+	// Rows are moved in place, in the order that never overwrites a row that still has to be read
+	const glm::ivec3 Step = glm::ivec3(1, delta.y < 0 ? -1 : 1, delta.z < 0 ? -1 : 1);
+	const glm::ivec3 First = glm::ivec3(0, Step.y < 0 ? m_Dimensions.y - 1 : 0, Step.z < 0 ? m_Dimensions.z - 1 : 0);
+	const int CopyX = std::max(m_Dimensions.x - std::abs(delta.x), 0);
+	const int DestinationX = std::max(-delta.x, 0);
+
+	for (int i = 0, z = First.z; i < m_Dimensions.z; i++, z += Step.z)
+	{
+		for (int j = 0, y = First.y; j < m_Dimensions.y; j++, y += Step.y)
+		{
+			uint8_t* Row = m_Data.data() + GetIndex(0, y, z);
+			const int SourceY = y + delta.y;
+			const int SourceZ = z + delta.z;
+
+			if (SourceY < 0 || SourceZ < 0 || SourceY >= m_Dimensions.y || SourceZ >= m_Dimensions.z || CopyX == 0)
+			{
+				std::memset(Row, m_MaxDistance, m_Dimensions.x);
+				continue;
+			}
+
+			std::memmove(Row + DestinationX, m_Data.data() + GetIndex(std::max(delta.x, 0), SourceY, SourceZ), CopyX);
+			std::memset(Row, m_MaxDistance, DestinationX);
+			std::memset(Row + DestinationX + CopyX, m_MaxDistance, m_Dimensions.x - DestinationX - CopyX);
+		}
+	}
+}
+
+void VoxelRT::DistanceField::ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			std::memcpy(output + (size_t)y * size.x + (size_t)z * size.x * size.y, m_Data.data() + GetIndex(origin.x, origin.y + y, origin.z + z), size.x);
+		}
+	}
+}
+
+size_t VoxelRT::DistanceField::GetMemoryUsage() const noexcept
+{
+	return m_Data.capacity() + m_Scratch.capacity();
+}
+
+// Distances of the 4 bit codes of the directional field, finer close to surfaces (same table as the shaders)
+static const int DIRECTIONAL_DISTANCES[16] = { 0, 1, 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 48, 64 };
+
+// Code of each distance, the largest code that doesn't stand for more than it
+static const std::array<uint8_t, 256>& GetDirectionalCodes()
+{
+	static const std::array<uint8_t, 256> Codes = []()
+	{
+		std::array<uint8_t, 256> codes = {};
+
+		for (int d = 0, code = 0; d < 256; d++)
+		{
+			while (code < 15 && DIRECTIONAL_DISTANCES[code + 1] <= d)
+			{
+				code++;
+			}
+
+			codes[d] = (uint8_t)code;
+		}
+
+		return codes;
+	}();
+
+	return Codes;
+}
+
+// codes[i] = code of distances[i] (distances are at most 64)
+static void EncodeDirectionalRow(const uint8_t* distances, uint8_t* codes, int count)
+{
+	int i = 0;
+
+#ifdef __AVX2__
+	// Below 16 the code is a lookup of the distance, above it a lookup of distance / 4 (the distances of the codes are
+	// multiples of 4 from there) except for 64 which is one code past 48
+	const __m256i Low = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9, 9, 9, 9, 0, 1, 2, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9, 9, 9, 9);
+	const __m256i High = _mm256_setr_epi8(0, 0, 0, 0, 10, 11, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 0, 0, 0, 0, 10, 11, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14);
+	const __m256i Fifteen = _mm256_set1_epi8(15);
+	const __m256i SixtyFour = _mm256_set1_epi8(64);
+	const __m256i Mask = _mm256_set1_epi8(0x3F);
+
+	for (; i + 32 <= count; i += 32)
+	{
+		const __m256i d = _mm256_loadu_si256((const __m256i*)(distances + i));
+		const __m256i Quarter = _mm256_min_epu8(_mm256_and_si256(_mm256_srli_epi16(d, 2), Mask), Fifteen);
+
+		__m256i Code = _mm256_blendv_epi8(_mm256_shuffle_epi8(Low, d), _mm256_shuffle_epi8(High, Quarter), _mm256_cmpgt_epi8(d, Fifteen));
+		Code = _mm256_sub_epi8(Code, _mm256_cmpeq_epi8(d, SixtyFour));
+		_mm256_storeu_si256((__m256i*)(codes + i), Code);
+	}
+#endif
+
+	const std::array<uint8_t, 256>& Codes = GetDirectionalCodes();
+
+	for (; i < count; i++)
+	{
+		codes[i] = Codes[distances[i]];
+	}
+}
+
+// Replaces the low (or high) nibbles of output[begin, end) with the codes
+static void WriteDirectionalNibbles(uint8_t* output, const uint8_t* codes, int begin, int end, bool high)
+{
+	int i = begin;
+
+#ifdef __AVX2__
+	const __m256i Keep = _mm256_set1_epi8(high ? 0x0F : (char)0xF0);
+
+	for (; i + 32 <= end; i += 32)
+	{
+		__m256i Code = _mm256_loadu_si256((const __m256i*)(codes + i));
+		Code = high ? _mm256_slli_epi16(Code, 4) : Code;
+
+		const __m256i Old = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(output + i)), Keep);
+		_mm256_storeu_si256((__m256i*)(output + i), _mm256_or_si256(Old, Code));
+	}
+#endif
+
+	for (; i < end; i++)
+	{
+		output[i] = high ? (uint8_t)((output[i] & 0x0F) | (codes[i] << 4)) : (uint8_t)((output[i] & 0xF0) | codes[i]);
+	}
+}
+
+int VoxelRT::DirectionalDistanceField::GetDistance(int code) noexcept
+{
+	return DIRECTIONAL_DISTANCES[code & 0xF];
+}
+
+void VoxelRT::DirectionalDistanceField::Resize(const glm::ivec3& dimensions)
+{
+	m_Dimensions = dimensions;
+	m_Volume = (size_t)dimensions.x * dimensions.y * dimensions.z;
+	m_Data.assign(m_Volume * 4, 0);
+	m_Data.shrink_to_fit();
+	m_Scratch.clear();
+	m_Scratch.shrink_to_fit();
+	m_Valid = false;
+}
+
+void VoxelRT::DirectionalDistanceField::Generate(const WorldData& data, int thread_count)
+{
+	if (thread_count <= 0)
+	{
+		thread_count = DistanceField::GetDefaultThreadCount();
+	}
+
+	ComputeWindow(data, { glm::ivec3(0), m_Dimensions }, nullptr, thread_count);
+	m_Valid = true;
+
+	// Twice the size of the world, the updates only need a fraction of it
+	m_Scratch.clear();
+	m_Scratch.shrink_to_fit();
+}
+
+bool VoxelRT::DirectionalDistanceField::Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions, size_t max_volume)
+{
+	updated_regions.clear();
+
+	// An edit can only change the voxels within MAX_DISTANCE of it, and those only depend on the voxels within
+	// MAX_DISTANCE of themselves in their octant, which is inside of the edit box grown by MAX_DISTANCE
+	std::vector<DirtyBox> EditBoxes;
+	std::vector<DirtyBox> Windows;
+	size_t TotalVolume = 0;
+
+	for (const DirtyBox& box : edits)
+	{
+		DirtyBox Edit = { glm::max(box.Min, glm::ivec3(0)), glm::min(box.Max, m_Dimensions) };
+
+		if (!glm::all(glm::lessThan(Edit.Min, Edit.Max)))
+		{
+			continue;
+		}
+
+		DirtyBox Window = { glm::max(Edit.Min - glm::ivec3(MAX_DISTANCE), glm::ivec3(0)), glm::min(Edit.Max + glm::ivec3(MAX_DISTANCE), m_Dimensions) };
+		TotalVolume += Window.GetVolume();
+		EditBoxes.push_back(Edit);
+		Windows.push_back(Window);
+	}
+
+	if (TotalVolume > max_volume)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < (int)Windows.size(); i++)
+	{
+		// Threads only pay off for big windows
+		const int ThreadCount = Windows[i].GetVolume() >= (1 << 20) ? DistanceField::GetDefaultThreadCount() : 1;
+		ComputeWindow(data, Windows[i], &EditBoxes[i], ThreadCount);
+		updated_regions.push_back(Windows[i]);
+	}
+
+	return true;
+}
+
+void VoxelRT::DirectionalDistanceField::ComputeWindow(const WorldData& data, const DirtyBox& window, const DirtyBox* edit, int thread_count)
+{
+	const OccupancyMask& Occupancy = data.GetOccupancy();
+	const glm::ivec3 Size = window.GetSize();
+	const size_t SliceSize = (size_t)Size.x * Size.y;
+	const size_t Volume = SliceSize * Size.z;
+
+	// The x pass only depends on the sign of x, it's done once for the whole window (one copy per sign) and shared by
+	// the 4 channels. Index 0 is the positive octant (the voxels with the larger coordinates, which propagate towards
+	// the smaller ones), it goes to the low nibble
+	m_Scratch.resize(Volume * 2);
+
+	ParallelFor(Size.z, thread_count, [&](int z_begin, int z_end)
+	{
+#ifdef __AVX2__
+		std::vector<uint8_t> Padded(ROW_PADDING + ((Size.x + 31) / 32) * 32 + ROW_PADDING, 255);
+#endif
+
+		for (int z = z_begin; z < z_end; z++)
+		{
+			for (int y = 0; y < Size.y; y++)
+			{
+				uint8_t* row = m_Scratch.data() + (size_t)y * Size.x + (size_t)z * SliceSize;
+				uint8_t* negative_row = row + Volume;
+				const int wy = window.Min.y + y;
+				const int wz = window.Min.z + z;
+
+				// Most bricks are either entirely air or entirely solid
+				for (int wx = window.Min.x; wx < window.Max.x;)
+				{
+					const int End = std::min((wx & ~BRICK_MASK) + BRICK_SIZE, window.Max.x);
+					const int SolidCount = Occupancy.GetSolidCount(wx, wy, wz);
+
+					if (SolidCount == 0 || SolidCount == BRICK_VOLUME)
+					{
+						std::memset(row + (wx - window.Min.x), SolidCount ? 0 : MAX_DISTANCE, End - wx);
+					}
+
+					else
+					{
+						for (int x = wx; x < End; x++)
+						{
+							row[x - window.Min.x] = Occupancy.IsSolid(x, wy, wz) ? 0 : MAX_DISTANCE;
+						}
+					}
+
+					wx = End;
+				}
+
+				std::memcpy(negative_row, row, Size.x);
+
+#ifdef __AVX2__
+				DirectionalRowPassAVX2(row, Size.x, true, Padded.data());
+				DirectionalRowPassAVX2(negative_row, Size.x, false, Padded.data());
+#else
+				for (int x = Size.x - 2; x >= 0; x--)
+				{
+					row[x] = (uint8_t)std::min((int)row[x], row[x + 1] + 1);
+				}
+
+				for (int x = 1; x < Size.x; x++)
+				{
+					negative_row[x] = (uint8_t)std::min((int)negative_row[x], negative_row[x - 1] + 1);
+				}
+#endif
+			}
+		}
+	});
+
+	// A channel holds the two octants that only differ by the sign of x, so no two threads ever write the same byte
+	ParallelFor(4, thread_count, [&](int channel_begin, int channel_end)
+	{
+		std::vector<uint8_t> Current[2] = { std::vector<uint8_t>(SliceSize), std::vector<uint8_t>(SliceSize) };
+		std::vector<uint8_t> Previous[2] = { std::vector<uint8_t>(SliceSize), std::vector<uint8_t>(SliceSize) };
+		std::vector<uint8_t> RowCodes[2] = { std::vector<uint8_t>(Size.x), std::vector<uint8_t>(Size.x) };
+
+		for (int channel = channel_begin; channel < channel_end; channel++)
+		{
+			const bool PositiveY = (channel & 1) == 0;
+			const bool PositiveZ = (channel & 2) == 0;
+
+			// Voxels to write (window space) : the ones whose octant contains part of the edit box, within MAX_DISTANCE
+			glm::ivec3 WriteMin[2] = { glm::ivec3(0), glm::ivec3(0) };
+			glm::ivec3 WriteMax[2] = { Size, Size };
+
+			if (edit)
+			{
+				for (int s = 0; s < 2; s++)
+				{
+					const glm::bvec3 Positive(s == 0, PositiveY, PositiveZ);
+
+					for (int axis = 0; axis < 3; axis++)
+					{
+						const int Min = Positive[axis] ? edit->Min[axis] - MAX_DISTANCE : edit->Min[axis];
+						const int Max = Positive[axis] ? edit->Max[axis] : edit->Max[axis] + MAX_DISTANCE;
+						WriteMin[s][axis] = std::max(Min - window.Min[axis], 0);
+						WriteMax[s][axis] = std::min(Max - window.Min[axis], Size[axis]);
+					}
+				}
+			}
+
+			uint8_t* Plane = m_Data.data() + (size_t)channel * m_Volume;
+
+			// Z is a serial dependency from slice to slice, the y pass is done on each slice as it comes
+			for (int i = 0; i < Size.z; i++)
+			{
+				const int z = PositiveZ ? Size.z - 1 - i : i;
+
+				for (int s = 0; s < 2; s++)
+				{
+					uint8_t* slice = Current[s].data();
+					std::memcpy(slice, m_Scratch.data() + Volume * s + (size_t)z * SliceSize, SliceSize);
+
+					if (PositiveY)
+					{
+						for (int y = Size.y - 2; y >= 0; y--)
+						{
+							MinWithNeighbour(slice + (size_t)y * Size.x, slice + (size_t)(y + 1) * Size.x, Size.x);
+						}
+					}
+
+					else
+					{
+						for (int y = 1; y < Size.y; y++)
+						{
+							MinWithNeighbour(slice + (size_t)y * Size.x, slice + (size_t)(y - 1) * Size.x, Size.x);
+						}
+					}
+
+					if (i > 0)
+					{
+						MinWithNeighbour(slice, Previous[s].data(), SliceSize);
+					}
+				}
+
+				// The y and z ranges only depend on the y and z signs, which both octants of the channel share
+				if (z >= WriteMin[0].z && z < WriteMax[0].z)
+				{
+					for (int y = WriteMin[0].y; y < WriteMax[0].y; y++)
+					{
+						uint8_t* out = Plane + GetIndex(window.Min.x, window.Min.y + y, window.Min.z + z);
+
+						EncodeDirectionalRow(Current[0].data() + (size_t)y * Size.x, RowCodes[0].data(), Size.x);
+						EncodeDirectionalRow(Current[1].data() + (size_t)y * Size.x, RowCodes[1].data(), Size.x);
+						WriteDirectionalNibbles(out, RowCodes[0].data(), WriteMin[0].x, WriteMax[0].x, false);
+						WriteDirectionalNibbles(out, RowCodes[1].data(), WriteMin[1].x, WriteMax[1].x, true);
+					}
+				}
+
+				std::swap(Current[0], Previous[0]);
+				std::swap(Current[1], Previous[1]);
+			}
+		}
+	});
+}
+
+void VoxelRT::DirectionalDistanceField::ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			const size_t Index = GetIndex(origin.x, origin.y + y, origin.z + z);
+			uint8_t* out = output + ((size_t)y * size.x + (size_t)z * size.x * size.y) * 4;
+
+			for (int x = 0; x < size.x; x++)
+			{
+				out[x * 4 + 0] = m_Data[Index + x];
+				out[x * 4 + 1] = m_Data[m_Volume + Index + x];
+				out[x * 4 + 2] = m_Data[m_Volume * 2 + Index + x];
+				out[x * 4 + 3] = m_Data[m_Volume * 3 + Index + x];
+			}
+		}
+	}
+}
+
+size_t VoxelRT::DirectionalDistanceField::GetMemoryUsage() const noexcept
+{
+	return m_Data.capacity() + m_Scratch.capacity();
+}
+
+VoxelRT::DistanceFieldTrace VoxelRT::TraceDistanceField(const DistanceField& field, const DirectionalDistanceField* directional, glm::vec3 origin, const glm::vec3& direction, int max_steps)
+{
+	DistanceFieldTrace Trace;
+
+	const glm::ivec3& Dimensions = field.GetDimensions();
+	const glm::ivec3 RaySign = glm::ivec3(glm::sign(direction));
+	const int Octant = DirectionalDistanceField::GetOctant(direction);
+	const float InverseLength = 1.0f / (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+
+	while (Trace.Steps < max_steps)
+	{
+		Trace.Steps++;
+
+		const glm::ivec3 Loc = glm::ivec3(glm::floor(origin));
+
+		if (glm::any(glm::lessThan(Loc, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Loc, Dimensions)))
+		{
+			break;
+		}
+
+		const float Dist = field.Get(Loc.x, Loc.y, Loc.z);
+		const int Euclidean = (int)std::floor(Dist == 1.0f ? 1.0f : Dist * 0.57735026918f);
+
+		if (directional)
+		{
+			// Every voxel the ray crosses within t is closer than |t * direction|1 + 3 (it can start anywhere in its voxel)
+			const float Step = (directional->Get(Loc.x, Loc.y, Loc.z, Octant) - 3) * InverseLength;
+
+			if (Step >= 1.0f && Step > Euclidean - 1)
+			{
+				origin += Step * direction;
+				continue;
+			}
+		}
+
+		if (Euclidean == 0)
+		{
+			Trace.Position = Loc;
+			Trace.Hit = true;
+			break;
+		}
+
+		if (Euclidean == 1)
+		{
+			// One voxel of DDA
+			glm::ivec3 GridCoords = glm::ivec3(origin);
+			glm::vec3 WithinVoxelCoords = origin - glm::vec3(GridCoords);
+			const glm::vec3 DistanceFactor = (glm::vec3((1 + RaySign) >> 1) - WithinVoxelCoords) * (1.0f / direction);
+
+			const int MinIdx = DistanceFactor.x < DistanceFactor.y && RaySign.x != 0
+				? (DistanceFactor.x < DistanceFactor.z || RaySign.z == 0 ? 0 : 2)
+				: (DistanceFactor.y < DistanceFactor.z || RaySign.z == 0 ? 1 : 2);
+
+			GridCoords[MinIdx] += RaySign[MinIdx];
+			WithinVoxelCoords += direction * DistanceFactor[MinIdx];
+			WithinVoxelCoords[MinIdx] = (float)(1 - ((1 + RaySign) >> 1)[MinIdx]);
+
+			origin = glm::vec3(GridCoords) + WithinVoxelCoords;
+			origin[MinIdx] += RaySign[MinIdx] * 0.0001f;
+		}
+
+		else
+		{
+			origin += (float)(Euclidean - 1) * direction;
+		}
+	}
+
+	return Trace;
+}
+
+VoxelRT::DistanceFieldStepStats VoxelRT::MeasureDistanceFieldSteps(const WorldData& data, const DistanceField& field, const DirectionalDistanceField& directional, int count, uint32_t seed)
+{
+	DistanceFieldStepStats Stats;
+
+	const glm::ivec3& Dimensions = data.GetDimensions();
+	const int MaxSteps = Dimensions.x + Dimensions.y + Dimensions.z;
+
+	std::mt19937 Generator(seed);
+	std::uniform_real_distribution<float> Random(0.0f, 1.0f);
+
+	size_t Steps = 0;
+	size_t DirectionalSteps = 0;
+
+	for (int attempt = 0; Stats.Rays < count && attempt < count * 16; attempt++)
+	{
+		const int x = (int)(Random(Generator) * Dimensions.x) % Dimensions.x;
+		const int z = (int)(Random(Generator) * Dimensions.z) % Dimensions.z;
+
+		// Topmost solid voxel of the column
+		int y = Dimensions.y - 2;
+
+		while (y >= 0 && !data.IsSolid(x, y, z))
+		{
+			y--;
+		}
+
+		if (y < 0)
+		{
+			continue;
+		}
+
+		// Cosine weighted direction around +y
+		const float u = Random(Generator);
+		const float Angle = 6.28318530718f * Random(Generator);
+		const float Radius = std::sqrt(u);
+		const glm::vec3 Direction = glm::vec3(Radius * std::cos(Angle), std::sqrt(1.0f - u), Radius * std::sin(Angle));
+		const glm::vec3 Origin = glm::vec3(x + Random(Generator), y + 1.001f, z + Random(Generator));
+
+		const DistanceFieldTrace A = TraceDistanceField(field, nullptr, Origin, Direction, MaxSteps);
+		const DistanceFieldTrace B = TraceDistanceField(field, &directional, Origin, Direction, MaxSteps);
+
+		Steps += A.Steps;
+		DirectionalSteps += B.Steps;
+		Stats.MaxSteps = std::max(Stats.MaxSteps, A.Steps);
+		Stats.MaxDirectionalSteps = std::max(Stats.MaxDirectionalSteps, B.Steps);
+		Stats.Mismatches += A.Hit != B.Hit || A.Position != B.Position;
+		Stats.Rays++;
+	}
+
+	if (Stats.Rays > 0)
+	{
+		Stats.AverageSteps = (double)Steps / Stats.Rays;
+		Stats.AverageDirectionalSteps = (double)DirectionalSteps / Stats.Rays;
+	}
+
+	return Stats;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+#include "DirtyRegion.h"
+
+namespace VoxelRT
+{
+	// Cpu side copy of the manhattan distance field (distance to the closest solid voxel, capped)
+	// Stored in the same linear (x + y * X + z * X * Y) layout as the distance field texture.
+	//
+	// Generate() is a reference implementation of the X/Y/Z passes done by the ManhattanDistance compute shaders and
+	// Update() recomputes only the part of the field that a set of edits can affect, both produce the exact same values
+	// as a full regeneration.
+
+	class DistanceField
+	{
+	public :
+
+		// Distances are capped at max_distance, <= 0 uses the cap of the ManhattanDistance shaders
+		// A lower cap means more steps through open space but edits affect a smaller part of the field
+		void Resize(const glm::ivec3& dimensions, int max_distance = 0);
+
+		// Full regeneration, thread_count <= 0 uses every core
+		// Doesn't need a gpu, so it can be used for headless tools and the save file cache as well
+		void Generate(const WorldData& data, int thread_count = 0);
+
+		// Same as Generate() with the boxes (max exclusive) counted as solid on top of the voxels of the world
+		// For a world whose voxels aren't all there yet (see LazyWorldLoader) : as long as the voxels that are missing are
+		// inside the boxes the distances are never larger than the real ones, and filling the boxes in only needs Update()
+		void Generate(const WorldData& data, const std::vector<DirtyBox>& solid_boxes, int thread_count = 0);
+
+		static int GetDefaultThreadCount();
+
+		// Recomputes the distances the voxels in the edit boxes can change
+		// The boxes that were rewritten (and have to be uploaded) are written to updated_regions
+		// Returns false without modifying the field if more than max_volume voxels would have to be recomputed
+		bool Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions, size_t max_volume = SIZE_MAX);
+
+		// Moves the field along with a streamed world (see WorldData::ShiftChunks(), delta is in voxels) : voxel p takes
+		// the distance of voxel p + delta and the voxels that come from outside are set to the max distance.
+		// The voxels that came in and the ones next to the side the field moved away from are stale until they go
+		// through Update() (see World::ShiftWindow())
+		void Shift(const glm::ivec3& delta);
+
+		inline uint8_t Get(int x, int y, int z) const noexcept
+		{
+			return m_Data[GetIndex(x, y, z)];
+		}
+
+		inline uint8_t* GetData() noexcept { return m_Data.data(); }
+		inline const std::vector<uint8_t>& GetVector() const noexcept { return m_Data; }
+		inline int GetMaxDistance() const noexcept { return m_MaxDistance; }
+		inline const glm::ivec3& GetDimensions() const noexcept { return m_Dimensions; }
+		inline size_t GetVolume() const noexcept { return m_Data.size(); }
+
+		// Whether the field matches the world (it was generated, or loaded along with it)
+		inline bool IsValid() const noexcept { return m_Valid; }
+		inline void SetValid(bool valid) noexcept { m_Valid = valid; }
+
+		// Copies a box to a linear (x + y * size.x + z * size.x * size.y) buffer
+		void ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const;
+
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		inline size_t GetIndex(int x, int y, int z) const noexcept
+		{
+			return (size_t)x + (size_t)y * m_Dimensions.x + (size_t)z * m_Dimensions.x * m_Dimensions.y;
+		}
+
+		inline size_t GetIndex(const glm::ivec3& p) const noexcept
+		{
+			return GetIndex(p.x, p.y, p.z);
+		}
+
+		// Grows the region until no voxel right outside of it can be affected by the edits
+		void GrowRegion(DirtyBox& region, const std::vector<DirtyBox>& edits) const;
+		bool IsFaceAffected(const DirtyBox& region, int axis, bool positive, const std::vector<DirtyBox>& edits) const;
+
+		// Recomputes the region, seeded by the (unchanged) voxels around it
+		void RecomputeRegion(const WorldData& data, const DirtyBox& region);
+
+		glm::ivec3 m_Dimensions = glm::ivec3(0);
+		int m_MaxDistance = 0;
+		bool m_Valid = false;
+		std::vector<uint8_t> m_Data;
+		std::vector<uint8_t> m_Scratch;
+	};
+
+	// Anisotropic companion of the manhattan field : for each of the 8 octants a ray can go towards, the manhattan
+	// distance to the closest solid voxel inside of that octant (the voxels q where q - p has the sign of the direction,
+	// or 0, on every axis). A ray only ever crosses voxels of its own octant, so it can move (distance - 3) / |direction|1
+	// in one step. Rays that leave a surface (sky, shadow and reflection rays) only see what is in front of them instead
+	// of the surface they started from, and take much longer steps than the isotropic field allows.
+	//
+	// The distances are capped at MAX_DISTANCE and rounded down to one of 16 values (GetDistance()), the 8 octants fit
+	// in one RGBA8UI texel : octant = (x < 0) | (y < 0) << 1 | (z < 0) << 2, the channel is octant >> 1 and the nibble
+	// octant & 1. The cpu copy is stored as 4 planes of one channel each, ReadRegion() interleaves them.
+	// The traversals take the longest step either field allows, the manhattan field still covers the long distances.
+	// The primary trace doesn't read it, camera rays rarely graze surfaces and the second fetch per step costs more
+	// than the few steps it saves them. Shaders have to be compiled with VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD defined to read it.
+
+	class DirectionalDistanceField
+	{
+	public :
+
+		static constexpr int MAX_DISTANCE = 64;
+
+		// u_DirectionalDistanceField, after the packed voxel volume
+		static constexpr int TEXTURE_UNIT = 33;
+
+		// Distance a 4 bit code stands for (same table as the shaders)
+		static int GetDistance(int code) noexcept;
+
+		static inline int GetOctant(const glm::vec3& direction) noexcept
+		{
+			return (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 4 : 0);
+		}
+
+		void Resize(const glm::ivec3& dimensions);
+
+		// Full regeneration, thread_count <= 0 uses every core (4 at most, one per channel)
+		void Generate(const WorldData& data, int thread_count = 0);
+
+		// Recomputes the voxels within MAX_DISTANCE of the edit boxes, from the occupancy of the voxels within
+		// MAX_DISTANCE of them. Same contract as DistanceField::Update()
+		bool Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions, size_t max_volume = SIZE_MAX);
+
+		// Capped and rounded down manhattan distance
+		inline int Get(int x, int y, int z, int octant) const noexcept
+		{
+			const uint8_t Texel = m_Data[(size_t)(octant >> 1) * m_Volume + GetIndex(x, y, z)];
+			return GetDistance((octant & 1) ? Texel >> 4 : Texel & 0xF);
+		}
+
+		// Copies a box to a linear buffer of RGBA texels (4 bytes per voxel)
+		void ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const;
+
+		inline bool IsValid() const noexcept { return m_Valid; }
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		inline size_t GetIndex(int x, int y, int z) const noexcept
+		{
+			return (size_t)x + (size_t)y * m_Dimensions.x + (size_t)z * m_Dimensions.x * m_Dimensions.y;
+		}
+
+		// Runs the passes over the window (outside of it counts as empty) and writes the voxels whose octant contains
+		// voxels of the edit box. Every voxel of the window is written if edit is null
+		void ComputeWindow(const WorldData& data, const DirtyBox& window, const DirtyBox* edit, int thread_count);
+
+		glm::ivec3 m_Dimensions = glm::ivec3(0);
+		size_t m_Volume = 0;
+		bool m_Valid = false;
+		std::vector<uint8_t> m_Data; // 4 planes, one per channel
+		std::vector<uint8_t> m_Scratch; // The window after the x pass, once per sign of x
+	};
+
+	struct DistanceFieldTrace
+	{
+		glm::ivec3 Position = glm::ivec3(-1); // The solid voxel that was hit
+		int Steps = 0; // Iterations of the traversal loop
+		bool Hit = false;
+	};
+
+	// Cpu reference of the distance field traversal of the trace shaders (VoxelTraversalDF), it takes the same steps
+	// and needs the same number of iterations. The directional field is used when it isn't null.
+	DistanceFieldTrace TraceDistanceField(const DistanceField& field, const DirectionalDistanceField* directional, glm::vec3 origin, const glm::vec3& direction, int max_steps);
+
+	struct DistanceFieldStepStats
+	{
+		int Rays = 0;
+		double AverageSteps = 0.0; // Manhattan field only
+		double AverageDirectionalSteps = 0.0;
+		int MaxSteps = 0;
+		int MaxDirectionalSteps = 0;
+		int Mismatches = 0; // Rays that didn't hit the same voxel with both
+	};
+
+	// Traces count rays leaving random surface voxels towards the upper hemisphere (like sky, shadow and reflection
+	// rays) with and without the directional field
+	DistanceFieldStepStats MeasureDistanceFieldSteps(const WorldData& data, const DistanceField& field, const DirectionalDistanceField& directional, int count, uint32_t seed = 1);
+}
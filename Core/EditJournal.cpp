@@ -0,0 +1,308 @@
+#include "EditJournal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "World.h"
+#include "WorldEdit.h"
+
+static const char EDIT_LOG_MAGIC[4] = { 'V', 'R', 'T', 'J' };
+static const uint32_t EDIT_LOG_VERSION = 1;
+
+VoxelRT::EditJournal::~EditJournal()
+{
+	CloseLog();
+}
+
+void VoxelRT::EditJournal::SetMemoryBudget(size_t bytes)
+{
+	m_MemoryBudget = bytes;
+	TrimToBudget();
+}
+
+void VoxelRT::EditJournal::BeginTransaction()
+{
+	m_TransactionDepth++;
+}
+
+void VoxelRT::EditJournal::EndTransaction()
+{
+	if (m_TransactionDepth == 0 || --m_TransactionDepth > 0)
+	{
+		return;
+	}
+
+	if (m_Current.Runs.empty())
+	{
+		return;
+	}
+
+	EditTransaction Transaction = std::move(m_Current);
+	m_Current = EditTransaction();
+	Transaction.Runs.shrink_to_fit();
+
+	WriteLog(Transaction, true);
+
+	// A new edit makes the undone transactions unreachable
+	for (const EditTransaction& e : m_Redo)
+	{
+		m_MemoryUsage -= e.GetMemoryUsage();
+	}
+
+	m_Redo.clear();
+	m_MemoryUsage += Transaction.GetMemoryUsage();
+	m_Undo.push_back(std::move(Transaction));
+	TrimToBudget();
+}
+
+void VoxelRT::EditJournal::Record(uint32_t index, Block old_block, BlockState old_state, Block new_block, BlockState new_state)
+{
+	if (!IsRecording() || (old_block.block == new_block.block && old_state == new_state))
+	{
+		return;
+	}
+
+	const bool Standalone = m_TransactionDepth == 0;
+
+	if (Standalone)
+	{
+		BeginTransaction();
+	}
+
+	std::vector<EditRun>& Runs = m_Current.Runs;
+
+	if (!Runs.empty())
+	{
+		EditRun& Last = Runs.back();
+
+		if (Last.Start + Last.Length == index && Last.OldBlock == old_block.block && Last.NewBlock == new_block.block &&
+			Last.OldState == old_state && Last.NewState == new_state)
+		{
+			Last.Length++;
+			m_Current.Voxels++;
+
+			if (Standalone)
+			{
+				EndTransaction();
+			}
+
+			return;
+		}
+	}
+
+	Runs.push_back({ index, 1, old_block.block, new_block.block, old_state, new_state });
+	m_Current.Voxels++;
+
+	if (Standalone)
+	{
+		EndTransaction();
+	}
+}
+
+bool VoxelRT::EditJournal::Undo(World* world)
+{
+	if (m_Undo.empty() || m_TransactionDepth > 0)
+	{
+		return false;
+	}
+
+	EditTransaction Transaction = std::move(m_Undo.back());
+	m_Undo.pop_back();
+
+	Apply(world, Transaction, false);
+	WriteLog(Transaction, false);
+	m_Redo.push_back(std::move(Transaction));
+	return true;
+}
+
+bool VoxelRT::EditJournal::Redo(World* world)
+{
+	if (m_Redo.empty() || m_TransactionDepth > 0)
+	{
+		return false;
+	}
+
+	EditTransaction Transaction = std::move(m_Redo.back());
+	m_Redo.pop_back();
+
+	Apply(world, Transaction, true);
+	WriteLog(Transaction, true);
+	m_Undo.push_back(std::move(Transaction));
+	return true;
+}
+
+void VoxelRT::EditJournal::Clear()
+{
+	m_Undo.clear();
+	m_Redo.clear();
+	m_Current = EditTransaction();
+	m_TransactionDepth = 0;
+	m_MemoryUsage = 0;
+}
+
+void VoxelRT::EditJournal::Apply(World* world, const EditTransaction& transaction, bool forward)
+{
+	const glm::ivec3& Dimensions = world->GetDimensions();
+	const size_t RunCount = transaction.Runs.size();
+
+	m_Replaying = true;
+
+	{
+		WorldEdit Edit(world);
+
+		// Undo walks the runs backwards so that voxels written more than once end up with their oldest value
+		for (size_t r = 0; r < RunCount; r++)
+		{
+			const EditRun& Run = transaction.Runs[forward ? r : RunCount - 1 - r];
+			const Block Value = { forward ? Run.NewBlock : Run.OldBlock };
+			const BlockState State = forward ? Run.NewState : Run.OldState;
+			const uint32_t End = Run.Start + Run.Length;
+
+			// Runs can wrap around to the next rows, write them one row segment at a time
+			for (uint32_t i = Run.Start; i < End;)
+			{
+				const glm::ivec3 p = glm::ivec3(i % Dimensions.x, (i / Dimensions.x) % Dimensions.y, i / (Dimensions.x * Dimensions.y));
+				const int Length = (int)std::min<uint32_t>(End - i, (uint32_t)(Dimensions.x - p.x));
+
+				Edit.FillBox(p, p + glm::ivec3(Length, 1, 1), Value, State);
+				i += Length;
+			}
+		}
+
+		Edit.Commit();
+	}
+
+	m_Replaying = false;
+}
+
+void VoxelRT::EditJournal::TrimToBudget()
+{
+	while (m_MemoryUsage > m_MemoryBudget && !m_Undo.empty())
+	{
+		m_MemoryUsage -= m_Undo.front().GetMemoryUsage();
+		m_Undo.pop_front();
+	}
+
+	// Only if the budget was lowered below what the redo history alone takes
+	while (m_MemoryUsage > m_MemoryBudget && !m_Redo.empty())
+	{
+		m_MemoryUsage -= m_Redo.front().GetMemoryUsage();
+		m_Redo.erase(m_Redo.begin());
+	}
+}
+
+bool VoxelRT::EditJournal::OpenLog(const std::string& path, const glm::ivec3& dimensions)
+{
+	CloseLog();
+
+	m_Log = fopen(path.c_str(), "wb");
+
+	if (!m_Log)
+	{
+		std::cout << "\nCouldn't open the edit log " << path << "\n";
+		return false;
+	}
+
+	const int32_t Size[3] = { dimensions.x, dimensions.y, dimensions.z };
+	fwrite(EDIT_LOG_MAGIC, 1, 4, m_Log);
+	fwrite(&EDIT_LOG_VERSION, sizeof(uint32_t), 1, m_Log);
+	fwrite(Size, sizeof(int32_t), 3, m_Log);
+	fflush(m_Log);
+	return true;
+}
+
+void VoxelRT::EditJournal::CloseLog()
+{
+	if (m_Log)
+	{
+		fclose(m_Log);
+		m_Log = nullptr;
+	}
+}
+
+void VoxelRT::EditJournal::WriteLog(const EditTransaction& transaction, bool forward)
+{
+	if (!m_Log)
+	{
+		return;
+	}
+
+	// The log only stores forward transactions, an undo is written as the transaction that reverts it
+	const EditRun* Runs = transaction.Runs.data();
+	const uint32_t Count = (uint32_t)transaction.Runs.size();
+
+	if (!forward)
+	{
+		m_LogBuffer.assign(transaction.Runs.rbegin(), transaction.Runs.rend());
+
+		for (EditRun& e : m_LogBuffer)
+		{
+			std::swap(e.OldBlock, e.NewBlock);
+			std::swap(e.OldState, e.NewState);
+		}
+
+		Runs = m_LogBuffer.data();
+	}
+
+	fwrite(&Count, sizeof(uint32_t), 1, m_Log);
+	fwrite(Runs, sizeof(EditRun), Count, m_Log);
+
+	// Keeps the log usable if the session crashes
+	fflush(m_Log);
+}
+
+int VoxelRT::EditJournal::ReplayLog(const std::string& path, World* world)
+{
+	FILE* File = fopen(path.c_str(), "rb");
+
+	if (!File)
+	{
+		std::cout << "\nCouldn't open the edit log " << path << "\n";
+		return -1;
+	}
+
+	char Magic[4] = { 0 };
+	uint32_t Version = 0;
+	int32_t Size[3] = { 0 };
+
+	if (fread(Magic, 1, 4, File) != 4 || memcmp(Magic, EDIT_LOG_MAGIC, 4) != 0 || fread(&Version, sizeof(uint32_t), 1, File) != 1 ||
+		Version != EDIT_LOG_VERSION || fread(Size, sizeof(int32_t), 3, File) != 3 || glm::ivec3(Size[0], Size[1], Size[2]) != world->GetDimensions())
+	{
+		std::cout << "\nInvalid edit log, or it was recorded on a world of another size : " << path << "\n";
+		fclose(File);
+		return -1;
+	}
+
+	const uint32_t MaxIndex = GetIndex(world->GetDimensions() - 1, world->GetDimensions());
+	EditTransaction Transaction;
+	uint32_t Count = 0;
+	int Replayed = 0;
+
+	while (fread(&Count, sizeof(uint32_t), 1, File) == 1)
+	{
+		Transaction.Runs.resize(Count);
+
+		// A truncated transaction at the end means the session was interrupted while writing it
+		if (fread(Transaction.Runs.data(), sizeof(EditRun), Count, File) != Count)
+		{
+			break;
+		}
+
+		const bool Valid = std::all_of(Transaction.Runs.begin(), Transaction.Runs.end(), [MaxIndex](const EditRun& e)
+		{
+			return e.Length > 0 && e.Start <= MaxIndex && e.Length - 1 <= MaxIndex - e.Start;
+		});
+
+		if (!Valid)
+		{
+			std::cout << "\nCorrupt edit log, stopped after " << Replayed << " transactions : " << path << "\n";
+			break;
+		}
+
+		Apply(world, Transaction, true);
+		Replayed++;
+	}
+
+	fclose(File);
+	return Replayed;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Block.h"
+#include "VoxelStates.h"
+
+namespace VoxelRT
+{
+	class World;
+
+	// A run of consecutive voxels (x + y * X + z * X * Y order) that all went from the same block/state to the same block/state
+	// Single block edits are runs of length 1, region operations collapse into a run per row segment (or less)
+	struct EditRun
+	{
+		uint32_t Start;
+		uint32_t Length;
+		uint16_t OldBlock;
+		uint16_t NewBlock;
+		BlockState OldState;
+		BlockState NewState;
+	};
+
+	static_assert(sizeof(EditRun) == 16, "The edit log stores runs as is");
+
+	struct EditTransaction
+	{
+		std::vector<EditRun> Runs; // In the order the voxels were written
+		size_t Voxels = 0;
+
+		size_t GetMemoryUsage() const noexcept { return sizeof(EditTransaction) + Runs.capacity() * sizeof(EditRun); }
+	};
+
+	// Undo/redo journal of the world edits
+	// Every edit transaction (a click, a committed WorldEdit) is stored as the list of runs it changed. Undo and redo
+	// write the old/new blocks back with a WorldEdit, so they go through the same relighting, distance field and upload
+	// path as any other edit. The oldest transactions are dropped once the journal uses more than its memory budget.
+	//
+	// The applied transactions (edits, undos and redos) can also be streamed to a log file as they happen, and the log
+	// replayed on a copy of the world later on (reproducing a long session for profiling etc).
+	// Log : "VRTJ", uint32 version, int32 x 3 world size, then per transaction a uint32 run count followed by the runs.
+
+	class EditJournal
+	{
+	public :
+
+		~EditJournal();
+
+		// Nothing is recorded until the journal is enabled (world generation and loading don't need to be undone)
+		inline void SetEnabled(bool enabled) noexcept { m_Enabled = enabled; }
+		inline bool IsRecording() const noexcept { return m_Enabled && !m_Replaying; }
+
+		void SetMemoryBudget(size_t bytes);
+		inline size_t GetMemoryBudget() const noexcept { return m_MemoryBudget; }
+		inline size_t GetMemoryUsage() const noexcept { return m_MemoryUsage; }
+
+		static inline uint32_t GetIndex(const glm::ivec3& p, const glm::ivec3& dimensions) noexcept
+		{
+			return (uint32_t)p.x + (uint32_t)p.y * dimensions.x + (uint32_t)p.z * dimensions.x * dimensions.y;
+		}
+
+		// Edits recorded between these two are undone as one, edits recorded outside of a transaction are a transaction each
+		void BeginTransaction();
+		void EndTransaction();
+
+		void Record(uint32_t index, Block old_block, BlockState old_state, Block new_block, BlockState new_state);
+
+		// Return false if there's nothing to undo/redo (or a transaction is still open)
+		bool Undo(World* world);
+		bool Redo(World* world);
+
+		inline size_t GetUndoCount() const noexcept { return m_Undo.size(); }
+		inline size_t GetRedoCount() const noexcept { return m_Redo.size(); }
+
+		// Drops the history, the log (if any) stays open
+		void Clear();
+
+		// Starts appending the applied transactions to the file (overwritten), dimensions are those of the world
+		// The log only records positions in the world as it is now, World::Resize() and World::ShiftWindow() close it
+		bool OpenLog(const std::string& path, const glm::ivec3& dimensions);
+		void CloseLog();
+		inline bool IsLogOpen() const noexcept { return m_Log != nullptr; }
+
+		// Applies every transaction of a log to the world (one commit each), nothing is recorded while replaying
+		// Returns the number of transactions replayed, -1 if the file can't be read or is for a world of another size
+		int ReplayLog(const std::string& path, World* world);
+
+	private :
+
+		void Apply(World* world, const EditTransaction& transaction, bool forward);
+		void WriteLog(const EditTransaction& transaction, bool forward);
+		void TrimToBudget();
+
+		std::deque<EditTransaction> m_Undo;
+		std::vector<EditTransaction> m_Redo;
+		EditTransaction m_Current;
+		int m_TransactionDepth = 0;
+
+		size_t m_MemoryBudget = 32 * 1024 * 1024;
+		size_t m_MemoryUsage = 0;
+
+		bool m_Enabled = false;
+		bool m_Replaying = false;
+		FILE* m_Log = nullptr;
+		std::vector<EditRun> m_LogBuffer;
+	};
+}
@@ -1,4 +1,5 @@
 #include "ComputeShader.h"
+#include "Shader.h"
 
 namespace GLClasses
 {
@@ -44,7 +45,8 @@ namespace GLClasses
         m_ID = glCreateProgram();
         GLuint m_ComputeID = glCreateShader(GL_COMPUTE_SHADER);
 
-        const char* contcstr = m_ShaderContents.c_str();
+        const std::string contents = InjectGlobalShaderDefines(m_ShaderContents);
+        const char* contcstr = contents.c_str();
         glShaderSource(m_ComputeID, 1, &contcstr, 0);
         glCompileShader(m_ComputeID);
 
@@ -8,6 +8,56 @@ namespace GLClasses
 		return pth.string();
 	}
 
+	static std::vector<std::pair<std::string, std::string>> GlobalShaderDefines;
+
+	void SetGlobalShaderDefine(const std::string& name, const std::string& value)
+	{
+		for (auto& e : GlobalShaderDefines)
+		{
+			if (e.first == name)
+			{
+				e.second = value;
+				return;
+			}
+		}
+
+		GlobalShaderDefines.push_back({ name, value });
+	}
+
+	std::string InjectGlobalShaderDefines(const std::string& source)
+	{
+		if (GlobalShaderDefines.empty())
+		{
+			return source;
+		}
+
+		std::string defines = "";
+
+		for (auto& e : GlobalShaderDefines)
+		{
+			defines += "#define " + e.first + " " + e.second + "\n";
+		}
+
+		// #version has to stay the first directive in the shader
+		size_t version = source.find("#version");
+
+		if (version == std::string::npos)
+		{
+			return defines + source;
+		}
+
+		size_t line_end = source.find('\n', version);
+
+		if (line_end == std::string::npos)
+		{
+			return source + "\n" + defines;
+		}
+
+		std::string result = source;
+		result.insert(line_end + 1, defines);
+		return result;
+	}
+
 	Shader::~Shader()
 	{
 		glDeleteProgram(m_Program);
@@ -30,7 +80,8 @@ namespace GLClasses
 		{
 			gs = glCreateShader(GL_GEOMETRY_SHADER);
 
-			const char* geo_source = m_GeometryData.c_str();
+			const std::string geo_data = InjectGlobalShaderDefines(m_GeometryData);
+			const char* geo_source = geo_data.c_str();
 
 			glShaderSource(gs, 1, &geo_source, 0);
 			glCompileShader(gs);
@@ -66,8 +117,10 @@ namespace GLClasses
 		vs = glCreateShader(GL_VERTEX_SHADER);
 		fs = glCreateShader(GL_FRAGMENT_SHADER);
 
-		const char* vs_char = m_VertexData.c_str();
-		const char* fs_char = m_FragmentData.c_str();
+		const std::string vertex_data = InjectGlobalShaderDefines(m_VertexData);
+		const std::string fragment_data = InjectGlobalShaderDefines(m_FragmentData);
+		const char* vs_char = vertex_data.c_str();
+		const char* fs_char = fragment_data.c_str();
 
 		glShaderSource(vs, 1, &vs_char, 0);
 		glShaderSource(fs, 1, &fs_char, 0);
@@ -19,6 +19,11 @@
 
 namespace GLClasses
 {
+	// Global defines are inserted right after the #version directive of every shader (including compute shaders)
+	// compiled after they are set. Used for values only known at runtime, like the world dimensions.
+	void SetGlobalShaderDefine(const std::string& name, const std::string& value);
+	std::string InjectGlobalShaderDefines(const std::string& source);
+
 	class Shader
 	{
 	public:
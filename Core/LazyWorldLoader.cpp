@@ -0,0 +1,359 @@
+#include "LazyWorldLoader.h"
+
+#include <algorithm>
+
+#include "World.h"
+#include "ChunkCodec.h"
+#include "VolumetricFloodFill.h"
+
+bool VoxelRT::LazyWorldLoader::Open(World* world, const std::string& world_name, std::vector<glm::ivec3>& lights)
+{
+	Close();
+
+	const std::string Path = "Saves/" + world_name;
+	FILE* File = fopen(Path.c_str(), "rb");
+
+	if (!File)
+	{
+		return false;
+	}
+
+	m_Timer.Start();
+
+	WorldFileHeader Header;
+	const bool Valid = ReadWorldFileHeader(File, Header) && Header.Version >= 4;
+	const glm::ivec3 Dimensions = glm::ivec3(Header.SizeX, Header.SizeY, Header.SizeZ);
+	const glm::ivec3 Chunks = Dimensions / CHUNK_SIZE;
+
+	// The world is only touched once the index is known to be valid
+	if (!Valid || !ReadWorldFileChunkIndex(File, Chunks.x * Chunks.y * Chunks.z, m_Index) || SeekTo(File, m_Index.End) != 0)
+	{
+		fclose(File);
+		return false;
+	}
+
+	world->Resize(Dimensions);
+	const bool HasSummary = ReadWorldFileSections(world, File, Header.Flags);
+
+	if (HasSummary && (Header.Flags & WORLD_FILE_HAS_LOG))
+	{
+		ReadWorldFileLog(File, m_Index);
+	}
+
+	fclose(File);
+
+	if (!HasSummary || !m_File.Open(Path) || m_File.GetSize() < m_Index.End)
+	{
+		m_File.Close();
+		return false;
+	}
+
+	m_World = world;
+	m_Chunks = Chunks;
+	m_Loaded.assign(world->m_WorldData.GetChunkCount(), 0);
+	m_PendingCount = world->m_WorldData.GetChunkCount();
+	m_QueueCenter = glm::ivec3(-1);
+	m_CorruptedChunks = 0;
+	m_Relight.Clear();
+	m_ApproximateField = false;
+
+	// The summaries in the file are the ones of the chunks the log replaced, its chunks (the ones saved last, a fraction
+	// of the file, see WorldFileLayout.h) are loaded right away. The cached distance field doesn't have them
+	if (!m_Index.LogChunks.empty())
+	{
+		world->GetDistanceField().SetValid(false);
+	}
+
+	for (size_t k = 0; k < m_Index.LogChunks.size(); k++)
+	{
+		LoadChunk(m_Index.LogChunks[k], &m_Index.LogStates[k]);
+	}
+
+	// Every chunk is in the file until it is loaded, LoadChunk() updates their versions
+	SetWorldFileLayout(world, world_name, Header.Flags, m_Index);
+
+	// The lights of the chunks that aren't loaded yet are in their summaries
+	world->m_WorldData.GetLights(glm::ivec3(0), Dimensions, lights);
+	world->SetLazyLoader(this);
+
+	std::cout << "\n\n" << "MAPPED WORLD FILE (" << Dimensions.x << "x" << Dimensions.y << "x" << Dimensions.z << ", "
+		<< m_PendingCount << " chunks to load, " << m_Timer.End() << " ms)" << "\n\n";
+
+	return true;
+}
+
+void VoxelRT::LazyWorldLoader::LoadAround(const glm::vec3& position, int radius)
+{
+	if (!IsLoading())
+	{
+		return;
+	}
+
+	const glm::ivec3 Center = glm::ivec3(glm::floor(position / (float)CHUNK_SIZE));
+	const glm::ivec3 Min = glm::max(Center - radius, glm::ivec3(0));
+	const glm::ivec3 Max = glm::min(Center + radius + 1, m_Chunks);
+
+	LoadRegion(glm::ivec3(Min.x, 0, Min.z) * CHUNK_SIZE, glm::ivec3(Max.x, m_Chunks.y, Max.z) * CHUNK_SIZE);
+
+	if (IsLoading() && !m_World->IsBuffered() && !m_World->GetDistanceField().IsValid())
+	{
+		GenerateApproximateField();
+	}
+}
+
+void VoxelRT::LazyWorldLoader::Update(const glm::vec3& position, int max_chunks)
+{
+	if (!IsLoading())
+	{
+		return;
+	}
+
+	const glm::ivec3 Center = glm::clamp(glm::ivec3(glm::floor(position / (float)CHUNK_SIZE)), glm::ivec3(0), m_Chunks - 1);
+
+	if (Center != m_QueueCenter)
+	{
+		SortQueue(Center);
+	}
+
+	// Air chunks cost almost nothing and don't count
+	int Loaded = 0;
+
+	while (m_QueueStart < m_Queue.size() && Loaded < max_chunks)
+	{
+		Loaded += LoadChunk(m_Queue[m_QueueStart++]) ? 1 : 0;
+	}
+
+	FlushLoaded();
+
+	if (m_PendingCount == 0)
+	{
+		std::cout << "\n\n" << "FINISHED LOADING THE WORLD (" << m_Timer.End() << " ms after it was mapped";
+
+		if (m_CorruptedChunks > 0)
+		{
+			std::cout << ", " << m_CorruptedChunks << " CORRUPTED CHUNKS WERE LEFT EMPTY";
+		}
+
+		std::cout << ")" << "\n\n";
+		Close();
+	}
+}
+
+void VoxelRT::LazyWorldLoader::LoadRegion(const glm::ivec3& min, const glm::ivec3& max)
+{
+	if (!IsLoading())
+	{
+		return;
+	}
+
+	const glm::ivec3 Min = glm::max(min, glm::ivec3(0)) / CHUNK_SIZE;
+	const glm::ivec3 Max = (glm::min(max, m_Chunks * CHUNK_SIZE) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+	for (int z = Min.z; z < Max.z; z++)
+	{
+		for (int y = Min.y; y < Max.y; y++)
+		{
+			for (int x = Min.x; x < Max.x; x++)
+			{
+				LoadChunk(m_World->m_WorldData.GetChunkIndex(x, y, z));
+			}
+		}
+	}
+
+	// Everything has been read (a save), the file can be written again
+	if (m_PendingCount == 0)
+	{
+		FlushLoaded();
+		Close();
+	}
+}
+
+void VoxelRT::LazyWorldLoader::Close()
+{
+	if (m_World)
+	{
+		// The chunks that were loaded didn't update the approximate field (see LoadChunk()), the ones that weren't are
+		// still solid in it
+		if (m_ApproximateField && m_World->IsBuffered() && m_PendingCount == 0)
+		{
+			m_World->GenerateDistanceField();
+		}
+
+		else if (m_ApproximateField)
+		{
+			m_World->GetDistanceField().SetValid(false);
+		}
+
+		m_World->SetLazyLoader(nullptr);
+	}
+
+	m_World = nullptr;
+	m_File.Close();
+	m_Index = WorldFileChunkIndex();
+	m_Loaded.clear();
+	m_Loaded.shrink_to_fit();
+	m_Queue.clear();
+	m_Queue.shrink_to_fit();
+	m_QueueStart = 0;
+	m_PendingCount = 0;
+	m_Relight.Clear();
+	m_Unbuffered.Clear();
+	m_ApproximateField = false;
+}
+
+bool VoxelRT::LazyWorldLoader::LoadChunk(int index, const std::vector<uint32_t>* states)
+{
+	if (m_Loaded[index])
+	{
+		return false;
+	}
+
+	m_Loaded[index] = 1;
+	m_PendingCount--;
+
+	VoxelChunk Chunk;
+	const bool Decoded = ChunkCodec::Decode(m_File.GetData() + m_Index.Offsets[index], m_Index.Sizes[index], m_Index.Remap, Chunk);
+
+	// The world was cleared when it was opened, a chunk that can't be decoded stays empty but its summary (from the
+	// file) has to be replaced, so does the one of a chunk of the log
+	if (Decoded && !states && Chunk.IsUniform() && Chunk.GetUniformBlock().block == 0)
+	{
+		return false;
+	}
+
+	m_CorruptedChunks += Decoded ? 0 : 1;
+
+	// A distance field that was cached or generated with the chunk counted as solid already is a lower bound of the
+	// distances with the chunk in (counting voxels as solid only makes the distances shorter), going through the update
+	// around it would regenerate most of the field every frame
+	const glm::ivec3 Min = m_World->m_WorldData.GetChunkPosition(index);
+	const bool InDistanceField = IsInDistanceField(Chunk, Min);
+
+	// The states of the chunk were read with the other sections, or with the log
+	WorldData& Data = m_World->m_WorldData;
+	const std::vector<uint32_t>* States = states ? states : Data.GetStates().GetChunkEntries(index);
+	m_World->SetChunk(index, std::move(Chunk), States ? *States : std::vector<uint32_t>(), InDistanceField);
+
+	// The chunk is the one in the file, the next save doesn't have to append it
+	WorldFileLayout& Layout = m_World->GetFileLayout();
+
+	if (Layout.IsValid())
+	{
+		Layout.Versions[index] = Data.GetChunkVersion(index);
+	}
+
+	m_Relight.Add(Min, Min + glm::ivec3(CHUNK_SIZE));
+
+	// World::SetChunk() only queues the chunk for FlushEdits() once the world is buffered
+	if (!InDistanceField && !m_World->IsBuffered())
+	{
+		m_Unbuffered.Add(Min, Min + glm::ivec3(CHUNK_SIZE));
+	}
+
+	return true;
+}
+
+void VoxelRT::LazyWorldLoader::FlushLoaded()
+{
+	// Before the world is buffered the lights are the ones Open() got from the summaries and nothing is lit yet
+	if (!m_World->IsBuffered())
+	{
+		m_Relight.Clear();
+		return;
+	}
+
+	for (const DirtyBox& Box : m_Unbuffered.GetBoxes())
+	{
+		m_World->MarkDirty(Box.Min, Box.Max);
+	}
+
+	m_Unbuffered.Clear();
+
+	if (m_Relight.IsEmpty())
+	{
+		return;
+	}
+
+	m_World->UpdateLightList(m_Relight.GetBoxes());
+
+	for (const DirtyBox& Box : m_Relight.GetBoxes())
+	{
+		Volumetrics::RelightRegion(Box.Min, Box.Max);
+	}
+
+	m_Relight.Clear();
+}
+
+void VoxelRT::LazyWorldLoader::SortQueue(const glm::ivec3& chunk)
+{
+	std::vector<std::pair<int, int>> Pending;
+	Pending.reserve(m_PendingCount);
+
+	for (int i = 0; i < (int)m_Loaded.size(); i++)
+	{
+		if (!m_Loaded[i])
+		{
+			const glm::ivec3 d = m_World->m_WorldData.GetChunkPosition(i) / CHUNK_SIZE - chunk;
+			Pending.push_back({ d.x * d.x + d.y * d.y + d.z * d.z, i });
+		}
+	}
+
+	std::sort(Pending.begin(), Pending.end());
+
+	m_Queue.resize(Pending.size());
+
+	for (size_t i = 0; i < Pending.size(); i++)
+	{
+		m_Queue[i] = Pending[i].second;
+	}
+
+	m_QueueStart = 0;
+	m_QueueCenter = chunk;
+}
+
+bool VoxelRT::LazyWorldLoader::IsInDistanceField(const VoxelChunk& chunk, const glm::ivec3& min) const
+{
+	const DistanceField& Field = m_World->GetDistanceField();
+
+	if (!Field.IsValid())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		if (chunk.GetBlock(i).block != 0)
+		{
+			const glm::ivec3 p = min + VoxelIndexing::GetBrickLocalPosition(i);
+
+			if (Field.Get(p.x, p.y, p.z) != 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void VoxelRT::LazyWorldLoader::GenerateApproximateField()
+{
+	const ChunkSummary& Summary = m_World->m_WorldData.GetSummary();
+	std::vector<DirtyBox> Solid;
+
+	for (int i = 0; i < (int)m_Loaded.size(); i++)
+	{
+		int Lowest, Highest;
+
+		if (!m_Loaded[i] && Summary.GetSolidLayers(i, Lowest, Highest))
+		{
+			const glm::ivec3 Min = m_World->m_WorldData.GetChunkPosition(i);
+			Solid.push_back({ Min + glm::ivec3(0, Lowest, 0), Min + glm::ivec3(CHUNK_SIZE, Highest + 1, CHUNK_SIZE) });
+		}
+	}
+
+	// The chunks that are loaded already are in it
+	m_World->GetDistanceField().Generate(m_World->m_WorldData, Solid);
+	m_Unbuffered.Clear();
+	m_ApproximateField = true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+#include "MappedFile.h"
+#include "DirtyRegion.h"
+#include "WorldFileHandler.h"
+#include "Utils/Timer.h"
+
+namespace VoxelRT
+{
+	class World;
+
+	// Loads a version 4 save file (see WorldFileHandler.h) a few chunks at a time instead of all at once before the
+	// first frame. Open() maps the file and only reads what is small or needed right away : the chunk index, the voxel
+	// states, the cached distance field and the chunk summaries (the lights and solid layers of the entire world).
+	// The chunks are decoded from the mapping when they're needed :
+	//  - LoadAround() and Update() load the chunks closest to the camera first, Update() a few per frame, they reach the
+	//    gpu through the regular FlushEdits() path so the volumes fill in from around the camera
+	//  - the world loads the chunks it is about to edit (World::LoadRegion()) so edits never land on a chunk that isn't
+	//    there yet
+	// Anything else that reads the world on the cpu sees air where the chunks aren't loaded yet. The file is unmapped
+	// once every chunk is loaded. The chunks of the log of the file (the saves that appended to it) are loaded by Open(),
+	// the summaries in the file don't describe them.
+	//
+	// The chunks don't go through the distance field update as they come in, an update around a freshly loaded chunk
+	// grows to most of the world and FlushEdits() would regenerate the field every frame. The field has to have them
+	// already instead : files saved with their distance field have the final one, otherwise LoadAround() generates one
+	// where the solid layers of the chunks that aren't loaded yet count as solid. That one is only a lower bound of the
+	// distances (rays take shorter steps around the chunks that were loaded) and is regenerated once every chunk is in.
+
+	class LazyWorldLoader
+	{
+	public :
+
+		// Resizes the world and reads everything but the chunks, the lights of the entire world are appended to lights
+		// The loader stays attached to the world (World::SetLazyLoader()) until every chunk is loaded
+		// Returns false if the file can't be mapped, isn't a version 4 file or its chunk summaries don't match the
+		// block database (the lights and heights of the chunks aren't known then), LoadWorld() has to be used instead
+		bool Open(World* world, const std::string& world_name, std::vector<glm::ivec3>& lights);
+
+		// Loads the columns of chunks within radius chunks (horizontally) of the position, before the world is buffered
+		// Generates the approximate distance field if the file has none, World::UploadDistanceField() has to be used
+		// instead of GenerateDistanceField() then (the field is valid)
+		void LoadAround(const glm::vec3& position, int radius);
+
+		// Once per frame, before World::FlushEdits() : loads up to max_chunks chunks that aren't empty, closest to the
+		// position first, and relights them
+		void Update(const glm::vec3& position, int max_chunks);
+
+		// Loads the chunks in the box (max exclusive) that aren't loaded yet, they are relit by the next Update()
+		void LoadRegion(const glm::ivec3& min, const glm::ivec3& max);
+
+		// Stops loading, the chunks that weren't loaded stay empty
+		// The approximate distance field is marked as invalid if it wasn't updated with every chunk
+		// The destructor only unmaps the file, the world can be gone by then
+		void Close();
+
+		inline bool IsLoading() const noexcept { return m_File.IsOpen(); }
+		inline int GetPendingCount() const noexcept { return m_PendingCount; }
+
+	private :
+
+		// Returns false if the chunk was already loaded or is air (nothing to upload)
+		// states replaces the states the table has for the chunk (the chunks of the log)
+		bool LoadChunk(int index, const std::vector<uint32_t>* states = nullptr);
+
+		// Relights the boxes of the chunks loaded since the last call
+		void FlushLoaded();
+
+		// Pending chunks closest to the chunk first
+		void SortQueue(const glm::ivec3& chunk);
+
+		// Whether every solid voxel of the chunk (at min) has a distance of 0 in the distance field
+		bool IsInDistanceField(const VoxelChunk& chunk, const glm::ivec3& min) const;
+
+		// Distance field of the loaded chunks with the solid layers of the others filled in (see the comment above)
+		void GenerateApproximateField();
+
+		World* m_World = nullptr;
+		MappedFile m_File;
+		WorldFileChunkIndex m_Index;
+		glm::ivec3 m_Chunks = glm::ivec3(0);
+
+		std::vector<uint8_t> m_Loaded;
+		int m_PendingCount = 0;
+		std::vector<int> m_Queue; // Loaded chunks are skipped
+		size_t m_QueueStart = 0;
+		glm::ivec3 m_QueueCenter = glm::ivec3(-1);
+		DirtyRegion m_Relight;
+		DirtyRegion m_Unbuffered; // Loaded before the world was buffered and not in the distance field
+		bool m_ApproximateField = false;
+		int m_CorruptedChunks = 0;
+		Blocks::Timer m_Timer; // Since Open()
+	};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
-#define WORLD_SIZE_X 384
-#define WORLD_SIZE_Y 128
-#define WORLD_SIZE_Z 384
\ No newline at end of file
+// Dimensions used when creating a new world
+// A loaded world stores its own dimensions in the save header, query them with World::GetDimensions() at runtime
+#define DEFAULT_WORLD_SIZE_X 384
+#define DEFAULT_WORLD_SIZE_Y 128
+#define DEFAULT_WORLD_SIZE_Z 384
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+VoxelRT::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool VoxelRT::MappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER Size;
+
+	if (!GetFileSizeEx(File, &Size) || Size.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* Data = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (!Data)
+	{
+		if (Mapping) { CloseHandle(Mapping); }
+		CloseHandle(File);
+		return false;
+	}
+
+	m_File = File;
+	m_Mapping = Mapping;
+	m_Data = (const uint8_t*)Data;
+	m_Size = (uint64_t)Size.QuadPart;
+#else
+	const int File = open(path.c_str(), O_RDONLY);
+
+	if (File < 0)
+	{
+		return false;
+	}
+
+	struct stat Stat;
+
+	if (fstat(File, &Stat) != 0 || Stat.st_size == 0)
+	{
+		close(File);
+		return false;
+	}
+
+	void* Data = mmap(nullptr, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+
+	// The mapping keeps the file alive
+	close(File);
+
+	if (Data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_Data = (const uint8_t*)Data;
+	m_Size = (uint64_t)Stat.st_size;
+#endif
+
+	return true;
+}
+
+void VoxelRT::MappedFile::Close()
+{
+	if (!m_Data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+	CloseHandle((HANDLE)m_Mapping);
+	CloseHandle((HANDLE)m_File);
+	m_File = m_Mapping = nullptr;
+#else
+	munmap((void*)m_Data, (size_t)m_Size);
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
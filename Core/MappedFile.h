@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+
+namespace VoxelRT
+{
+	// Read only memory mapping of an entire file, the os only reads the pages that are accessed
+	// (mmap on linux, CreateFileMapping/MapViewOfFile on windows)
+
+	class MappedFile
+	{
+	public :
+
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		// Returns false if the file can't be opened or is empty
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const noexcept { return m_Data != nullptr; }
+		inline const uint8_t* GetData() const noexcept { return m_Data; }
+		inline uint64_t GetSize() const noexcept { return m_Size; }
+
+	private :
+
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Size = 0;
+
+#ifdef _WIN32
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+}
@@ -2,15 +2,15 @@
 
 namespace VoxelRT {
 	namespace MCWorldImporter {
-		const int HALF_WORLD_X = 384 / 2;
-		const int HALF_WORLD_Z = 384 / 2;
+		static int HALF_WORLD_X = DEFAULT_WORLD_SIZE_X / 2;
+		static int HALF_WORLD_Z = DEFAULT_WORLD_SIZE_Z / 2;
+		static int WORLD_HEIGHT = DEFAULT_WORLD_SIZE_Y;
 		static glm::vec3 ImportOrigin;
-
-		static std::array<uint8_t, 384 * 128 * 384> ReadWorldData;
+		static WorldData* ImportOutput = nullptr;
 
 		bool IsInBounds(const glm::ivec3& Position) {
 			if (Position.x <= -HALF_WORLD_X || Position.x >= HALF_WORLD_X || Position.z <= -HALF_WORLD_X || Position.z >= HALF_WORLD_X ||
-				Position.y <= 1 || Position.y >= 128) {
+				Position.y <= 1 || Position.y >= WORLD_HEIGHT) {
 				return true;
 			}
 
@@ -20,7 +20,7 @@ namespace VoxelRT {
 		bool IsInBounds(int x, int y, int z) {
 			const glm::ivec3 Position = glm::ivec3(x, y, z);
 			if (Position.x <= -HALF_WORLD_X || Position.x >= HALF_WORLD_X || Position.z <= -HALF_WORLD_X || Position.z >= HALF_WORLD_X ||
-				Position.y <= 1 || Position.y >= 128) {
+				Position.y <= 1 || Position.y >= WORLD_HEIGHT) {
 				return true;
 			}
 
@@ -32,7 +32,7 @@ namespace VoxelRT {
 		}
 
 		int ConvertTo1DIDXWorld(int x, int y, int z) {
-			const glm::ivec3 Dimensions = glm::ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+			const glm::ivec3& Dimensions = ImportOutput->GetDimensions();
 			return x + y * Dimensions.x + z * Dimensions.x * Dimensions.y;
 		}
 
@@ -59,27 +59,22 @@ namespace VoxelRT {
 		}
 
 		bool ChunkInBounds(int cx, int cz) {
-			bool Valid = cx < -(384 / 32) || cx >(384 / 32) || cz < -(384 / 32) || cz > (384 / 32);
+			bool Valid = cx < -(HALF_WORLD_X / 16) || cx >(HALF_WORLD_X / 16) || cz < -(HALF_WORLD_Z / 16) || cz > (HALF_WORLD_Z / 16);
 			return !Valid;
 		}
 
-		void WriteVoxel(uint8_t voxel, glm::ivec3 Position)
+		void WriteVoxel(uint16_t voxel, uint8_t state, glm::ivec3 Position)
 		{
 			Position -= glm::ivec3(ImportOrigin);
 			Position.x += HALF_WORLD_X;
 			Position.z += HALF_WORLD_Z;
 
-			if (Position.y >= 128 || Position.x >= 384 || Position.z >= 384 || Position.y < 0 || Position.x < 0 || Position.z < 0 || voxel == 0) {
-				return;
-			}
-
-			int index = ConvertTo1DIDXWorld(Position.x, Position.y, Position.z);
-
-			if (index < 0 || index > 384 * 128 * 384) {
+			if (Position.y >= WORLD_HEIGHT || Position.x >= HALF_WORLD_X * 2 || Position.z >= HALF_WORLD_Z * 2 || Position.y < 0 || Position.x < 0 || Position.z < 0 || voxel == 0) {
 				return;
 			}
 
-			ReadWorldData[index] = voxel;
+			// The data value (orientation, half, variant...) is kept as the state of the voxel
+			ImportOutput->SetBlock(Position.x, Position.y, Position.z, { voxel }, state);
 		} // 4524 10 937
 
 		void ImportRegionFile(const std::string& Path) {
@@ -120,14 +115,8 @@ namespace VoxelRT {
 										//uint8_t voxel = enkiGetChunkSectionVoxel(&aChunk, section, sPos);
 										enkiMIVoxelData ReadVoxel = enkiGetChunkSectionVoxelData(&aChunk, section, sPos);
 										glm::ivec3 StoreLoc = storeOrigin + glm::ivec3(sPos.x, sPos.y, sPos.z);
-										uint8_t voxel = ReadVoxel.blockID;
-										uint8_t dataval = ReadVoxel.dataValue;
-
-										if (dataval == 0) {
-											voxel = BlockDatabase::GetIDFromMCID(voxel);
-											WriteVoxel(voxel, StoreLoc);
-										}
-										
+										uint16_t voxel = BlockDatabase::GetIDFromMCID(ReadVoxel.blockID);
+										WriteVoxel(voxel, ReadVoxel.dataValue, StoreLoc);
 									}
 								}
 							}
@@ -147,11 +136,14 @@ namespace VoxelRT {
 
 		}
 
-		void ImportWorld(const std::string& Filepath, void* Output, const glm::vec3& origin)
+		void ImportWorld(const std::string& Filepath, WorldData* Output, const glm::vec3& origin)
 		{
 			ImportOrigin = origin;
-			memset(&ReadWorldData, 0, 384 * 128 * 384);
-			memset(Output, 0, 384 * 128 * 384);
+			ImportOutput = Output;
+			HALF_WORLD_X = Output->GetDimensions().x / 2;
+			HALF_WORLD_Z = Output->GetDimensions().z / 2;
+			WORLD_HEIGHT = Output->GetDimensions().y;
+			ImportOutput->Clear();
 
 			const std::filesystem::path Directory{ Filepath.c_str() };
 
@@ -162,7 +154,8 @@ namespace VoxelRT {
 				}
 			}
 
-			memcpy(Output, &ReadWorldData, 384 * 128 * 384);
+			ImportOutput->Compact();
+			ImportOutput = nullptr;
 		}
 
 	}
@@ -15,6 +15,7 @@
 #include "../../Dependencies/enkiMI/enkimi.h"
 
 #include "../BlockDatabase.h"
+#include "../WorldData.h"
 
 #ifdef _MSC_VER
 #pragma warning (disable: 4996)
@@ -23,6 +24,6 @@
 namespace VoxelRT
 {
 	namespace MCWorldImporter {
-		void ImportWorld(const std::string& Filepath, void* Output, const glm::vec3&);
+		void ImportWorld(const std::string& Filepath, WorldData* Output, const glm::vec3&);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "OccupancyMask.h"
+
+#include <algorithm>
+
+// Bits of a 4 voxel x row inside of a 4^3 cell with y = 0 and z = 0 (morton positions 0, 1, 8, 9)
+static const uint64_t CELL_ROW_MASK = 0x303ull;
+
+static inline uint32_t MortonSpread2(uint32_t v)
+{
+	return (v & 1u) | ((v & 2u) << 2);
+}
+
+void VoxelRT::OccupancyMask::Resize(const glm::ivec3& dimensions)
+{
+	m_Indexer = BrickedVolumeIndexer(dimensions);
+	m_Words.assign(m_Indexer.GetVolume() / 64, 0);
+	m_Words.shrink_to_fit();
+	m_SolidCounts.assign(m_Indexer.GetVolume() / BRICK_VOLUME, 0);
+	m_SolidCounts.shrink_to_fit();
+	m_BrickCellMasks.assign(m_SolidCounts.size(), 0);
+	m_BrickCellMasks.shrink_to_fit();
+
+	// Regions on the far edges can stick out of the volume
+	const glm::ivec3 Regions = (dimensions + glm::ivec3((1 << REGION_SHIFT) - 1)) >> REGION_SHIFT;
+	m_RegionsX = Regions.x;
+	m_RegionsXY = Regions.x * Regions.y;
+	m_RegionBrickMasks.assign((size_t)Regions.x * Regions.y * Regions.z, 0);
+	m_RegionBrickMasks.shrink_to_fit();
+}
+
+void VoxelRT::OccupancyMask::Clear()
+{
+	std::fill(m_Words.begin(), m_Words.end(), 0);
+	std::fill(m_SolidCounts.begin(), m_SolidCounts.end(), 0);
+	std::fill(m_BrickCellMasks.begin(), m_BrickCellMasks.end(), 0);
+	std::fill(m_RegionBrickMasks.begin(), m_RegionBrickMasks.end(), 0);
+}
+
+void VoxelRT::OccupancyMask::FillBrick(int x, int y, int z, bool solid) noexcept
+{
+	const int brick = m_Indexer.GetBrickIndex(x, y, z);
+	const uint64_t word = solid ? ~0ull : 0ull;
+
+	std::fill_n(m_Words.begin() + (size_t)brick * (BRICK_VOLUME / 64), BRICK_VOLUME / 64, word);
+	m_SolidCounts[brick] = solid ? BRICK_VOLUME : 0;
+	m_BrickCellMasks[brick] = word;
+
+	uint64_t& bricks = m_RegionBrickMasks[GetRegionIndex(x, y, z)];
+	const uint64_t brick_bit = 1ull << GetBrickIndexInRegion(x, y, z);
+	bricks = solid ? (bricks | brick_bit) : (bricks & ~brick_bit);
+}
+
+void VoxelRT::OccupancyMask::SetBrick(int x, int y, int z, const uint64_t* words) noexcept
+{
+	const int brick = m_Indexer.GetBrickIndex(x, y, z);
+	uint64_t* dst = &m_Words[(size_t)brick * (BRICK_VOLUME / 64)];
+	uint64_t cells = 0;
+	int count = 0;
+
+	for (int i = 0; i < BRICK_VOLUME / 64; i++)
+	{
+		dst[i] = words[i];
+		cells |= (uint64_t)(words[i] != 0) << i;
+		count += CountBits(words[i]);
+	}
+
+	m_SolidCounts[brick] = (uint16_t)count;
+	m_BrickCellMasks[brick] = cells;
+
+	uint64_t& bricks = m_RegionBrickMasks[GetRegionIndex(x, y, z)];
+	const uint64_t brick_bit = 1ull << GetBrickIndexInRegion(x, y, z);
+	bricks = cells != 0 ? (bricks | brick_bit) : (bricks & ~brick_bit);
+}
+
+void VoxelRT::OccupancyMask::ShiftBricks(const glm::ivec3& delta)
+{
+	const glm::ivec3 Bricks = m_Indexer.GetDimensions() >> BRICK_SHIFT;
+	const size_t WordsPerBrick = BRICK_VOLUME / 64;
+
+	std::vector<uint64_t> Words(m_Words.size(), 0);
+	std::vector<uint16_t> SolidCounts(m_SolidCounts.size(), 0);
+	std::vector<uint64_t> BrickCellMasks(m_BrickCellMasks.size(), 0);
+
+	for (int z = 0; z < Bricks.z; z++)
+	{
+		for (int y = 0; y < Bricks.y; y++)
+		{
+			for (int x = 0; x < Bricks.x; x++)
+			{
+				const glm::ivec3 Source = glm::ivec3(x, y, z) + delta;
+
+				if (glm::any(glm::lessThan(Source, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Source, Bricks)))
+				{
+					continue;
+				}
+
+				const int From = m_Indexer.GetBrickIndex(Source.x << BRICK_SHIFT, Source.y << BRICK_SHIFT, Source.z << BRICK_SHIFT);
+				const int To = m_Indexer.GetBrickIndex(x << BRICK_SHIFT, y << BRICK_SHIFT, z << BRICK_SHIFT);
+
+				std::copy_n(m_Words.begin() + From * WordsPerBrick, WordsPerBrick, Words.begin() + To * WordsPerBrick);
+				SolidCounts[To] = m_SolidCounts[From];
+				BrickCellMasks[To] = m_BrickCellMasks[From];
+			}
+		}
+	}
+
+	m_Words = std::move(Words);
+	m_SolidCounts = std::move(SolidCounts);
+	m_BrickCellMasks = std::move(BrickCellMasks);
+
+	// 64^3 regions don't line up with the bricks after the move, rebuild them from the bricks
+	std::fill(m_RegionBrickMasks.begin(), m_RegionBrickMasks.end(), 0);
+
+	for (int z = 0; z < Bricks.z; z++)
+	{
+		for (int y = 0; y < Bricks.y; y++)
+		{
+			for (int x = 0; x < Bricks.x; x++)
+			{
+				const glm::ivec3 p = glm::ivec3(x, y, z) << BRICK_SHIFT;
+
+				if (m_BrickCellMasks[m_Indexer.GetBrickIndex(p.x, p.y, p.z)] != 0)
+				{
+					m_RegionBrickMasks[GetRegionIndex(p.x, p.y, p.z)] |= 1ull << GetBrickIndexInRegion(p.x, p.y, p.z);
+				}
+			}
+		}
+	}
+}
+
+bool VoxelRT::OccupancyMask::IsRowEmpty(int x, int y, int z) const noexcept
+{
+	if (IsBrickEmpty(x, y, z))
+	{
+		return true;
+	}
+
+	// The row goes through 4 cells, test the same 4 bits in each of them
+	const uint64_t mask = CELL_ROW_MASK << ((MortonSpread2(y & 3) << 1) | (MortonSpread2(z & 3) << 2));
+	const int base_x = x & ~BRICK_MASK;
+
+	for (int cx = 0; cx < BRICK_SIZE; cx += 4)
+	{
+		if (GetCellWord(base_x + cx, y, z) & mask)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t VoxelRT::OccupancyMask::GetMemoryUsage() const noexcept
+{
+	return m_Words.capacity() * sizeof(uint64_t) + m_SolidCounts.capacity() * sizeof(uint16_t) +
+		m_BrickCellMasks.capacity() * sizeof(uint64_t) + m_RegionBrickMasks.capacity() * sizeof(uint64_t);
+}
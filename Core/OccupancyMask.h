@@ -0,0 +1,154 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <bitset>
+#include <glm/glm.hpp>
+
+#include "VoxelIndexing.h"
+
+namespace VoxelRT
+{
+	// 1 bit per voxel "solid or air" mask, kept in sync with the world data
+	// Each 64 bit word holds a 4^3 cell (the voxels are in the same morton order as the chunks) so an entire cell can
+	// be tested for emptiness with a single compare. A solid voxel count is kept per 16^3 brick as well.
+	//
+	// The words are the leaves of a 64-tree (4^3 children per node) : every brick has a 64 bit mask of its non empty
+	// cells and every 64^3 region has a 64 bit mask of its non empty bricks (both in morton order). Ray queries use the
+	// masks to skip empty space (see VoxelRaycast.h).
+
+	class OccupancyMask
+	{
+	public :
+
+		// Edge of the regions (in voxels), bricks in different regions share no word of the mask
+		static const int REGION_SIZE = 64;
+
+		// Dimensions have to be multiples of BRICK_SIZE, resizing clears the mask
+		void Resize(const glm::ivec3& dimensions);
+		void Clear();
+
+		inline bool IsSolid(int x, int y, int z) const noexcept
+		{
+			const int local = VoxelIndexing::GetBrickLocalIndex(x, y, z);
+			return (m_Words[GetWordIndex(x, y, z, local)] >> (local & 63)) & 1;
+		}
+
+		inline void Set(int x, int y, int z, bool solid) noexcept
+		{
+			const int local = VoxelIndexing::GetBrickLocalIndex(x, y, z);
+			uint64_t& word = m_Words[GetWordIndex(x, y, z, local)];
+			const uint64_t bit = 1ull << (local & 63);
+
+			if (((word & bit) != 0) == solid)
+			{
+				return;
+			}
+
+			word ^= bit;
+
+			const int brick = m_Indexer.GetBrickIndex(x, y, z);
+			m_SolidCounts[brick] += solid ? 1 : -1;
+
+			// The cell went from empty to non empty or the other way around
+			if (word == 0 || word == bit)
+			{
+				uint64_t& cells = m_BrickCellMasks[brick];
+				const uint64_t cell_bit = 1ull << (local >> 6);
+				cells ^= cell_bit;
+
+				if (cells == 0 || cells == cell_bit)
+				{
+					m_RegionBrickMasks[GetRegionIndex(x, y, z)] ^= 1ull << GetBrickIndexInRegion(x, y, z);
+				}
+			}
+		}
+
+		// Sets every voxel of the 16^3 brick containing the voxel, for bulk edits that fill entire chunks
+		void FillBrick(int x, int y, int z, bool solid) noexcept;
+
+		// Replaces the bits of the 16^3 brick containing the voxel, words has BRICK_VOLUME / 64 of them in the order of
+		// the mask (see VoxelChunk::GetVoxelMask()), for the writes that replace entire chunks
+		void SetBrick(int x, int y, int z, const uint64_t* words) noexcept;
+
+		// Moves every brick by -delta bricks (brick p takes the bits of brick p + delta), the bricks that come from
+		// outside of the volume are empty
+		void ShiftBricks(const glm::ivec3& delta);
+
+		// The 4^3 cell containing the voxel
+		inline uint64_t GetCellWord(int x, int y, int z) const noexcept
+		{
+			return m_Words[GetWordIndex(x, y, z, VoxelIndexing::GetBrickLocalIndex(x, y, z))];
+		}
+
+		inline bool IsCellEmpty(int x, int y, int z) const noexcept
+		{
+			return GetCellWord(x, y, z) == 0;
+		}
+
+		// The BRICK_SIZE long x row of the brick containing the voxel
+		bool IsRowEmpty(int x, int y, int z) const noexcept;
+
+		// The 16^3 brick containing the voxel
+		inline bool IsBrickEmpty(int x, int y, int z) const noexcept
+		{
+			return m_SolidCounts[m_Indexer.GetBrickIndex(x, y, z)] == 0;
+		}
+
+		inline int GetSolidCount(int x, int y, int z) const noexcept
+		{
+			return m_SolidCounts[m_Indexer.GetBrickIndex(x, y, z)];
+		}
+
+		// Mask of the non empty 4^3 cells in the brick containing the voxel, bit (brick local morton index >> 6)
+		inline uint64_t GetBrickCellMask(int x, int y, int z) const noexcept
+		{
+			return m_BrickCellMasks[m_Indexer.GetBrickIndex(x, y, z)];
+		}
+
+		// Mask of the non empty bricks in the 64^3 region containing the voxel, bit GetBrickIndexInRegion()
+		inline uint64_t GetRegionBrickMask(int x, int y, int z) const noexcept
+		{
+			return m_RegionBrickMasks[GetRegionIndex(x, y, z)];
+		}
+
+		inline bool IsRegionEmpty(int x, int y, int z) const noexcept
+		{
+			return m_RegionBrickMasks[GetRegionIndex(x, y, z)] == 0;
+		}
+
+		static inline int GetBrickIndexInRegion(int x, int y, int z) noexcept
+		{
+			return (int)VoxelIndexing::GetBrickLocalIndex(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT) & 63;
+		}
+
+		static inline int CountBits(uint64_t word) noexcept
+		{
+			return (int)std::bitset<64>(word).count();
+		}
+
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		inline size_t GetWordIndex(int x, int y, int z, int local) const noexcept
+		{
+			return ((size_t)m_Indexer.GetBrickIndex(x, y, z) * (BRICK_VOLUME / 64)) + (local >> 6);
+		}
+
+		inline int GetRegionIndex(int x, int y, int z) const noexcept
+		{
+			return (x >> REGION_SHIFT) + (y >> REGION_SHIFT) * m_RegionsX + (z >> REGION_SHIFT) * m_RegionsXY;
+		}
+
+		static const int REGION_SHIFT = 6; // 64^3
+
+		BrickedVolumeIndexer m_Indexer;
+		std::vector<uint64_t> m_Words;
+		std::vector<uint16_t> m_SolidCounts;
+		std::vector<uint64_t> m_BrickCellMasks;
+		std::vector<uint64_t> m_RegionBrickMasks;
+		int m_RegionsX = 0;
+		int m_RegionsXY = 0;
+	};
+}
@@ -0,0 +1,181 @@
+#include "PackedVoxelVolume.h"
+
+#include <algorithm>
+
+#include "World.h"
+#include "VolumetricFloodFill.h"
+
+void VoxelRT::PackedVoxelVolume::Build(const World& world)
+{
+	const glm::ivec3& Dimensions = world.GetDimensions();
+
+	m_Texture.CreateTexture(Dimensions.x, Dimensions.y, Dimensions.z, nullptr, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+	m_Dirty.Clear();
+
+	// The volumetrics sample the light level with hardware trilinear filtering, texelFetch() ignores it
+	glBindTexture(GL_TEXTURE_3D, m_Texture.GetTextureID());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Upload one slab of chunks at a time so that we never need a flat copy of the entire volume
+	for (int z = 0; z < Dimensions.z; z += CHUNK_SIZE)
+	{
+		UploadRegion(world, glm::ivec3(0, 0, z), glm::ivec3(Dimensions.x, Dimensions.y, glm::min(CHUNK_SIZE, Dimensions.z - z)));
+	}
+
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	m_UploadBuffer.clear();
+	m_UploadBuffer.shrink_to_fit();
+	m_BlockBuffer.clear();
+	m_BlockBuffer.shrink_to_fit();
+	m_DistanceBuffer.clear();
+	m_DistanceBuffer.shrink_to_fit();
+	m_LightBuffer.clear();
+	m_LightBuffer.shrink_to_fit();
+	m_LightColorBuffer.clear();
+	m_LightColorBuffer.shrink_to_fit();
+}
+
+void VoxelRT::PackedVoxelVolume::Flush(const World& world)
+{
+	if (m_Dirty.IsEmpty())
+	{
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_Texture.GetTextureID());
+
+	for (const DirtyBox& box : m_Dirty.GetBoxes())
+	{
+		UploadRegion(world, box.Min, box.GetSize());
+	}
+
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	m_Dirty.Clear();
+}
+
+void VoxelRT::PackedVoxelVolume::ReadRegion(const World& world, const glm::ivec3& origin, const glm::ivec3& size, uint32_t* output)
+{
+	const size_t Volume = (size_t)size.x * size.y * size.z;
+
+	m_BlockBuffer.resize(Volume);
+	m_DistanceBuffer.resize(Volume);
+	m_LightBuffer.resize(Volume);
+	m_LightColorBuffer.resize(Volume);
+
+	world.m_WorldData.ReadRegion(origin, size, m_BlockBuffer.data());
+	Volumetrics::ReadRegion(origin, size, m_LightBuffer.data(), m_LightColorBuffer.data());
+
+	if (world.GetDistanceField().IsValid())
+	{
+		world.GetDistanceField().ReadRegion(origin, size, m_DistanceBuffer.data());
+	}
+
+	else
+	{
+		std::fill(m_DistanceBuffer.begin(), m_DistanceBuffer.end(), 0);
+	}
+
+	for (size_t i = 0; i < Volume; i++)
+	{
+		output[i] = Pack(m_BlockBuffer[i], m_DistanceBuffer[i], m_LightBuffer[i], (uint8_t)m_LightColorBuffer[i]);
+	}
+}
+
+void VoxelRT::PackedVoxelVolume::UploadRegion(const World& world, const glm::ivec3& origin, const glm::ivec3& size)
+{
+	m_UploadBuffer.resize((size_t)size.x * size.y * size.z);
+	ReadRegion(world, origin, size, m_UploadBuffer.data());
+
+	// 8_8_8_8_REV puts the lowest byte in the red channel whatever the endianness
+	glTexSubImage3D(GL_TEXTURE_3D, 0, origin.x, origin.y, origin.z, size.x, size.y, size.z, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, m_UploadBuffer.data());
+}
+
+void VoxelRT::PackedVoxelVolume::Bind(int unit) const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, m_Texture.GetTextureID());
+}
+
+bool VoxelRT::PackedVoxelVolume::RunPackingTest()
+{
+	const uint8_t Others[] = { 0, 1, 127, 128, 254, 255 };
+	int RoundTripErrors = 0;
+
+	// Every value of each channel with the edge values in the other three
+	for (int channel = 0; channel < 4; channel++)
+	{
+		for (int v = 0; v < 256; v++)
+		{
+			for (uint8_t a : Others)
+			{
+				for (uint8_t b : Others)
+				{
+					for (uint8_t c : Others)
+					{
+						const uint8_t Rest[3] = { a, b, c };
+						uint8_t Values[4];
+
+						for (int k = 0; k < 4; k++)
+						{
+							Values[k] = k == channel ? (uint8_t)v : Rest[k - (k > channel ? 1 : 0)];
+						}
+
+						const uint32_t Texel = Pack(Values[0], Values[1], Values[2], Values[3]);
+						const PackedVoxel Voxel = Unpack(Texel);
+
+						if (Voxel.Block != Values[0] || Voxel.Distance != Values[1] || Voxel.Light != Values[2] || Voxel.LightColor != Values[3] ||
+							Pack(Voxel.Block, Voxel.Distance, Voxel.Light, Voxel.LightColor) != Texel)
+						{
+							RoundTripErrors++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Channel order on the gpu : 256 texels uploaded like UploadRegion() does, read back a byte per channel
+	std::vector<uint32_t> Texels(256);
+	std::vector<uint8_t> Channels(Texels.size() * 4, 0);
+
+	for (int i = 0; i < 256; i++)
+	{
+		Texels[i] = Pack((uint8_t)i, (uint8_t)(255 - i), (uint8_t)(i ^ 0x55), (uint8_t)(i * 7));
+	}
+
+	GLuint Texture = 0;
+	glGenTextures(1, &Texture);
+	glBindTexture(GL_TEXTURE_3D, Texture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, 16, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, 16, 4, 4, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, Texels.data());
+	glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_UNSIGNED_BYTE, Channels.data());
+	glBindTexture(GL_TEXTURE_3D, 0);
+	glDeleteTextures(1, &Texture);
+
+	int ChannelErrors = 0;
+
+	for (int i = 0; i < 256; i++)
+	{
+		const PackedVoxel Voxel = Unpack(Texels[i]);
+		const uint8_t* RGBA = &Channels[(size_t)i * 4];
+		ChannelErrors += RGBA[0] != Voxel.Block || RGBA[1] != Voxel.Distance || RGBA[2] != Voxel.Light || RGBA[3] != Voxel.LightColor;
+	}
+
+	std::cout << "\nPacked voxel volume, pack/unpack mismatches : " << RoundTripErrors << ", texels with the wrong channel order on the gpu : "
+		<< ChannelErrors << " of 256\n";
+
+	return RoundTripErrors == 0 && ChannelErrors == 0;
+}
+
+size_t VoxelRT::PackedVoxelVolume::GetVideoMemoryUsage() const noexcept
+{
+	if (!IsCreated())
+	{
+		return 0;
+	}
+
+	return (size_t)m_Texture.GetWidth() * m_Texture.GetHeight() * m_Texture.GetDepth() * sizeof(uint32_t);
+}
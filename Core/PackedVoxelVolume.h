@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "DirtyRegion.h"
+#include "Texture3D.h"
+
+namespace VoxelRT
+{
+	class World;
+
+	struct PackedVoxel
+	{
+		uint8_t Block;
+		uint8_t Distance;
+		uint8_t Light;
+		uint8_t LightColor;
+	};
+
+	// Interleaved copy of the four volumes the primary trace and the volumetrics read per voxel, so that one fetch
+	// returns all of them. One RGBA8 texel per voxel :
+	//	R : block id (k / 255, like m_DataTexture)
+	//	G : distance field (like m_DistanceFieldTexture)
+	//	B : flood fill light level (like the density volume)
+	//	A : block type of the light (like the color volume, it indexes the average color ssbo)
+	// The shaders have to be compiled with VOXEL_RT_PACKED_VOLUME defined to read it (u_PackedVoxelVolume).
+	//
+	// There's no cpu copy, the boxes marked dirty are packed from the world data, the distance field and the light
+	// volume when the volume is flushed. The separate volumes are still kept, the other passes read them.
+	// Only for 8 bit block ids (BlockDatabase::UsesWideBlockIDs() is false).
+
+	class PackedVoxelVolume
+	{
+	public :
+
+		// u_PackedVoxelVolume, past the units the passes already use (a sampler can use any unit below the combined limit)
+		static constexpr int TEXTURE_UNIT = 32;
+
+		static inline uint32_t Pack(uint8_t block, uint8_t distance, uint8_t light, uint8_t light_color) noexcept
+		{
+			return (uint32_t)block | ((uint32_t)distance << 8) | ((uint32_t)light << 16) | ((uint32_t)light_color << 24);
+		}
+
+		static inline PackedVoxel Unpack(uint32_t texel) noexcept
+		{
+			return { (uint8_t)(texel & 0xFF), (uint8_t)((texel >> 8) & 0xFF), (uint8_t)((texel >> 16) & 0xFF), (uint8_t)(texel >> 24) };
+		}
+
+		// Checks that Unpack() gives back what Pack() was given for every value of every channel and that a texel
+		// uploaded the way the volume is (GL_UNSIGNED_INT_8_8_8_8_REV) reads back as block, distance, light and light
+		// color in R, G, B and A. Needs a context, prints the mismatches and returns false if there was any.
+		// World::BufferPackedVolume() runs it with VOXEL_RT_PACKED_VOLUME_DEBUG defined
+		static bool RunPackingTest();
+
+		// (Re)creates the texture and packs the entire world into it
+		// The distance field and the light volume have to exist already (they're read as zeros otherwise)
+		void Build(const World& world);
+
+		// max is exclusive, the box is repacked on the next Flush()
+		inline void MarkDirty(const glm::ivec3& min, const glm::ivec3& max)
+		{
+			if (m_Texture.GetTextureID() != 0)
+			{
+				m_Dirty.Add(min, max);
+			}
+		}
+
+		// Repacks and uploads the dirty boxes, called once per frame after the world and the light volume are flushed
+		void Flush(const World& world);
+
+		// Packs a box of voxels (x + y * size.x + z * size.x * size.y)
+		void ReadRegion(const World& world, const glm::ivec3& origin, const glm::ivec3& size, uint32_t* output);
+
+		void Bind(int unit = TEXTURE_UNIT) const;
+
+		inline bool IsCreated() const noexcept { return m_Texture.GetTextureID() != 0; }
+		inline GLuint GetTextureID() const noexcept { return m_Texture.GetTextureID(); }
+		size_t GetVideoMemoryUsage() const noexcept;
+
+	private :
+
+		void UploadRegion(const World& world, const glm::ivec3& origin, const glm::ivec3& size);
+
+		Texture3D m_Texture;
+		DirtyRegion m_Dirty;
+
+		std::vector<uint32_t> m_UploadBuffer;
+		std::vector<uint8_t> m_BlockBuffer;
+		std::vector<uint8_t> m_DistanceBuffer;
+		std::vector<uint8_t> m_LightBuffer;
+		std::vector<uint16_t> m_LightColorBuffer;
+	};
+}
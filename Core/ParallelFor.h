@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace VoxelRT
+{
+	// Splits [0, count) into thread_count ranges and runs func(begin, end) for each of them on its own thread
+	template <typename T>
+	void ParallelFor(int count, int thread_count, const T& func)
+	{
+		thread_count = std::max(1, std::min(thread_count, count));
+
+		if (thread_count == 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		std::vector<std::thread> Threads;
+
+		for (int i = 0; i < thread_count; i++)
+		{
+			const int Begin = (int)(((int64_t)count * i) / thread_count);
+			const int End = (int)(((int64_t)count * (i + 1)) / thread_count);
+			Threads.emplace_back([&func, Begin, End]() { func(Begin, End); });
+		}
+
+		for (std::thread& thread : Threads)
+		{
+			thread.join();
+		}
+	}
+}
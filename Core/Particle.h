@@ -8,6 +8,7 @@
 
 #include <array>
 #include "Macros.h"
+#include "WorldData.h"
 
 namespace VoxelRT
 {
@@ -37,39 +38,24 @@ namespace VoxelRT
 				m_InitialPosition = blockpos;
 			}
 
-			bool TestParticleCollision(const glm::vec3& pos, std::array<Block, WORLD_SIZE_X* WORLD_SIZE_Y* WORLD_SIZE_Z>& data)
+			bool TestParticleCollision(const glm::vec3& pos, const WorldData& data)
 			{
 				glm::ivec3 SamplePos = glm::ivec3(floor(pos.x), floor(pos.y), floor(pos.z));
 
-				if (SamplePos.x > 0 && SamplePos.x < WORLD_SIZE_X &&
-					SamplePos.y > 0 && SamplePos.y < WORLD_SIZE_Y &&
-					SamplePos.z > 0 && SamplePos.z < WORLD_SIZE_Z )
+				const glm::ivec3& WorldSize = data.GetDimensions();
+
+				if (SamplePos.x > 0 && SamplePos.x < WorldSize.x &&
+					SamplePos.y > 0 && SamplePos.y < WorldSize.y &&
+					SamplePos.z > 0 && SamplePos.z < WorldSize.z )
 				{
-					int loc = SamplePos.x + SamplePos.y * WORLD_SIZE_X + SamplePos.z * WORLD_SIZE_X * WORLD_SIZE_Y;
-					
-					if (loc >= WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z)
-					{
-						return false;
-					}
-					
-					uint8_t block1 = data.at(loc).block;
-					
-					if (block1 == 0)
-					{
-						return false;
-					}
-
-					else
-					{
-						return true;
-					}
+					return data.IsSolid(SamplePos.x, SamplePos.y, SamplePos.z);
 				}
 
 				return false;
 			}
 
 
-			void OnUpdate(std::array<Block, WORLD_SIZE_X* WORLD_SIZE_Y* WORLD_SIZE_Z>& data, float dt)
+			void OnUpdate(const WorldData& data, float dt)
 			{
 				glm::vec3 pos_before = m_Position;
 
@@ -127,7 +113,7 @@ namespace VoxelRT
 			bool m_IsAlive;
 			bool m_HasCollided = false;
 
-			uint8_t m_BlockType;
+			uint16_t m_BlockType;
 			ParticleDirection m_Dir;
 		};
 	}
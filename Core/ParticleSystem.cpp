@@ -132,7 +132,7 @@ namespace VoxelRT
 		}
 
 		void ParticleEmitter::EmitParticlesAt(const glm::vec3& blockpos, float lifetime, int num_particles, const glm::vec3& origin, const glm::vec3& extent,
-			const glm::vec3& vel, uint8_t block)
+			const glm::vec3& vel, uint16_t block)
 		{
 			Random random;
 
@@ -161,7 +161,7 @@ namespace VoxelRT
 			}
 		}
 
-		void ParticleEmitter::OnUpdateAndRender(FPSCamera* camera, std::array<Block, WORLD_SIZE_X* WORLD_SIZE_Y* WORLD_SIZE_Z>& data, GLuint pos_tex, GLuint shadow_tex, GLuint diff, GLuint diff2, const glm::vec3& sundir, const glm::vec3& player_pos, const glm::vec2& dims, float dt)
+		void ParticleEmitter::OnUpdateAndRender(FPSCamera* camera, const WorldData& data, GLuint pos_tex, GLuint shadow_tex, GLuint diff, GLuint diff2, const glm::vec3& sundir, const glm::vec3& player_pos, const glm::vec2& dims, float dt)
 		{
 			m_Renderer.StartParticleRender();
 
@@ -189,5 +189,14 @@ namespace VoxelRT
 				}
 			}
 		}
+
+		void ParticleEmitter::Translate(const glm::vec3& offset)
+		{
+			for (Particle& particle : m_Particles)
+			{
+				particle.m_Position += offset;
+				particle.m_InitialPosition += offset;
+			}
+		}
 	}
 }
@@ -49,9 +49,13 @@ namespace VoxelRT
 		public : 
 			ParticleEmitter();
 			void EmitParticlesAt(const glm::vec3& blockpos, float lifetime, int num_particles, const glm::vec3& origin, 
-				const glm::vec3& extent, const glm::vec3& vel, uint8_t block);
-			void OnUpdateAndRender(FPSCamera* camera, std::array<Block, WORLD_SIZE_X* WORLD_SIZE_Y* WORLD_SIZE_Z>& data, GLuint, GLuint, GLuint, GLuint, const glm::vec3& sundir, const glm::vec3& player_pos, const glm::vec2& dims, float);
+				const glm::vec3& extent, const glm::vec3& vel, uint16_t block);
+			void OnUpdateAndRender(FPSCamera* camera, const WorldData& data, GLuint, GLuint, GLuint, GLuint, const glm::vec3& sundir, const glm::vec3& player_pos, const glm::vec2& dims, float);
 			void CleanUpList();
+
+			// Moves every particle along with a streamed world (World::ShiftWindow())
+			void Translate(const glm::vec3& offset);
+
 			void Recompile() { m_Renderer.Recompile(); }
 
 		private :
@@ -5,6 +5,8 @@
 // includes 
 #include "Pipeline.h"
 #include <chrono>
+#include <algorithm>
+#include <filesystem>
 #include "ShaderManager.h"
 #include "BlockDataSSBO.h"
 #include "BlueNoiseDataSSBO.h"
@@ -12,7 +14,11 @@
 #include "TAAJitter.h"
 #include "VolumetricFloodFill.h"
 #include "NBT/Importer.h"
+#include "ChunkStreamer.h"
+#include "LazyWorldLoader.h"
+#include "WorldAutosaver.h"
 #include "AnimatedTexture.h"
+#include "Utils/Timer.h"
 
 // Player/World/Cameras
 static VoxelRT::Player MainPlayer;
@@ -20,6 +26,21 @@ static VoxelRT::World* world = nullptr;
 static VoxelRT::FPSCamera& MainCamera = MainPlayer.Camera;
 static VoxelRT::OrthographicCamera OCamera(0.0f, 800.0f, 0.0f, 600.0f);
 
+// Streamed (unbounded) worlds
+static VoxelRT::ChunkStreamer Streamer;
+static bool StreamingStressTest = false; // Flies the player along +x and reports the upload bandwidth and the hitches
+static float StreamingStressSpeed = 4.0f; // Blocks per frame
+static float StreamingStressDistance = 0.0f;
+static std::vector<float> StreamingStressFrames;
+static size_t StreamingStressUploadedBytes = 0;
+
+static VoxelRT::LazyWorldLoader LazyLoader;
+static int LazyLoadChunksPerFrame = 64; // Chunks that aren't empty
+
+static VoxelRT::WorldAutosaver Autosaver;
+static bool Autosave = true;
+static float AutosaveInterval = 60.0f; // Seconds
+
 // Flags
 static bool ModifiedWorld = false;
 
@@ -57,8 +78,15 @@ static float InitialTraceResolution = 1.0f;
 static float GBufferResolution = 1.0f;
 static int RenderDistance = 475;
 
+// Voxel LOD (distance at which the 2x level starts, the coarser ones start at 2x and 4x that)
+static float PrimaryLODDistance = 160.0f;
+static float SecondaryLODDistance = 24.0f;
+
 // Misc
 static bool VSync = false;
+static bool CacheDistanceField = false; // Saves the distance field along with the world so that loading doesn't have to generate it
+static int EditHistoryBudget = 32; // MB
+static bool RecordEditLog = false; // Streams the edits to Saves/<world>.editlog
 static bool Fucktard = false;
 static bool JitterSceneForTAA = true;
 static int PIXEL_PADDING = 20; // to reduce artifacts on edges
@@ -399,6 +427,101 @@ public:
 
 			ImGui::NewLine();
 			ImGui::Checkbox("VSync", &VSync);
+			ImGui::Checkbox("Cache distance field in the save file", &CacheDistanceField);
+			ImGui::NewLine();
+
+			if (world)
+			{
+				VoxelRT::EditJournal& Journal = world->GetJournal();
+				ImGui::Text("Edit history (Ctrl+Z / Ctrl+Y) : %d undo, %d redo, %.2f MB", (int)Journal.GetUndoCount(), (int)Journal.GetRedoCount(), (float)Journal.GetMemoryUsage() / (1024.0f * 1024.0f));
+
+				if (ImGui::SliderInt("Edit history budget (MB)", &EditHistoryBudget, 1, 512))
+				{
+					Journal.SetMemoryBudget((size_t)EditHistoryBudget * 1024 * 1024);
+				}
+
+				// Moving the window or loading another world closes the log
+				RecordEditLog = Journal.IsLogOpen();
+
+				if (ImGui::Checkbox("Record edit log", &RecordEditLog))
+				{
+					if (RecordEditLog)
+					{
+						RecordEditLog = Journal.OpenLog("Saves/" + world->m_Name + ".editlog", world->GetDimensions());
+					}
+
+					else
+					{
+						Journal.CloseLog();
+					}
+				}
+
+				// Streamed worlds keep their edited columns in the column cache instead
+				if (!world->IsStreamed() && ImGui::Checkbox("Autosave", &Autosave))
+				{
+					if (Autosave)
+					{
+						Autosaver.Start(world->m_Name, AutosaveInterval);
+					}
+
+					else
+					{
+						Autosaver.Stop();
+					}
+				}
+
+				if (Autosaver.IsRunning())
+				{
+					if (ImGui::SliderFloat("Autosave interval (seconds)", &AutosaveInterval, 10.0f, 600.0f))
+					{
+						Autosaver.SetInterval(AutosaveInterval);
+					}
+
+					if (!Autosaver.IsSaving())
+					{
+						const VoxelRT::WorldAutosaverStats& Stats = Autosaver.GetStats();
+						ImGui::Text("Autosaves : %d (%d appended, %d unchanged), last one took %.2f ms on this thread and %.1f ms on the worker, %.2f MB", (int)Stats.Saves, (int)Stats.AppendedSaves, (int)Stats.SkippedSaves,
+							Stats.LastRequestTime, Stats.LastWriteTime, (float)Stats.LastFileSize / (1024.0f * 1024.0f));
+					}
+				}
+
+				if (!RecordEditLog && ImGui::Button("Replay edit log"))
+				{
+					Blocks::Timer ReplayTimer;
+					ReplayTimer.Start();
+					const int Replayed = Journal.ReplayLog("Saves/" + world->m_Name + ".editlog", world);
+					std::cout << "\nReplayed " << Replayed << " edit transactions in " << ReplayTimer.End() << " ms\n";
+					ModifiedWorld = Replayed > 0;
+				}
+
+#ifdef VOXEL_RT_SNAPSHOT_DEBUG
+				// Runs on a world of its own, the current one isn't touched
+				if (ImGui::Button("Snapshot stress test (5 seconds, blocks the frame)"))
+				{
+					VoxelRT::WorldSnapshot::RunStressTest(5.0f);
+				}
+#endif
+
+				if (world->IsStreamed())
+				{
+					const VoxelRT::ChunkStreamerStats& Stats = Streamer.GetStats();
+					ImGui::NewLine();
+					ImGui::Text("Streaming : %d columns generated, %d loaded, %d saved, %d window moves, %d queued, %d ready", (int)Stats.ColumnsGenerated,
+						(int)Stats.ColumnsLoaded, (int)Stats.ColumnsSaved, (int)Stats.Shifts, (int)Stats.QueuedColumns, (int)Stats.ReadyColumns);
+					ImGui::SliderFloat("Stress test speed (blocks per frame)", &StreamingStressSpeed, 0.5f, 16.0f);
+
+					if (!StreamingStressTest && ImGui::Button("Streaming stress test (fly 10000 blocks)"))
+					{
+						StreamingStressTest = true;
+						StreamingStressDistance = 0.0f;
+						StreamingStressFrames.clear();
+						StreamingStressUploadedBytes = world->GetUploadedBytes();
+						MainPlayer.Freefly = true;
+						MainPlayer.DisableCollisions = true;
+					}
+				}
+			}
+
 			ImGui::NewLine();
 			ImGui::NewLine();
 
@@ -459,6 +582,8 @@ public:
 			ImGui::SliderFloat("GBuffer Generate Resolution", &GBufferResolution, 0.1f, 1.0f);
 			if (ADVANCED_MODE)
 				ImGui::SliderInt("DF Trace Length.", &RenderDistance, 20, 600);
+			ImGui::SliderFloat("Voxel LOD Distance (Primary rays)", &PrimaryLODDistance, 16.0f, 512.0f);
+			ImGui::SliderFloat("Voxel LOD Distance (Shadow, GI and reflection rays)", &SecondaryLODDistance, 4.0f, 256.0f);
 			ImGui::NewLine();
 
 
@@ -869,7 +994,7 @@ public:
 				int cx = int(floor(float(block_loc.x) / float(16)));
 				int cy = int(floor(float(block_loc.y) / float(16)));
 				int cz = int(floor(float(block_loc.z) / float(16)));
-				int OffsetArrayFetchLocation = (cz * 24 * 8) + (cy * 24) + cx;
+				int OffsetArrayFetchLocation = world->Get1DIndexForLightChunk(cx, cy, cz);
 				glm::ivec2 ChunkData = world->LightChunkOffsets[OffsetArrayFetchLocation];
 
 				ImGui::Text("Player Original Position : %f  %f  %f", MainPlayer.m_Position.x, MainPlayer.m_Position.y, MainPlayer.m_Position.z);
@@ -913,9 +1038,11 @@ public:
 					glm::ivec3 Idx = glm::ivec3(glm::floor(MainPlayer.m_Position));
 					Idx.y -= 2;
 
-					if (Idx.x > 0 && Idx.x < WORLD_SIZE_X - 1 && 
-						Idx.y > 0 && Idx.y < WORLD_SIZE_Y - 1 && 
-						Idx.z > 0 && Idx.z < WORLD_SIZE_Z - 1)
+					const glm::ivec3& WorldSize = world->GetDimensions();
+
+					if (Idx.x > 0 && Idx.x < WorldSize.x - 1 && 
+						Idx.y > 0 && Idx.y < WorldSize.y - 1 && 
+						Idx.z > 0 && Idx.z < WorldSize.z - 1)
 					{
 						auto blockat = world->GetBlock((uint16_t)Idx.x, (uint16_t)Idx.y, (uint16_t)Idx.z);
 						s1 = blockat.block > 0 ? VoxelRT::BlockDatabase::GetBlockName(blockat.block) : s1;
@@ -1065,6 +1192,14 @@ public:
 			}
 		}
 
+		if (e.type == VoxelRT::EventTypes::KeyPress && (e.mods & GLFW_MOD_CONTROL) && (e.key == GLFW_KEY_Z || e.key == GLFW_KEY_Y))
+		{
+			if (world)
+			{
+				ModifiedWorld = e.key == GLFW_KEY_Z ? world->Undo() : world->Redo();
+			}
+		}
+
 		if (e.type == VoxelRT::EventTypes::KeyPress && e.key == GLFW_KEY_F1)
 		{
 			this->SetCursorLocked(!this->GetCursorLocked());
@@ -1110,7 +1245,19 @@ public:
 
 		if (e.type == VoxelRT::EventTypes::KeyPress && e.key == GLFW_KEY_ESCAPE)
 		{
-			VoxelRT::SaveWorld(world, world->m_Name);
+			if (world->IsStreamed())
+			{
+				Streamer.SaveColumns(world);
+				Streamer.Stop();
+			}
+
+			else
+			{
+				// Both write the same file
+				Autosaver.Stop();
+				VoxelRT::SaveWorld(world, world->m_Name, CacheDistanceField);
+			}
+
 			delete world;
 			exit(0);
 		}
@@ -1139,10 +1286,10 @@ public:
 
 };
 
-GLClasses::Framebuffer InitialTraceFBO_1(16, 16, { {GL_R16F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R32F, GL_RED, GL_FLOAT, true, true} }, false);
-GLClasses::Framebuffer InitialTraceFBO_2(16, 16, { {GL_R16F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R32F, GL_RED, GL_FLOAT, true, true} }, false);
-GLClasses::Framebuffer HalfResGBuffer(16, 16, { {GL_R32F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false} }, false);
-GLClasses::Framebuffer QuarterResGBuffer(16, 16, { {GL_R32F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false} }, false);
+GLClasses::Framebuffer InitialTraceFBO_1(16, 16, { {GL_R16F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R16, GL_RED, GL_UNSIGNED_SHORT, false, false}, {GL_R32F, GL_RED, GL_FLOAT, true, true} }, false);
+GLClasses::Framebuffer InitialTraceFBO_2(16, 16, { {GL_R16F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R16, GL_RED, GL_UNSIGNED_SHORT, false, false}, {GL_R32F, GL_RED, GL_FLOAT, true, true} }, false);
+GLClasses::Framebuffer HalfResGBuffer(16, 16, { {GL_R32F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R16, GL_RED, GL_UNSIGNED_SHORT, false, false} }, false);
+GLClasses::Framebuffer QuarterResGBuffer(16, 16, { {GL_R32F, GL_RED, GL_FLOAT, true, true}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false}, {GL_R16, GL_RED, GL_UNSIGNED_SHORT, false, false} }, false);
 
 //GLClasses::Framebuffer GeneratedGBuffer(16, 16, { {GL_RGB16F, GL_RGB, GL_FLOAT, true, true}, {GL_RGB16F, GL_RED, GL_FLOAT, true, true}, {GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false} }, false);
 GLClasses::Framebuffer GeneratedGBuffer(16, 16, { {GL_RGB16F, GL_RGB, GL_FLOAT, true, true}, {GL_RGB16F, GL_RED, GL_FLOAT, true, true}, {GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, false, false}, {GL_RED, GL_RED, GL_UNSIGNED_BYTE, false, false} }, false);
@@ -1251,9 +1398,39 @@ void VoxelRT::MainPipeline::StartPipeline()
 
 	world->m_Name = world_name;
 
-	if (!LoadWorld(world, world_name, LightLocations))
+	bool LazyLoad = false;
+
+	if (std::filesystem::exists("Saves/" + world_name))
+	{
+		std::cout << "\nLoad the world progressively, starting around the spawn point? (Faster startup on large worlds) (NO = 0, YES = 1) : ";
+		std::cin >> LazyLoad;
+	}
+
+	// Only version 4 saves can be loaded progressively, LoadWorld() reads the others
+	if (LazyLoad && LazyLoader.Open(world, world_name, LightLocations))
+	{
+		// The player spawns above the center of the world, it needs the ground under it for the first frame
+		LazyLoader.LoadAround(glm::vec3(world->GetDimensions()) * 0.5f, 2);
+	}
+
+	else if (!LoadWorld(world, world_name, LightLocations))
 	{
-		std::cout << "\nWhat would you like to create your world with? (0 : TERRAIN GENERATOR, 1 : IMPORT MINECRAFT WORLD) : ";
+		glm::ivec3 NewWorldSize = glm::ivec3(0);
+		std::cout << "\nEnter the size of your world (X Y Z, multiples of 16. Enter 0 0 0 for the default size of "
+			<< DEFAULT_WORLD_SIZE_X << " " << DEFAULT_WORLD_SIZE_Y << " " << DEFAULT_WORLD_SIZE_Z << ") : ";
+		std::cin >> NewWorldSize.x;
+		std::cin >> NewWorldSize.y;
+		std::cin >> NewWorldSize.z;
+
+		if (NewWorldSize.x <= 0 || NewWorldSize.y <= 0 || NewWorldSize.z <= 0 ||
+			NewWorldSize.x % 16 != 0 || NewWorldSize.y % 16 != 0 || NewWorldSize.z % 16 != 0)
+		{
+			NewWorldSize = glm::ivec3(DEFAULT_WORLD_SIZE_X, DEFAULT_WORLD_SIZE_Y, DEFAULT_WORLD_SIZE_Z);
+		}
+
+		world->Resize(NewWorldSize);
+
+		std::cout << "\nWhat would you like to create your world with? (0 : TERRAIN GENERATOR, 1 : IMPORT MINECRAFT WORLD, 2 : STREAMED (UNBOUNDED) TERRAIN) : ";
 		std::cin >> create_type;
 		std::cout << "\n\n";
 
@@ -1293,6 +1470,32 @@ void VoxelRT::MainPipeline::StartPipeline()
 			std::cin >> ImportOrigin.z;
 			VoxelRT::MCWorldImporter::ImportWorld(MinecraftWorldPath, &world->m_WorldData, ImportOrigin);
 		}
+
+		// Loaded worlds get their lights from LoadWorld(), the generated and imported ones from the chunk summaries
+		if (create_type == 0 || create_type == 1) {
+			world->m_WorldData.GetLights(glm::ivec3(0), world->GetDimensions(), LightLocations);
+		}
+
+		else if (create_type == 2) {
+			// The world size is the size of the window that moves along with the player
+			VoxelRT::ChunkStreamerSettings Settings;
+			std::cout << "\nEnter the seed : ";
+			std::cin >> Settings.Seed;
+			std::cout << "\nGenerate structures? (NO = 0, YES = 1) : ";
+			std::cin >> Settings.Structures;
+			std::cout << "\n\n";
+
+			// Edited columns are kept next to the save files, the window itself isn't saved
+			Settings.CacheDirectory = "Saves/" + world_name + ".columns";
+
+			world->SetStreamed(true);
+			Streamer.Start(world, Settings, LightLocations);
+		}
+	}
+
+	if (Autosave && !world->IsStreamed())
+	{
+		Autosaver.Start(world_name, AutosaveInterval);
 	}
 
 
@@ -1301,6 +1504,26 @@ void VoxelRT::MainPipeline::StartPipeline()
 	std::cout << "\nHardware Spec? (0 -> Low, 1 -> Medium (RECOMMENDED), 2 -> High, 3 -> Insane) : ";
 	std::cin >> HardwareProfile;
 
+	bool UseBrickPool = false;
+
+	std::cout << "\nStore the voxel data on the gpu as a sparse brick pool? (Uses less VRAM) (NO = 0, YES = 1) : ";
+	std::cin >> UseBrickPool;
+
+	bool UsePackedVolume = false;
+
+	std::cout << "\nPack the voxel, distance and light volumes into a single RGBA8 volume for the primary trace and the volumetrics? (Uses more VRAM) (NO = 0, YES = 1) : ";
+	std::cin >> UsePackedVolume;
+
+	bool UseDirectionalDistanceField = false;
+
+	std::cout << "\nGenerate a directional (per octant) distance field so that rays take longer steps? (Uses more VRAM) (NO = 0, YES = 1) : ";
+	std::cin >> UseDirectionalDistanceField;
+
+	bool UseVoxelLOD = false;
+
+	std::cout << "\nGenerate 2x/4x/8x downsampled copies of the world so that far away rays trace coarser voxels? (Uses more VRAM) (NO = 0, YES = 1) : ";
+	std::cin >> UseVoxelLOD;
+
 	std::cout << "\n\n\n";
 
 	if (HardwareProfile == 0)
@@ -1364,10 +1587,122 @@ void VoxelRT::MainPipeline::StartPipeline()
 		TAABiasAdder = 0.0;
 	}
 
+	const glm::ivec3 WorldSize = world->GetDimensions();
+
+	// Voxel storage stats (compared to a flat byte per voxel array)
+	std::cout << "\nWorld voxel storage : " << (float)world->m_WorldData.GetMemoryUsage() / (1024.0f * 1024.0f) << " MB "
+		<< "(Flat array : " << ((float)WorldSize.x * WorldSize.y * WorldSize.z) / (1024.0f * 1024.0f) << " MB, "
+		<< world->m_WorldData.GetUniformChunkCount() << "/" << world->m_WorldData.GetChunkCount() << " uniform chunks, "
+		<< (float)world->m_WorldData.GetOccupancy().GetMemoryUsage() / (1024.0f * 1024.0f) << " MB of it is the occupancy mask)\n";
+
+	// The world dimensions are only known at runtime, pass them on to every shader compiled from here on
+	GLClasses::SetGlobalShaderDefine("WORLD_SIZE_X", std::to_string(WorldSize.x));
+	GLClasses::SetGlobalShaderDefine("WORLD_SIZE_Y", std::to_string(WorldSize.y));
+	GLClasses::SetGlobalShaderDefine("WORLD_SIZE_Z", std::to_string(WorldSize.z));
+
+	// Block ids are stored as unorm values in the voxel volume and the gbuffer, 8 bit unless the database needs more
+	// The gbuffer id attachments are always R16 (it represents both k / 255 and k / 65535 exactly)
+	GLClasses::SetGlobalShaderDefine("BLOCK_ID_SCALE", BlockDatabase::UsesWideBlockIDs() ? "65535.0f" : "255.0f");
+	GLClasses::SetGlobalShaderDefine("BLOCK_DATA_SIZE", std::to_string(BlockDatabase::GetBlockDataTableSize()));
+
+	// Only the dense volumes can be addressed toroidally
+	if (world->IsStreamed() && (UseBrickPool || UsePackedVolume || UseDirectionalDistanceField || UseVoxelLOD))
+	{
+		std::cout << "\nThe brick pool, the packed volume, the directional distance field and the voxel LOD can't be used with a streamed world, using the dense volumes\n";
+		UseBrickPool = UsePackedVolume = UseDirectionalDistanceField = UseVoxelLOD = false;
+	}
+
+	if (world->IsStreamed())
+	{
+		GLClasses::SetGlobalShaderDefine("VOXEL_RT_STREAMING", "1");
+	}
+
+	if (UseBrickPool)
+	{
+		GLClasses::SetGlobalShaderDefine("VOXEL_RT_BRICK_POOL", "1");
+	}
+
+	// The packed volume is dense and stores 8 bit block ids
+	if (UsePackedVolume && (UseBrickPool || BlockDatabase::UsesWideBlockIDs()))
+	{
+		std::cout << "\nThe packed volume can't be used with the brick pool or with block ids above 255, using the separate volumes\n";
+		UsePackedVolume = false;
+	}
+
+	if (UsePackedVolume)
+	{
+		GLClasses::SetGlobalShaderDefine("VOXEL_RT_PACKED_VOLUME", "1");
+	}
+
+	if (UseDirectionalDistanceField)
+	{
+		GLClasses::SetGlobalShaderDefine("VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD", "1");
+	}
+
+	if (UseVoxelLOD)
+	{
+		GLClasses::SetGlobalShaderDefine("VOXEL_RT_VOXEL_LOD", "1");
+	}
+
 	// Initialize world, df generator etc 
-	world->Buffer();
+	Blocks::Timer DistanceFieldTimer;
+	world->Buffer(UseBrickPool);
+
+	std::cout << "\nVoxel data on the gpu : " << (float)world->GetVoxelDataVideoMemory() / (1024.0f * 1024.0f) << " MB";
+
+	if (UseBrickPool)
+	{
+		const VoxelRT::BrickPool& Pool = world->GetBrickPool();
+		std::cout << " (Brick pool, " << Pool.GetStoredBrickCount() << " stored / " << Pool.GetUniformBrickCount() << " uniform / "
+			<< Pool.GetEmptyBrickCount() << " empty 8^3 bricks, atlas capacity : " << Pool.GetAtlasCapacity() << ")";
+	}
+
+	std::cout << "\nVoxel states : " << world->m_WorldData.GetStates().GetCount() << " (" << world->GetStatePool().GetStoredBrickCount()
+		<< " 8^3 bricks on the gpu, " << (float)world->GetStatePool().GetVideoMemoryUsage() / (1024.0f * 1024.0f) << " MB)";
+
+	std::cout << "\n";
 	world->InitializeDistanceGenerator();
-	world->GenerateDistanceField();
+	DistanceFieldTimer.Start();
+
+	if (world->GetDistanceField().IsValid())
+	{
+		// Or the approximate one of a world that is loaded progressively (see LazyWorldLoader.h)
+		std::cout << "\nUsing the distance field " << (LazyLoader.IsLoading() ? "of the world being loaded" : "cached in the save file") << "\n";
+		world->UploadDistanceField();
+	}
+
+	else
+	{
+		world->GenerateDistanceField();
+	}
+
+	glFinish();
+	std::cout << "\nInitial distance field (" << WorldSize.x << "x" << WorldSize.y << "x" << WorldSize.z << ") : " << DistanceFieldTimer.End() << " ms\n";
+	std::cout << "\nCpu copy of the distance field : " << (float)world->GetDistanceField().GetMemoryUsage() / (1024.0f * 1024.0f) << " MB\n";
+
+	if (UseDirectionalDistanceField)
+	{
+		DistanceFieldTimer.Start();
+		world->BufferDirectionalDistanceField();
+		glFinish();
+
+		std::cout << "\nDirectional distance field : " << DistanceFieldTimer.End() << " ms, " << (float)world->GetDirectionalDistanceFieldVideoMemory() / (1024.0f * 1024.0f) << " MB\n";
+
+		// Cpu reference of the traversal, over rays leaving the surface
+		const VoxelRT::DistanceFieldStepStats Steps = VoxelRT::MeasureDistanceFieldSteps(world->m_WorldData, world->GetDistanceField(), world->GetDirectionalDistanceField(), 4096);
+		std::cout << "\nTraversal steps over " << Steps.Rays << " test rays : " << Steps.AverageSteps << " (max " << Steps.MaxSteps << ") with the manhattan field, "
+			<< Steps.AverageDirectionalSteps << " (max " << Steps.MaxDirectionalSteps << ") with the directional field, " << Steps.Mismatches << " different hits\n";
+	}
+
+	if (UseVoxelLOD)
+	{
+		DistanceFieldTimer.Start();
+		world->BufferVoxelLOD();
+		glFinish();
+
+		std::cout << "\nVoxel LOD levels : " << DistanceFieldTimer.End() << " ms, " << (float)world->GetVoxelLODVideoMemory() / (1024.0f * 1024.0f) << " MB on the gpu, "
+			<< (float)world->GetVoxelLOD().GetMemoryUsage() / (1024.0f * 1024.0f) << " MB cpu copy\n";
+	}
 
 	// Initialize sound engine
 
@@ -1572,8 +1907,9 @@ void VoxelRT::MainPipeline::StartPipeline()
 	// Disable blending (enabled by default on some dumbass gpus)
 	glDisable(GL_BLEND);
 
-	// Set camera position to center of the map
-	MainCamera.SetPosition(glm::vec3(WORLD_SIZE_X / 2, 75, WORLD_SIZE_Z / 2));
+	// Set camera position to center of the map, above the ground
+	const int SpawnGround = world->m_WorldData.GetHighestSolid(WorldSize.x / 2, WorldSize.z / 2);
+	MainCamera.SetPosition(glm::vec3(WorldSize.x / 2, glm::min(glm::max(75, SpawnGround + 3), WorldSize.y - 2), WorldSize.z / 2));
 
 	// Initializations
 	glm::vec3 StrongerLightDirection;
@@ -1601,7 +1937,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 	// Create volume, propogate lighting
 	Volumetrics::CreateVolume(world, BlockDataStorageBuffer.GetSSBO(), BlockDatabase::GetTextureArray());
 	for (auto& e : LightLocations) {
-		uint8_t block_at = world->GetBlock(e).block;
+		uint16_t block_at = world->GetBlock(e).block;
 		Volumetrics::AddLightToVolume(e, block_at);
 		world->InsertToLightList(e);
 	}
@@ -1610,6 +1946,16 @@ void VoxelRT::MainPipeline::StartPipeline()
 		Volumetrics::PropogateVolume();
 	}
 
+	if (UsePackedVolume)
+	{
+		world->BufferPackedVolume();
+		std::cout << "\nPacked voxel volume : " << (float)world->GetPackedVolume().GetVideoMemoryUsage() / (1024.0f * 1024.0f) << " MB\n";
+	}
+
+	// Loading isn't undoable, only the edits made from here on
+	world->GetJournal().SetMemoryBudget((size_t)EditHistoryBudget * 1024 * 1024);
+	world->GetJournal().SetEnabled(true);
+
 	// Post process 
 	// Auto exposure
 	const float ZeroFloat = 0.0f;
@@ -1890,6 +2236,83 @@ void VoxelRT::MainPipeline::StartPipeline()
 		// Application update
 		app.OnUpdate();
 
+		// Streamed worlds : the window moves along with the player by whole chunks, everything that is in window
+		// coordinates (player, camera, last frame's matrices) moves back by the same amount
+		if (world->IsStreamed())
+		{
+			if (StreamingStressTest)
+			{
+				MainPlayer.m_Position.x += StreamingStressSpeed;
+				MainCamera.SetPosition(MainCamera.GetPosition() + glm::vec3(StreamingStressSpeed, 0.0f, 0.0f));
+				StreamingStressDistance += StreamingStressSpeed;
+				StreamingStressFrames.push_back(DeltaTime * 1000.0f);
+
+				if (StreamingStressDistance >= 10000.0f)
+				{
+					std::vector<float> Sorted = StreamingStressFrames;
+					std::sort(Sorted.begin(), Sorted.end());
+
+					float TotalTime = 0.0f;
+					int Hitches = 0;
+
+					for (float t : Sorted)
+					{
+						TotalTime += t;
+						Hitches += t > Sorted[Sorted.size() / 2] * 2.0f ? 1 : 0;
+					}
+
+					const float UploadedMB = (float)(world->GetUploadedBytes() - StreamingStressUploadedBytes) / (1024.0f * 1024.0f);
+					const VoxelRT::ChunkStreamerStats& Stats = Streamer.GetStats();
+
+					std::cout << "\nStreaming stress test : " << StreamingStressDistance << " blocks in " << Sorted.size() << " frames (" << TotalTime / 1000.0f << " s)"
+						<< "\n\tFrame time : " << TotalTime / (float)Sorted.size() << " ms average, " << Sorted[Sorted.size() / 2] << " ms median, "
+						<< Sorted[(Sorted.size() * 99) / 100] << " ms p99, " << Sorted.back() << " ms max, " << Hitches << " hitches (over twice the median)"
+						<< "\n\tUploads : " << UploadedMB << " MB, " << UploadedMB / (TotalTime / 1000.0f) << " MB/s"
+						<< "\n\tColumns : " << Stats.ColumnsGenerated << " generated, " << Stats.ColumnsLoaded << " loaded, " << Stats.Shifts << " window moves"
+						<< "\n\tMemory : " << (float)world->m_WorldData.GetMemoryUsage() / (1024.0f * 1024.0f) << " MB of voxel data, "
+						<< (float)world->GetDistanceField().GetMemoryUsage() / (1024.0f * 1024.0f) << " MB of distance field\n";
+
+					StreamingStressTest = false;
+				}
+			}
+
+			const glm::ivec3 WindowDelta = Streamer.Update(world, MainPlayer.m_Position);
+
+			if (WindowDelta != glm::ivec3(0))
+			{
+				const glm::vec3 Offset = -glm::vec3(WindowDelta);
+				MainPlayer.m_Position += Offset;
+				MainPlayer.m_AABB.SetPosition(MainPlayer.m_Position);
+				MainCamera.SetPosition(MainCamera.GetPosition() + Offset);
+				CurrentPosition += Offset;
+				CurrentView = CurrentView * glm::translate(glm::mat4(1.0f), glm::vec3(WindowDelta));
+			}
+
+			const glm::vec3 VolumeOffset = glm::vec3(world->GetVolumeOffset());
+
+			for (GLClasses::Shader* Shader : { &InitialTraceShader, &DiffuseTraceShader, &ShadowTraceShader, &ReflectionTraceShader, &RTAOShader, &PostProcessingShader, &ColorShader, &PointVolumetrics })
+			{
+				Shader->SetVector3f("u_VolumeOffset", VolumeOffset, true);
+			}
+
+			AmbientSoundEstimator.Use();
+			AmbientSoundEstimator.SetVector3f("u_VolumeOffset", VolumeOffset);
+		}
+
+		// Lazily loaded worlds fill in from around the camera
+		if (LazyLoader.IsLoading())
+		{
+			LazyLoader.Update(MainCamera.GetPosition(), LazyLoadChunksPerFrame);
+		}
+
+		// Upload everything the edits this frame touched in a few batched calls (and regenerate the distance field once)
+		// instead of stalling on a tiny upload for every modified voxel
+		world->FlushEdits();
+		Volumetrics::FlushUploads();
+		world->FlushPackedVolume();
+		world->PublishSnapshot();
+		Autosaver.Update(world);
+
 		// Matrices
 		glm::mat4 TempView = PreviousView;
 		PreviousProjection = CurrentProjection;
@@ -1987,12 +2410,18 @@ void VoxelRT::MainPipeline::StartPipeline()
 			AmbientSoundEstimator.Use();
 
 			AmbientSoundEstimator.SetInteger("u_DistanceField", 0);
+			AmbientSoundEstimator.SetInteger("u_DirectionalDistanceField", VoxelRT::DirectionalDistanceField::TEXTURE_UNIT);
 			AmbientSoundEstimator.SetVector3f("u_PlayerPosition", MainCamera.GetPosition());
 			AmbientSoundEstimator.SetInteger("u_Frame", app.GetCurrentFrame());
 
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
+			if (world->UsesDirectionalDistanceField())
+			{
+				world->BindDirectionalDistanceField();
+			}
+
 			glBindBuffer(GL_SHADER_STORAGE_BUFFER, AmbientSSBO);
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, AmbientSSBO);
 
@@ -2061,9 +2490,11 @@ void VoxelRT::MainPipeline::StartPipeline()
 			InitialTraceShader.SetMatrix4("u_InverseView", inv_view);
 			InitialTraceShader.SetMatrix4("u_InverseProjection",  glm::inverse(MainCamera.GetProjectionMatrix()));
 			InitialTraceShader.SetInteger("u_VoxelDataTexture", 0);
+			InitialTraceShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 			InitialTraceShader.SetInteger("u_AlbedoTextures", 1);
 			InitialTraceShader.SetInteger("u_RenderDistance", RenderDistance);
 			InitialTraceShader.SetInteger("u_DistanceFieldTexture", 2);
+			InitialTraceShader.SetInteger("u_PackedVoxelVolume", VoxelRT::PackedVoxelVolume::TEXTURE_UNIT);
 			InitialTraceShader.SetInteger("u_CurrentFrame", app.GetCurrentFrame());
 			InitialTraceShader.SetInteger("u_VertCurrentFrame", app.GetCurrentFrame());
 			InitialTraceShader.SetVector2f("u_Dimensions", glm::vec2(InitialTraceFBO->GetWidth(), InitialTraceFBO->GetHeight()));
@@ -2075,9 +2506,12 @@ void VoxelRT::MainPipeline::StartPipeline()
 			InitialTraceShader.SetFloat("u_Time", glfwGetTime());
 			InitialTraceShader.SetBool("u_ShouldAlphaTest", ShouldAlphaTest);
 			InitialTraceShader.SetBool("u_JitterSceneForTAA", JitterSceneForTAA);
+			InitialTraceShader.SetInteger("u_VoxelLOD", VoxelRT::VoxelLOD::TEXTURE_UNIT);
+
+			// The cone spread is half the angle a pixel covers, a level is used once a pixel is as wide as two of its cells
+			InitialTraceShader.SetVector3f("u_LODDistances", VoxelRT::GetVoxelLODDistances(PrimaryLODDistance, glm::tan(glm::radians(MainCamera.GetFov()) * 0.5f) / (float)InitialTraceFBO->GetHeight()));
 			
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+			world->BindVoxelData(0);
 
 			glActiveTexture(GL_TEXTURE1);
 			glBindTexture(GL_TEXTURE_2D_ARRAY, VoxelRT::BlockDatabase::GetTextureArray());
@@ -2085,6 +2519,16 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE2);
 			glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
+			if (world->UsesPackedVolume())
+			{
+				world->GetPackedVolume().Bind();
+			}
+
+			if (world->UsesVoxelLOD())
+			{
+				world->BindVoxelLOD();
+			}
+
 			BlockDataStorageBuffer.Bind(0);
 
 			VAO.Bind();
@@ -2269,6 +2713,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 		DiffuseTraceShader.Use();
 		
 		DiffuseTraceShader.SetInteger("u_VoxelData", 0);
+		DiffuseTraceShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 		DiffuseTraceShader.SetInteger("u_PositionTexture", 1);
 		DiffuseTraceShader.SetInteger("u_NormalTexture", 2);
 		DiffuseTraceShader.SetInteger("u_Skymap", 3);
@@ -2278,6 +2723,9 @@ void VoxelRT::MainPipeline::StartPipeline()
 		DiffuseTraceShader.SetInteger("u_BlockPBRTextures", 8);
 		DiffuseTraceShader.SetInteger("u_BlockEmissiveTextures", 11);
 		DiffuseTraceShader.SetInteger("u_DistanceFieldTexture", 13);
+		DiffuseTraceShader.SetInteger("u_DirectionalDistanceField", VoxelRT::DirectionalDistanceField::TEXTURE_UNIT);
+		DiffuseTraceShader.SetInteger("u_VoxelLOD", VoxelRT::VoxelLOD::TEXTURE_UNIT);
+		DiffuseTraceShader.SetVector3f("u_LODDistances", VoxelRT::GetVoxelLODDistances(SecondaryLODDistance, 0.0f));
 		DiffuseTraceShader.SetInteger("u_DiffuseTraceLength", DiffuseTraceLength);
 		DiffuseTraceShader.SetVector2f("u_Halton", glm::vec2(GetTAAJitterSecondary(app.GetCurrentFrame())));
 
@@ -2326,8 +2774,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 		DiffuseTraceShader.SetMatrix4("u_InverseView", inv_view);
 		DiffuseTraceShader.SetMatrix4("u_InverseProjection", inv_projection);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+		world->BindVoxelData(0);
 
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, InitialTraceFBO->GetTexture(0));
@@ -2362,6 +2809,16 @@ void VoxelRT::MainPipeline::StartPipeline()
 		glActiveTexture(GL_TEXTURE13);
 		glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
+		if (world->UsesDirectionalDistanceField())
+		{
+			world->BindDirectionalDistanceField();
+		}
+
+		if (world->UsesVoxelLOD())
+		{
+			world->BindVoxelLOD();
+		}
+
 		BlockDataStorageBuffer.Bind(0);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, BlueNoise_SSBO.m_SSBO);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, world->LightChunkDataSSBO);
@@ -2890,9 +3347,13 @@ void VoxelRT::MainPipeline::StartPipeline()
 
 			ShadowTraceShader.SetInteger("u_PositionTexture", 0);
 			ShadowTraceShader.SetInteger("u_VoxelData", 1);
+			ShadowTraceShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 			ShadowTraceShader.SetInteger("u_AlbedoTextures", 2);
 			ShadowTraceShader.SetInteger("u_NormalTexture", 3);
 			ShadowTraceShader.SetInteger("u_DistanceFieldTexture", 5);
+			ShadowTraceShader.SetInteger("u_DirectionalDistanceField", VoxelRT::DirectionalDistanceField::TEXTURE_UNIT);
+			ShadowTraceShader.SetInteger("u_VoxelLOD", VoxelRT::VoxelLOD::TEXTURE_UNIT);
+			ShadowTraceShader.SetVector3f("u_LODDistances", VoxelRT::GetVoxelLODDistances(SecondaryLODDistance, 0.0f));
 			ShadowTraceShader.SetInteger("u_BlueNoiseTexture", 6);
 
 			ShadowTraceShader.SetVector3f("u_LightDirection", StrongerLightDirection);
@@ -2918,8 +3379,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, InitialTraceFBO->GetTexture(0));
 
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+			world->BindVoxelData(1);
 
 			glActiveTexture(GL_TEXTURE2);
 			glBindTexture(GL_TEXTURE_2D_ARRAY, VoxelRT::BlockDatabase::GetTextureArray());
@@ -2930,6 +3390,16 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE5);
 			glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
+			if (world->UsesDirectionalDistanceField())
+			{
+				world->BindDirectionalDistanceField();
+			}
+
+			if (world->UsesVoxelLOD())
+			{
+				world->BindVoxelLOD();
+			}
+
 			glActiveTexture(GL_TEXTURE6);
 			glBindTexture(GL_TEXTURE_2D, BluenoiseTexture.GetTextureID());
 
@@ -3104,8 +3574,12 @@ void VoxelRT::MainPipeline::StartPipeline()
 			ReflectionTraceShader.SetInteger("u_BlockPBRTextures", 6);
 			ReflectionTraceShader.SetInteger("u_Skymap", 7);
 			ReflectionTraceShader.SetInteger("u_VoxelData", 8);
+			ReflectionTraceShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 			ReflectionTraceShader.SetInteger("u_BlueNoiseTexture", 9);
 			ReflectionTraceShader.SetInteger("u_DistanceFieldTexture", 10);
+			ReflectionTraceShader.SetInteger("u_DirectionalDistanceField", VoxelRT::DirectionalDistanceField::TEXTURE_UNIT);
+			ReflectionTraceShader.SetInteger("u_VoxelLOD", VoxelRT::VoxelLOD::TEXTURE_UNIT);
+			ReflectionTraceShader.SetVector3f("u_LODDistances", VoxelRT::GetVoxelLODDistances(SecondaryLODDistance, 0.0f));
 			ReflectionTraceShader.SetInteger("u_BlockEmissiveTextures", 11);
 			ReflectionTraceShader.SetInteger("u_DiffuseSH", 14);
 			ReflectionTraceShader.SetInteger("u_DiffuseCoCg", 15);
@@ -3206,8 +3680,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE7);
 			glBindTexture(GL_TEXTURE_CUBE_MAP, SkymapSecondary.GetTexture());
 
-			glActiveTexture(GL_TEXTURE8);
-			glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+			world->BindVoxelData(8);
 
 			glActiveTexture(GL_TEXTURE9);
 			glBindTexture(GL_TEXTURE_2D, BluenoiseTexture.GetTextureID());
@@ -3215,6 +3688,16 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE10);
 			glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
+			if (world->UsesDirectionalDistanceField())
+			{
+				world->BindDirectionalDistanceField();
+			}
+
+			if (world->UsesVoxelLOD())
+			{
+				world->BindVoxelLOD();
+			}
+
 			glActiveTexture(GL_TEXTURE11);
 			glBindTexture(GL_TEXTURE_2D_ARRAY, VoxelRT::BlockDatabase::GetEmissiveTextureArray());
 
@@ -3586,6 +4069,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 
 			RTAOShader.SetInteger("u_PositionTexture", 0);
 			RTAOShader.SetInteger("u_VoxelData", 1);
+			RTAOShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 			RTAOShader.SetInteger("u_NormalTexture", 2);
 			RTAOShader.SetInteger("u_BlockAlbedoTextures", 3);
 			RTAOShader.SetInteger("u_BlockNormalTextures", 4);
@@ -3597,8 +4081,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, InitialTraceFBO->GetTexture(0));
 
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+			world->BindVoxelData(1);
 
 			glActiveTexture(GL_TEXTURE2);
 			glBindTexture(GL_TEXTURE_2D, InitialTraceFBO->GetTexture(1));
@@ -4221,6 +4704,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 			PointVolumetrics.SetInteger("u_LinearDepthTexture", 2);
 			PointVolumetrics.SetInteger("u_VolumetricDensityData", 3);
 			PointVolumetrics.SetInteger("u_VolumetricColorDataSampler", 4);
+			PointVolumetrics.SetInteger("u_PackedVoxelVolume", VoxelRT::PackedVoxelVolume::TEXTURE_UNIT);
 			PointVolumetrics.SetInteger("u_LightCount", world->LightChunkData.size());
 
 			PointVolumetrics.SetFloat("u_Time", glfwGetTime());
@@ -4248,6 +4732,11 @@ void VoxelRT::MainPipeline::StartPipeline()
 			glActiveTexture(GL_TEXTURE4);
 			glBindTexture(GL_TEXTURE_3D, VoxelRT::Volumetrics::GetColorVolume());
 
+			if (world->UsesPackedVolume())
+			{
+				world->GetPackedVolume().Bind();
+			}
+
 			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, VoxelRT::Volumetrics::GetAverageColorSSBO());
 			//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, world->m_LightPositionSSBO);
 
@@ -4447,7 +4936,9 @@ void VoxelRT::MainPipeline::StartPipeline()
 		PostProcessingShader.SetBool("u_FilmGrain", FilmGrainStrength>0.001f);
 
 		PostProcessingShader.SetInteger("u_DistanceFieldTexture", 18);
+		PostProcessingShader.SetInteger("u_DirectionalDistanceField", VoxelRT::DirectionalDistanceField::TEXTURE_UNIT);
 		PostProcessingShader.SetInteger("u_VoxelVolume", 19);
+		PostProcessingShader.SetInteger("u_VoxelBrickAtlas", VoxelRT::BrickPool::ATLAS_TEXTURE_UNIT);
 		PostProcessingShader.SetInteger("u_Sky", 26);
 
 		PostProcessingShader.SetFloat("u_Time", glfwGetTime());
@@ -4511,8 +5002,12 @@ void VoxelRT::MainPipeline::StartPipeline()
 		glActiveTexture(GL_TEXTURE18);
 		glBindTexture(GL_TEXTURE_3D, world->m_DistanceFieldTexture.GetTextureID());
 
-		glActiveTexture(GL_TEXTURE19);
-		glBindTexture(GL_TEXTURE_3D, world->m_DataTexture.GetTextureID());
+		if (world->UsesDirectionalDistanceField())
+		{
+			world->BindDirectionalDistanceField();
+		}
+
+		world->BindVoxelData(19);
 
 		glActiveTexture(GL_TEXTURE20);
 		glBindTexture(GL_TEXTURE_2D, CloudData);
@@ -4857,7 +5352,7 @@ void VoxelRT::MainPipeline::StartPipeline()
 
 		
 		if (MainPlayer.m_Position.y < 2.0f) {
-			MainPlayer.m_Position.y = 127.0f;
+			MainPlayer.m_Position.y = (float)(world->GetDimensions().y - 1);
 			MainPlayer.Camera.SetPosition(MainPlayer.m_Position);
 		}
 
@@ -4866,7 +5361,6 @@ void VoxelRT::MainPipeline::StartPipeline()
 		// (You want to make sure that too many heavy operations don't take place on the exact same frame) 
 		if (app.GetCurrentFrame() % 643 == 0)
 		{
-			world->GenerateDistanceField();
 			world->RebufferLightChunks();
 		}
 
@@ -4936,7 +5430,18 @@ void VoxelRT::MainPipeline::StartPipeline()
 		////std::cout << MainPlayer.InitialCollisionDone;
 	}
 
-	SaveWorld(world, world_name);
+	if (world->IsStreamed())
+	{
+		Streamer.SaveColumns(world);
+		Streamer.Stop();
+	}
+
+	else
+	{
+		Autosaver.Stop();
+		SaveWorld(world, world_name, CacheDistanceField);
+	}
+
 	SoundManager::Destroy();
 	delete world;
 	return;
@@ -11,7 +11,7 @@ namespace VoxelRT
 	{
 		m_Acceleration = glm::vec3(0.0f);
 		m_Velocity = glm::vec3(0.0f);
-		m_Position = glm::vec3(WORLD_SIZE_X / 2, 70, WORLD_SIZE_Z / 2);
+		m_Position = glm::vec3(DEFAULT_WORLD_SIZE_X / 2, 70, DEFAULT_WORLD_SIZE_Z / 2);
 		Freefly = false;
 		m_isOnGround = false;
 		m_AABB.m_Position = m_Position;
@@ -141,9 +141,11 @@ namespace VoxelRT
 			glm::ivec3 Idx = glm::ivec3(glm::floor(Camera.GetPosition()));
 			Idx.y -= 2;
 
-			if (Idx.x > 0 && Idx.x < WORLD_SIZE_X - 1 &&
-				Idx.y > 0 && Idx.y < WORLD_SIZE_Y - 1 &&
-				Idx.z > 0 && Idx.z < WORLD_SIZE_Z - 1)
+			const glm::ivec3& WorldSize = world->GetDimensions();
+
+			if (Idx.x > 0 && Idx.x < WorldSize.x - 1 &&
+				Idx.y > 0 && Idx.y < WorldSize.y - 1 &&
+				Idx.z > 0 && Idx.z < WorldSize.z - 1)
 			{
 				auto blockat = world->GetBlock((uint16_t)Idx.x, (uint16_t)Idx.y, (uint16_t)Idx.z);
 				//s1 = blockat.block > 0 ? VoxelRT::BlockDatabase::GetBlockName(blockat.block) : s1;
@@ -189,20 +191,20 @@ namespace VoxelRT
 			return;
 		}
 
+		const glm::ivec3& WorldSize = world->GetDimensions();
+
 		for (int x = position.x - m_AABB.m_Dimensions.x; x < position.x + m_AABB.m_Dimensions.x; x++)
 		{
 			for (int y = position.y - m_AABB.m_Dimensions.y; y < position.y + 0.7; y++)
 			{
 				for (int z = position.z - m_AABB.m_Dimensions.z; z < position.z + m_AABB.m_Dimensions.z; z++)
 				{
-					if (x >= 0 && x < WORLD_SIZE_X - 1 &&
-						y >= 0 && y < WORLD_SIZE_Y - 1 &&
-						z >= 0 && z < WORLD_SIZE_Z - 1)
+					if (x >= 0 && x < WorldSize.x - 1 &&
+						y >= 0 && y < WorldSize.y - 1 &&
+						z >= 0 && z < WorldSize.z - 1)
 					{
 
-						Block block = world->GetBlock(x, y, z);
-
-						if (block.block != 0)
+						if (world->IsSolid(x, y, z))
 						{
 							if (vel.y > 0)
 							{
@@ -1,5 +1,13 @@
 #version 330 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 layout (location = 0) out vec4 o_SpatialResult;
 layout (location = 1) out vec2 o_SpatialResult2;
 
@@ -39,7 +47,7 @@ vec4 GetPositionAt(sampler2D pos_tex, vec2 txc)
 int GetBlockAt(vec2 txc)
 {
 	float id = texture(u_BlockIDTexture, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 float GetLuminance(vec3 color) 
@@ -3,6 +3,21 @@
 #version 450 core
 
 #define CLOUD_HEIGHT 70
+
+#ifndef WORLD_SIZE_X
+#define WORLD_SIZE_X 384
+#define WORLD_SIZE_Y 128
+#define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define PI 3.14159265359
 #define THRESH 1.41414
 
@@ -72,6 +87,26 @@ uniform sampler2D u_HighResBL;
 // Light Propogation Volume debug stuff
 uniform sampler3D u_LPVLightLevel;
 uniform usampler3D u_LPVColorData;
+
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+// The light volumes repeat horizontally, uv is in the window
+vec3 WrapVolumeUV(vec3 uv)
+{
+	return uv + u_VolumeOffset / vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+
+// Texel of a wrapped uv, it can be just past the edge of the volume
+ivec3 RepeatVolumeTexel(ivec3 texel)
+{
+	const ivec3 Resolution = ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+	return (texel % Resolution + Resolution) % Resolution;
+}
+#else
+#define WrapVolumeUV(uv) (uv)
+#define RepeatVolumeTexel(texel) (texel)
+#endif
 uniform int u_LPVDebugState; // Debug state 
 
 
@@ -145,17 +180,17 @@ float bayer2(vec2 a){
 // SSBOS
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
-	int BlockSSSSSData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
+	int BlockSSSSSData[BLOCK_DATA_SIZE];
 };
 
 layout (std430, binding = 1) buffer SSBO_BlockAverageData
 {
-    vec4 BlockAverageColorData[128]; // Returns the average color per block type 
+    vec4 BlockAverageColorData[BLOCK_DATA_SIZE]; // Returns the average color per block type 
 };
 //
 
@@ -1129,7 +1164,7 @@ vec4 SamplePositionAt(sampler2D pos_tex, vec2 txc)
 int GetBlockID(vec2 txc)
 {
 	float id = texture(u_BlockIDTexture, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 bool InScreenSpace(vec2 x)
@@ -1283,30 +1318,30 @@ vec4 ClampedTexture(sampler2D tex, vec2 txc)
 
 vec3 SampleLPVColor(vec3 UV) {
     uint BlockID = texture(u_LPVColorData, UV).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 SampleLPVColor(vec3 UV, float D) {
-    uint BlockID = texture(u_LPVColorData, UV+D*0.5f*(1.0f/vec3(384.0f,128.0f,384.0f))).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    uint BlockID = texture(u_LPVColorData, UV+D*0.5f*(1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z))).x;
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 }   
 
 vec3 SampleLPVColorTexel(ivec3 Texel, int LOD) {
-    uint BlockID = texelFetch(u_LPVColorData, Texel, LOD).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    uint BlockID = texelFetch(u_LPVColorData, RepeatVolumeTexel(Texel), LOD).x;
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 SampleLPVColorTexel(ivec3 Texel) {
-    uint BlockID = texelFetch(u_LPVColorData, Texel, 0).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    uint BlockID = texelFetch(u_LPVColorData, RepeatVolumeTexel(Texel), 0).x;
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 InterpolateLPVColorData(vec3 uv)
 {
-    vec3 res = vec3(384.0f, 128.0f, 384.0f);
+    vec3 res = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     vec3 q = fract(uv * res);
     ivec3 t = ivec3(uv * res);
     ivec3 e = ivec3(-1, 0, 1);
@@ -1359,7 +1394,7 @@ vec3 InterpolateLPVColorDithered(vec3 UV) // Very few samples with fantastic res
 	const bool TemporalIntegration = true;
 	vec2 OffsettedTxc = g_TexCoords + (vec2(fract(u_Time)*6., fract(u_Time)*2.)/max(vec2(0.0001f),u_Dimensions))*float(TemporalIntegration);
     vec3 Dither = texture(u_BlueNoiseHighRes, (OffsettedTxc * (u_Dimensions / vec2(textureSize(u_BlueNoiseHighRes,0).xy)))).xyz;
-    const vec3 Resolution = vec3(384.0f, 128.0f, 384.0f);
+    const vec3 Resolution = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     Dither /= Resolution;
 
     vec3 FractTexel = fract(UV * Resolution);
@@ -1383,7 +1418,7 @@ vec3 InterpolateLPVColorDithered(vec3 UV) // Very few samples with fantastic res
 
 float InterpLPVDensity(vec3 UV) 
 {
-    vec3 LPVResolution = vec3(384.0f, 128.0f, 384.0f);
+    vec3 LPVResolution = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     vec3 FractTexel = fract(UV * LPVResolution);
     vec3 LinearOffset = (FractTexel * (FractTexel - 1.0f) + 0.5f) / LPVResolution;
     vec3 W0 = UV - LinearOffset;
@@ -1402,13 +1437,13 @@ float InterpLPVDensity(vec3 UV)
 
 
 vec3 GetSmoothLPVData(vec3 UV) {    
-    UV *= 1.0f/vec3(384.0f,128.0f,384.0f);
+    UV = WrapVolumeUV(UV * (1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)));
     //return vec3(InterpLPVDensity(UV)*50.0f)*pow(InterpolateLPVColorData(UV),vec3(1.0f/1.8f))*2.0f;
     return vec3(InterpLPVDensity(UV)*50.0f)*pow(InterpolateLPVColorDithered(UV),vec3(1.0f/1.8f))*2.0f;
 }
 
 vec3 GetSmoothLPVDensity(vec3 UV) {    
-    UV *= 1.0f/vec3(384.0f,128.0f,384.0f);
+    UV = WrapVolumeUV(UV * (1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)));
     return vec3(InterpLPVDensity(UV)*54.0f);
 }
 
@@ -20,6 +20,10 @@
 
 #version 430 core 
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
 #define INF 100000.0f
 #define PI 3.14159265359f
 #define TAU (2.0f * PI)
@@ -68,12 +72,12 @@ uniform int u_CactusBlockProps[10];
 // IDs ->
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
-	int BlockSSSSSData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
+	int BlockSSSSSData[BLOCK_DATA_SIZE];
 };
 
 // Constants 
@@ -1,4 +1,13 @@
 #version 330 core
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define INF 100000.0f
 
 float bayer2(vec2 a){
@@ -68,7 +77,7 @@ vec4 SamplePositionAt(vec2 txc)
 int GetBlockAt(vec2 txc)
 {
 	float id = texture(u_BlockIDTex, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 float GetLuminance(vec3 color) 
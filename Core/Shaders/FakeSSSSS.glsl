@@ -1,5 +1,13 @@
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 layout (location = 0) out float o_OutputShadow;
 
 uniform sampler2D u_Texture;
@@ -9,12 +17,12 @@ in vec2 v_TexCoords;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
-	int BlockSSSData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
+	int BlockSSSData[BLOCK_DATA_SIZE];
 };
 
 vec4 SampleShadow(vec2 TexCoord) {
@@ -52,7 +60,7 @@ float GaussianShadow(vec2 uv)
 void main()
 {
     float id = texelFetch(u_BlockIDs, ivec2(v_TexCoords * textureSize(u_BlockIDs, 0).xy), 0).r;
-	int iid = clamp(int(floor(id * 255.0f)), 0, 127);
+	int iid = clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
     int SSSFetch = BlockSSSData[iid];
 
     if (SSSFetch > 0) {
@@ -1,5 +1,13 @@
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 layout (location = 0) out float o_OutputShadow;
 
 uniform sampler2D u_Texture;
@@ -10,12 +18,12 @@ in vec2 v_TexCoords;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
-	int BlockSSSData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
+	int BlockSSSData[BLOCK_DATA_SIZE];
 };
 
 float bayer2(vec2 a){
@@ -46,7 +54,7 @@ const vec2 poisson60[60] = vec2[60]( vec2( 0.0f, 0.0f ), vec2( -0.68825379228537
 void main()
 {
     float id = texelFetch(u_BlockIDs, ivec2(v_TexCoords * textureSize(u_BlockIDs, 0).xy), 0).r;
-	int iid = clamp(int(floor(id * 255.0f)), 0, 127);
+	int iid = clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
     int SSSMaskFetch = BlockSSSData[iid];
 
     if (SSSMaskFetch > 0 && v_TexCoords == clamp(v_TexCoords, 0.04f, 0.96f)) {
@@ -68,7 +76,7 @@ void main()
             
             if (SampleCoord == clamp(SampleCoord, 0.0f, 1.0)) 
 			{
-                //int BlockIDAt = clamp(int(floor(( texelFetch(u_BlockIDs, ivec2(SampleCoord * textureSize(u_BlockIDs, 0).xy), 0).r) * 255.0f)), 0, 127);
+                //int BlockIDAt = clamp(int(round(( texelFetch(u_BlockIDs, ivec2(SampleCoord * textureSize(u_BlockIDs, 0).xy), 0).r) * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
                 //if (BlockIDAt == iid || BlockIDAt == 0)
                 
                 float DepthAt = texture(u_Depth, SampleCoord).x;
@@ -3,6 +3,14 @@
 
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define EPS 0.000001f
 
 
@@ -66,11 +74,11 @@ uniform mat4 u_View;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 };
 
 
@@ -102,7 +110,7 @@ vec3 SampleNormalFromTex(sampler2D samp, vec2 txc) {
 int GetBlockID(vec2 txc)
 {
 	float id = texture(u_BlockIDs, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 
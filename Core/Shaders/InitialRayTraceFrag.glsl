@@ -1,9 +1,19 @@
 #version 430 core
 
 
+#ifndef WORLD_SIZE_X
 #define WORLD_SIZE_X 384
 #define WORLD_SIZE_Y 128
 #define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
 
 #define MULTIPLE_TEXTURING_GRASS
 #define ALPHA_TESTING
@@ -17,9 +27,34 @@ in vec2 v_TexCoords;
 
 uniform int u_CurrentFrame;
 
+#ifdef VOXEL_RT_BRICK_POOL
+uniform usampler3D u_VoxelDataTexture; // Brick pool indirection, one texel per 8^3 brick (see BrickPool.h)
+uniform sampler3D u_VoxelBrickAtlas;
+#else
 uniform sampler3D u_VoxelDataTexture;
+#endif
 uniform sampler3D u_DistanceFieldTexture;
 
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+ivec3 WrapVolume(ivec3 loc)
+{
+	return (loc + ivec3(u_VolumeOffset)) % ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+#else
+#define WrapVolume(loc) (loc)
+#endif
+
+#ifdef VOXEL_RT_VOXEL_LOD
+uniform sampler3D u_VoxelLOD; // 2x, 4x and 8x downsampled blocks, one mip per level (see VoxelLOD.h)
+uniform vec3 u_LODDistances; // Distance from the ray origin at which level 1, 2 and 3 start (GetVoxelLODDistances())
+#endif
+
+#ifdef VOXEL_RT_PACKED_VOLUME
+uniform sampler3D u_PackedVoxelVolume; // Block, distance, light level, light color (see PackedVoxelVolume.h)
+#endif
+
 uniform sampler2DArray u_AlbedoTextures;
 
 uniform vec2 u_Dimensions;
@@ -41,11 +76,11 @@ uniform float u_Time;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 };
 
 struct Ray
@@ -80,12 +115,49 @@ float GetVoxel(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-        return texelFetch(u_VoxelDataTexture, loc, 0).r;
+#if defined(VOXEL_RT_PACKED_VOLUME)
+        return texelFetch(u_PackedVoxelVolume, loc, 0).r;
+#elif defined(VOXEL_RT_BRICK_POOL)
+        uint Brick = texelFetch(u_VoxelDataTexture, loc >> 3, 0).r;
+
+        // Empty and uniform bricks store the block in the indirection texel
+        if (Brick < 0x80000000u)
+        {
+            uint Block = Brick & 0xFFFFu;
+            return float(Block) / BLOCK_ID_SCALE;
+        }
+
+        ivec3 AtlasBrick = ivec3(Brick & 0x3FFu, (Brick >> 10) & 0x3FFu, (Brick >> 20) & 0x3FFu);
+        return texelFetch(u_VoxelBrickAtlas, (AtlasBrick << 3) + (loc & 7), 0).r;
+#else
+        return texelFetch(u_VoxelDataTexture, WrapVolume(loc), 0).r;
+#endif
     }
     
     return 0.0f;
 }
 
+#ifdef VOXEL_RT_BRICK_POOL
+// Moves the ray just past the face of the 8^3 brick it's in if the brick is empty, axis is the face it crossed
+bool SkipEmptyBrick(inout vec3 origin, vec3 direction, ivec3 ray_sign, inout int axis)
+{
+	ivec3 Brick = ivec3(floor(origin)) >> 3;
+
+	if (texelFetch(u_VoxelDataTexture, Brick, 0).r != 0u)
+	{
+		return false;
+	}
+
+	vec3 Boundary = vec3((Brick + ((1 + ray_sign) >> 1)) << 3);
+	vec3 T = mix((Boundary - origin) / direction, vec3(1e30f), equal(ray_sign, ivec3(0)));
+	axis = T.x < T.y ? (T.x < T.z ? 0 : 2) : (T.y < T.z ? 1 : 2);
+
+	origin += direction * T[axis];
+	origin[axis] = Boundary[axis] + float(ray_sign[axis]) * 0.0001f;
+	return true;
+}
+#endif
+
 float ToConservativeEuclidean(float Manhattan)
 {
 	return Manhattan == 1 ? 1 : Manhattan * 0.57735026918f;
@@ -95,7 +167,11 @@ float GetDistance(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-         return (texelFetch(u_DistanceFieldTexture, loc, 0).r);
+#ifdef VOXEL_RT_PACKED_VOLUME
+         return texelFetch(u_PackedVoxelVolume, loc, 0).g;
+#else
+         return (texelFetch(u_DistanceFieldTexture, WrapVolume(loc), 0).r);
+#endif
     }
     
     return -1.0f;
@@ -113,7 +189,7 @@ bool VoxelExists(in vec3 loc)
 
 int GetBlockID(float id)
 {
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 bool CompareVec3(vec3 v1, vec3 v2) {
@@ -201,6 +277,56 @@ bool StopRay(vec3 P, vec3 N, float Type) {
 	return Alpha > 0.975f;
 }
 
+#ifdef VOXEL_RT_VOXEL_LOD
+// Level the ray is at t voxels away from its origin
+int GetLODLevel(float t)
+{
+	return int(t >= u_LODDistances.x) + int(t >= u_LODDistances.y) + int(t >= u_LODDistances.z);
+}
+
+// One step of a ray through a coarse level, a cell is hit if any voxel inside of it is solid
+// The full resolution distance field still skips the empty space, minus the diagonal of a cell
+bool VoxelStepLOD(int level, int euclidean, ivec3 loc, vec3 direction, ivec3 ray_sign, inout vec3 origin, inout int axis, out float block)
+{
+	float CellSize = float(1 << level);
+	float Skip = float(euclidean) - 1.0f - CellSize * 1.7320508f;
+	block = 0.0f;
+
+	if (Skip >= CellSize)
+	{
+		origin += Skip * direction;
+		return false;
+	}
+
+	ivec3 Cell = loc >> level;
+	block = texelFetch(u_VoxelLOD, Cell, level - 1).r;
+
+	if (block > 0.0f)
+	{
+		return true;
+	}
+
+	// Step to the next cell, or as far as the distance field allows if that gets further
+	vec3 Bound = (vec3(Cell) + vec3(greaterThan(direction, vec3(0.0f)))) * CellSize;
+	vec3 DistanceFactor = (Bound - origin) * (1.0f / direction);
+
+	int Axis = DistanceFactor.x < DistanceFactor.y && ray_sign.x != 0
+		? (DistanceFactor.x < DistanceFactor.z || ray_sign.z == 0 ? 0 : 2)
+		: (DistanceFactor.y < DistanceFactor.z || ray_sign.z == 0 ? 1 : 2);
+
+	if (Skip > DistanceFactor[Axis])
+	{
+		origin += Skip * direction;
+		return false;
+	}
+
+	axis = Axis;
+	origin += DistanceFactor[axis] * direction;
+	origin[axis] = Bound[axis] + ray_sign[axis] * 0.0001f;
+	return false;
+}
+#endif
+
 float VoxelTraversalDF_AlphaTest(vec3 origin, vec3 direction, inout vec3 normal, inout float blockType) 
 {
 	vec3 initial_origin = origin;
@@ -222,15 +348,54 @@ float VoxelTraversalDF_AlphaTest(vec3 origin, vec3 direction, inout vec3 normal,
 			break;
 		}
 
+#ifdef VOXEL_RT_PACKED_VOLUME
+		// The distance and the block come from the same texel
+		vec4 Packed = texelFetch(u_PackedVoxelVolume, Loc, 0);
+		float Dist = Packed.g * 255.0f;
+#else
 		float Dist = GetDistance(Loc) * 255.0f; 
+#endif
 
 		int Euclidean = int(floor(ToConservativeEuclidean(Dist)));
 
+#ifdef VOXEL_RT_VOXEL_LOD
+		// Far enough from the origin (or once the ray cone is wide enough) the ray steps through the coarse levels
+		int Level = Euclidean > 0 ? GetLODLevel(distance(origin, initial_origin)) : 0;
+
+		if (Level > 0)
+		{
+			float LODBlock;
+
+			if (VoxelStepLOD(Level, Euclidean, Loc, direction, RaySign, origin, MinIdx, LODBlock))
+			{
+				normal = vec3(0.0f);
+				normal[MinIdx] = -RaySign[MinIdx];
+				blockType = LODBlock;
+				return distance(origin, initial_origin);
+			}
+
+			continue;
+		}
+#endif
+
+#ifdef VOXEL_RT_BRICK_POOL
+		// Close to surfaces the distance field only allows short steps, empty bricks can still be crossed in one
+		if (Euclidean > 0 && Euclidean < 8 && SkipEmptyBrick(origin, direction, RaySign, MinIdx))
+		{
+			Intersection = true;
+			continue;
+		}
+#endif
+
 		if (Euclidean == 0)
 		{
 			vec3 tn = vec3(0.0f);
 			tn[MinIdx] = -RaySign[MinIdx];
+#ifdef VOXEL_RT_PACKED_VOLUME
+			float bt = Packed.r;
+#else
 			float bt = GetVoxel(ivec3(floor(origin)));
+#endif
 			if (StopRay(origin, tn, bt)) {
 				break;
 			}
@@ -329,6 +494,35 @@ float VoxelTraversalDF(vec3 origin, vec3 direction, inout vec3 normal, inout flo
 
 		int Euclidean = int(floor(ToConservativeEuclidean(Dist)));
 
+#ifdef VOXEL_RT_VOXEL_LOD
+		// Far enough from the origin (or once the ray cone is wide enough) the ray steps through the coarse levels
+		int Level = Euclidean > 0 ? GetLODLevel(distance(origin, initial_origin)) : 0;
+
+		if (Level > 0)
+		{
+			float LODBlock;
+
+			if (VoxelStepLOD(Level, Euclidean, Loc, direction, RaySign, origin, MinIdx, LODBlock))
+			{
+				normal = vec3(0.0f);
+				normal[MinIdx] = -RaySign[MinIdx];
+				blockType = LODBlock;
+				return distance(origin, initial_origin);
+			}
+
+			continue;
+		}
+#endif
+
+#ifdef VOXEL_RT_BRICK_POOL
+		// Close to surfaces the distance field only allows short steps, empty bricks can still be crossed in one
+		if (Euclidean > 0 && Euclidean < 8 && SkipEmptyBrick(origin, direction, RaySign, MinIdx))
+		{
+			Intersection = true;
+			continue;
+		}
+#endif
+
 		if (Euclidean == 0)
 		{
 			break;
@@ -445,7 +639,7 @@ void main()
 
 	if (true)
 	{
-		vec2 IntBox = IntersectBox(r.Origin - vec3(384. / 2., 128. / 2., 384. / 2.), 1. / r.Direction, vec3(384. / 2., 128.0f / 2., 384.0f / 2.));
+		vec2 IntBox = IntersectBox(r.Origin - vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z) / 2., 1. / r.Direction, vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z) / 2.);
 		if (IntBox.x > 0.0f) {
 			AddT = IntBox.x + 0.5f;
 			r.Origin += r.Direction * (AddT);
@@ -1,8 +1,14 @@
 #version 330 core
 
+#ifndef WORLD_SIZE_X
 #define WORLD_SIZE_X 384
 #define WORLD_SIZE_Y 128
 #define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
 
 layout (location = 0) in vec2 a_Position;
 layout (location = 1) in vec2 a_TexCoords;
@@ -18,7 +24,27 @@ uniform mat4 u_VertInverseView;
 uniform mat4 u_VertInverseProjection;
 
 uniform sampler3D u_DistanceFieldTexture;
+
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+ivec3 WrapVolume(ivec3 loc)
+{
+	return (loc + ivec3(u_VolumeOffset)) % ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+#else
+#define WrapVolume(loc) (loc)
+#endif
+
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+uniform usampler3D u_DirectionalDistanceField; // 4 bit distance per ray octant (see DistanceField.h)
+#endif
+#ifdef VOXEL_RT_BRICK_POOL
+uniform usampler3D u_VoxelVolume; // Brick pool indirection, one texel per 8^3 brick (see BrickPool.h)
+uniform sampler3D u_VoxelBrickAtlas;
+#else
 uniform sampler3D u_VoxelVolume;
+#endif
 uniform bool u_ComputePlayerShadow;
 uniform vec3 u_VertSunDir;
 
@@ -79,22 +105,70 @@ float GetVoxel(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-        return texelFetch(u_VoxelVolume, loc, 0).r;
+#ifdef VOXEL_RT_BRICK_POOL
+        uint Brick = texelFetch(u_VoxelVolume, loc >> 3, 0).r;
+
+        // Empty and uniform bricks store the block in the indirection texel
+        if (Brick < 0x80000000u)
+        {
+            uint Block = Brick & 0xFFFFu;
+            return float(Block) / BLOCK_ID_SCALE;
+        }
+
+        ivec3 AtlasBrick = ivec3(Brick & 0x3FFu, (Brick >> 10) & 0x3FFu, (Brick >> 20) & 0x3FFu);
+        return texelFetch(u_VoxelBrickAtlas, (AtlasBrick << 3) + (loc & 7), 0).r;
+#else
+        return texelFetch(u_VoxelVolume, WrapVolume(loc), 0).r;
+#endif
     }
     
     return 0.0f;
 }
 
+#ifdef VOXEL_RT_BRICK_POOL
+// Moves the ray just past the face of the 8^3 brick it's in if the brick is empty, axis is the face it crossed
+bool SkipEmptyBrick(inout vec3 origin, vec3 direction, ivec3 ray_sign, inout int axis)
+{
+	ivec3 Brick = ivec3(floor(origin)) >> 3;
+
+	if (texelFetch(u_VoxelVolume, Brick, 0).r != 0u)
+	{
+		return false;
+	}
+
+	vec3 Boundary = vec3((Brick + ((1 + ray_sign) >> 1)) << 3);
+	vec3 T = mix((Boundary - origin) / direction, vec3(1e30f), equal(ray_sign, ivec3(0)));
+	axis = T.x < T.y ? (T.x < T.z ? 0 : 2) : (T.y < T.z ? 1 : 2);
+
+	origin += direction * T[axis];
+	origin[axis] = Boundary[axis] + float(ray_sign[axis]) * 0.0001f;
+	return true;
+}
+#endif
+
 float ToConservativeEuclidean(float Manhattan)
 {
 	return Manhattan == 1 ? 1 : Manhattan * 0.57735026918f;
 }
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+// Distances of the 4 bit codes of the directional field (see DistanceField.h)
+const float DIRECTIONAL_DISTANCES[16] = float[16](0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 8.0f, 10.0f, 12.0f, 16.0f, 20.0f, 24.0f, 32.0f, 48.0f, 64.0f);
+
+// How far the ray can move from the voxel, the voxels it crosses are closer than t * |direction|1 + 3 and all of them
+// are in the octant it goes towards
+float GetDirectionalStep(ivec3 loc, int octant, float inverse_length)
+{
+	uint Texel = texelFetch(u_DirectionalDistanceField, loc, 0)[octant >> 1];
+	return (DIRECTIONAL_DISTANCES[(Texel >> uint((octant & 1) * 4)) & 0xFu] - 3.0f) * inverse_length;
+}
+#endif
+
 float GetDistance(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-         return (texelFetch(u_DistanceFieldTexture, loc, 0).r);
+         return (texelFetch(u_DistanceFieldTexture, WrapVolume(loc), 0).r);
     }
     
     return -1.0f;
@@ -109,6 +183,11 @@ float VoxelTraversalDF(vec3 origin, vec3 direction, inout vec3 normal, inout flo
 	int MinIdx = 0;
 	ivec3 RaySign = ivec3(sign(direction));
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+	int Octant = int(direction.x < 0.0f) | (int(direction.y < 0.0f) << 1) | (int(direction.z < 0.0f) << 2);
+	float InverseLength = 1.0f / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+#endif
+
 	int itr = 0;
 
 	for (itr = 0 ; itr < 350 ; itr++)
@@ -125,6 +204,29 @@ float VoxelTraversalDF(vec3 origin, vec3 direction, inout vec3 normal, inout flo
 
 		int Euclidean = int(floor(ToConservativeEuclidean(Dist)));
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+		// Take the longer of the two steps, a directional step is at most 61 voxels
+		if (Euclidean > 0 && Euclidean < 62)
+		{
+			float Directional = GetDirectionalStep(Loc, Octant, InverseLength);
+
+			if (Directional >= 1.0f && Directional > float(Euclidean - 1))
+			{
+				origin += Directional * direction;
+				continue;
+			}
+		}
+#endif
+
+#ifdef VOXEL_RT_BRICK_POOL
+		// Close to surfaces the distance field only allows short steps, empty bricks can still be crossed in one
+		if (Euclidean > 0 && Euclidean < 8 && SkipEmptyBrick(origin, direction, RaySign, MinIdx))
+		{
+			Intersection = true;
+			continue;
+		}
+#endif
+
 		if (Euclidean == 0)
 		{
 			break;
@@ -1,8 +1,19 @@
 #version 430 core
 
+#ifndef WORLD_SIZE_X
 #define WORLD_SIZE_X 384
 #define WORLD_SIZE_Y 128
 #define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define PI 3.14159265359
 #define ALPHA_TEST
 
@@ -12,7 +23,23 @@ in vec2 v_TexCoords;
 in vec3 v_RayOrigin;
 in vec3 v_RayDirection;
 
+#ifdef VOXEL_RT_BRICK_POOL
+uniform usampler3D u_VoxelData; // Brick pool indirection, one texel per 8^3 brick (see BrickPool.h)
+uniform sampler3D u_VoxelBrickAtlas;
+#else
 uniform sampler3D u_VoxelData;
+#endif
+
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+ivec3 WrapVolume(ivec3 loc)
+{
+	return (loc + ivec3(u_VolumeOffset)) % ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+#else
+#define WrapVolume(loc) (loc)
+#endif
 uniform sampler2D u_PositionTexture;
 uniform sampler2D u_NormalTexture;
 uniform sampler2D u_BlockIDTexture;
@@ -26,11 +53,11 @@ const vec3 MapSize = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 };
 	
 bool IsInVoxelizationVolume(in vec3 pos)
@@ -48,7 +75,21 @@ float GetVoxel(ivec3 loc)
 {
     if (IsInVoxelizationVolume(loc))
     {
-         return texelFetch(u_VoxelData, loc, 0).r;
+#ifdef VOXEL_RT_BRICK_POOL
+         uint Brick = texelFetch(u_VoxelData, loc >> 3, 0).r;
+
+         // Empty and uniform bricks store the block in the indirection texel
+         if (Brick < 0x80000000u)
+         {
+             uint Block = Brick & 0xFFFFu;
+             return float(Block) / BLOCK_ID_SCALE;
+         }
+
+         ivec3 AtlasBrick = ivec3(Brick & 0x3FFu, (Brick >> 10) & 0x3FFu, (Brick >> 20) & 0x3FFu);
+         return texelFetch(u_VoxelBrickAtlas, (AtlasBrick << 3) + (loc & 7), 0).r;
+#else
+         return texelFetch(u_VoxelData, WrapVolume(loc), 0).r;
+#endif
     }
     
     return 0.0f;
@@ -234,7 +275,7 @@ float voxel_traversal(vec3 orig, vec3 direction)
 			}
 
 			//#ifdef ALPHA_TEST
-			//int reference_id = clamp(int(floor(block * 255.0f)), 0, 127);
+			//int reference_id = clamp(int(round(block * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 			//bool transparent = BLOCK_TEXTURE_DATA[reference_id].a > 0.5f;
 			//
 			//if (transparent)
@@ -421,7 +462,7 @@ vec4 GetTextureIDs(int BlockID)
 int GetBlockID(vec2 txc)
 {
 	float id = texture(u_BlockIDTexture, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 bool CompareFloatNormal(float x, float y) {
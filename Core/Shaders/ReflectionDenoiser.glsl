@@ -1,5 +1,13 @@
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 layout (location = 0) out vec4 o_SpatialResult;
 layout (location = 1) out vec2 o_CoCg;
 
@@ -28,11 +36,11 @@ uniform float u_ReflectionDenoiserScale;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 };
 
 // Large kernel gaussian denoiser //
@@ -158,7 +166,7 @@ vec4 FireflyReject(vec4 Col)
 int GetBlockID(vec2 txc)
 {
 	float id = texelFetch(u_BlockIDTex, ivec2(txc * textureSize(u_BlockIDTex, 0).xy), 0).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 //bool SampleNormalMappedAt(vec3 WorldPos, out vec3 N) {
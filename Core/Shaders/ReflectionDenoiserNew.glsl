@@ -9,6 +9,14 @@
 
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 //#define NORMAL_MAP_KERNEL_WEIGHT
 
 #define sqr(x) (x*x)
@@ -116,7 +124,7 @@ vec3 VarianceFireflyRejection(vec3 Radiance, float VarianceEstimate, vec3 Mean)
 int GetBlockID(vec2 txc)
 {
 	float id = texelFetch(u_BlockIDTex, ivec2(txc * textureSize(u_BlockIDTex, 0).xy), 0).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 float GradientNoise()
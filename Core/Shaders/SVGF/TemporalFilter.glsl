@@ -1,5 +1,13 @@
 #version 330 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define bayer4(a)   (bayer2(  0.5 * (a)) * 0.25 + bayer2(a))
 #define bayer8(a)   (bayer4(  0.5 * (a)) * 0.25 + bayer2(a))
 #define bayer16(a)  (bayer8(  0.5 * (a)) * 0.25 + bayer2(a))
@@ -161,7 +169,7 @@ void main()
 
 	const vec2 Offsets[5] = vec2[5](vec2(1, 0), vec2(0, 1), vec2(0.0f), vec2(-1, 0), vec2(0, -1));
 
-	int BaseBlock = clamp(int(floor((texture(u_CurrentBlockIDTexture, v_TexCoords).r) * 255.0f)), 0, 127);
+	int BaseBlock = clamp(int(round((texture(u_CurrentBlockIDTexture, v_TexCoords).r) * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 	ivec2 Jitter = ivec2((GradientNoise() - 0.5f) * float(1.0f));
 
 	int SuccessfulSamples = 0;
@@ -257,7 +265,7 @@ void main()
 		float PositionError = dot(PositionDifference, PositionDifference);
 		float CurrentWeight = Weights[i];
 		float idat = texture(u_PrevBlockIDTexture, SampleCoord).r;
-		int SampleBlock = clamp(int(floor((idat) * 255.0f)), 0, 127);
+		int SampleBlock = clamp(int(round((idat) * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 
 		bool SampleValid = false;
 
@@ -1,5 +1,13 @@
 #version 430 core
 
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
+
 #define ESTIMATE_VARIANCE_BASED_ON_NEIGHBOURS
 
 layout (location = 0) out vec4 o_SH;
@@ -51,11 +59,11 @@ const float POSITION_THRESH = 4.0f;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 };
 
 vec3 GetRayDirectionAt(vec2 txc)
@@ -74,7 +82,7 @@ vec4 GetPositionAt(vec2 txc)
 int GetBlockAt(vec2 txc)
 {
 	float id = texture(u_BlockIDTexture, txc).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 float GetLuminance(vec3 color) 
@@ -160,7 +168,7 @@ vec3 SampleNormalFromTex(sampler2D samp, vec2 txc) {
 int GetBlockID(vec2 txc)
 {
 	float id = texelFetch(u_BlockIDTexture, ivec2(txc * textureSize(u_BlockIDTexture, 0).xy), 0).r;
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 float sqr(float x) { return x * x; }
@@ -1,8 +1,18 @@
 #version 430 core
 
+#ifndef WORLD_SIZE_X
 #define WORLD_SIZE_X 384
 #define WORLD_SIZE_Y 128
 #define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
+#ifndef BLOCK_ID_SCALE
+#define BLOCK_ID_SCALE 255.0f
+#endif
 
 layout (location = 0) out float o_Shadow;
 layout (location = 1) out float o_IntersectionTransversal; // -> Used as an input to the denoiser 
@@ -11,11 +21,36 @@ in vec2 v_TexCoords;
 in vec3 v_RayOrigin;
 in vec3 v_RayDirection;
 
+#ifdef VOXEL_RT_BRICK_POOL
+uniform usampler3D u_VoxelData; // Brick pool indirection, one texel per 8^3 brick (see BrickPool.h)
+uniform sampler3D u_VoxelBrickAtlas;
+#else
 uniform sampler3D u_VoxelData;
+#endif
 uniform sampler2D u_PositionTexture;
 uniform sampler2D u_NormalTexture;
 uniform sampler2DArray u_AlbedoTextures;
 uniform sampler3D u_DistanceFieldTexture;
+
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+ivec3 WrapVolume(ivec3 loc)
+{
+	return (loc + ivec3(u_VolumeOffset)) % ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+#else
+#define WrapVolume(loc) (loc)
+#endif
+
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+uniform usampler3D u_DirectionalDistanceField; // 4 bit distance per ray octant (see DistanceField.h)
+#endif
+
+#ifdef VOXEL_RT_VOXEL_LOD
+uniform sampler3D u_VoxelLOD; // 2x, 4x and 8x downsampled blocks, one mip per level (see VoxelLOD.h)
+uniform vec3 u_LODDistances; // Distance from the ray origin at which level 1, 2 and 3 start (GetVoxelLODDistances())
+#endif
 uniform sampler2D u_BlueNoiseTexture;
 
 uniform bool u_DoFullTrace;
@@ -38,11 +73,11 @@ uniform vec2 u_Halton;
 
 layout (std430, binding = 0) buffer SSBO_BlockData
 {
-    int BlockAlbedoData[128];
-    int BlockNormalData[128];
-    int BlockPBRData[128];
-    int BlockEmissiveData[128];
-	int BlockTransparentData[128];
+    int BlockAlbedoData[BLOCK_DATA_SIZE];
+    int BlockNormalData[BLOCK_DATA_SIZE];
+    int BlockPBRData[BLOCK_DATA_SIZE];
+    int BlockEmissiveData[BLOCK_DATA_SIZE];
+	int BlockTransparentData[BLOCK_DATA_SIZE];
 }; 
 
 vec2 g_TexCoords;
@@ -64,22 +99,70 @@ float GetVoxel(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-        return texelFetch(u_VoxelData, loc, 0).r;
+#ifdef VOXEL_RT_BRICK_POOL
+        uint Brick = texelFetch(u_VoxelData, loc >> 3, 0).r;
+
+        // Empty and uniform bricks store the block in the indirection texel
+        if (Brick < 0x80000000u)
+        {
+            uint Block = Brick & 0xFFFFu;
+            return float(Block) / BLOCK_ID_SCALE;
+        }
+
+        ivec3 AtlasBrick = ivec3(Brick & 0x3FFu, (Brick >> 10) & 0x3FFu, (Brick >> 20) & 0x3FFu);
+        return texelFetch(u_VoxelBrickAtlas, (AtlasBrick << 3) + (loc & 7), 0).r;
+#else
+        return texelFetch(u_VoxelData, WrapVolume(loc), 0).r;
+#endif
     }
     
     return 0.0f;
 }
 
+#ifdef VOXEL_RT_BRICK_POOL
+// Moves the ray just past the face of the 8^3 brick it's in if the brick is empty, axis is the face it crossed
+bool SkipEmptyBrick(inout vec3 origin, vec3 direction, ivec3 ray_sign, inout int axis)
+{
+	ivec3 Brick = ivec3(floor(origin)) >> 3;
+
+	if (texelFetch(u_VoxelData, Brick, 0).r != 0u)
+	{
+		return false;
+	}
+
+	vec3 Boundary = vec3((Brick + ((1 + ray_sign) >> 1)) << 3);
+	vec3 T = mix((Boundary - origin) / direction, vec3(1e30f), equal(ray_sign, ivec3(0)));
+	axis = T.x < T.y ? (T.x < T.z ? 0 : 2) : (T.y < T.z ? 1 : 2);
+
+	origin += direction * T[axis];
+	origin[axis] = Boundary[axis] + float(ray_sign[axis]) * 0.0001f;
+	return true;
+}
+#endif
+
 float ToConservativeEuclidean(float Manhattan)
 {
 	return Manhattan == 1 ? 1 : Manhattan * 0.57735026918f;
 }
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+// Distances of the 4 bit codes of the directional field (see DistanceField.h)
+const float DIRECTIONAL_DISTANCES[16] = float[16](0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 8.0f, 10.0f, 12.0f, 16.0f, 20.0f, 24.0f, 32.0f, 48.0f, 64.0f);
+
+// How far the ray can move from the voxel, the voxels it crosses are closer than t * |direction|1 + 3 and all of them
+// are in the octant it goes towards
+float GetDirectionalStep(ivec3 loc, int octant, float inverse_length)
+{
+	uint Texel = texelFetch(u_DirectionalDistanceField, loc, 0)[octant >> 1];
+	return (DIRECTIONAL_DISTANCES[(Texel >> uint((octant & 1) * 4)) & 0xFu] - 3.0f) * inverse_length;
+}
+#endif
+
 float GetDistance(ivec3 loc)
 {
     if (IsInVolume(loc))
     {
-         return (texelFetch(u_DistanceFieldTexture, loc, 0).r);
+         return (texelFetch(u_DistanceFieldTexture, WrapVolume(loc), 0).r);
     }
     
     return -1.0f;
@@ -87,7 +170,7 @@ float GetDistance(ivec3 loc)
 
 int GetBlockID(float id)
 {
-	return clamp(int(floor(id * 255.0f)), 0, 127);
+	return clamp(int(round(id * BLOCK_ID_SCALE)), 0, BLOCK_DATA_SIZE - 1);
 }
 
 bool CompareVec3(vec3 v1, vec3 v2) {
@@ -116,6 +199,56 @@ bool StopRay(vec3 P, vec3 N, float Type) {
 	return Alpha > 0.975f;
 }
 
+#ifdef VOXEL_RT_VOXEL_LOD
+// Level the ray is at t voxels away from its origin
+int GetLODLevel(float t)
+{
+	return int(t >= u_LODDistances.x) + int(t >= u_LODDistances.y) + int(t >= u_LODDistances.z);
+}
+
+// One step of a ray through a coarse level, a cell is hit if any voxel inside of it is solid
+// The full resolution distance field still skips the empty space, minus the diagonal of a cell
+bool VoxelStepLOD(int level, int euclidean, ivec3 loc, vec3 direction, ivec3 ray_sign, inout vec3 origin, inout int axis, out float block)
+{
+	float CellSize = float(1 << level);
+	float Skip = float(euclidean) - 1.0f - CellSize * 1.7320508f;
+	block = 0.0f;
+
+	if (Skip >= CellSize)
+	{
+		origin += Skip * direction;
+		return false;
+	}
+
+	ivec3 Cell = loc >> level;
+	block = texelFetch(u_VoxelLOD, Cell, level - 1).r;
+
+	if (block > 0.0f)
+	{
+		return true;
+	}
+
+	// Step to the next cell, or as far as the distance field allows if that gets further
+	vec3 Bound = (vec3(Cell) + vec3(greaterThan(direction, vec3(0.0f)))) * CellSize;
+	vec3 DistanceFactor = (Bound - origin) * (1.0f / direction);
+
+	int Axis = DistanceFactor.x < DistanceFactor.y && ray_sign.x != 0
+		? (DistanceFactor.x < DistanceFactor.z || ray_sign.z == 0 ? 0 : 2)
+		: (DistanceFactor.y < DistanceFactor.z || ray_sign.z == 0 ? 1 : 2);
+
+	if (Skip > DistanceFactor[Axis])
+	{
+		origin += Skip * direction;
+		return false;
+	}
+
+	axis = Axis;
+	origin += DistanceFactor[axis] * direction;
+	origin[axis] = Bound[axis] + ray_sign[axis] * 0.0001f;
+	return false;
+}
+#endif
+
 float VoxelTraversalDF_AlphaTest(vec3 origin, vec3 direction, inout vec3 normal, inout float blockType) 
 {
 	vec3 initial_origin = origin;
@@ -125,6 +258,11 @@ float VoxelTraversalDF_AlphaTest(vec3 origin, vec3 direction, inout vec3 normal,
 	int MinIdx = 0;
 	ivec3 RaySign = ivec3(sign(direction));
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+	int Octant = int(direction.x < 0.0f) | (int(direction.y < 0.0f) << 1) | (int(direction.z < 0.0f) << 2);
+	float InverseLength = 1.0f / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+#endif
+
 	int itr = 0;
 
 	for (itr = 0 ; itr < 350 ; itr++)
@@ -141,6 +279,49 @@ float VoxelTraversalDF_AlphaTest(vec3 origin, vec3 direction, inout vec3 normal,
 
 		int Euclidean = int(floor(ToConservativeEuclidean(Dist)));
 
+#ifdef VOXEL_RT_VOXEL_LOD
+		// Far enough from the origin (or once the ray cone is wide enough) the ray steps through the coarse levels
+		int Level = Euclidean > 0 ? GetLODLevel(distance(origin, initial_origin)) : 0;
+
+		if (Level > 0)
+		{
+			float LODBlock;
+
+			if (VoxelStepLOD(Level, Euclidean, Loc, direction, RaySign, origin, MinIdx, LODBlock))
+			{
+				normal = vec3(0.0f);
+				normal[MinIdx] = -RaySign[MinIdx];
+				blockType = LODBlock;
+				return distance(origin, initial_origin);
+			}
+
+			continue;
+		}
+#endif
+
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+		// Take the longer of the two steps, a directional step is at most 61 voxels
+		if (Euclidean > 0 && Euclidean < 62)
+		{
+			float Directional = GetDirectionalStep(Loc, Octant, InverseLength);
+
+			if (Directional >= 1.0f && Directional > float(Euclidean - 1))
+			{
+				origin += Directional * direction;
+				continue;
+			}
+		}
+#endif
+
+#ifdef VOXEL_RT_BRICK_POOL
+		// Close to surfaces the distance field only allows short steps, empty bricks can still be crossed in one
+		if (Euclidean > 0 && Euclidean < 8 && SkipEmptyBrick(origin, direction, RaySign, MinIdx))
+		{
+			Intersection = true;
+			continue;
+		}
+#endif
+
 		if (Euclidean == 0)
 		{
 			vec3 tn = vec3(0.0f);
@@ -228,6 +409,11 @@ float VoxelTraversalDF(vec3 origin, vec3 direction, inout vec3 normal, inout flo
 	int MinIdx = 0;
 	ivec3 RaySign = ivec3(sign(direction));
 
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+	int Octant = int(direction.x < 0.0f) | (int(direction.y < 0.0f) << 1) | (int(direction.z < 0.0f) << 2);
+	float InverseLength = 1.0f / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+#endif
+
 	int itr = 0;
 
 	for (itr = 0 ; itr < 350 ; itr++)
@@ -244,6 +430,49 @@ float VoxelTraversalDF(vec3 origin, vec3 direction, inout vec3 normal, inout flo
 
 		int Euclidean = int(floor(ToConservativeEuclidean(Dist)));
 
+#ifdef VOXEL_RT_VOXEL_LOD
+		// Far enough from the origin (or once the ray cone is wide enough) the ray steps through the coarse levels
+		int Level = Euclidean > 0 ? GetLODLevel(distance(origin, initial_origin)) : 0;
+
+		if (Level > 0)
+		{
+			float LODBlock;
+
+			if (VoxelStepLOD(Level, Euclidean, Loc, direction, RaySign, origin, MinIdx, LODBlock))
+			{
+				normal = vec3(0.0f);
+				normal[MinIdx] = -RaySign[MinIdx];
+				blockType = LODBlock;
+				return distance(origin, initial_origin);
+			}
+
+			continue;
+		}
+#endif
+
+#ifdef VOXEL_RT_DIRECTIONAL_DISTANCE_FIELD
+		// Take the longer of the two steps, a directional step is at most 61 voxels
+		if (Euclidean > 0 && Euclidean < 62)
+		{
+			float Directional = GetDirectionalStep(Loc, Octant, InverseLength);
+
+			if (Directional >= 1.0f && Directional > float(Euclidean - 1))
+			{
+				origin += Directional * direction;
+				continue;
+			}
+		}
+#endif
+
+#ifdef VOXEL_RT_BRICK_POOL
+		// Close to surfaces the distance field only allows short steps, empty bricks can still be crossed in one
+		if (Euclidean > 0 && Euclidean < 8 && SkipEmptyBrick(origin, direction, RaySign, MinIdx))
+		{
+			Intersection = true;
+			continue;
+		}
+#endif
+
 		if (Euclidean == 0)
 		{
 			break;
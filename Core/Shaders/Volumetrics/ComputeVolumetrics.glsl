@@ -1,8 +1,15 @@
 #version 430 core
 
+#ifndef WORLD_SIZE_X
 #define WORLD_SIZE_X 384
 #define WORLD_SIZE_Y 128
 #define WORLD_SIZE_Z 384
+#endif
+
+#ifndef BLOCK_DATA_SIZE
+#define BLOCK_DATA_SIZE 128
+#endif
+
 #define PI 3.14159265359
 
 // Bayer dithering functions
@@ -30,6 +37,30 @@ uniform sampler2D u_LinearDepthTexture;
 uniform usampler3D u_VolumetricColorDataSampler;
 uniform sampler3D u_VolumetricDensityData;
 
+#ifdef VOXEL_RT_STREAMING
+uniform vec3 u_VolumeOffset; // Texel of voxel 0, the volumes of a streamed world are addressed toroidally (see World::GetVolumeOffset())
+
+// The light volumes repeat horizontally
+vec3 WrapVolumeUV(vec3 uv)
+{
+	return uv + u_VolumeOffset / vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+}
+
+// Texels can be just outside of the window
+ivec3 WrapVolumeTexel(ivec3 texel)
+{
+	const ivec3 Resolution = ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+	return ((texel + ivec3(u_VolumeOffset)) % Resolution + Resolution) % Resolution;
+}
+#else
+#define WrapVolumeUV(uv) (uv)
+#define WrapVolumeTexel(texel) (texel)
+#endif
+
+#ifdef VOXEL_RT_PACKED_VOLUME
+uniform sampler3D u_PackedVoxelVolume; // Block, distance, light level, light color (see PackedVoxelVolume.h)
+#endif
+
 uniform bool u_UsePerlinNoiseForOD;
 uniform bool u_PointVolTriquadraticDensityInterpolation;
 
@@ -54,7 +85,7 @@ uniform bool u_GroundTruthColorInterpolation = false;
 // Ssbos 
 layout (std430, binding = 2) buffer SSBO_BlockAverageData
 {
-    vec4 BlockAverageColorData[128]; // Returns the average color per block type 
+    vec4 BlockAverageColorData[BLOCK_DATA_SIZE]; // Returns the average color per block type 
 };
 
 // 
@@ -234,32 +265,61 @@ float MarchODShadow(vec3 Point, vec3 Lo)
 }
 
 
+#ifdef VOXEL_RT_PACKED_VOLUME
+// The light color is a block id, it can't be filtered : nearest texel, like texture() on the integer color volume
+uint GetLightColorID(vec3 UV) {
+    const ivec3 Resolution = ivec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
+    ivec3 Texel = clamp(ivec3(floor(UV * vec3(Resolution))), ivec3(0), Resolution - 1);
+    return uint(round(texelFetch(u_PackedVoxelVolume, Texel, 0).a * 255.0f));
+}
+
+float GetLightDensity(vec3 UV) {
+    return texture(u_PackedVoxelVolume, UV).b;
+}
+#else
+uint GetLightColorID(vec3 UV) {
+    return texture(u_VolumetricColorDataSampler, WrapVolumeUV(UV)).x;
+}
+
+float GetLightDensity(vec3 UV) {
+    return texture(u_VolumetricDensityData, WrapVolumeUV(UV)).x;
+}
+#endif
+
 vec3 SampleVolumetricColor(vec3 UV) {
-    uint BlockID = texture(u_VolumetricColorDataSampler, UV).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    uint BlockID = GetLightColorID(UV);
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 SampleVolumetricColor(vec3 UV, float D) {
-    uint BlockID = texture(u_VolumetricColorDataSampler, UV+D*0.5f*(1.0f/vec3(384.0f,128.0f,384.0f))).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+    uint BlockID = GetLightColorID(UV+D*0.5f*(1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)));
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 }   
 
 vec3 SampleVolumetricColorTexel(ivec3 Texel) {
-    uint BlockID = texelFetch(u_VolumetricColorDataSampler, Texel, 0).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+#ifdef VOXEL_RT_PACKED_VOLUME
+    uint BlockID = uint(round(texelFetch(u_PackedVoxelVolume, Texel, 0).a * 255.0f));
+#else
+    uint BlockID = texelFetch(u_VolumetricColorDataSampler, WrapVolumeTexel(Texel), 0).x;
+#endif
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 SampleVolumetricColorTexel(ivec3 Texel, int LOD) {
-    uint BlockID = texelFetch(u_VolumetricColorDataSampler, Texel, LOD).x;
-    return vec3(BlockAverageColorData[clamp(BlockID,0u,128u)]);
+#ifdef VOXEL_RT_PACKED_VOLUME
+    uint BlockID = uint(round(texelFetch(u_PackedVoxelVolume, Texel, LOD).a * 255.0f));
+#else
+    uint BlockID = texelFetch(u_VolumetricColorDataSampler, WrapVolumeTexel(Texel), LOD).x;
+#endif
+    return vec3(BlockAverageColorData[min(BlockID, uint(BLOCK_DATA_SIZE - 1))]);
 
 }   
 
 vec3 InterpolateVolumetricColorGT(vec3 uv) // Ground truth interpolation
 {
-    vec3 res = vec3(384.0f, 128.0f, 384.0f);
+    vec3 res = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     vec3 q = fract(uv * res);
     ivec3 t = ivec3(uv * res);
     ivec3 e = ivec3(-1, 0, 1);
@@ -320,7 +380,7 @@ vec3 CustomTriquadraticVolumeInterp(vec3 UV, vec3 BayerNormalized)
         return InterpolateVolumetricColorGT(UV);
     }
 
-    const vec3 Resolution = vec3(384.0f, 128.0f, 384.0f);
+    const vec3 Resolution = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     vec3 FractTexel = fract(UV * Resolution);
     vec3 LinearOffset = (FractTexel * (FractTexel - 1.0f) + 0.5f) / Resolution;
     vec3 W0 = UV - LinearOffset;
@@ -343,19 +403,19 @@ vec3 CustomTriquadraticVolumeInterp(vec3 UV, vec3 BayerNormalized)
 
 float SampleTriQuadraticDensity(vec3 UV) 
 {
-    vec3 LPVResolution = vec3(384.0f, 128.0f, 384.0f);
+    vec3 LPVResolution = vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
     vec3 FractTexel = fract(UV * LPVResolution);
     vec3 LinearOffset = (FractTexel * (FractTexel - 1.0f) + 0.5f) / LPVResolution;
     vec3 W0 = UV - LinearOffset;
     vec3 W1 = UV + LinearOffset;
-    float Density = texture(u_VolumetricDensityData, vec3(W0.x, W0.y, W0.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W1.x, W0.y, W0.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W1.x, W1.y, W0.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W0.x, W1.y, W0.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W0.x, W1.y, W1.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W1.x, W1.y, W1.z)).x
-    	          + texture(u_VolumetricDensityData, vec3(W1.x, W0.y, W1.z)).x
-		          + texture(u_VolumetricDensityData, vec3(W0.x, W0.y, W1.z)).x;
+    float Density = GetLightDensity(vec3(W0.x, W0.y, W0.z))
+    	          + GetLightDensity(vec3(W1.x, W0.y, W0.z))
+    	          + GetLightDensity(vec3(W1.x, W1.y, W0.z))
+    	          + GetLightDensity(vec3(W0.x, W1.y, W0.z))
+    	          + GetLightDensity(vec3(W0.x, W1.y, W1.z))
+    	          + GetLightDensity(vec3(W1.x, W1.y, W1.z))
+    	          + GetLightDensity(vec3(W1.x, W0.y, W1.z))
+		          + GetLightDensity(vec3(W0.x, W0.y, W1.z));
 	return max(Density / 8.0, 0.00000001f);
 }
 
@@ -417,7 +477,7 @@ void main()
 
     vec3 SampleDither = vec3(bayer128(gl_FragCoord.xy), bayer16(gl_FragCoord.xy)*0.4, bayer16(gl_FragCoord.xy)*0.7);
     vec3 VolumetricColorDither = vec3(bayer128(gl_FragCoord.xy));
-    VolumetricColorDither *= 1.0f/vec3(384.0f,128.0f,384.0f);
+    VolumetricColorDither *= 1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z);
 
     //float CurrentTransmittance = 1.0f;
     //float TotalTransmittance = 1.0f;
@@ -437,7 +497,7 @@ void main()
         if (AirDensity > 0.001f) {
 
             float SampleSigmaS = SigmaS * AirDensity; 
-            vec3 DensitySamplePosition = (vec3(RayPosition.xyz-vec3(0.125f,0.0f,0.125f))*(1.0f/vec3(384.0f,128.0f,384.0f)))+(SampleDither*0.125f*(1.0f/vec3(384.0f,128.0f,384.0f)));
+            vec3 DensitySamplePosition = (vec3(RayPosition.xyz-vec3(0.125f,0.0f,0.125f))*(1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)))+(SampleDither*0.125f*(1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)));
             float PointDensity;
 
             if (u_PointVolTriquadraticDensityInterpolation) {
@@ -445,7 +505,7 @@ void main()
             }
 
             else {
-                PointDensity = texture(u_VolumetricDensityData, DensitySamplePosition).x; // Hardware trilinear
+                PointDensity = GetLightDensity(DensitySamplePosition); // Hardware trilinear
             }
 
             PointDensity *= pdM;
@@ -455,8 +515,8 @@ void main()
 
             if (u_Colored) {
                 // Triquadratic interpolation 
-                vec3 Normalized = RayPosition * (1.0f/vec3(384.0f,128.0f,384.0f));
-               // Normalized += SampleDither * 0.450f * (1.0f/vec3(384.0f,128.0f,384.0f)); // Jitter ray sample position
+                vec3 Normalized = RayPosition * (1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z));
+               // Normalized += SampleDither * 0.450f * (1.0f/vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z)); // Jitter ray sample position
                 ScatteringColor = clamp(CustomTriquadraticVolumeInterp(Normalized,VolumetricColorDither), 0.0f, 1.0f)*2.0f*1.66676f; 
             }
 
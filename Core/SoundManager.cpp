@@ -49,7 +49,7 @@ namespace VoxelRT
 	{
 		glm::vec3 p = glm::vec3(0.0f, 70.0f, 0.0f);
 
-		for (int block = 0; block < 128; block++) {
+		for (int block = 0; block <= BlockDatabase::GetNumberOfBlocksInDatabase(); block++) {
 			std::string snd_typ = BlockDatabase::GetStepSound(block);
 			std::string snd_1_typ = BlockDatabase::GetModifySound(block);
 
@@ -75,7 +75,7 @@ namespace VoxelRT
 		}
 	}
 
-	void SoundManager::PlayBlockSound(uint8_t block, const glm::vec3& p, bool type)
+	void SoundManager::PlayBlockSound(uint16_t block, const glm::vec3& p, bool type)
 	{
 		// Air.
 		if (block <= 0)
@@ -17,7 +17,7 @@ namespace VoxelRT
 		void InitializeSoundManager();
 		void UpdatePosition(const glm::vec3& Front, const glm::vec3& Position, const glm::vec3& Up);
 		void PlaySound(const std::string& s, const glm::vec3& p, float d, float v, bool pause);
-		void PlayBlockSound(uint8_t block, const glm::vec3& p, bool type);
+		void PlayBlockSound(uint16_t block, const glm::vec3& p, bool type);
 		void Destroy();
 		void SetPack(bool TYPE);
 		void LoadSounds();
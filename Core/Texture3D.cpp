@@ -5,7 +5,7 @@ VoxelRT::Texture3D::Texture3D()
 	m_ID = 0;
 }
 
-void VoxelRT::Texture3D::CreateTexture(int w, int h, int d, void* data)
+void VoxelRT::Texture3D::CreateTexture(int w, int h, int d, void* data, GLenum internal_format, GLenum format, GLenum type)
 {
 	if (m_ID > 0)
 	{
@@ -24,5 +24,5 @@ void VoxelRT::Texture3D::CreateTexture(int w, int h, int d, void* data)
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, w, h, d, 0, GL_RED, GL_UNSIGNED_BYTE, data);
+	glTexImage3D(GL_TEXTURE_3D, 0, internal_format, w, h, d, 0, format, type, data);
 }
@@ -11,7 +11,8 @@ namespace VoxelRT
 	{
 	public :
 		Texture3D();
-		void CreateTexture(int w, int h, int d, void* data);
+		// Defaults to a single channel byte texture (the voxel data / distance field format)
+		void CreateTexture(int w, int h, int d, void* data, GLenum internal_format = GL_RED, GLenum format = GL_RED, GLenum type = GL_UNSIGNED_BYTE);
 
 		inline int GetWidth() const { return m_Width; }
 		inline int GetHeight() const { return m_Height; }
@@ -1,6 +1,12 @@
 #include "VolumetricFloodFill.h"
 
 #include <memory>
+#include <algorithm>
+#include <tuple>
+
+#include "VoxelIndexing.h"
+#include "DirtyRegion.h"
+#include "BlockDatabase.h"
 
 // Flood fill implementation done using a BFS queue system
 // Fastest CPU side algorithm, about 2x faster than recursion
@@ -15,13 +21,19 @@ namespace VoxelRT {
 	static std::queue<LightNode> LightBFS;
 	static std::queue<LightRemovalNode> LightRemovalBFS;
 	static World* VolumetricWorldPtr = nullptr;
-	static std::unique_ptr<std::array<uint8_t, 384 * 128 * 384>> WorldVolumetricDensityData;
-	static std::unique_ptr<std::array<uint8_t, 384 * 128 * 384>> WorldVolumetricColorData;
+	static glm::ivec3 VolumeDimensions = glm::ivec3(0);
+	static BrickedVolumeIndexer VolumeIndexer; // The cpu side light data uses the bricked layout, the textures are linear
+	static std::vector<uint8_t> WorldVolumetricDensityData;
+	static std::vector<uint16_t> WorldVolumetricColorData; // Block type of the light, indexes the average color ssbo
+	static bool ColorDataWide = false; // The color volume is R16UI if the block ids don't fit in a byte, R8UI otherwise
+	static DirtyRegion LightDirtyRegion; // Voxels modified since the last FlushUploads()
+	static std::vector<uint8_t> UploadBuffer;
+	static std::vector<uint16_t> ColorUploadBuffer;
 
 
 	bool InVoxelVolume(const glm::ivec3& x) {
 
-		if (x.x > 0 && x.y > 0 && x.z > 0 && x.x < 384 && x.y < 128 && x.z < 384)
+		if (x.x > 0 && x.y > 0 && x.z > 0 && x.x < VolumeDimensions.x && x.y < VolumeDimensions.y && x.z < VolumeDimensions.z)
 		{
 			return true;
 		}
@@ -36,25 +48,31 @@ void VoxelRT::Volumetrics::CreateVolume(World* world, GLuint SSBO_Blockdata, GLu
 	ColorDataFloodFillVolume = 0;
 	AverageColorSSBO = 0;
 	VolumetricWorldPtr = world;
+	VolumeDimensions = world->GetDimensions();
+	VolumeIndexer = BrickedVolumeIndexer(VolumeDimensions);
+	ColorDataWide = BlockDatabase::UsesWideBlockIDs();
+
+	// A streamed world is addressed toroidally on x and z, filtering has to wrap around the same way
+	const GLint HorizontalWrap = world->IsStreamed() ? GL_REPEAT : GL_CLAMP_TO_EDGE;
 
 	glGenTextures(1, &VolumetricFloodFillVolume);
 	glBindTexture(GL_TEXTURE_3D, VolumetricFloodFillVolume);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, HorizontalWrap);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, 384, 128, 384, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, HorizontalWrap);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RED, VolumeDimensions.x, VolumeDimensions.y, VolumeDimensions.z, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
 
 
 	glGenTextures(1, &ColorDataFloodFillVolume);
 	glBindTexture(GL_TEXTURE_3D, ColorDataFloodFillVolume);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, HorizontalWrap);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, 384, 128, 384, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, HorizontalWrap);
+	glTexImage3D(GL_TEXTURE_3D, 0, ColorDataWide ? GL_R16UI : GL_R8UI, VolumeDimensions.x, VolumeDimensions.y, VolumeDimensions.z, 0, GL_RED_INTEGER, ColorDataWide ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, nullptr);
 
 
 
@@ -63,6 +81,7 @@ void VoxelRT::Volumetrics::CreateVolume(World* world, GLuint SSBO_Blockdata, GLu
 
 	// clear (doesnt automatically clear on some gpus)
 	
+	const glm::ivec3 ClearGroups = (VolumeDimensions + glm::ivec3(7)) / 8;
 
 	GLClasses::ComputeShader ClearShaderFloat;
 	ClearShaderFloat.CreateComputeShader("Core/Shaders/Volumetrics/ClearDataFloat.comp");
@@ -70,30 +89,27 @@ void VoxelRT::Volumetrics::CreateVolume(World* world, GLuint SSBO_Blockdata, GLu
 	ClearShaderFloat.Use();
 
 	glBindImageTexture(0, VolumetricFloodFillVolume, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
-	glDispatchCompute(384 / 8, 128 / 8, 384 / 8);
+	glDispatchCompute(ClearGroups.x, ClearGroups.y, ClearGroups.z);
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 	GLClasses::ComputeShader ClearShader;
-	ClearShader.CreateComputeShader("Core/Shaders/Volumetrics/ClearData.comp");
+	ClearShader.CreateComputeShader(ColorDataWide ? "Core/Shaders/ComputeUtility/ClearIntData.comp" : "Core/Shaders/Volumetrics/ClearData.comp");
 	ClearShader.Compile();
 	ClearShader.Use();
 
-	glBindImageTexture(0, ColorDataFloodFillVolume, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8UI);
-	glDispatchCompute(384 / 8, 128 / 8, 384 / 8);
+	glBindImageTexture(0, ColorDataFloodFillVolume, 0, GL_TRUE, 0, GL_READ_WRITE, ColorDataWide ? GL_R16UI : GL_R8UI);
+	glDispatchCompute(ClearGroups.x, ClearGroups.y, ClearGroups.z);
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 	// Create light data array
-	WorldVolumetricColorData = std::unique_ptr<std::array<uint8_t, 384 * 128 * 384>>(new std::array<uint8_t, 384 * 128 * 384>);
-	WorldVolumetricDensityData = std::unique_ptr<std::array<uint8_t, 384 * 128 * 384>>(new std::array<uint8_t, 384 * 128 * 384>);
-
-	// memset 
-	memset(WorldVolumetricColorData.get()->data(), 0, 384 * 128 * 384 * sizeof(uint8_t));
-	memset(WorldVolumetricDensityData.get()->data(), 0, 384 * 128 * 384 * sizeof(uint8_t));
+	const size_t VolumeSize = VolumeIndexer.GetVolume();
+	WorldVolumetricColorData.assign(VolumeSize, 0);
+	WorldVolumetricDensityData.assign(VolumeSize, 0);
 
 	// initialize data ssbo 
 	glGenBuffers(1, &AverageColorSSBO);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, AverageColorSSBO);
-	int TotalBufferSize = (sizeof(GLfloat) * 4) * 128;
+	int TotalBufferSize = (sizeof(GLfloat) * 4) * BlockDatabase::GetBlockDataTableSize();
 	glBufferData(GL_SHADER_STORAGE_BUFFER, TotalBufferSize, nullptr, GL_STATIC_DRAW);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
@@ -124,12 +140,12 @@ uint8_t VoxelRT::Volumetrics::GetLightValue(const glm::ivec3& p)
 		return 0;
 	}
 
-	int idx = p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y;
-	auto& arr = *WorldVolumetricDensityData;
+	size_t idx = VolumeIndexer.GetIndex(p);
+	auto& arr = WorldVolumetricDensityData;
 	return (arr.at(idx));
 }
 
-uint8_t VoxelRT::Volumetrics::GetBlockTypeLightValue(const glm::ivec3& p)
+uint16_t VoxelRT::Volumetrics::GetBlockTypeLightValue(const glm::ivec3& p)
 {
 #ifdef VOXEL_RT_VOLUMETRICS_DEBUG
 	std::cout << "GetBlockTypeLightValue() Called";
@@ -140,12 +156,12 @@ uint8_t VoxelRT::Volumetrics::GetBlockTypeLightValue(const glm::ivec3& p)
 		//throw "wtf";
 	}
 
-	int idx = p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y;
-	auto& arr = *WorldVolumetricColorData;
+	size_t idx = VolumeIndexer.GetIndex(p);
+	auto& arr = WorldVolumetricColorData;
 	return ((arr.at(idx)));
 }
 
-void VoxelRT::Volumetrics::SetLightValue(const glm::ivec3& p, uint8_t v, uint8_t block)
+void VoxelRT::Volumetrics::SetLightValue(const glm::ivec3& p, uint8_t v, uint16_t block)
 {
 #ifdef VOXEL_RT_VOLUMETRICS_DEBUG
 	std::cout << "SetLightValue() Called";
@@ -156,12 +172,12 @@ void VoxelRT::Volumetrics::SetLightValue(const glm::ivec3& p, uint8_t v, uint8_t
 		return;
 	}
 
-	int idx = p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y;
-	WorldVolumetricColorData.get()->at(idx) = block;
-	WorldVolumetricDensityData.get()->at(idx) = v;
+	size_t idx = VolumeIndexer.GetIndex(p);
+	WorldVolumetricColorData.at(idx) = block;
+	WorldVolumetricDensityData.at(idx) = v;
 }
 
-void VoxelRT::Volumetrics::UploadLight(const glm::ivec3& p, uint8_t v, uint8_t block, bool should_bind)
+void VoxelRT::Volumetrics::UploadLight(const glm::ivec3& p, uint8_t, uint16_t, bool should_bind)
 {
 #ifdef VOXEL_RT_VOLUMETRICS_DEBUG
 	std::cout << "UploadLight() Called";
@@ -172,15 +188,12 @@ void VoxelRT::Volumetrics::UploadLight(const glm::ivec3& p, uint8_t v, uint8_t b
 		//throw "wtf";
 	}
 
-
-	glBindTexture(GL_TEXTURE_3D, VolumetricFloodFillVolume);
-	glTexSubImage3D(GL_TEXTURE_3D, 0, (int)p.x, (int)p.y, (int)p.z, 1, 1, 1, GL_RED, GL_UNSIGNED_BYTE, &v);
-
-	glBindTexture(GL_TEXTURE_3D, ColorDataFloodFillVolume);
-	glTexSubImage3D(GL_TEXTURE_3D, 0, (int)p.x, (int)p.y, (int)p.z, 1, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &block);
+	// The values are already in the cpu side volume (SetLightValue), the voxel is uploaded along with the rest of the
+	// voxels the flood fill touched in FlushUploads()
+	LightDirtyRegion.Add(p);
 }
 
-void VoxelRT::Volumetrics::AddLightToVolume(const glm::ivec3& p, uint8_t block)
+void VoxelRT::Volumetrics::AddLightToVolume(const glm::ivec3& p, uint16_t block)
 {
 	VoxelRT::Volumetrics::SetLightValue(glm::ivec3(
 		floor(p.x),
@@ -196,15 +209,107 @@ void VoxelRT::Volumetrics::AddLightToVolume(const glm::ivec3& p, uint8_t block)
 		floor(p.z))));
 }
 
+// Converts a box of a bricked volume to the linear layout used by the textures
+template <typename T, typename U>
+static void LinearizeRegion(const std::vector<T>& volume, const glm::ivec3& origin, const glm::ivec3& size, U* output)
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			U* row = output + (y * size.x) + ((size_t)z * size.x * size.y);
+
+			for (int x = 0; x < size.x; x++)
+			{
+				row[x] = (U)volume[VoxelRT::VolumeIndexer.GetIndex(origin.x + x, origin.y + y, origin.z + z)];
+			}
+		}
+	}
+}
+
+// The textures of a streamed world are addressed toroidally, a box can be split in up to 4 parts
+static void UploadRegion(const glm::ivec3& origin, const glm::ivec3& size, std::vector<uint8_t>& buffer)
+{
+	const VoxelRT::DirtyBox Box = { origin, origin + size };
+
+	VoxelRT::ForEachWrappedBox(Box, VoxelRT::VolumetricWorldPtr->GetVolumeOffset(), VoxelRT::VolumeDimensions, [&buffer](const glm::ivec3& origin, const glm::ivec3& size, const glm::ivec3& texel)
+	{
+		buffer.resize((size_t)size.x * size.y * size.z);
+
+		LinearizeRegion(VoxelRT::WorldVolumetricDensityData, origin, size, buffer.data());
+		glBindTexture(GL_TEXTURE_3D, VoxelRT::VolumetricFloodFillVolume);
+		glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED, GL_UNSIGNED_BYTE, buffer.data());
+
+		glBindTexture(GL_TEXTURE_3D, VoxelRT::ColorDataFloodFillVolume);
+
+		if (VoxelRT::ColorDataWide)
+		{
+			VoxelRT::ColorUploadBuffer.resize(buffer.size());
+			LinearizeRegion(VoxelRT::WorldVolumetricColorData, origin, size, VoxelRT::ColorUploadBuffer.data());
+			glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED_INTEGER, GL_UNSIGNED_SHORT, VoxelRT::ColorUploadBuffer.data());
+		}
+
+		else
+		{
+			LinearizeRegion(VoxelRT::WorldVolumetricColorData, origin, size, buffer.data());
+			glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED_INTEGER, GL_UNSIGNED_BYTE, buffer.data());
+		}
+	});
+}
+
 void VoxelRT::Volumetrics::Reupload()
 {
-	glBindTexture(GL_TEXTURE_3D, VolumetricFloodFillVolume);
-	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, 384, 128, 384, GL_RED, GL_UNSIGNED_BYTE, WorldVolumetricDensityData.get()->data());
+	// Upload one slab of bricks at a time so that we never need a flat copy of the entire volume
+	const glm::ivec3 SlabSize = glm::ivec3(VolumeDimensions.x, VolumeDimensions.y, BRICK_SIZE);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int z = 0; z < VolumeDimensions.z; z += BRICK_SIZE)
+	{
+		UploadRegion(glm::ivec3(0, 0, z), SlabSize, UploadBuffer);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glBindTexture(GL_TEXTURE_3D, 0);
 
-	glBindTexture(GL_TEXTURE_3D, ColorDataFloodFillVolume);
-	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, 384, 128, 384, GL_RED_INTEGER, GL_UNSIGNED_BYTE, WorldVolumetricColorData.get()->data());
+	LightDirtyRegion.Clear();
+	VolumetricWorldPtr->GetPackedVolume().MarkDirty(glm::ivec3(0), VolumeDimensions);
+}
+
+void VoxelRT::Volumetrics::FlushUploads()
+{
+	if (LightDirtyRegion.IsEmpty())
+	{
+		return;
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (const DirtyBox& box : LightDirtyRegion.GetBoxes())
+	{
+		UploadRegion(box.Min, box.GetSize(), UploadBuffer);
+		VolumetricWorldPtr->GetPackedVolume().MarkDirty(box.Min, box.Max);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glBindTexture(GL_TEXTURE_3D, 0);
+
+	LightDirtyRegion.Clear();
+}
+
+void VoxelRT::Volumetrics::ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* density, uint16_t* color)
+{
+	const size_t Volume = (size_t)size.x * size.y * size.z;
+
+	if (WorldVolumetricDensityData.empty())
+	{
+		std::fill(density, density + Volume, 0);
+		std::fill(color, color + Volume, 0);
+		return;
+	}
+
+	LinearizeRegion(WorldVolumetricDensityData, origin, size, density);
+	LinearizeRegion(WorldVolumetricColorData, origin, size, color);
 }
 
 GLuint VoxelRT::Volumetrics::GetDensityVolume()
@@ -219,10 +324,145 @@ GLuint VoxelRT::Volumetrics::GetColorVolume()
 
 void VoxelRT::Volumetrics::ClearEntireVolume()
 {
-	memset(WorldVolumetricColorData.get()->data(), 0, 384 * 128 * 384 * sizeof(uint8_t));
-	memset(WorldVolumetricDensityData.get()->data(), 0, 384 * 128 * 384 * sizeof(uint8_t));
+	std::fill(WorldVolumetricColorData.begin(), WorldVolumetricColorData.end(), 0);
+	std::fill(WorldVolumetricDensityData.begin(), WorldVolumetricDensityData.end(), 0);
+}
+
+void VoxelRT::Volumetrics::RelightRegion(const glm::ivec3& min, const glm::ivec3& max)
+{
+	World* world = VolumetricWorldPtr;
+
+	if (!world)
+	{
+		return;
+	}
+
+	// Light drops by one per voxel, nothing further than the source level from the edits can change
+	const uint8_t SourceLight = VoxelRT_FloodFillDistanceLimit > 8 ? 8 : VoxelRT_FloodFillDistanceLimit;
+	const glm::ivec3 Min = glm::max(min - glm::ivec3(SourceLight), glm::ivec3(1));
+	const glm::ivec3 Max = glm::min(max + glm::ivec3(SourceLight), VolumeDimensions);
+
+	if (glm::any(glm::greaterThanEqual(Min, Max)))
+	{
+		return;
+	}
+
+	for (int z = Min.z; z < Max.z; z++)
+	{
+		for (int y = Min.y; y < Max.y; y++)
+		{
+			for (int x = Min.x; x < Max.x; x++)
+			{
+				const size_t idx = VolumeIndexer.GetIndex(x, y, z);
+				WorldVolumetricDensityData[idx] = 0;
+				WorldVolumetricColorData[idx] = 0;
+			}
+		}
+	}
+
+	// The emissive voxels come from the chunk summaries instead of a lookup per voxel, in the order of the box so that
+	// lights of different colors that reach a voxel at the same level resolve the same way
+	std::vector<glm::ivec3> Lights;
+	world->m_WorldData.GetLights(Min, Max, Lights);
+
+	std::sort(Lights.begin(), Lights.end(), [](const glm::ivec3& a, const glm::ivec3& b) {
+		return std::tie(a.z, a.y, a.x) < std::tie(b.z, b.y, b.x);
+	});
+
+	for (const glm::ivec3& p : Lights)
+	{
+		// The summaries of the chunks a lazily loaded world doesn't have yet come from the file
+		const uint16_t block = world->GetBlock(p.x, p.y, p.z).block;
+
+		if (block == 0)
+		{
+			continue;
+		}
+
+		const size_t idx = VolumeIndexer.GetIndex(p);
+		WorldVolumetricDensityData[idx] = SourceLight;
+		WorldVolumetricColorData[idx] = block;
+		LightBFS.push(LightNode(glm::vec3(p)));
+	}
+
+	// Light from the lights outside of the box flows back in from the voxels around it
+	auto PushLit = [](const glm::ivec3& p)
+	{
+		if (VoxelRT::InVoxelVolume(p) && WorldVolumetricDensityData[VolumeIndexer.GetIndex(p)] > 0)
+		{
+			LightBFS.push(LightNode(p));
+		}
+	};
+
+	for (int z = Min.z; z < Max.z; z++)
+	{
+		for (int y = Min.y; y < Max.y; y++)
+		{
+			PushLit(glm::ivec3(Min.x - 1, y, z));
+			PushLit(glm::ivec3(Max.x, y, z));
+		}
+
+		for (int x = Min.x; x < Max.x; x++)
+		{
+			PushLit(glm::ivec3(x, Min.y - 1, z));
+			PushLit(glm::ivec3(x, Max.y, z));
+		}
+	}
+
+	for (int y = Min.y; y < Max.y; y++)
+	{
+		for (int x = Min.x; x < Max.x; x++)
+		{
+			PushLit(glm::ivec3(x, y, Min.z - 1));
+			PushLit(glm::ivec3(x, y, Max.z));
+		}
+	}
+
+	LightDirtyRegion.Add(Min, Max);
+	PropogateVolume();
 }
 
+void VoxelRT::Volumetrics::ShiftVolume(const glm::ivec3& delta, const std::vector<DirtyBox>& relight)
+{
+	if (WorldVolumetricDensityData.empty())
+	{
+		return;
+	}
+
+	// Bricks are moved in place, in the order that never overwrites a brick that still has to be read
+	const glm::ivec3 Bricks = VolumeDimensions >> BRICK_SHIFT;
+	const glm::ivec3 BrickDelta = delta >> BRICK_SHIFT;
+	const glm::ivec3 Step = glm::ivec3(BrickDelta.x < 0 ? -1 : 1, BrickDelta.y < 0 ? -1 : 1, BrickDelta.z < 0 ? -1 : 1);
+	const glm::ivec3 First = glm::mix(glm::ivec3(0), Bricks - 1, glm::lessThan(Step, glm::ivec3(0)));
+
+	for (int i = 0, z = First.z; i < Bricks.z; i++, z += Step.z)
+	{
+		for (int j = 0, y = First.y; j < Bricks.y; j++, y += Step.y)
+		{
+			for (int k = 0, x = First.x; k < Bricks.x; k++, x += Step.x)
+			{
+				const glm::ivec3 Source = glm::ivec3(x, y, z) + BrickDelta;
+				const size_t To = (size_t)VolumeIndexer.GetBrickIndex(x << BRICK_SHIFT, y << BRICK_SHIFT, z << BRICK_SHIFT) * BRICK_VOLUME;
+
+				if (glm::any(glm::lessThan(Source, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Source, Bricks)))
+				{
+					std::fill_n(WorldVolumetricDensityData.begin() + To, BRICK_VOLUME, 0);
+					std::fill_n(WorldVolumetricColorData.begin() + To, BRICK_VOLUME, 0);
+					continue;
+				}
+
+				const size_t From = (size_t)VolumeIndexer.GetBrickIndex(Source.x << BRICK_SHIFT, Source.y << BRICK_SHIFT, Source.z << BRICK_SHIFT) * BRICK_VOLUME;
+				std::copy_n(WorldVolumetricDensityData.begin() + From, BRICK_VOLUME, WorldVolumetricDensityData.begin() + To);
+				std::copy_n(WorldVolumetricColorData.begin() + From, BRICK_VOLUME, WorldVolumetricColorData.begin() + To);
+			}
+		}
+	}
+
+	for (const DirtyBox& box : relight)
+	{
+		RelightRegion(box.Min, box.Max);
+	}
+}
 
 GLuint VoxelRT::Volumetrics::GetAverageColorSSBO()
 {
@@ -251,13 +491,13 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		glm::ivec3 pos = node.m_Position;
 		uint8_t current_light = VoxelRT::Volumetrics::GetLightValue(pos);
-		uint8_t current_block_type = VoxelRT::Volumetrics::GetBlockTypeLightValue(pos);
+		uint16_t current_block_type = VoxelRT::Volumetrics::GetBlockTypeLightValue(pos);
 		glm::ivec3 temp_pos = glm::vec3(0.0f);
 
 		temp_pos = glm::vec3(pos.x + 1, pos.y, pos.z);
 		if (VoxelRT::InVoxelVolume(temp_pos))
 		{
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -268,7 +508,7 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		temp_pos = glm::vec3(pos.x - 1, pos.y, pos.z);
 		if (VoxelRT::InVoxelVolume(temp_pos)) {
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -280,7 +520,7 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		temp_pos = glm::vec3(pos.x, pos.y + 1, pos.z);
 		if (VoxelRT::InVoxelVolume(temp_pos)) {
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -291,7 +531,7 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		temp_pos = glm::vec3(pos.x, pos.y - 1, pos.z);
 		if (VoxelRT::InVoxelVolume(temp_pos)) {
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -302,7 +542,7 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		temp_pos = glm::vec3(pos.x, pos.y, pos.z - 1);
 		if (VoxelRT::InVoxelVolume(temp_pos)) {
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -312,7 +552,7 @@ void VoxelRT::Volumetrics::PropogateVolume()
 
 		temp_pos = glm::vec3(pos.x, pos.y, pos.z + 1);
 		if (VoxelRT::InVoxelVolume(temp_pos)) {
-			if (world->GetBlock(temp_pos).block == 0 && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
+			if (!world->IsSolid(temp_pos) && Volumetrics::GetLightValue(temp_pos) + 2 < current_light)
 			{
 				Volumetrics::SetLightValue(temp_pos, current_light - 1, current_block_type);
 				Volumetrics::UploadLight(temp_pos, current_light - 1, current_block_type, false);
@@ -334,7 +574,7 @@ void VoxelRT::Volumetrics::DepropogateVolume()
 		uint8_t current_light = node.m_LightValue;
 		glm::ivec3 temp_pos = glm::vec3(0.0f);
 		uint8_t neighbouring_light;
-		uint8_t CurrentBlock;
+		uint16_t CurrentBlock;
 
 		// x + 1
 		temp_pos = glm::vec3(pos.x + 1, pos.y, pos.z);
@@ -45,16 +45,30 @@ namespace VoxelRT
 		void PropogateVolume();
 		void DepropogateVolume();
 		uint8_t GetLightValue(const glm::ivec3& p);
-		uint8_t GetBlockTypeLightValue(const glm::ivec3& p);
-		void SetLightValue(const glm::ivec3& p, uint8_t v, uint8_t block);
-		void UploadLight(const glm::ivec3& p, uint8_t v, uint8_t block, bool should_bind);
-		void AddLightToVolume(const glm::ivec3& p, uint8_t block);
+		uint16_t GetBlockTypeLightValue(const glm::ivec3& p);
+		void SetLightValue(const glm::ivec3& p, uint8_t v, uint16_t block);
+		void UploadLight(const glm::ivec3& p, uint8_t v, uint16_t block, bool should_bind); // Deferred until FlushUploads()
+		void AddLightToVolume(const glm::ivec3& p, uint16_t block);
 		void Reupload();
+		void FlushUploads(); // Uploads the voxels modified since the last flush, called once per frame
+
+		// Reads a box of the light volume (x + y * size.x + z * size.x * size.y), zeros if the volume wasn't created
+		void ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* density, uint16_t* color);
 		GLuint GetAverageColorSSBO();
 		std::queue<LightNode>& GetLightBFSQueue();
 		std::queue<LightRemovalNode>& GetLightRemovalBFSQueue();
 		GLuint GetDensityVolume();
 		GLuint GetColorVolume();
 		void ClearEntireVolume();
+
+		// Recomputes the light around a box of edited voxels (max exclusive) in a single pass : everything within the
+		// light range of the box is cleared and flood filled again from the lights inside and the voxels around it
+		void RelightRegion(const glm::ivec3& min, const glm::ivec3& max);
+
+		// Moves the volume along with a streamed world (delta in voxels, whole bricks, after WorldData::ShiftChunks()),
+		// voxel p takes the light of voxel p + delta. The textures are addressed toroidally (World::GetVolumeOffset()),
+		// nothing is uploaded for the move itself, only the boxes that are relit afterwards (the part that came in and
+		// the side the light moved away from)
+		void ShiftVolume(const glm::ivec3& delta, const std::vector<DirtyBox>& relight);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace VoxelRT
+{
+	// Voxel indexing shared by all the CPU side voxel volumes
+	// Volumes are split into 16^3 bricks and the voxels inside a brick are stored in morton (z order) order.
+	// Morton order is hierarchical, so every aligned 8^3 (and 4^3, 2^3) sub brick is contiguous as well which
+	// keeps all six neighbours of a voxel within a few cache lines instead of a full row or slice away.
+
+	const int BRICK_SIZE = 16;
+	const int BRICK_SHIFT = 4;
+	const int BRICK_MASK = BRICK_SIZE - 1;
+	const int BRICK_VOLUME = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+	namespace VoxelIndexing
+	{
+		// Spreads the low 4 bits of v so that there are two zero bits in between each bit
+		constexpr uint32_t MortonSpread4(uint32_t v) noexcept
+		{
+			return (v & 1u) | ((v & 2u) << 2) | ((v & 4u) << 4) | ((v & 8u) << 6);
+		}
+
+		constexpr uint32_t MortonCompact4(uint32_t v) noexcept
+		{
+			return (v & 1u) | ((v >> 2) & 2u) | ((v >> 4) & 4u) | ((v >> 6) & 8u);
+		}
+
+		struct MortonTable
+		{
+			uint32_t Spread[BRICK_SIZE];
+
+			constexpr MortonTable() : Spread()
+			{
+				for (uint32_t i = 0; i < BRICK_SIZE; i++)
+				{
+					Spread[i] = MortonSpread4(i);
+				}
+			}
+		};
+
+		constexpr MortonTable MortonLUT;
+
+		// Index of a voxel inside of its brick (only the low 4 bits of each component are used)
+		inline int GetBrickLocalIndex(int x, int y, int z) noexcept
+		{
+			return (int)(MortonLUT.Spread[x & BRICK_MASK] | (MortonLUT.Spread[y & BRICK_MASK] << 1) | (MortonLUT.Spread[z & BRICK_MASK] << 2));
+		}
+
+		inline glm::ivec3 GetBrickLocalPosition(int idx) noexcept
+		{
+			return glm::ivec3(MortonCompact4((uint32_t)idx), MortonCompact4((uint32_t)idx >> 1), MortonCompact4((uint32_t)idx >> 2));
+		}
+	}
+
+	// Maps positions in a volume (dimensions have to be multiples of BRICK_SIZE) to brick major, morton ordered indices
+	class BrickedVolumeIndexer
+	{
+	public :
+
+		BrickedVolumeIndexer() {}
+
+		BrickedVolumeIndexer(const glm::ivec3& dimensions)
+		{
+			m_Dimensions = dimensions;
+			m_BricksX = dimensions.x >> BRICK_SHIFT;
+			m_BricksXY = m_BricksX * (dimensions.y >> BRICK_SHIFT);
+		}
+
+		inline int GetBrickIndex(int x, int y, int z) const noexcept
+		{
+			return (x >> BRICK_SHIFT) + (y >> BRICK_SHIFT) * m_BricksX + (z >> BRICK_SHIFT) * m_BricksXY;
+		}
+
+		inline size_t GetIndex(int x, int y, int z) const noexcept
+		{
+			return ((size_t)GetBrickIndex(x, y, z) * BRICK_VOLUME) + VoxelIndexing::GetBrickLocalIndex(x, y, z);
+		}
+
+		inline size_t GetIndex(const glm::ivec3& p) const noexcept
+		{
+			return GetIndex(p.x, p.y, p.z);
+		}
+
+		inline size_t GetVolume() const noexcept
+		{
+			return (size_t)m_Dimensions.x * m_Dimensions.y * m_Dimensions.z;
+		}
+
+		inline const glm::ivec3& GetDimensions() const noexcept { return m_Dimensions; }
+
+	private :
+
+		glm::ivec3 m_Dimensions = glm::ivec3(0);
+		int m_BricksX = 0;
+		int m_BricksXY = 0;
+	};
+}
@@ -0,0 +1,378 @@
+#include "VoxelLOD.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ParallelFor.h"
+
+// Merges 8 cells into their parent : the block with the most solid voxels across them (the first one on a tie)
+static inline void MergeCells(const uint16_t* blocks, const uint16_t* counts, uint16_t& block, uint16_t& count)
+{
+	int Best = 0;
+	int BestCount = 0;
+	int Total = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		Total += counts[i];
+
+		if (counts[i] == 0 || blocks[i] == Best)
+		{
+			continue;
+		}
+
+		int Sum = counts[i];
+
+		for (int j = i + 1; j < 8; j++)
+		{
+			Sum += blocks[j] == blocks[i] ? counts[j] : 0;
+		}
+
+		if (Sum > BestCount)
+		{
+			Best = blocks[i];
+			BestCount = Sum;
+		}
+	}
+
+	block = (uint16_t)Best;
+	count = (uint16_t)Total;
+}
+
+void VoxelRT::VoxelLOD::Resize(const glm::ivec3& dimensions)
+{
+	m_Chunks = dimensions / CHUNK_SIZE;
+
+	for (int i = 0; i < LEVEL_COUNT; i++)
+	{
+		Level& L = m_Levels[i];
+		L.Dimensions = dimensions >> (i + 1);
+
+		const size_t Cells = (size_t)L.Dimensions.x * L.Dimensions.y * L.Dimensions.z;
+		L.Blocks.assign(Cells, 0);
+		L.SolidCounts.assign(Cells, 0);
+	}
+
+	m_Valid = false;
+}
+
+void VoxelRT::VoxelLOD::Generate(const WorldData& data, int thread_count)
+{
+	if (thread_count <= 0)
+	{
+		thread_count = DistanceField::GetDefaultThreadCount();
+	}
+
+	ParallelFor(m_Chunks.z, thread_count, [&](int z_begin, int z_end)
+	{
+		for (int z = z_begin; z < z_end; z++)
+		{
+			for (int y = 0; y < m_Chunks.y; y++)
+			{
+				for (int x = 0; x < m_Chunks.x; x++)
+				{
+					BuildChunk(data, x, y, z);
+				}
+			}
+		}
+	});
+
+	m_Valid = true;
+}
+
+void VoxelRT::VoxelLOD::Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions)
+{
+	updated_regions.clear();
+
+	// The boxes can overlap, every chunk is only rebuilt once
+	std::vector<int> Chunks;
+
+	for (const DirtyBox& edit : edits)
+	{
+		const glm::ivec3 Min = glm::max(edit.Min, glm::ivec3(0)) / CHUNK_SIZE;
+		const glm::ivec3 Max = (glm::min(edit.Max, m_Chunks * CHUNK_SIZE) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		if (glm::any(glm::greaterThanEqual(Min, Max)))
+		{
+			continue;
+		}
+
+		for (int z = Min.z; z < Max.z; z++)
+		{
+			for (int y = Min.y; y < Max.y; y++)
+			{
+				for (int x = Min.x; x < Max.x; x++)
+				{
+					Chunks.push_back(x + y * m_Chunks.x + z * m_Chunks.x * m_Chunks.y);
+				}
+			}
+		}
+
+		updated_regions.push_back({ Min * CHUNK_SIZE, Max * CHUNK_SIZE });
+	}
+
+	std::sort(Chunks.begin(), Chunks.end());
+	Chunks.erase(std::unique(Chunks.begin(), Chunks.end()), Chunks.end());
+
+	for (int idx : Chunks)
+	{
+		BuildChunk(data, idx % m_Chunks.x, (idx / m_Chunks.x) % m_Chunks.y, idx / (m_Chunks.x * m_Chunks.y));
+	}
+}
+
+void VoxelRT::VoxelLOD::BuildChunk(const WorldData& data, int chunk_x, int chunk_y, int chunk_z)
+{
+	// The cells of each level inside of the chunk, in morton order (the children of cell i are 8i to 8i + 7)
+	uint16_t Blocks1[512], Counts1[512];
+	uint16_t Blocks2[64], Counts2[64];
+	uint16_t Blocks3[8], Counts3[8];
+
+	const glm::ivec3 Origin = glm::ivec3(chunk_x, chunk_y, chunk_z) * CHUNK_SIZE;
+	const VoxelChunk& Chunk = data.GetChunk(Origin.x, Origin.y, Origin.z);
+
+	if (Chunk.IsUniform())
+	{
+		const uint16_t Block = Chunk.GetUniformBlock().block;
+
+		std::fill(Blocks1, Blocks1 + 512, Block);
+		std::fill(Counts1, Counts1 + 512, Block ? 8 : 0);
+		std::fill(Blocks2, Blocks2 + 64, Block);
+		std::fill(Counts2, Counts2 + 64, Block ? 64 : 0);
+		std::fill(Blocks3, Blocks3 + 8, Block);
+		std::fill(Counts3, Counts3 + 8, Block ? 512 : 0);
+	}
+
+	else
+	{
+		const OccupancyMask& Occupancy = data.GetOccupancy();
+		const uint64_t CellMask = Occupancy.GetBrickCellMask(Origin.x, Origin.y, Origin.z);
+
+		for (int Cell = 0; Cell < 64; Cell++)
+		{
+			// One occupancy word per 4^3 cell, one byte of it per 2^3 cell
+			uint64_t Word = 0;
+
+			if ((CellMask >> Cell) & 1)
+			{
+				const glm::ivec3 Local = VoxelIndexing::GetBrickLocalPosition(Cell << 6);
+				Word = Occupancy.GetCellWord(Origin.x + Local.x, Origin.y + Local.y, Origin.z + Local.z);
+			}
+
+			for (int i = 0; i < 8; i++)
+			{
+				const int Index = Cell * 8 + i;
+				const uint32_t Solid = (uint32_t)(Word >> (i * 8)) & 0xFF;
+
+				if (Solid == 0)
+				{
+					Blocks1[Index] = 0;
+					Counts1[Index] = 0;
+					continue;
+				}
+
+				uint16_t Voxels[8], Ones[8];
+
+				for (int v = 0; v < 8; v++)
+				{
+					const bool IsSolid = (Solid >> v) & 1;
+					Voxels[v] = IsSolid ? Chunk.GetBlock(Index * 8 + v).block : 0;
+					Ones[v] = IsSolid ? 1 : 0;
+				}
+
+				MergeCells(Voxels, Ones, Blocks1[Index], Counts1[Index]);
+			}
+		}
+
+		for (int i = 0; i < 64; i++)
+		{
+			MergeCells(Blocks1 + i * 8, Counts1 + i * 8, Blocks2[i], Counts2[i]);
+		}
+
+		for (int i = 0; i < 8; i++)
+		{
+			MergeCells(Blocks2 + i * 8, Counts2 + i * 8, Blocks3[i], Counts3[i]);
+		}
+	}
+
+	const uint16_t* Blocks[LEVEL_COUNT] = { Blocks1, Blocks2, Blocks3 };
+	const uint16_t* Counts[LEVEL_COUNT] = { Counts1, Counts2, Counts3 };
+
+	for (int l = 0; l < LEVEL_COUNT; l++)
+	{
+		Level& L = m_Levels[l];
+		const int Shift = l + 1;
+		const int CellCount = 512 >> (3 * l);
+
+		for (int i = 0; i < CellCount; i++)
+		{
+			const glm::ivec3 Cell = (Origin + VoxelIndexing::GetBrickLocalPosition(i << (3 * Shift))) >> Shift;
+			const size_t Index = (size_t)Cell.x + (size_t)Cell.y * L.Dimensions.x + (size_t)Cell.z * L.Dimensions.x * L.Dimensions.y;
+
+			L.Blocks[Index] = Blocks[l][i];
+			L.SolidCounts[Index] = Counts[l][i];
+		}
+	}
+}
+
+template <typename T>
+static void ReadLevelRegion(const std::vector<uint16_t>& blocks, const glm::ivec3& dimensions, const glm::ivec3& origin, const glm::ivec3& size, T* output)
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			const uint16_t* Row = blocks.data() + (size_t)origin.x + (size_t)(origin.y + y) * dimensions.x + (size_t)(origin.z + z) * dimensions.x * dimensions.y;
+			T* Out = output + (size_t)y * size.x + (size_t)z * size.x * size.y;
+
+			for (int x = 0; x < size.x; x++)
+			{
+				Out[x] = (T)Row[x];
+			}
+		}
+	}
+}
+
+void VoxelRT::VoxelLOD::ReadRegion(int level, const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const
+{
+	const Level& L = m_Levels[level - 1];
+	ReadLevelRegion(L.Blocks, L.Dimensions, origin, size, output);
+}
+
+void VoxelRT::VoxelLOD::ReadRegion(int level, const glm::ivec3& origin, const glm::ivec3& size, uint16_t* output) const
+{
+	const Level& L = m_Levels[level - 1];
+	ReadLevelRegion(L.Blocks, L.Dimensions, origin, size, output);
+}
+
+size_t VoxelRT::VoxelLOD::GetMemoryUsage() const noexcept
+{
+	size_t Total = 0;
+
+	for (const Level& L : m_Levels)
+	{
+		Total += (L.Blocks.capacity() + L.SolidCounts.capacity()) * sizeof(uint16_t);
+	}
+
+	return Total;
+}
+
+glm::vec3 VoxelRT::GetVoxelLODDistances(float lod_distance, float cone_spread)
+{
+	glm::vec3 Distances;
+
+	for (int i = 0; i < VoxelLOD::LEVEL_COUNT; i++)
+	{
+		const float Scale = (float)(1 << i);
+		const float Start = cone_spread > 0.0f ? std::min(lod_distance * Scale, Scale / cone_spread) : lod_distance * Scale;
+		Distances[i] = std::max(Start, Scale * 4.0f);
+	}
+
+	return Distances;
+}
+
+VoxelRT::VoxelLODTrace VoxelRT::TraceVoxelLOD(const WorldData& data, const DistanceField& field, const VoxelLOD& lod, glm::vec3 origin, const glm::vec3& direction,
+	const glm::vec3& lod_distances, int max_steps)
+{
+	VoxelLODTrace Trace;
+
+	const glm::vec3 InitialOrigin = origin;
+	const glm::ivec3& Dimensions = field.GetDimensions();
+	const glm::ivec3 RaySign = glm::ivec3(glm::sign(direction));
+	int Axis = 0;
+
+	while (Trace.Steps < max_steps)
+	{
+		Trace.Steps++;
+
+		const glm::ivec3 Loc = glm::ivec3(glm::floor(origin));
+
+		if (glm::any(glm::lessThan(Loc, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Loc, Dimensions)))
+		{
+			return Trace;
+		}
+
+		const float Dist = field.Get(Loc.x, Loc.y, Loc.z);
+		const int Euclidean = (int)std::floor(Dist == 1.0f ? 1.0f : Dist * 0.57735026918f);
+		const float T = glm::distance(origin, InitialOrigin);
+		const int Level = Euclidean > 0 ? GetVoxelLODLevel(T, lod_distances) : 0;
+
+		if (Level > 0)
+		{
+			// Coarse step : the distance field still skips the empty space, minus the diagonal of a cell (no cell the
+			// skip crosses can have a solid voxel), otherwise the ray goes to the next cell of the level
+			const float CellSize = (float)(1 << Level);
+			const float Skip = (float)Euclidean - 1.0f - CellSize * 1.7320508f;
+
+			if (Skip >= CellSize)
+			{
+				origin += Skip * direction;
+				continue;
+			}
+
+			const glm::ivec3 Cell = Loc >> Level;
+			const uint16_t Block = lod.GetBlock(Level, Cell.x, Cell.y, Cell.z);
+
+			if (Block > 0)
+			{
+				Trace.Position = origin;
+				Trace.Distance = T;
+				Trace.Block = Block;
+				Trace.Level = Level;
+				Trace.Hit = true;
+				return Trace;
+			}
+
+			const glm::vec3 Bound = (glm::vec3(Cell) + glm::vec3(glm::greaterThan(direction, glm::vec3(0.0f)))) * CellSize;
+			const glm::vec3 Factor = (Bound - origin) * (1.0f / direction);
+
+			const int CellAxis = Factor.x < Factor.y && RaySign.x != 0
+				? (Factor.x < Factor.z || RaySign.z == 0 ? 0 : 2)
+				: (Factor.y < Factor.z || RaySign.z == 0 ? 1 : 2);
+
+			if (Skip > Factor[CellAxis])
+			{
+				origin += Skip * direction;
+				continue;
+			}
+
+			Axis = CellAxis;
+			origin += Factor[Axis] * direction;
+			origin[Axis] = Bound[Axis] + RaySign[Axis] * 0.0001f;
+			continue;
+		}
+
+		if (Euclidean == 0)
+		{
+			Trace.Position = origin;
+			Trace.Distance = T;
+			Trace.Block = data.GetBlock(Loc.x, Loc.y, Loc.z).block;
+			Trace.Hit = true;
+			return Trace;
+		}
+
+		if (Euclidean == 1)
+		{
+			glm::ivec3 GridCoords = glm::ivec3(origin);
+			glm::vec3 WithinVoxelCoords = origin - glm::vec3(GridCoords);
+			const glm::vec3 DistanceFactor = (glm::vec3((1 + RaySign) >> 1) - WithinVoxelCoords) * (1.0f / direction);
+
+			Axis = DistanceFactor.x < DistanceFactor.y && RaySign.x != 0
+				? (DistanceFactor.x < DistanceFactor.z || RaySign.z == 0 ? 0 : 2)
+				: (DistanceFactor.y < DistanceFactor.z || RaySign.z == 0 ? 1 : 2);
+
+			GridCoords[Axis] += RaySign[Axis];
+			WithinVoxelCoords += direction * DistanceFactor[Axis];
+			WithinVoxelCoords[Axis] = (float)(1 - ((1 + RaySign) >> 1)[Axis]);
+
+			origin = glm::vec3(GridCoords) + WithinVoxelCoords;
+			origin[Axis] += RaySign[Axis] * 0.0001f;
+		}
+
+		else
+		{
+			origin += (float)(Euclidean - 1) * direction;
+		}
+	}
+
+	return Trace;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+#include "DirtyRegion.h"
+#include "DistanceField.h"
+
+namespace VoxelRT
+{
+	// Downsampled copies of the voxel data for the far field : level 1, 2 and 3 are 2x, 4x and 8x coarser than the world.
+	// A cell is occupied when any voxel inside of it is solid, so tracing a coarse level never misses geometry, it only
+	// makes it up to 2^level - 1 voxels thicker. It stores the block of its 8 children that covers the most solid voxels
+	// (0 if it's empty), which is the most common block of the 2^3 cells but only an estimate of it for the coarser ones.
+	//
+	// Cells never straddle two chunks (8 divides CHUNK_SIZE), each chunk is built on its own from its morton ordered
+	// voxels (every 2^3, 4^3 and 8^3 cell is a contiguous run of them) and edits only rebuild the chunks they touch.
+	// The gpu copy is one texture with a mip per level (mip 0 is level 1), in the format of the dense voxel volume
+	// (R8 or R16, k / BLOCK_ID_SCALE). Shaders have to be compiled with VOXEL_RT_VOXEL_LOD defined to read it (u_VoxelLOD).
+
+	class VoxelLOD
+	{
+	public :
+
+		static constexpr int LEVEL_COUNT = 3;
+
+		// u_VoxelLOD, after the directional distance field
+		static constexpr int TEXTURE_UNIT = 34;
+
+		void Resize(const glm::ivec3& dimensions);
+
+		// Full rebuild, thread_count <= 0 uses every core
+		void Generate(const WorldData& data, int thread_count = 0);
+
+		// Rebuilds the chunks the edit boxes touch, updated_regions gets the chunk aligned boxes (in voxels) that changed
+		void Update(const WorldData& data, const std::vector<DirtyBox>& edits, std::vector<DirtyBox>& updated_regions);
+
+		// Level 1 to LEVEL_COUNT, cell coordinates (voxel >> level)
+		inline uint16_t GetBlock(int level, int x, int y, int z) const noexcept
+		{
+			const Level& L = m_Levels[level - 1];
+			return L.Blocks[(size_t)x + (size_t)y * L.Dimensions.x + (size_t)z * L.Dimensions.x * L.Dimensions.y];
+		}
+
+		// Number of solid voxels in the cell
+		inline int GetSolidCount(int level, int x, int y, int z) const noexcept
+		{
+			const Level& L = m_Levels[level - 1];
+			return L.SolidCounts[(size_t)x + (size_t)y * L.Dimensions.x + (size_t)z * L.Dimensions.x * L.Dimensions.y];
+		}
+
+		inline const glm::ivec3& GetLevelDimensions(int level) const noexcept { return m_Levels[level - 1].Dimensions; }
+
+		// Copies a box of cells of a level to a linear buffer, in the format of the gpu copy (ids above 255 are truncated
+		// by the 8 bit version)
+		void ReadRegion(int level, const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const;
+		void ReadRegion(int level, const glm::ivec3& origin, const glm::ivec3& size, uint16_t* output) const;
+
+		inline bool IsValid() const noexcept { return m_Valid; }
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		struct Level
+		{
+			glm::ivec3 Dimensions = glm::ivec3(0);
+			std::vector<uint16_t> Blocks;
+			std::vector<uint16_t> SolidCounts;
+		};
+
+		// Rebuilds the cells of every level inside of the chunk
+		void BuildChunk(const WorldData& data, int chunk_x, int chunk_y, int chunk_z);
+
+		std::array<Level, LEVEL_COUNT> m_Levels;
+		glm::ivec3 m_Chunks = glm::ivec3(0);
+		bool m_Valid = false;
+	};
+
+	// Distance from the ray origin at which level 1, 2 and 3 start (u_LODDistances in the trace shaders)
+	// Level n starts at lod_distance * 2^(n - 1), or once the ray cone (cone_spread * t, in 2 voxel units) is 2^n voxels
+	// wide. A level is never used before the ray is two of its cells away from the origin, so that the coarse cell
+	// around the surface the ray leaves can't stop it.
+	glm::vec3 GetVoxelLODDistances(float lod_distance, float cone_spread);
+
+	inline int GetVoxelLODLevel(float t, const glm::vec3& distances) noexcept
+	{
+		return (int)(t >= distances.x) + (int)(t >= distances.y) + (int)(t >= distances.z);
+	}
+
+	struct VoxelLODTrace
+	{
+		glm::vec3 Position = glm::vec3(0.0f); // Where the ray stopped
+		float Distance = -1.0f;
+		uint16_t Block = 0;
+		int Level = 0; // Level of the hit, 0 for a full resolution hit
+		int Steps = 0; // Iterations of the traversal loop
+		bool Hit = false;
+	};
+
+	// Cpu reference of the distance field traversal with the coarse levels (VoxelTraversalDF + VoxelStepLOD in the
+	// trace shaders), it takes the same steps
+	VoxelLODTrace TraceVoxelLOD(const WorldData& data, const DistanceField& field, const VoxelLOD& lod, glm::vec3 origin, const glm::vec3& direction,
+		const glm::vec3& lod_distances, int max_steps);
+}
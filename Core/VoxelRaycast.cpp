@@ -0,0 +1,142 @@
+#include "VoxelRaycast.h"
+
+#include <algorithm>
+#include <limits>
+
+bool VoxelRT::CastVoxelRay(const WorldData& data, const glm::vec3& origin, const glm::vec3& direction, float max_distance, VoxelRayHit& hit)
+{
+	const float Length = glm::length(direction);
+
+	if (!(Length > 0.0f))
+	{
+		return false;
+	}
+
+	const glm::vec3 Direction = direction / Length;
+	const glm::ivec3& Dimensions = data.GetDimensions();
+	const OccupancyMask& Occupancy = data.GetOccupancy();
+	const float Infinity = std::numeric_limits<float>::infinity();
+
+	glm::vec3 InverseDirection;
+	glm::ivec3 Step;
+
+	for (int i = 0; i < 3; i++)
+	{
+		Step[i] = Direction[i] > 0.0f ? 1 : (Direction[i] < 0.0f ? -1 : 0);
+		InverseDirection[i] = Step[i] != 0 ? 1.0f / Direction[i] : Infinity;
+	}
+
+	// Clip the ray to the world
+	float TMin = 0.0f;
+	float TMax = max_distance;
+	int EntryAxis = -1;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (Step[i] == 0)
+		{
+			if (origin[i] < 0.0f || origin[i] >= (float)Dimensions[i])
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		float t0 = (0.0f - origin[i]) * InverseDirection[i];
+		float t1 = ((float)Dimensions[i] - origin[i]) * InverseDirection[i];
+
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+
+		if (t0 > TMin)
+		{
+			TMin = t0;
+			EntryAxis = i;
+		}
+
+		TMax = std::min(TMax, t1);
+	}
+
+	if (TMin > TMax)
+	{
+		return false;
+	}
+
+	const glm::ivec3 LastVoxel = Dimensions - glm::ivec3(1);
+	glm::ivec3 Voxel = glm::clamp(glm::ivec3(glm::floor(origin + Direction * TMin)), glm::ivec3(0), LastVoxel);
+	glm::ivec3 Normal = glm::ivec3(0);
+	float t = TMin;
+
+	if (EntryAxis >= 0)
+	{
+		Voxel[EntryAxis] = Step[EntryAxis] > 0 ? 0 : LastVoxel[EntryAxis];
+		Normal[EntryAxis] = -Step[EntryAxis];
+	}
+
+	while (true)
+	{
+		// Size of the largest empty node that contains the voxel
+		int Size = 0;
+
+		if (Occupancy.IsRegionEmpty(Voxel.x, Voxel.y, Voxel.z)) { Size = 64; }
+		else if (Occupancy.IsBrickEmpty(Voxel.x, Voxel.y, Voxel.z)) { Size = 16; }
+		else if (Occupancy.IsCellEmpty(Voxel.x, Voxel.y, Voxel.z)) { Size = 4; }
+		else if (!Occupancy.IsSolid(Voxel.x, Voxel.y, Voxel.z)) { Size = 1; }
+
+		else
+		{
+			hit.Position = Voxel;
+			hit.Normal = Normal;
+			hit.Block = data.GetBlock(Voxel.x, Voxel.y, Voxel.z).block;
+			hit.Distance = t;
+			return true;
+		}
+
+		// Step out of the node
+		const glm::ivec3 Base = Voxel & glm::ivec3(~(Size - 1));
+		float TExit = Infinity;
+		int Axis = 0;
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (Step[i] == 0)
+			{
+				continue;
+			}
+
+			const float Boundary = (float)(Step[i] > 0 ? Base[i] + Size : Base[i]);
+			const float TBoundary = (Boundary - origin[i]) * InverseDirection[i];
+
+			if (TBoundary < TExit)
+			{
+				TExit = TBoundary;
+				Axis = i;
+			}
+		}
+
+		if (TExit > TMax)
+		{
+			return false;
+		}
+
+		t = std::max(t, TExit);
+
+		// The position is only used for the axes that didn't cross the boundary, and clamped to the node so that
+		// rounding can't make the ray skip a node
+		glm::ivec3 Next = glm::ivec3(glm::floor(origin + Direction * t));
+		Next = glm::clamp(Next, Base, glm::min(Base + glm::ivec3(Size - 1), LastVoxel));
+		Next[Axis] = Step[Axis] > 0 ? Base[Axis] + Size : Base[Axis] - 1;
+
+		if (Next[Axis] < 0 || Next[Axis] > LastVoxel[Axis])
+		{
+			return false;
+		}
+
+		Voxel = Next;
+		Normal = glm::ivec3(0);
+		Normal[Axis] = -Step[Axis];
+	}
+}
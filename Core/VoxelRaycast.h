@@ -0,0 +1,22 @@
+#pragma once
+
+#include <iostream>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+
+namespace VoxelRT
+{
+	struct VoxelRayHit
+	{
+		glm::ivec3 Position = glm::ivec3(-1); // The solid voxel that was hit
+		glm::ivec3 Normal = glm::ivec3(0); // Face that was entered (zero if the ray started inside of the voxel)
+		uint16_t Block = 0;
+		float Distance = 0.0f; // Along the (normalized) ray
+	};
+
+	// Traces a ray through the 64-tree of the occupancy mask : the ray skips entire 64^3 regions, 16^3 bricks and 4^3
+	// cells when they're empty and only walks single voxels inside of non empty cells.
+	// direction doesn't have to be normalized. Returns false if nothing was hit within max_distance.
+	bool CastVoxelRay(const WorldData& data, const glm::vec3& origin, const glm::vec3& direction, float max_distance, VoxelRayHit& hit);
+}
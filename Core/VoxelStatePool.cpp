@@ -0,0 +1,226 @@
+#include "VoxelStatePool.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool VoxelRT::VoxelStatePool::GatherBrick(const VoxelStateTable& states, const glm::ivec3& brick, uint8_t* voxels) const
+{
+	const glm::ivec3 Origin = brick * BRICK_SIZE;
+	const std::vector<uint32_t>* Entries = states.GetChunkEntries(states.GetChunkIndex(Origin.x, Origin.y, Origin.z));
+
+	if (!Entries)
+	{
+		return false;
+	}
+
+	// The top 3 bits of a 16^3 morton index select the 8^3 sub brick, its entries are contiguous
+	const uint32_t Octant = (uint32_t)((brick.x & 1) | ((brick.y & 1) << 1) | ((brick.z & 1) << 2));
+	auto First = std::lower_bound(Entries->begin(), Entries->end(), Octant << 17);
+	auto Last = std::lower_bound(First, Entries->end(), (Octant + 1) << 17);
+
+	if (First == Last)
+	{
+		return false;
+	}
+
+	std::memset(voxels, 0, BRICK_VOLUME);
+
+	for (auto Entry = First; Entry != Last; ++Entry)
+	{
+		const glm::ivec3 Local = VoxelIndexing::GetBrickLocalPosition(VoxelStateTable::GetEntryIndex(*Entry)) & (BRICK_SIZE - 1);
+		voxels[Local.x + Local.y * BRICK_SIZE + Local.z * BRICK_SIZE * BRICK_SIZE] = VoxelStateTable::GetEntryState(*Entry);
+	}
+
+	return true;
+}
+
+void VoxelRT::VoxelStatePool::Build(const WorldData& data)
+{
+	const VoxelStateTable& States = data.GetStates();
+
+	m_Bricks = data.GetDimensions() >> BRICK_SHIFT;
+	m_Indirection.assign((size_t)m_Bricks.x * m_Bricks.y * m_Bricks.z, 0);
+	m_StoredBricks = 0;
+
+	// States of the stored bricks in slot order
+	std::vector<uint8_t> Stored;
+
+	for (int z = 0; z < m_Bricks.z; z++)
+	{
+		for (int y = 0; y < m_Bricks.y; y++)
+		{
+			for (int x = 0; x < m_Bricks.x; x++)
+			{
+				uint8_t Voxels[BRICK_VOLUME];
+
+				if (GatherBrick(States, glm::ivec3(x, y, z), Voxels))
+				{
+					m_Indirection[GetIndirectionIndex(x, y, z)] = BrickPool::EncodeSlot((uint32_t)m_StoredBricks);
+					Stored.insert(Stored.end(), Voxels, Voxels + BRICK_VOLUME);
+					m_StoredBricks++;
+				}
+			}
+		}
+	}
+
+	// Same headroom as the brick pool, the atlas is rebuilt if it fills up
+	GLint MaxTextureSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &MaxTextureSize);
+
+	const int MaxLayers = std::min(MaxTextureSize / BRICK_SIZE, 1024);
+	const int Capacity = std::min(GetBrickCount(), m_StoredBricks + m_StoredBricks / 4 + BrickPool::ATLAS_LAYER_BRICKS);
+	m_AtlasLayers = std::max((Capacity + BrickPool::ATLAS_LAYER_BRICKS - 1) / BrickPool::ATLAS_LAYER_BRICKS, 1);
+
+	if (m_AtlasLayers > MaxLayers)
+	{
+		throw "Voxel state atlas doesn't fit in a 3D texture!";
+	}
+
+	m_FreeSlots.clear();
+
+	for (int i = GetAtlasCapacity() - 1; i >= m_StoredBricks; i--)
+	{
+		m_FreeSlots.push_back((uint32_t)i);
+	}
+
+	m_IndirectionTexture.CreateTexture(m_Bricks.x, m_Bricks.y, m_Bricks.z, m_Indirection.data(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+	m_AtlasTexture.CreateTexture(BrickPool::ATLAS_BRICKS_X * BRICK_SIZE, BrickPool::ATLAS_BRICKS_Y * BRICK_SIZE, m_AtlasLayers * BRICK_SIZE, nullptr,
+		GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE);
+
+	// Upload one layer of bricks at a time
+	const glm::ivec3 LayerSize = glm::ivec3(BrickPool::ATLAS_BRICKS_X, BrickPool::ATLAS_BRICKS_Y, 1) * BRICK_SIZE;
+	std::vector<uint8_t> Layer((size_t)LayerSize.x * LayerSize.y * LayerSize.z);
+
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int FirstSlot = 0; FirstSlot < m_StoredBricks; FirstSlot += BrickPool::ATLAS_LAYER_BRICKS)
+	{
+		std::fill(Layer.begin(), Layer.end(), 0);
+
+		for (int Slot = FirstSlot; Slot < std::min(FirstSlot + BrickPool::ATLAS_LAYER_BRICKS, m_StoredBricks); Slot++)
+		{
+			const glm::ivec3 Origin = BrickPool::GetSlotCoord((uint32_t)Slot) * BRICK_SIZE;
+			const uint8_t* Voxels = &Stored[(size_t)Slot * BRICK_VOLUME];
+
+			for (int z = 0; z < BRICK_SIZE; z++)
+			{
+				for (int y = 0; y < BRICK_SIZE; y++)
+				{
+					const size_t Row = (size_t)Origin.x + (size_t)(Origin.y + y) * LayerSize.x + (size_t)z * LayerSize.x * LayerSize.y;
+					std::memcpy(&Layer[Row], Voxels + (y + z * BRICK_SIZE) * BRICK_SIZE, BRICK_SIZE);
+				}
+			}
+		}
+
+		const int LayerZ = (FirstSlot / BrickPool::ATLAS_LAYER_BRICKS) * BRICK_SIZE;
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, LayerZ, LayerSize.x, LayerSize.y, LayerSize.z, GL_RED_INTEGER, GL_UNSIGNED_BYTE, Layer.data());
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::VoxelStatePool::Update(const WorldData& data, const std::vector<DirtyBox>& boxes)
+{
+	const VoxelStateTable& States = data.GetStates();
+
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (const DirtyBox& box : boxes)
+	{
+		const glm::ivec3 Min = box.Min >> BRICK_SHIFT;
+		const glm::ivec3 Max = ((box.Max - 1) >> BRICK_SHIFT) + 1;
+		bool Changed = false;
+
+		for (int z = Min.z; z < Max.z; z++)
+		{
+			for (int y = Min.y; y < Max.y; y++)
+			{
+				for (int x = Min.x; x < Max.x; x++)
+				{
+					uint32_t& Entry = m_Indirection[GetIndirectionIndex(x, y, z)];
+					uint8_t Voxels[BRICK_VOLUME];
+
+					if (!GatherBrick(States, glm::ivec3(x, y, z), Voxels))
+					{
+						if (Entry != 0)
+						{
+							m_FreeSlots.push_back(BrickPool::DecodeSlot(Entry));
+							m_StoredBricks--;
+							Entry = 0;
+							Changed = true;
+						}
+
+						continue;
+					}
+
+					if (Entry == 0)
+					{
+						if (m_FreeSlots.empty())
+						{
+							// Out of space, rebuilding gathers (and uploads) every brick so there's nothing left to do
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+							glBindTexture(GL_TEXTURE_3D, 0);
+							Build(data);
+							return;
+						}
+
+						Entry = BrickPool::EncodeSlot(m_FreeSlots.back());
+						m_FreeSlots.pop_back();
+						m_StoredBricks++;
+						Changed = true;
+					}
+
+					const glm::ivec3 Origin = BrickPool::GetSlotCoord(BrickPool::DecodeSlot(Entry)) * BRICK_SIZE;
+					glTexSubImage3D(GL_TEXTURE_3D, 0, Origin.x, Origin.y, Origin.z, BRICK_SIZE, BRICK_SIZE, BRICK_SIZE, GL_RED_INTEGER, GL_UNSIGNED_BYTE, Voxels);
+				}
+			}
+		}
+
+		if (Changed)
+		{
+			UploadIndirection(Min, Max);
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::VoxelStatePool::UploadIndirection(const glm::ivec3& min, const glm::ivec3& max)
+{
+	const glm::ivec3 Size = max - min;
+	m_UploadBuffer.resize((size_t)Size.x * Size.y * Size.z);
+
+	size_t i = 0;
+
+	for (int z = min.z; z < max.z; z++)
+	{
+		for (int y = min.y; y < max.y; y++)
+		{
+			const uint32_t* Row = &m_Indirection[GetIndirectionIndex(min.x, y, z)];
+			std::copy(Row, Row + Size.x, &m_UploadBuffer[i]);
+			i += Size.x;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_IndirectionTexture.GetTextureID());
+	glTexSubImage3D(GL_TEXTURE_3D, 0, min.x, min.y, min.z, Size.x, Size.y, Size.z, GL_RED_INTEGER, GL_UNSIGNED_INT, m_UploadBuffer.data());
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+}
+
+void VoxelRT::VoxelStatePool::Bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + ATLAS_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_3D, m_AtlasTexture.GetTextureID());
+
+	glActiveTexture(GL_TEXTURE0 + INDIRECTION_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_3D, m_IndirectionTexture.GetTextureID());
+}
+
+size_t VoxelRT::VoxelStatePool::GetVideoMemoryUsage() const noexcept
+{
+	return m_Indirection.size() * sizeof(uint32_t) + (size_t)GetAtlasCapacity() * BRICK_VOLUME;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+#include "DirtyRegion.h"
+#include "BrickPool.h"
+#include "Texture3D.h"
+
+namespace VoxelRT
+{
+	// Gpu copy of the voxel states (see VoxelStates.h), no shader reads it yet. A voxel's state takes two fetches
+	// Same layout as the brick pool : one R32UI indirection texel per 8^3 brick, 0 if none of the voxels of the brick
+	// have a state, otherwise the atlas coordinate of the brick (BrickPool::EncodeSlot()) in an R8UI atlas of 8^3 bricks.
+	// Only bricks that contain stateful voxels take space in the atlas.
+
+	class VoxelStatePool
+	{
+	public :
+
+		static constexpr int BRICK_SIZE = BrickPool::BRICK_SIZE;
+		static constexpr int BRICK_SHIFT = BrickPool::BRICK_SHIFT;
+		static constexpr int BRICK_VOLUME = BrickPool::BRICK_VOLUME;
+
+		// Where World::BindVoxelData() binds the indirection and the atlas
+		static constexpr int INDIRECTION_TEXTURE_UNIT = 28;
+		static constexpr int ATLAS_TEXTURE_UNIT = 29;
+
+		// (Re)creates both textures from the states of the world
+		void Build(const WorldData& data);
+
+		// Regathers and reuploads the bricks the boxes touch
+		void Update(const WorldData& data, const std::vector<DirtyBox>& boxes);
+
+		// Binds the indirection to INDIRECTION_TEXTURE_UNIT and the atlas to ATLAS_TEXTURE_UNIT
+		void Bind() const;
+
+		inline int GetBrickCount() const noexcept { return (int)m_Indirection.size(); }
+		inline int GetStoredBrickCount() const noexcept { return m_StoredBricks; }
+		inline int GetAtlasCapacity() const noexcept { return m_AtlasLayers * BrickPool::ATLAS_LAYER_BRICKS; }
+
+		// Indirection + atlas
+		size_t GetVideoMemoryUsage() const noexcept;
+
+	private :
+
+		// Writes the states of the brick (x + y * 8 + z * 64) and returns true, returns false if none of its voxels have a state
+		bool GatherBrick(const VoxelStateTable& states, const glm::ivec3& brick, uint8_t* voxels) const;
+
+		inline size_t GetIndirectionIndex(int x, int y, int z) const noexcept
+		{
+			return (size_t)x + (size_t)y * m_Bricks.x + (size_t)z * m_Bricks.x * m_Bricks.y;
+		}
+
+		void UploadIndirection(const glm::ivec3& min, const glm::ivec3& max);
+
+		glm::ivec3 m_Bricks = glm::ivec3(0);
+		std::vector<uint32_t> m_Indirection;
+		std::vector<uint32_t> m_FreeSlots;
+		std::vector<uint32_t> m_UploadBuffer;
+
+		int m_AtlasLayers = 0;
+		int m_StoredBricks = 0;
+
+		Texture3D m_IndirectionTexture;
+		Texture3D m_AtlasTexture;
+	};
+}
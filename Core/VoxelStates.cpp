@@ -0,0 +1,159 @@
+#include "VoxelStates.h"
+
+void VoxelRT::VoxelStateTable::Resize(const glm::ivec3& dimensions)
+{
+	m_ChunksX = dimensions.x >> BRICK_SHIFT;
+	m_ChunksY = dimensions.y >> BRICK_SHIFT;
+	m_ChunksZ = dimensions.z >> BRICK_SHIFT;
+	Clear();
+}
+
+void VoxelRT::VoxelStateTable::Clear()
+{
+	m_Chunks.clear();
+	m_Count = 0;
+}
+
+VoxelRT::BlockState VoxelRT::VoxelStateTable::Get(int x, int y, int z) const
+{
+	if (m_Count == 0)
+	{
+		return 0;
+	}
+
+	auto Chunk = m_Chunks.find(GetChunkIndex(x, y, z));
+
+	if (Chunk == m_Chunks.end())
+	{
+		return 0;
+	}
+
+	return FindState(Chunk->second, VoxelIndexing::GetBrickLocalIndex(x, y, z));
+}
+
+void VoxelRT::VoxelStateTable::Set(int x, int y, int z, BlockState state)
+{
+	const int ChunkIndex = GetChunkIndex(x, y, z);
+	auto Chunk = m_Chunks.find(ChunkIndex);
+
+	if (Chunk == m_Chunks.end())
+	{
+		if (state == 0)
+		{
+			return;
+		}
+
+		Chunk = m_Chunks.emplace(ChunkIndex, std::vector<uint32_t>()).first;
+	}
+
+	const uint32_t Key = (uint32_t)VoxelIndexing::GetBrickLocalIndex(x, y, z) << 8;
+	std::vector<uint32_t>& Entries = Chunk->second;
+	auto Entry = std::lower_bound(Entries.begin(), Entries.end(), Key);
+	const bool Exists = Entry != Entries.end() && (*Entry & ~0xFFu) == Key;
+
+	if (state == 0)
+	{
+		if (Exists)
+		{
+			Entries.erase(Entry);
+			m_Count--;
+
+			if (Entries.empty())
+			{
+				m_Chunks.erase(Chunk);
+			}
+		}
+
+		return;
+	}
+
+	if (Exists)
+	{
+		*Entry = Key | state;
+		return;
+	}
+
+	Entries.insert(Entry, Key | state);
+	m_Count++;
+}
+
+void VoxelRT::VoxelStateTable::FillChunk(int chunk, BlockState state)
+{
+	auto Chunk = m_Chunks.find(chunk);
+
+	if (Chunk != m_Chunks.end())
+	{
+		m_Count -= Chunk->second.size();
+		m_Chunks.erase(Chunk);
+	}
+
+	if (state == 0)
+	{
+		return;
+	}
+
+	std::vector<uint32_t>& Entries = m_Chunks[chunk];
+	Entries.resize(BRICK_VOLUME);
+
+	for (int i = 0; i < BRICK_VOLUME; i++)
+	{
+		Entries[i] = ((uint32_t)i << 8) | state;
+	}
+
+	m_Count += BRICK_VOLUME;
+}
+
+void VoxelRT::VoxelStateTable::SetChunkEntries(int chunk, std::vector<uint32_t> entries)
+{
+	FillChunk(chunk, 0);
+
+	if (entries.empty())
+	{
+		return;
+	}
+
+	m_Count += entries.size();
+	m_Chunks[chunk] = std::move(entries);
+}
+
+void VoxelRT::VoxelStateTable::ShiftChunks(const glm::ivec3& delta)
+{
+	const glm::ivec3 Chunks = glm::ivec3(m_ChunksX, m_ChunksY, m_ChunksZ);
+	std::unordered_map<int, std::vector<uint32_t>> Shifted;
+	size_t Count = 0;
+
+	for (auto& e : m_Chunks)
+	{
+		const glm::ivec3 p = glm::ivec3(e.first % m_ChunksX, (e.first / m_ChunksX) % m_ChunksY, e.first / (m_ChunksX * m_ChunksY)) - delta;
+
+		if (glm::any(glm::lessThan(p, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(p, Chunks)))
+		{
+			continue;
+		}
+
+		Count += e.second.size();
+		Shifted.emplace(p.x + p.y * m_ChunksX + p.z * m_ChunksX * m_ChunksY, std::move(e.second));
+	}
+
+	m_Chunks = std::move(Shifted);
+	m_Count = Count;
+}
+
+const std::vector<uint32_t>* VoxelRT::VoxelStateTable::GetChunkEntries(int chunk) const
+{
+	auto Chunk = m_Chunks.find(chunk);
+	return Chunk == m_Chunks.end() ? nullptr : &Chunk->second;
+}
+
+size_t VoxelRT::VoxelStateTable::GetMemoryUsage() const noexcept
+{
+	// Map node : key, list and the next pointer (+ the bucket array)
+	size_t Total = sizeof(VoxelStateTable) + m_Chunks.bucket_count() * sizeof(void*);
+
+	for (auto& e : m_Chunks)
+	{
+		Total += sizeof(void*) + sizeof(int) + sizeof(std::vector<uint32_t>) + e.second.capacity() * sizeof(uint32_t);
+	}
+
+	return Total;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "VoxelIndexing.h"
+
+namespace VoxelRT
+{
+	// Per voxel block state (orientation, facing, half, variant...), 0 -> no state
+	// What the bits mean is up to the block, the minecraft importer stores the data value of the voxel as is
+	typedef uint8_t BlockState;
+
+	// Sparse per voxel state storage
+	// Only the 16^3 chunks (same grid as WorldData) that contain stateful voxels have an entry, which is a list of
+	// (morton index << 8 | state) sorted by morton index. Stateless voxels and chunks don't cost anything.
+	// Morton order keeps every aligned 8^3 sub brick contiguous in the list, which is what the gpu copy (VoxelStatePool) is made of.
+	class VoxelStateTable
+	{
+	public :
+
+		void Resize(const glm::ivec3& dimensions);
+		void Clear();
+
+		BlockState Get(int x, int y, int z) const;
+
+		// A state of 0 removes the entry
+		void Set(int x, int y, int z, BlockState state);
+
+		// Gives every voxel of a chunk the same state (0 removes all of its entries)
+		void FillChunk(int chunk, BlockState state);
+
+		// Replaces the entries of a chunk with a sorted list (empty removes them)
+		void SetChunkEntries(int chunk, std::vector<uint32_t> entries);
+
+		// Moves every chunk by -delta chunks (chunk p takes the entries of chunk p + delta), the states of the chunks
+		// that end up outside of the volume are dropped
+		void ShiftChunks(const glm::ivec3& delta);
+
+		inline bool IsEmpty() const noexcept { return m_Count == 0; }
+		inline size_t GetCount() const noexcept { return m_Count; }
+		inline size_t GetChunkCount() const noexcept { return m_Chunks.size(); }
+
+		inline int GetChunkIndex(int x, int y, int z) const noexcept
+		{
+			return (x >> BRICK_SHIFT) + (y >> BRICK_SHIFT) * m_ChunksX + (z >> BRICK_SHIFT) * m_ChunksX * m_ChunksY;
+		}
+
+		// Sorted entries of a chunk, nullptr if none of its voxels have a state
+		const std::vector<uint32_t>* GetChunkEntries(int chunk) const;
+
+		// State of the voxel (morton index inside of its chunk) in a sorted list of entries, 0 if it isn't in the list
+		static inline BlockState FindState(const std::vector<uint32_t>& entries, int morton) noexcept
+		{
+			const uint32_t Key = (uint32_t)morton << 8;
+			auto Entry = std::lower_bound(entries.begin(), entries.end(), Key);
+			return (Entry == entries.end() || (*Entry & ~0xFFu) != Key) ? 0 : GetEntryState(*Entry);
+		}
+
+		static inline int GetEntryIndex(uint32_t entry) noexcept { return (int)(entry >> 8); }
+		static inline BlockState GetEntryState(uint32_t entry) noexcept { return (BlockState)(entry & 0xFFu); }
+
+		// Calls f(position, state) for every stateful voxel, chunk by chunk
+		template <typename F>
+		void ForEach(F&& f) const
+		{
+			std::vector<int> Chunks;
+			Chunks.reserve(m_Chunks.size());
+
+			for (auto& e : m_Chunks)
+			{
+				Chunks.push_back(e.first);
+			}
+
+			std::sort(Chunks.begin(), Chunks.end());
+
+			for (int Chunk : Chunks)
+			{
+				const glm::ivec3 Origin = glm::ivec3(Chunk % m_ChunksX, (Chunk / m_ChunksX) % m_ChunksY, Chunk / (m_ChunksX * m_ChunksY)) * BRICK_SIZE;
+
+				for (uint32_t Entry : m_Chunks.at(Chunk))
+				{
+					f(Origin + VoxelIndexing::GetBrickLocalPosition(GetEntryIndex(Entry)), GetEntryState(Entry));
+				}
+			}
+		}
+
+		// Entries, lists and map nodes, in bytes (approximate for the map)
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		std::unordered_map<int, std::vector<uint32_t>> m_Chunks;
+		size_t m_Count = 0;
+		int m_ChunksX = 0;
+		int m_ChunksY = 0;
+		int m_ChunksZ = 0;
+	};
+}
@@ -1,7 +1,37 @@
 #include "World.h"
 
+#include <numeric>
+#include <functional>
+#include <tuple>
+
 #include "VolumetricFloodFill.h"
 #include "BlockDatabase.h"
+#include "LazyWorldLoader.h"
+
+void VoxelRT::World::Resize(const glm::ivec3& dimensions)
+{
+	m_WorldData.Resize(dimensions);
+	m_DistanceField.Resize(dimensions, m_Streamed ? STREAMED_MAX_DISTANCE : 0);
+
+	// The lights of the chunk summaries are the blocks with an emissive texture
+	std::vector<uint16_t> EmissiveBlocks;
+
+	for (int i = 1; i < BlockDatabase::GetBlockDataTableSize(); i++)
+	{
+		if (BlockDatabase::GetBlockEmissiveTexture((BlockDatabase::BlockIDType)i) >= 0)
+		{
+			EmissiveBlocks.push_back((uint16_t)i);
+		}
+	}
+
+	m_WorldData.SetEmissiveBlocks(EmissiveBlocks);
+	m_LightChunkGridSize = dimensions / 16;
+	LightChunkOffsets.assign(m_LightChunkGridSize.x * m_LightChunkGridSize.y * m_LightChunkGridSize.z, glm::ivec2(-1));
+	LightChunkData.clear();
+	m_Journal.Clear();
+	m_Journal.CloseLog();
+	m_FileLayout.Clear();
+}
 
 void VoxelRT::World::InitializeLightList()
 {
@@ -17,7 +47,7 @@ void VoxelRT::World::InitializeLightList()
 
 	glGenBuffers(1, &LightChunkOffsetSSBO);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, LightChunkOffsetSSBO);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(GLuint) * (24 * 8 * 24), nullptr, GL_DYNAMIC_DRAW);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::ivec2) * LightChunkOffsets.size(), nullptr, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
@@ -43,7 +73,609 @@ void VoxelRT::World::RebufferLightChunks()
 	}
 }
 
+void VoxelRT::World::UpdateLightList(const std::vector<DirtyBox>& boxes)
+{
+	auto InBoxes = [&boxes](const glm::ivec3& p)
+	{
+		for (const DirtyBox& box : boxes)
+		{
+			if (glm::all(glm::greaterThanEqual(p, box.Min)) && glm::all(glm::lessThan(p, box.Max)))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	// (chunk, light) pairs, the lights outside of the boxes are kept as is
+	std::vector<std::pair<int, glm::ivec3>> Lights;
+
+	for (int Chunk = 0; Chunk < (int)LightChunkOffsets.size(); Chunk++)
+	{
+		const glm::ivec2& Offset = LightChunkOffsets[Chunk];
+
+		for (int i = glm::max(Offset.x, 0); i < Offset.x + Offset.y && i < (int)LightChunkData.size(); i++)
+		{
+			const glm::ivec3 Light = glm::ivec3(LightChunkData[i]);
+
+			if (!InBoxes(Light))
+			{
+				Lights.push_back({ Chunk, Light });
+			}
+		}
+	}
+
+	// The emissive blocks in the boxes come from the chunk summaries
+	std::vector<glm::ivec3> BoxLights;
+
+	for (const DirtyBox& box : boxes)
+	{
+		m_WorldData.GetLights(box.Min, box.Max, BoxLights);
+	}
+
+	for (const glm::ivec3& e : BoxLights)
+	{
+		Lights.push_back({ Get1DIndexForLightChunk(e.x / 16, e.y / 16, e.z / 16), e });
+	}
+
+	RebuildLightList(Lights);
+}
+
+void VoxelRT::World::RebuildLightList(std::vector<std::pair<int, glm::ivec3>>& Lights)
+{
+	// Boxes can overlap
+	auto Less = [](const std::pair<int, glm::ivec3>& a, const std::pair<int, glm::ivec3>& b)
+	{
+		return std::make_tuple(a.first, a.second.x, a.second.y, a.second.z) < std::make_tuple(b.first, b.second.x, b.second.y, b.second.z);
+	};
+
+	std::sort(Lights.begin(), Lights.end(), Less);
+	Lights.erase(std::unique(Lights.begin(), Lights.end()), Lights.end());
+
+	// The shaders treat an offset of 0 as a chunk without lights, so the first entry is never used
+	LightChunkData.assign(1, glm::vec4(0.0f));
+	LightChunkOffsets.assign(LightChunkOffsets.size(), glm::ivec2(-1));
+
+	for (const auto& e : Lights)
+	{
+		glm::ivec2& Offset = LightChunkOffsets[e.first];
+
+		if (Offset.x < 0)
+		{
+			Offset = glm::ivec2((int)LightChunkData.size(), 0);
+		}
+
+		LightChunkData.push_back(glm::vec4(glm::vec3(e.second), 0.0f));
+		Offset.y++;
+	}
+
+	if (LightChunkDataSSBO != 0)
+	{
+		RebufferLightChunks();
+	}
+}
+
+void VoxelRT::World::PublishSnapshot()
+{
+	std::shared_ptr<const WorldSnapshot> Previous = std::atomic_load(&m_Snapshot);
+
+	// Nothing changed, the readers can keep using the current one
+	if (Previous && Previous->IsCurrent(m_WorldData))
+	{
+		return;
+	}
+
+	m_SnapshotEpoch++;
+	std::atomic_store(&m_Snapshot, WorldSnapshot::Create(m_WorldData, Previous.get(), m_SnapshotEpoch));
+}
+
+void VoxelRT::World::SetStreamed(bool streamed)
+{
+	m_Streamed = streamed;
+	m_DistanceField.Resize(GetDimensions(), m_Streamed ? STREAMED_MAX_DISTANCE : 0);
+}
+
+void VoxelRT::World::LoadRegion(const glm::ivec3& min, const glm::ivec3& max)
+{
+	if (m_LazyLoader)
+	{
+		m_LazyLoader->LoadRegion(min, max);
+	}
+}
+
+void VoxelRT::World::SetChunk(int index, VoxelChunk chunk, std::vector<uint32_t> states, bool in_distance_field)
+{
+	m_WorldData.SetChunk(index, std::move(chunk), std::move(states));
+
+	const glm::ivec3 Min = m_WorldData.GetChunkPosition(index);
+
+	if (in_distance_field && m_Buffered)
+	{
+		m_DirtyVoxelsInDistanceField.Add(Min, Min + glm::ivec3(CHUNK_SIZE));
+	}
+
+	else
+	{
+		MarkDirty(Min, Min + glm::ivec3(CHUNK_SIZE));
+	}
+}
+
+void VoxelRT::World::ShiftWindow(const glm::ivec3& delta)
+{
+	if (delta == glm::ivec3(0))
+	{
+		return;
+	}
+
+	if (!m_Streamed || delta.y != 0)
+	{
+		throw "World::ShiftWindow() -> Only a streamed world can move, and only horizontally!";
+	}
+
+	if (m_UseBrickPool || UsesPackedVolume() || UsesDirectionalDistanceField() || UsesVoxelLOD())
+	{
+		throw "World::ShiftWindow() -> The brick pool, the packed volume, the directional distance field and the voxel LOD levels can't be moved!";
+	}
+
+	// Whatever is queued is in the coordinates of the current window
+	FlushEdits();
+	Volumetrics::FlushUploads();
+
+	const glm::ivec3& Dimensions = GetDimensions();
+	const glm::ivec3 Offset = delta * CHUNK_SIZE;
+
+	// The slabs that come in, and the slabs of voxels that were next to the ones that left
+	std::vector<DirtyBox> Exposed;
+	std::vector<DirtyBox> Boundaries;
+
+	for (int axis = 0; axis < 3; axis += 2)
+	{
+		if (Offset[axis] == 0)
+		{
+			continue;
+		}
+
+		DirtyBox Slab = { glm::ivec3(0), Dimensions };
+		DirtyBox Boundary = { glm::ivec3(0), Dimensions };
+
+		if (Offset[axis] > 0)
+		{
+			Slab.Min[axis] = glm::max(Dimensions[axis] - Offset[axis], 0);
+			Boundary.Max[axis] = 1;
+		}
+
+		else
+		{
+			Slab.Max[axis] = glm::min(-Offset[axis], Dimensions[axis]);
+			Boundary.Min[axis] = Dimensions[axis] - 1;
+		}
+
+		Exposed.push_back(Slab);
+		Boundaries.push_back(Boundary);
+	}
+
+	m_WorldData.ShiftChunks(delta);
+	m_DistanceField.Shift(Offset);
+	m_VolumeOffset = ((m_VolumeOffset + Offset) % Dimensions + Dimensions) % Dimensions;
+
+	// The exposed texels still hold the light of the voxels that left
+	std::vector<DirtyBox> Relight = Exposed;
+	Relight.insert(Relight.end(), Boundaries.begin(), Boundaries.end());
+	Volumetrics::ShiftVolume(Offset, Relight);
+
+	std::vector<std::pair<int, glm::ivec3>> Lights;
+
+	for (const glm::ivec2& ChunkOffset : LightChunkOffsets)
+	{
+		for (int i = glm::max(ChunkOffset.x, 0); i < ChunkOffset.x + ChunkOffset.y && i < (int)LightChunkData.size(); i++)
+		{
+			const glm::ivec3 Light = glm::ivec3(LightChunkData[i]) - Offset;
+
+			if (glm::all(glm::greaterThanEqual(Light, glm::ivec3(0))) && glm::all(glm::lessThan(Light, Dimensions)))
+			{
+				Lights.push_back({ Get1DIndexForLightChunk(Light.x / 16, Light.y / 16, Light.z / 16), Light });
+			}
+		}
+	}
+
+	RebuildLightList(Lights);
+	m_ParticleEmitter.Translate(-glm::vec3(Offset));
+
+	// The exposed voxels are uploaded (as air until the streamer writes them) and their distances recomputed by the
+	// next flush, along with the distances next to the boundaries
+	for (const DirtyBox& box : Exposed)
+	{
+		m_DirtyVoxels.Add(box.Min, box.Max);
+	}
+
+	m_ShiftBoundaries.insert(m_ShiftBoundaries.end(), Boundaries.begin(), Boundaries.end());
+
+	// The state pool isn't addressed toroidally, it's small enough to be rebuilt
+	if (!m_WorldData.GetStates().IsEmpty() || m_StatePool.GetStoredBrickCount() > 0)
+	{
+		m_StatePool.Build(m_WorldData);
+	}
+
+	// The history and the edit log are in the coordinates of the previous window, a replay would put the edits that
+	// follow at the wrong positions
+	m_Journal.Clear();
+
+	if (m_Journal.IsLogOpen())
+	{
+		m_Journal.CloseLog();
+		std::cout << "\n\n" << "THE WINDOW MOVED, THE EDIT LOG WAS CLOSED" << "\n\n";
+	}
+}
+
+void VoxelRT::World::Buffer(bool brick_pool)
+{
+	m_UseBrickPool = brick_pool;
+	m_WideBlockIDs = BlockDatabase::UsesWideBlockIDs();
+	m_DirtyVoxels.Clear();
+	m_DirtyVoxelsInDistanceField.Clear();
+	m_Buffered = true;
+	m_StatePool.Build(m_WorldData);
+
+	if (m_UseBrickPool)
+	{
+		m_BrickPool.Build(m_WorldData, m_WideBlockIDs);
+		return;
+	}
+
+	const glm::ivec3& Dimensions = GetDimensions();
+	const GLenum Type = m_WideBlockIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+	m_DataTexture.CreateTexture(Dimensions.x, Dimensions.y, Dimensions.z, nullptr, m_WideBlockIDs ? GL_R16 : GL_RED, GL_RED, Type);
+
+	// Upload one slab of chunks at a time so that we never need a flat copy of the entire world
+	const glm::ivec3 SlabSize = glm::ivec3(Dimensions.x, Dimensions.y, CHUNK_SIZE);
+
+	glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
+
+	for (int z = 0; z < Dimensions.z; z += CHUNK_SIZE)
+	{
+		ForEachWrappedBox({ glm::ivec3(0, 0, z), glm::ivec3(0, 0, z) + SlabSize }, m_VolumeOffset, Dimensions, [&](const glm::ivec3& min, const glm::ivec3& size, const glm::ivec3& texel)
+		{
+			ReadUploadRegion(min, size);
+			glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED, Type, m_UploadBuffer.data());
+		});
+	}
+
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	m_UploadBuffer.clear();
+	m_UploadBuffer.shrink_to_fit();
+}
+
+void VoxelRT::World::ReadUploadRegion(const glm::ivec3& origin, const glm::ivec3& size)
+{
+	const size_t Volume = (size_t)size.x * size.y * size.z;
+
+	if (m_WideBlockIDs)
+	{
+		m_UploadBuffer.resize(Volume * sizeof(uint16_t));
+		m_WorldData.ReadRegion(origin, size, reinterpret_cast<uint16_t*>(m_UploadBuffer.data()));
+	}
+
+	else
+	{
+		m_UploadBuffer.resize(Volume);
+		m_WorldData.ReadRegion(origin, size, m_UploadBuffer.data());
+	}
+}
+
+void VoxelRT::World::BindVoxelData(int unit) const
+{
+	m_StatePool.Bind();
+
+	if (m_UseBrickPool)
+	{
+		m_BrickPool.Bind(unit);
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
+}
+
+size_t VoxelRT::World::GetVoxelDataVideoMemory() const noexcept
+{
+	if (m_UseBrickPool)
+	{
+		return m_BrickPool.GetVideoMemoryUsage();
+	}
+
+	const glm::ivec3& Dimensions = GetDimensions();
+	return (size_t)Dimensions.x * Dimensions.y * Dimensions.z * (m_WideBlockIDs ? 2 : 1);
+}
+
+void VoxelRT::World::FlushEdits()
+{
+	// The voxels next to the side a streamed world moved away from lost their neighbours, their distances have to be
+	// recomputed even though they didn't change
+	std::vector<DirtyBox> DistanceEdits = m_DirtyVoxels.GetBoxes();
+	DistanceEdits.insert(DistanceEdits.end(), m_ShiftBoundaries.begin(), m_ShiftBoundaries.end());
+	m_ShiftBoundaries.clear();
+
+	// The chunks the distance field already has are only uploaded
+	for (const DirtyBox& box : m_DirtyVoxelsInDistanceField.GetBoxes())
+	{
+		m_DirtyVoxels.Add(box.Min, box.Max);
+	}
+
+	m_DirtyVoxelsInDistanceField.Clear();
+
+	if (m_DirtyVoxels.IsEmpty() && DistanceEdits.empty())
+	{
+		return;
+	}
+
+	if (m_UseBrickPool)
+	{
+		m_BrickPool.Update(m_WorldData, m_DirtyVoxels.GetBoxes());
+	}
+
+	else
+	{
+		glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (const DirtyBox& box : m_DirtyVoxels.GetBoxes())
+		{
+			ForEachWrappedBox(box, m_VolumeOffset, GetDimensions(), [&](const glm::ivec3& min, const glm::ivec3& size, const glm::ivec3& texel)
+			{
+				ReadUploadRegion(min, size);
+				glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED, m_WideBlockIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, m_UploadBuffer.data());
+				m_UploadedBytes += m_UploadBuffer.size();
+			});
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_3D, 0);
+	}
+
+	// Nothing to do for a world without states
+	if (!m_WorldData.GetStates().IsEmpty() || m_StatePool.GetStoredBrickCount() > 0)
+	{
+		m_StatePool.Update(m_WorldData, m_DirtyVoxels.GetBoxes());
+	}
+
+	// Only the part of the distance field the edits can affect is recomputed (on the cpu copy) and uploaded
+	// Edits in open space can affect a huge part of the field, past a point a full regeneration is faster
+	// Moving a streamed window rewrites a slab bigger than that, but its capped field is cheaper to recompute and a
+	// full regeneration would upload all of it
+	const glm::ivec3& Dimensions = GetDimensions();
+	const size_t MaxIncrementalVolume = ((size_t)Dimensions.x * Dimensions.y * Dimensions.z) / (m_Streamed ? 3 : 8);
+
+	for (const DirtyBox& box : m_DirtyVoxels.GetBoxes())
+	{
+		m_PackedVolume.MarkDirty(box.Min, box.Max);
+	}
+
+	if (m_VoxelLOD.IsValid())
+	{
+		m_VoxelLOD.Update(m_WorldData, m_DirtyVoxels.GetBoxes(), m_VoxelLODRegions);
+
+		for (const DirtyBox& region : m_VoxelLODRegions)
+		{
+			UploadVoxelLODRegion(region);
+		}
+	}
+
+	if (m_DirectionalDistanceField.IsValid())
+	{
+		if (!m_DirectionalDistanceField.Update(m_WorldData, m_DirtyVoxels.GetBoxes(), m_DirectionalDistanceRegions, MaxIncrementalVolume))
+		{
+			m_DirectionalDistanceField.Generate(m_WorldData);
+			m_DirectionalDistanceRegions.assign(1, { glm::ivec3(0), Dimensions });
+		}
+
+		for (const DirtyBox& region : m_DirectionalDistanceRegions)
+		{
+			UploadDirectionalDistanceRegion(region);
+		}
+	}
+
+	if (!m_DistanceField.Update(m_WorldData, DistanceEdits, m_DistanceFieldRegions, MaxIncrementalVolume))
+	{
+		GenerateDistanceField();
+		m_DirtyVoxels.Clear();
+		return;
+	}
+
+	for (const DirtyBox& region : m_DistanceFieldRegions)
+	{
+		m_PackedVolume.MarkDirty(region.Min, region.Max);
+		UploadDistanceFieldRegion(region);
+	}
+
+#ifdef VOXEL_RT_DISTANCE_FIELD_DEBUG
+	DistanceField Reference;
+	Reference.Resize(GetDimensions(), m_DistanceField.GetMaxDistance());
+	Reference.Generate(m_WorldData);
+
+	std::cout << "\nIncremental distance field update, mismatches against a full regeneration : " <<
+		std::inner_product(Reference.GetVector().begin(), Reference.GetVector().end(), m_DistanceField.GetVector().begin(), (size_t)0, std::plus<size_t>(), std::not_equal_to<uint8_t>()) << "\n";
+#endif
+
+	m_DirtyVoxels.Clear();
+}
+
+void VoxelRT::World::UploadDistanceFieldRegion(const DirtyBox& region)
+{
+	glBindTexture(GL_TEXTURE_3D, m_DistanceFieldTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
+	ForEachWrappedBox(region, m_VolumeOffset, GetDimensions(), [&](const glm::ivec3& min, const glm::ivec3& size, const glm::ivec3& texel)
+	{
+		m_UploadBuffer.resize((size_t)size.x * size.y * size.z);
+		m_DistanceField.ReadRegion(min, size, m_UploadBuffer.data());
+		glTexSubImage3D(GL_TEXTURE_3D, 0, texel.x, texel.y, texel.z, size.x, size.y, size.z, GL_RED, GL_UNSIGNED_BYTE, m_UploadBuffer.data());
+		m_UploadedBytes += m_UploadBuffer.size();
+	});
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::World::BufferPackedVolume()
+{
+	if (m_WideBlockIDs || BlockDatabase::UsesWideBlockIDs())
+	{
+		std::cout << "\nThe packed voxel volume only stores 8 bit block ids, using the separate volumes\n";
+		return;
+	}
+
+	m_PackedVolume.Build(*this);
+
+#ifdef VOXEL_RT_PACKED_VOLUME_DEBUG
+	PackedVoxelVolume::RunPackingTest();
+
+	// What the texture holds against the volumes it was packed from
+	const glm::ivec3& Dimensions = GetDimensions();
+	std::vector<uint32_t> Reference((size_t)Dimensions.x * Dimensions.y * Dimensions.z);
+	std::vector<uint32_t> Uploaded(Reference.size());
+	m_PackedVolume.ReadRegion(*this, glm::ivec3(0), Dimensions, Reference.data());
+
+	glBindTexture(GL_TEXTURE_3D, m_PackedVolume.GetTextureID());
+	glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, Uploaded.data());
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	std::cout << "\nPacked voxel volume, texels that don't match the cpu volumes : " <<
+		std::inner_product(Reference.begin(), Reference.end(), Uploaded.begin(), (size_t)0, std::plus<size_t>(), std::not_equal_to<uint32_t>()) << "\n";
+#endif
+}
+
+void VoxelRT::World::BufferDirectionalDistanceField()
+{
+	const glm::ivec3& Dimensions = GetDimensions();
+
+	m_DirectionalDistanceField.Resize(Dimensions);
+	m_DirectionalDistanceField.Generate(m_WorldData);
+
+	// Integer textures can't be filtered, Texture3D uses nearest filtering
+	m_DirectionalDistanceTexture.CreateTexture(Dimensions.x, Dimensions.y, Dimensions.z, nullptr, GL_RGBA8UI, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE);
+	UploadDirectionalDistanceRegion({ glm::ivec3(0), Dimensions });
+}
+
+void VoxelRT::World::UploadDirectionalDistanceRegion(const DirtyBox& region)
+{
+	const glm::ivec3 Size = region.GetSize();
+
+	glBindTexture(GL_TEXTURE_3D, m_DirectionalDistanceTexture.GetTextureID());
+
+	// Never needs a copy of more than a slab of chunks
+	for (int z = region.Min.z; z < region.Max.z; z += CHUNK_SIZE)
+	{
+		const glm::ivec3 Origin = glm::ivec3(region.Min.x, region.Min.y, z);
+		const glm::ivec3 SlabSize = glm::ivec3(Size.x, Size.y, std::min(CHUNK_SIZE, region.Max.z - z));
+
+		m_UploadBuffer.resize((size_t)SlabSize.x * SlabSize.y * SlabSize.z * 4);
+		m_DirectionalDistanceField.ReadRegion(Origin, SlabSize, m_UploadBuffer.data());
+		glTexSubImage3D(GL_TEXTURE_3D, 0, Origin.x, Origin.y, Origin.z, SlabSize.x, SlabSize.y, SlabSize.z, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, m_UploadBuffer.data());
+	}
+
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::World::BindDirectionalDistanceField() const
+{
+	glActiveTexture(GL_TEXTURE0 + DirectionalDistanceField::TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_3D, m_DirectionalDistanceTexture.GetTextureID());
+}
+
+size_t VoxelRT::World::GetDirectionalDistanceFieldVideoMemory() const noexcept
+{
+	if (!UsesDirectionalDistanceField())
+	{
+		return 0;
+	}
+
+	const glm::ivec3& Dimensions = GetDimensions();
+	return (size_t)Dimensions.x * Dimensions.y * Dimensions.z * 4;
+}
+
+void VoxelRT::World::BufferVoxelLOD()
+{
+	const glm::ivec3& Dimensions = GetDimensions();
+	const GLenum InternalFormat = m_WideBlockIDs ? GL_R16 : GL_R8;
+	const GLenum Type = m_WideBlockIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+
+	m_VoxelLOD.Resize(Dimensions);
+	m_VoxelLOD.Generate(m_WorldData);
+
+	// Texture3D only creates the first mip, the shaders read the others with texelFetch() (nearest filtering)
+	const glm::ivec3 FirstLevel = m_VoxelLOD.GetLevelDimensions(1);
+	m_VoxelLODTexture.CreateTexture(FirstLevel.x, FirstLevel.y, FirstLevel.z, nullptr, InternalFormat, GL_RED, Type);
+
+	glBindTexture(GL_TEXTURE_3D, m_VoxelLODTexture.GetTextureID());
+
+	for (int level = 2; level <= VoxelLOD::LEVEL_COUNT; level++)
+	{
+		const glm::ivec3 Size = m_VoxelLOD.GetLevelDimensions(level);
+		glTexImage3D(GL_TEXTURE_3D, level - 1, InternalFormat, Size.x, Size.y, Size.z, 0, GL_RED, Type, nullptr);
+	}
+
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, VoxelLOD::LEVEL_COUNT - 1);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	UploadVoxelLODRegion({ glm::ivec3(0), Dimensions });
+}
+
+void VoxelRT::World::UploadVoxelLODRegion(const DirtyBox& region)
+{
+	glBindTexture(GL_TEXTURE_3D, m_VoxelLODTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int level = 1; level <= VoxelLOD::LEVEL_COUNT; level++)
+	{
+		// The region is chunk aligned, so it's aligned to the cells of every level
+		const glm::ivec3 Origin = region.Min >> level;
+		const glm::ivec3 Size = region.GetSize() >> level;
+
+		if (m_WideBlockIDs)
+		{
+			m_UploadBuffer.resize((size_t)Size.x * Size.y * Size.z * sizeof(uint16_t));
+			m_VoxelLOD.ReadRegion(level, Origin, Size, reinterpret_cast<uint16_t*>(m_UploadBuffer.data()));
+		}
+
+		else
+		{
+			m_UploadBuffer.resize((size_t)Size.x * Size.y * Size.z);
+			m_VoxelLOD.ReadRegion(level, Origin, Size, m_UploadBuffer.data());
+		}
+
+		glTexSubImage3D(GL_TEXTURE_3D, level - 1, Origin.x, Origin.y, Origin.z, Size.x, Size.y, Size.z, GL_RED, m_WideBlockIDs ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, m_UploadBuffer.data());
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void VoxelRT::World::BindVoxelLOD() const
+{
+	glActiveTexture(GL_TEXTURE0 + VoxelLOD::TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_3D, m_VoxelLODTexture.GetTextureID());
+}
+
+size_t VoxelRT::World::GetVoxelLODVideoMemory() const noexcept
+{
+	if (!UsesVoxelLOD())
+	{
+		return 0;
+	}
+
+	size_t Total = 0;
+
+	for (int level = 1; level <= VoxelLOD::LEVEL_COUNT; level++)
+	{
+		const glm::ivec3 Size = m_VoxelLOD.GetLevelDimensions(level);
+		Total += (size_t)Size.x * Size.y * Size.z * (m_WideBlockIDs ? 2 : 1);
+	}
+
+	return Total;
+}
 
 void VoxelRT::World::InitializeDistanceGenerator()
 {
@@ -63,26 +695,73 @@ void VoxelRT::World::InitializeDistanceGenerator()
 	m_DistanceShaderZ.CreateComputeShader("Core/Shaders/ManhattanDistanceZ.comp");
 	m_DistanceShaderZ.Compile();
 
-	m_DistanceFieldTexture.CreateTexture(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z, nullptr);
+	const glm::ivec3& Dimensions = GetDimensions();
+	m_DistanceFieldTexture.CreateTexture(Dimensions.x, Dimensions.y, Dimensions.z, nullptr);
 }
 
 void VoxelRT::World::GenerateDistanceField()
 {
-	std::cout << "\nGenerating Distance Field!\n";
+	std::cout << "\nGenerating Distance Field (" << DistanceField::GetDefaultThreadCount() << " threads)!\n";
+
+	m_DistanceField.Generate(m_WorldData);
+	UploadDistanceField();
+
+	std::cout << "\nFinished Generating Distance Field!\n";
+}
+
+void VoxelRT::World::UploadDistanceField()
+{
+	const glm::ivec3& Dimensions = GetDimensions();
+
+	// The field of a streamed world that moved doesn't start at texel 0
+	if (m_VolumeOffset != glm::ivec3(0))
+	{
+		for (int z = 0; z < Dimensions.z; z += CHUNK_SIZE)
+		{
+			UploadDistanceFieldRegion({ glm::ivec3(0, 0, z), glm::ivec3(Dimensions.x, Dimensions.y, z + CHUNK_SIZE) });
+		}
+
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_3D, m_DistanceFieldTexture.GetTextureID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, Dimensions.x, Dimensions.y, Dimensions.z, GL_RED, GL_UNSIGNED_BYTE, m_DistanceField.GetData());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	m_UploadedBytes += m_DistanceField.GetVolume();
+
+	m_PackedVolume.MarkDirty(glm::ivec3(0), Dimensions);
+}
+
+void VoxelRT::World::GenerateDistanceFieldGPU()
+{
+	// The passes read the dense volume, from texel 0
+	if (m_UseBrickPool || m_VolumeOffset != glm::ivec3(0))
+	{
+		GenerateDistanceField();
+		return;
+	}
+
+	std::cout << "\nGenerating Distance Field on the GPU!\n";
 
 	const int GROUP_SIZE = 32;
+	const glm::ivec3& Dimensions = GetDimensions();
+
+	// Round up, the passes discard the invocations outside the volume
+	const glm::ivec3 Groups = (Dimensions + glm::ivec3(GROUP_SIZE - 1)) / GROUP_SIZE;
 
 	// X PASS
 
 	m_DistanceShaderX.Use();
-	m_DistanceShaderX.SetVector3f("u_Dimensions", glm::vec3(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z));
+	m_DistanceShaderX.SetVector3f("u_Dimensions", glm::vec3(Dimensions));
 	m_DistanceShaderX.SetInteger("u_BlockData", 1);
 
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
 
 	glBindImageTexture(0, m_DistanceFieldTexture.GetTextureID(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
-	glDispatchCompute(1, WORLD_SIZE_Y / GROUP_SIZE, WORLD_SIZE_Z / GROUP_SIZE);
+	glDispatchCompute(1, Groups.y, Groups.z);
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 	glUseProgram(0);
@@ -93,7 +772,7 @@ void VoxelRT::World::GenerateDistanceField()
 	m_DistanceShaderY.Use();
 
 	glBindImageTexture(0, m_DistanceFieldTexture.GetTextureID(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
-	glDispatchCompute(WORLD_SIZE_X / GROUP_SIZE, 1, WORLD_SIZE_Z / GROUP_SIZE);
+	glDispatchCompute(Groups.x, 1, Groups.z);
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 	glUseProgram(0);
@@ -104,11 +783,30 @@ void VoxelRT::World::GenerateDistanceField()
 	m_DistanceShaderZ.Use();
 
 	glBindImageTexture(0, m_DistanceFieldTexture.GetTextureID(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
-	glDispatchCompute(WORLD_SIZE_X / GROUP_SIZE, WORLD_SIZE_Y / GROUP_SIZE, 1);
+	glDispatchCompute(Groups.x, Groups.y, 1);
 	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 	glUseProgram(0);
 
+	// Read the field back once so that edits can update it incrementally on the cpu
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_3D, m_DistanceFieldTexture.GetTextureID());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_3D, 0, GL_RED, GL_UNSIGNED_BYTE, m_DistanceField.GetData());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	m_DistanceField.SetValid(true);
+	m_PackedVolume.MarkDirty(glm::ivec3(0), Dimensions);
+
+#ifdef VOXEL_RT_DISTANCE_FIELD_DEBUG
+	DistanceField Reference;
+	Reference.Resize(GetDimensions());
+	Reference.Generate(m_WorldData);
+
+	std::cout << "\nDistance field, gpu/cpu mismatches : " <<
+		std::inner_product(Reference.GetVector().begin(), Reference.GetVector().end(), m_DistanceField.GetVector().begin(), (size_t)0, std::plus<size_t>(), std::not_equal_to<uint8_t>()) << "\n";
+#endif
+
 	std::cout << "\nFinished Generating Distance Field!\n";
 }
 
@@ -118,7 +816,7 @@ void VoxelRT::World::ChangeCurrentlyHeldBlock(bool x)
 	{
 		m_CurrentlyHeldBlock++;
 
-		if (m_CurrentlyHeldBlock >= BlockDatabase::GetNumberOfBlocksInDatabase() || m_CurrentlyHeldBlock >= 127)
+		if (m_CurrentlyHeldBlock >= BlockDatabase::GetNumberOfBlocksInDatabase())
 		{
 			m_CurrentlyHeldBlock = 1;
 		}
@@ -238,12 +936,10 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 		position += direction * (t + 0.001f);
 
-		if (!((int)floor(position.x) >= WORLD_SIZE_X || (int)floor(position.y) >= WORLD_SIZE_Y || (int)floor(position.z) >= WORLD_SIZE_Z ||
+		if (!((int)floor(position.x) >= GetDimensions().x || (int)floor(position.y) >= GetDimensions().y || (int)floor(position.z) >= GetDimensions().z ||
 			(int)floor(position.x) <= 0 || (int)floor(position.y) <= 0 || (int)floor(position.z) <= 0 ))
 		{
-			Block ray_block = GetBlock((int)position.x, (int)position.y, (int)position.z);
-
-			if (ray_block.block != 0)
+			if (IsSolid((int)position.x, (int)position.y, (int)position.z))
 			{
 				glm::vec3 normal;
 
@@ -264,7 +960,7 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 				position = glm::floor(position);
 
-				if ((int)floor(position.x) >= WORLD_SIZE_X || (int)floor(position.y) >= WORLD_SIZE_Y || (int)floor(position.z) >= WORLD_SIZE_Z ||
+				if ((int)floor(position.x) >= GetDimensions().x || (int)floor(position.y) >= GetDimensions().y || (int)floor(position.z) >= GetDimensions().z ||
 					(int)floor(position.x) <= 0 || (int)floor(position.y) <= 0 || (int)floor(position.z) <= 0)
 				{ 
 					return false; 
@@ -323,7 +1019,7 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 
 
-					uint8_t editblock = m_CurrentlyHeldBlock;
+					uint16_t editblock = m_CurrentlyHeldBlock;
 
 					if (BlockDatabase::GetBlockEmissiveTexture(editblock) >= 0) {
 						std::cout << "\nLAMP PLACED";
@@ -364,16 +1060,9 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 
 
+					// The texture upload and the distance field regeneration are deferred to FlushEdits()
 					SetBlock((int)position.x, (int)position.y, (int)position.z, { editblock });
 
-					if (m_Buffered && PlacedSomething)
-					{
-					
-						glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
-						glTexSubImage3D(GL_TEXTURE_3D, 0, (int)position.x, (int)position.y, (int)position.z, 1, 1, 1, GL_RED, GL_UNSIGNED_BYTE, &editblock);
-						GenerateDistanceField();
-					}
-
 				}
 
 				else if (op == 0)
@@ -396,7 +1085,7 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 
 
-					uint8_t edited_block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
+					uint16_t edited_block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
 					auto& LightRemovalBFS = Volumetrics::GetLightRemovalBFSQueue();
 					auto& LightPropogateBFS = Volumetrics::GetLightBFSQueue();
 
@@ -451,15 +1140,6 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 						floor(position.y),
 						floor(position.z - 1))));
 
-					if (m_Buffered)
-					{
-						uint8_t editblock = 0;
-
-						glBindTexture(GL_TEXTURE_3D, m_DataTexture.GetTextureID());
-						glTexSubImage3D(GL_TEXTURE_3D, 0, (int)position.x, (int)position.y, (int)position.z, 1, 1, 1, GL_RED, GL_UNSIGNED_BYTE, &editblock);
-						GenerateDistanceField();
-					}
-
 					this->RemoveFromLightList(glm::vec3(
 						floor(position.x),
 						floor(position.y),
@@ -468,7 +1148,7 @@ bool VoxelRT::World::Raycast(uint8_t op, glm::vec3 pos, const glm::vec3& dir, co
 
 				else if (op == 2)
 				{
-					uint8_t block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
+					uint16_t block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
 
 					if (block > 0)
 					{
@@ -511,12 +1191,10 @@ glm::ivec4 VoxelRT::World::RaycastDetect(const glm::vec3& pos, const glm::vec3&
 
 		position += direction * (t + 0.001f);
 
-		if (!((int)floor(position.x) >= WORLD_SIZE_X || (int)floor(position.y) >= WORLD_SIZE_Y || (int)floor(position.z) >= WORLD_SIZE_Z ||
+		if (!((int)floor(position.x) >= GetDimensions().x || (int)floor(position.y) >= GetDimensions().y || (int)floor(position.z) >= GetDimensions().z ||
 			(int)floor(position.x) <= 0 || (int)floor(position.y) <= 0 || (int)floor(position.z) <= 0))
 		{
-			Block ray_block = GetBlock((int)position.x, (int)position.y, (int)position.z);
-
-			if (ray_block.block != 0)
+			if (IsSolid((int)position.x, (int)position.y, (int)position.z))
 			{
 				glm::vec3 normal;
 
@@ -532,13 +1210,13 @@ glm::ivec4 VoxelRT::World::RaycastDetect(const glm::vec3& pos, const glm::vec3&
 
 				position = glm::floor(position);
 
-				if ((int)floor(position.x) >= WORLD_SIZE_X || (int)floor(position.y) >= WORLD_SIZE_Y || (int)floor(position.z) >= WORLD_SIZE_Z ||
+				if ((int)floor(position.x) >= GetDimensions().x || (int)floor(position.y) >= GetDimensions().y || (int)floor(position.z) >= GetDimensions().z ||
 					(int)floor(position.x) <= 0 || (int)floor(position.y) <= 0 || (int)floor(position.z) <= 0)
 				{
 					return glm::ivec4(-1);
 				}
 
-				uint8_t block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
+				uint16_t block = GetBlock((int)position.x, (int)position.y, (int)position.z).block;
 				return glm::ivec4(glm::ivec3((int)position.x, (int)position.y, (int)position.z), block);
 			}
 		}
@@ -558,7 +1236,7 @@ void VoxelRT::World::RepropogateLPV_()
 	Volumetrics::ClearEntireVolume();
 
 	for (auto& e : LightChunkData) {
-		uint8_t block_at = this->GetBlock(glm::ivec3(glm::floor(glm::vec3(e)))).block;
+		uint16_t block_at = this->GetBlock(glm::ivec3(glm::floor(glm::vec3(e)))).block;
 		Volumetrics::AddLightToVolume(e, block_at);
 	}
 
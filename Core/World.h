@@ -6,9 +6,22 @@
 #include <glm/glm.hpp>
 
 #include <algorithm>
+#include <memory>
+#include <atomic>
 
 #include "Block.h"
+#include "WorldData.h"
 #include "Texture3D.h"
+#include "DirtyRegion.h"
+#include "DistanceField.h"
+#include "VoxelLOD.h"
+#include "BrickPool.h"
+#include "VoxelStatePool.h"
+#include "PackedVoxelVolume.h"
+#include "VoxelRaycast.h"
+#include "EditJournal.h"
+#include "WorldSnapshot.h"
+#include "WorldFileLayout.h"
 #include "Macros.h"
 
 #include "GLClasses/ComputeShader.h"
@@ -27,46 +40,94 @@ namespace VoxelRT
 	//	return glm::ivec3(x, y, z);
 	//}
 
-	inline static int Get1DIndexForLightChunk(int x, int y, int z)
-	{
-		return ((z * 24 * 8) + (y * 24) + x);
-	}
+	class LazyWorldLoader;
 
 	class World
 	{
 	public :
 
-		World()
+		// Distance field cap of a streamed world (SetStreamed())
+		static constexpr int STREAMED_MAX_DISTANCE = 16;
+
+		World(const glm::ivec3& dimensions = glm::ivec3(DEFAULT_WORLD_SIZE_X, DEFAULT_WORLD_SIZE_Y, DEFAULT_WORLD_SIZE_Z))
 		{
-			memset(&m_WorldData, 0, WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z);
-			memset(&LightChunkOffsets[0], -1, 24 * 8 * 24 * sizeof(int) * 2);
+			Resize(dimensions);
 			m_Buffered = false;
 		}
 
-		const Block& GetBlock(uint16_t x, uint16_t y, uint16_t z)
+		// Clears the world and resizes it, has to be called before the world is buffered
+		void Resize(const glm::ivec3& dimensions);
+		const glm::ivec3& GetDimensions() const noexcept { return m_WorldData.GetDimensions(); }
+		bool InBounds(int x, int y, int z) const noexcept { return m_WorldData.InBounds(x, y, z); }
+
+		// Light chunks are 16^3
+		const glm::ivec3& GetLightChunkGridSize() const noexcept { return m_LightChunkGridSize; }
+
+		inline int Get1DIndexForLightChunk(int x, int y, int z) const noexcept
+		{
+			return (z * m_LightChunkGridSize.x * m_LightChunkGridSize.y) + (y * m_LightChunkGridSize.x) + x;
+		}
+
+		Block GetBlock(uint16_t x, uint16_t y, uint16_t z) const
 		{
-			return m_WorldData[x + y * WORLD_SIZE_X + z * WORLD_SIZE_X * WORLD_SIZE_Y];
+			return m_WorldData.GetBlock(x, y, z);
 		}
 
 		void SetBlock(uint16_t x, uint16_t y, uint16_t z, Block block)
 		{
-			m_WorldData[x + y * WORLD_SIZE_X + z * WORLD_SIZE_X * WORLD_SIZE_Y] = block;
+			RecordEdit(glm::ivec3(x, y, z), block, 0);
+			m_WorldData.SetBlock(x, y, z, block);
+			MarkDirty(glm::ivec3(x, y, z));
+		}
+
+		bool IsSolid(int x, int y, int z) const
+		{
+			return m_WorldData.IsSolid(x, y, z);
 		}
 
-		const Block& GetBlock(const glm::ivec3& p)
+		bool IsSolid(const glm::ivec3& p) const
 		{
-			return m_WorldData[p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y];
+			return m_WorldData.IsSolid(p.x, p.y, p.z);
+		}
+
+		Block GetBlock(const glm::ivec3& p) const
+		{
+			return m_WorldData.GetBlock(p.x, p.y, p.z);
 		}
 
 		void SetBlock(const glm::ivec3& p, Block block)
 		{
-			m_WorldData[p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y] = block;
+			RecordEdit(p, block, 0);
+			m_WorldData.SetBlock(p.x, p.y, p.z, block);
+			MarkDirty(p);
 		}
 
-		void SetBlock(const glm::ivec3& p, uint8_t b)
+		void SetBlock(const glm::ivec3& p, uint16_t b)
 		{
 			Block block = { b };
-			m_WorldData[p.x + p.y * WORLD_SIZE_X + p.z * WORLD_SIZE_X * WORLD_SIZE_Y] = block;
+			RecordEdit(p, block, 0);
+			m_WorldData.SetBlock(p.x, p.y, p.z, block);
+			MarkDirty(p);
+		}
+
+		void SetBlock(const glm::ivec3& p, Block block, BlockState state)
+		{
+			RecordEdit(p, block, state);
+			m_WorldData.SetBlock(p.x, p.y, p.z, block, state);
+			MarkDirty(p);
+		}
+
+		// Per voxel states (orientation etc, see VoxelStates.h), setting a block without one removes the state of the voxel
+		BlockState GetBlockState(const glm::ivec3& p) const
+		{
+			return m_WorldData.GetState(p.x, p.y, p.z);
+		}
+
+		void SetBlockState(const glm::ivec3& p, BlockState state)
+		{
+			RecordEdit(p, m_WorldData.GetBlock(p.x, p.y, p.z), state);
+			m_WorldData.SetState(p.x, p.y, p.z, state);
+			MarkDirty(p);
 		}
 
 
@@ -164,17 +225,147 @@ namespace VoxelRT
 			RebufferLightChunks();
 		}
 
-		void Buffer()
-		{
-			m_DataTexture.CreateTexture(WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z, m_WorldData.data());
-			m_Buffered = true;
-		}
+		// Replaces the lights of the light chunk lists that are inside the boxes (max exclusive) with the emissive blocks
+		// that are there now and rebuffers the lists once, for bulk edits (see WorldEdit.h)
+		void UpdateLightList(const std::vector<DirtyBox>& boxes);
+
+		// Uploads the voxel data, either as a dense volume (m_DataTexture) or as a sparse brick pool
+		// The shaders have to be compiled with VOXEL_RT_BRICK_POOL defined to read the brick pool
+		// Both are R8 unless the block database has ids above 255 (BlockDatabase::UsesWideBlockIDs()), then they're R16
+		void Buffer(bool brick_pool = false);
+
+		// Binds the voxel data to the texture unit (u_VoxelData), the brick pool atlas goes to BrickPool::ATLAS_TEXTURE_UNIT
+		// The voxel states are always bound, to VoxelStatePool::INDIRECTION_TEXTURE_UNIT and VoxelStatePool::ATLAS_TEXTURE_UNIT
+		void BindVoxelData(int unit) const;
+
+		bool UsesBrickPool() const noexcept { return m_UseBrickPool; }
+		bool UsesWideBlockIDs() const noexcept { return m_WideBlockIDs; }
+		const BrickPool& GetBrickPool() const noexcept { return m_BrickPool; }
+		const VoxelStatePool& GetStatePool() const noexcept { return m_StatePool; }
+		size_t GetVoxelDataVideoMemory() const noexcept;
 
 		void InitializeDistanceGenerator();
+
+		// Full regeneration with the (threaded) cpu generator followed by a single upload
+		// Only needed once the world is loaded, edits update the field incrementally
 		void GenerateDistanceField();
 
+		// Full regeneration with the ManhattanDistance compute shaders, the result is read back into the cpu copy
+		void GenerateDistanceFieldGPU();
+
+		// Uploads the entire cpu copy (after generating it or loading it from the save file)
+		void UploadDistanceField();
+
+		DistanceField& GetDistanceField() noexcept { return m_DistanceField; }
+		const DistanceField& GetDistanceField() const noexcept { return m_DistanceField; }
+
+		// Uploads the voxels modified since the last flush and updates the part of the distance field they affect
+		// Called once per frame, edits made before the world is buffered are uploaded by Buffer()
+		void FlushEdits();
+
+		// Interleaved block/distance/light volume for the primary trace and the volumetrics (see PackedVoxelVolume.h)
+		// Has to be called once the distance field and the light volume exist, 8 bit block ids only
+		void BufferPackedVolume();
+
+		// Uploads the parts of the packed volume the edits and the light updates changed, after FlushEdits() and
+		// Volumetrics::FlushUploads() (once per frame)
+		inline void FlushPackedVolume() { m_PackedVolume.Flush(*this); }
+
+		bool UsesPackedVolume() const noexcept { return m_PackedVolume.IsCreated(); }
+		PackedVoxelVolume& GetPackedVolume() noexcept { return m_PackedVolume; }
+		const PackedVoxelVolume& GetPackedVolume() const noexcept { return m_PackedVolume; }
+
+		// Per octant distance field the traversals take longer steps with (see DirectionalDistanceField), optional
+		// Generated on the cpu, FlushEdits() keeps it up to date along with the manhattan field
+		void BufferDirectionalDistanceField();
+
+		// Binds it to DirectionalDistanceField::TEXTURE_UNIT (u_DirectionalDistanceField)
+		void BindDirectionalDistanceField() const;
+
+		bool UsesDirectionalDistanceField() const noexcept { return m_DirectionalDistanceField.IsValid(); }
+		const DirectionalDistanceField& GetDirectionalDistanceField() const noexcept { return m_DirectionalDistanceField; }
+		size_t GetDirectionalDistanceFieldVideoMemory() const noexcept;
+
+		// 2x, 4x and 8x downsampled voxel data for tracing the far field (see VoxelLOD.h), optional
+		// Built on the cpu, FlushEdits() rebuilds the chunks the edits touch
+		void BufferVoxelLOD();
+
+		// Binds it to VoxelLOD::TEXTURE_UNIT (u_VoxelLOD)
+		void BindVoxelLOD() const;
+
+		bool UsesVoxelLOD() const noexcept { return m_VoxelLOD.IsValid(); }
+		const VoxelLOD& GetVoxelLOD() const noexcept { return m_VoxelLOD; }
+		size_t GetVoxelLODVideoMemory() const noexcept;
+
+		// Queues a box (max exclusive) of voxels written to m_WorldData directly for the next FlushEdits()
+		inline void MarkDirty(const glm::ivec3& min, const glm::ivec3& max)
+		{
+			if (m_Buffered)
+			{
+				m_DirtyVoxels.Add(min, max);
+			}
+		}
+
 		void ChangeCurrentlyHeldBlock(bool x);
 
+		// Publishes the current blocks and states for the readers on other threads (see WorldSnapshot.h)
+		// Main thread only, between edits (once per frame), only the chunks modified since the last publish are copied
+		void PublishSnapshot();
+
+		// Latest published snapshot (null if there's none yet), can be called from any thread
+		// The snapshot never changes and stays alive for as long as the caller holds on to it
+		std::shared_ptr<const WorldSnapshot> AcquireSnapshot() const
+		{
+			return std::atomic_load(&m_Snapshot);
+		}
+
+		// A streamed world is a window of an unbounded one that moves with the player (see ChunkStreamer.h)
+		// Its distance field is capped at STREAMED_MAX_DISTANCE so that moving only recomputes the distances near the
+		// columns that came in and left (see DistanceField::Update()).
+		// Has to be set before the world is buffered, the brick pool, the packed volume, the directional distance field
+		// and the voxel LOD levels can't be used with it
+		void SetStreamed(bool streamed);
+		bool IsStreamed() const noexcept { return m_Streamed; }
+
+		// Moves the window by delta chunks (horizontally) : the voxel at p is at p - delta * CHUNK_SIZE afterwards and the
+		// chunks that come in are air until they're written (World::SetChunk()). The cpu copies are moved, the gpu volumes
+		// (voxels, distance field, light) only get a new toroidal offset and the part that came in is uploaded by the next
+		// FlushEdits(). The edit history is cleared.
+		void ShiftWindow(const glm::ivec3& delta);
+
+		// Texel of voxel 0 in the world volumes, texel = (p + offset) mod dimensions (u_VolumeOffset in the shaders)
+		// Always 0 unless the world is streamed
+		const glm::ivec3& GetVolumeOffset() const noexcept { return m_VolumeOffset; }
+
+		// Replaces an entire chunk (WorldData::SetChunk()) and queues it for the next FlushEdits()
+		// in_distance_field : every solid voxel of the chunk already has a distance of 0 in the distance field (it was
+		// cached or generated with the chunk counted as solid, see LazyWorldLoader), the field stays a lower bound of the
+		// distances without going through an update around the chunk
+		void SetChunk(int index, VoxelChunk chunk, std::vector<uint32_t> states = {}, bool in_distance_field = false);
+
+		// Bytes of voxel data and distance field uploaded since the world was buffered
+		size_t GetUploadedBytes() const noexcept { return m_UploadedBytes; }
+
+		bool IsBuffered() const noexcept { return m_Buffered; }
+
+		// A lazily loaded world (see LazyWorldLoader.h) loads the chunks it is about to edit first, the loader detaches
+		// itself once every chunk is loaded
+		void SetLazyLoader(LazyWorldLoader* loader) noexcept { m_LazyLoader = loader; }
+		bool IsLoading() const noexcept { return m_LazyLoader != nullptr; }
+
+		// Loads the chunks of a box (max exclusive) that a lazily loaded world doesn't have yet, for the code that reads
+		// or writes m_WorldData directly. Does nothing once everything is loaded
+		void LoadRegion(const glm::ivec3& min, const glm::ivec3& max);
+
+		// The save file the world was loaded from or last saved to, SaveWorld() only appends the chunks written to since
+		// Cleared by Resize(). The autosaver's worker writes to it while it saves (see WorldAutosaver.h)
+		WorldFileLayout& GetFileLayout() noexcept { return m_FileLayout; }
+
+		// Undo/redo history of the edits, disabled until EditJournal::SetEnabled() is called
+		EditJournal& GetJournal() noexcept { return m_Journal; }
+		bool Undo() { return m_Journal.Undo(this); }
+		bool Redo() { return m_Journal.Redo(this); }
+
 
 
 		// -- DDA Voxel Traversal Algorithm --
@@ -184,17 +375,23 @@ namespace VoxelRT
 		
 		// Detects the looked at block 
 		glm::ivec4 RaycastDetect(const glm::vec3& pos, const glm::vec3& dir);
+
+		// Accelerated ray query (see VoxelRaycast.h), for anything that needs a lot of rays or long ones
+		bool CastRay(const glm::vec3& origin, const glm::vec3& direction, float max_distance, VoxelRayHit& hit) const
+		{
+			return CastVoxelRay(m_WorldData, origin, direction, max_distance, hit);
+		}
 		
 
 		void Update(FPSCamera* cam) {};
 		void UpdateParticles(FPSCamera* cam, GLuint, GLuint, GLuint, GLuint, const glm::vec3& sdir, const glm::vec3& player_pos, const glm::vec2& dims, float dt);
 
-		std::array<Block, WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z> m_WorldData;
+		WorldData m_WorldData;
 		Texture3D m_DataTexture;
 
 		std::string m_Name = "";
 
-		uint8_t GetCurrentBlock() const noexcept { return m_CurrentlyHeldBlock; }
+		uint16_t GetCurrentBlock() const noexcept { return m_CurrentlyHeldBlock; }
 
 		Texture3D m_DistanceFieldTexture;
 		ParticleSystem::ParticleEmitter m_ParticleEmitter;
@@ -206,14 +403,84 @@ namespace VoxelRT
 
 		// Each "chunk" stores a list of lights that can be sampled using MIS
 		std::vector<glm::vec4> LightChunkData;
-		std::array<glm::ivec2, 24 * 8 * 24> LightChunkOffsets; // 16x16x16 chunks
+		std::vector<glm::ivec2> LightChunkOffsets; // 16x16x16 chunks
 
 		GLuint LightChunkDataSSBO = 0;
 		GLuint LightChunkOffsetSSBO = 0;
 
 	private :
+
+		inline void MarkDirty(const glm::ivec3& p)
+		{
+			if (m_Buffered)
+			{
+				m_DirtyVoxels.Add(p);
+			}
+		}
+
+		inline void RecordEdit(const glm::ivec3& p, Block block, BlockState state)
+		{
+			if (m_LazyLoader)
+			{
+				LoadRegion(p, p + glm::ivec3(1));
+			}
+
+			if (m_Journal.IsRecording())
+			{
+				m_Journal.Record(EditJournal::GetIndex(p, GetDimensions()), m_WorldData.GetBlock(p.x, p.y, p.z), m_WorldData.GetState(p.x, p.y, p.z), block, state);
+			}
+		}
+
+		// Reads a box of voxels into m_UploadBuffer, in the format of the gpu copy (1 or 2 bytes per voxel)
+		void ReadUploadRegion(const glm::ivec3& origin, const glm::ivec3& size);
+
+		// Uploads a box of the directional field, a slab of chunks at a time
+		void UploadDirectionalDistanceRegion(const DirtyBox& region);
+
+		// Uploads the cells of every level inside of a chunk aligned box of voxels
+		void UploadVoxelLODRegion(const DirtyBox& region);
+
+		// Uploads a box of the distance field, split where it wraps around the volume
+		void UploadDistanceFieldRegion(const DirtyBox& region);
+
+		// Replaces the light chunk lists with a list of (light chunk, position) pairs and rebuffers them
+		void RebuildLightList(std::vector<std::pair<int, glm::ivec3>>& lights);
+
+		DirtyRegion m_DirtyVoxels;
+		DirtyRegion m_DirtyVoxelsInDistanceField; // Uploaded by FlushEdits() but left out of the distance field update
+		EditJournal m_Journal;
+		LazyWorldLoader* m_LazyLoader = nullptr;
+		WorldFileLayout m_FileLayout;
+
+		std::shared_ptr<const WorldSnapshot> m_Snapshot; // Only accessed with std::atomic_load/atomic_store
+		uint64_t m_SnapshotEpoch = 0;
+		std::vector<uint8_t> m_UploadBuffer;
+		bool m_WideBlockIDs = false;
+
+		BrickPool m_BrickPool;
+		bool m_UseBrickPool = false;
+		VoxelStatePool m_StatePool;
+		PackedVoxelVolume m_PackedVolume;
+
+		DistanceField m_DistanceField; // Cpu copy of m_DistanceFieldTexture
+		std::vector<DirtyBox> m_DistanceFieldRegions;
+		std::vector<DirtyBox> m_ShiftBoundaries; // Next to the side the window moved away from, the distance field has to be updated there
+
+		bool m_Streamed = false;
+		glm::ivec3 m_VolumeOffset = glm::ivec3(0);
+		size_t m_UploadedBytes = 0;
+
+		DirectionalDistanceField m_DirectionalDistanceField; // Cpu copy of m_DirectionalDistanceTexture
+		Texture3D m_DirectionalDistanceTexture; // RGBA8UI
+		std::vector<DirtyBox> m_DirectionalDistanceRegions;
+
+		VoxelLOD m_VoxelLOD; // Cpu copy of m_VoxelLODTexture
+		Texture3D m_VoxelLODTexture; // One mip per level, same format as m_DataTexture
+		std::vector<DirtyBox> m_VoxelLODRegions;
+
+		glm::ivec3 m_LightChunkGridSize = glm::ivec3(0);
 		bool m_Buffered = false;
-		uint8_t m_CurrentlyHeldBlock = 1;
+		uint16_t m_CurrentlyHeldBlock = 1;
 
 		GLClasses::ComputeShader m_DistanceShaderX;
 		GLClasses::ComputeShader m_DistanceShaderY;
@@ -0,0 +1,238 @@
+#include "WorldAutosaver.h"
+
+#include "World.h"
+#include "WorldFileHandler.h"
+#include "ChunkCodec.h"
+
+VoxelRT::WorldAutosaver::~WorldAutosaver()
+{
+	Stop();
+}
+
+void VoxelRT::WorldAutosaver::Start(const std::string& world_name, float interval_seconds)
+{
+	Stop();
+
+	m_Name = world_name;
+	m_Interval = interval_seconds;
+	m_Stop = false;
+	m_Saving = false;
+	m_Saved.reset();
+	m_Encoded.clear();
+	m_Stale.clear();
+	m_Stats = WorldAutosaverStats();
+	m_Timer.Start();
+
+	m_Worker = std::thread(&WorldAutosaver::WorkerThread, this);
+}
+
+void VoxelRT::WorldAutosaver::Stop()
+{
+	if (!m_Worker.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Stop = true;
+	}
+
+	m_JobCondition.notify_all();
+	m_Worker.join();
+}
+
+void VoxelRT::WorldAutosaver::Update(World* world)
+{
+	if (!IsRunning() || m_Timer.End() < m_Interval * 1000.0f)
+	{
+		return;
+	}
+
+	Request(world);
+}
+
+bool VoxelRT::WorldAutosaver::Request(World* world)
+{
+	if (!IsRunning() || world->IsLoading() || world->IsStreamed() || IsSaving())
+	{
+		return false;
+	}
+
+	Blocks::Timer RequestTimer;
+	RequestTimer.Start();
+
+	// The frame publishes one already, this only costs something if the world was written to since
+	world->PublishSnapshot();
+
+	std::unique_ptr<Job> NewJob = std::make_unique<Job>();
+	NewJob->Snapshot = world->AcquireSnapshot();
+	NewJob->Layout = &world->GetFileLayout();
+	NewJob->EmissiveBlocks = world->m_WorldData.GetSummary().GetEmissiveBlocks();
+	GetWorldFileBlockNames(NewJob->BlockNames);
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Job = std::move(NewJob);
+		m_Saving = true;
+	}
+
+	m_JobCondition.notify_one();
+	m_Stats.LastRequestTime = RequestTimer.End();
+	m_Timer.Start();
+
+	return true;
+}
+
+void VoxelRT::WorldAutosaver::Wait()
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_DoneCondition.wait(Lock, [this] { return !m_Saving; });
+}
+
+bool VoxelRT::WorldAutosaver::IsSaving()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	return m_Saving;
+}
+
+void VoxelRT::WorldAutosaver::WorkerThread()
+{
+	while (true)
+	{
+		std::unique_ptr<Job> Current;
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_JobCondition.wait(Lock, [this] { return m_Stop || m_Job; });
+
+			// A save that was requested is still written
+			if (!m_Job)
+			{
+				return;
+			}
+
+			Current = std::move(m_Job);
+		}
+
+		Save(*Current);
+
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_Saving = false;
+		}
+
+		m_DoneCondition.notify_all();
+	}
+}
+
+const std::vector<uint8_t>& VoxelRT::WorldAutosaver::GetEncodedChunk(const WorldSnapshot& snapshot, int index)
+{
+	if (m_Stale[index])
+	{
+		m_Encoded[index].clear();
+		ChunkCodec::Encode(snapshot.GetChunk(index), m_Encoded[index]);
+		m_Summary.Rebuild(index, snapshot.GetChunk(index));
+		m_Stale[index] = 0;
+		m_Stats.EncodedChunks++;
+	}
+
+	return m_Encoded[index];
+}
+
+void VoxelRT::WorldAutosaver::Save(Job& job)
+{
+	Blocks::Timer WriteTimer;
+	WriteTimer.Start();
+
+	const WorldSnapshot& Snapshot = *job.Snapshot;
+	const int ChunkCount = Snapshot.GetChunkCount();
+	const glm::ivec3& Dimensions = Snapshot.GetDimensions();
+	WorldFileLayout& Layout = *job.Layout;
+
+	// Everything is stale after a resize or when the emissive blocks changed (the summaries depend on them)
+	std::vector<int> Changed;
+	const bool Rebuild = !m_Saved || m_Saved->GetDimensions() != Dimensions || (int)m_Encoded.size() != ChunkCount;
+	const bool NewLights = m_Summary.SetEmissiveBlocks(job.EmissiveBlocks);
+
+	if (Rebuild || NewLights)
+	{
+		m_Encoded.assign(ChunkCount, std::vector<uint8_t>());
+		m_Stale.assign(ChunkCount, 1);
+		m_Summary.Resize(ChunkCount);
+	}
+
+	else
+	{
+		Snapshot.GetChangedChunks(*m_Saved, Changed);
+
+		if (Changed.empty())
+		{
+			m_Saved = job.Snapshot;
+			m_Stats.SkippedSaves++;
+			return;
+		}
+
+		for (int i : Changed)
+		{
+			m_Stale[i] = 1;
+		}
+	}
+
+	const size_t EncodedBefore = m_Stats.EncodedChunks;
+
+	// The chunks the file doesn't have yet are appended to it, unless it has too much garbage
+	const int Appended = AppendWorldFileChanges(Snapshot, m_Name, job.BlockNames, Layout, [&](const std::vector<int>& chunks, std::vector<const std::vector<uint8_t>*>& encoded) {
+		for (int i : chunks)
+		{
+			encoded.push_back(&GetEncodedChunk(Snapshot, i));
+		}
+	});
+
+	// SaveWorld() wrote them already
+	if (Appended == 0)
+	{
+		m_Saved = job.Snapshot;
+		m_Stats.SkippedSaves++;
+		return;
+	}
+
+	if (Appended > 0)
+	{
+		m_Saved = job.Snapshot;
+		m_Stats.Saves++;
+		m_Stats.AppendedSaves++;
+		m_Stats.LastWriteTime = WriteTimer.End();
+		m_Stats.LastFileSize = (size_t)Layout.Size;
+
+		std::cout << "\n\n" << "AUTOSAVED WORLD (" << Appended << " chunks appended, " << m_Stats.LastWriteTime << " ms)" << "\n\n";
+		return;
+	}
+
+	for (int i = 0; i < ChunkCount; i++)
+	{
+		GetEncodedChunk(Snapshot, i);
+	}
+
+	WorldFileContents Contents;
+	GetWorldFileContents(Snapshot, job.BlockNames, Contents);
+	Contents.Chunks = &m_Encoded;
+	Contents.Summary = &m_Summary;
+
+	// The layout and the snapshot of the last save are left as they were, the next save compares the chunks to them again
+	if (!WriteWorldFile(m_Name, Contents, &Layout))
+	{
+		m_Stats.FailedSaves++;
+		std::cout << "\n\n" << "COULD NOT AUTOSAVE WORLD" << "\n\n";
+		return;
+	}
+
+	m_Saved = job.Snapshot;
+	SetWorldFileVersions(Snapshot, Layout);
+
+	m_Stats.Saves++;
+	m_Stats.LastWriteTime = WriteTimer.End();
+	m_Stats.LastFileSize = (size_t)Layout.Size;
+
+	std::cout << "\n\n" << "AUTOSAVED WORLD (" << m_Stats.EncodedChunks - EncodedBefore << " of " << ChunkCount << " chunks encoded, " << m_Stats.LastWriteTime << " ms)" << "\n\n";
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "WorldSnapshot.h"
+#include "ChunkSummary.h"
+#include "WorldFileLayout.h"
+#include "Utils/Timer.h"
+
+namespace VoxelRT
+{
+	class World;
+
+	struct WorldAutosaverStats
+	{
+		size_t Saves = 0; // Files written or appended to
+		size_t AppendedSaves = 0; // Only appended the chunks that changed (see WorldFileLayout.h)
+		size_t SkippedSaves = 0; // Nothing changed since the previous one
+		size_t FailedSaves = 0;
+		size_t EncodedChunks = 0; // Since Start()
+		float LastRequestTime = 0.0f; // Main thread, ms
+		float LastWriteTime = 0.0f; // Worker, ms
+		size_t LastFileSize = 0;
+	};
+
+	// Saves the world every few seconds on a worker thread, the main thread only hands it the current snapshot
+	// (World::PublishSnapshot(), which the frame already takes) and a copy of the block names.
+	//
+	// Saves append the chunks whose version isn't the one in the file to it (the world's WorldFileLayout, shared with
+	// SaveWorld()), the file is only written entirely by the first save of a world that has no layout or once it has too
+	// much garbage. The worker keeps an encoded copy of every chunk and its summary for those, along with the snapshot
+	// they're from : the chunks that changed since (WorldSnapshot::GetChangedChunks()) are stale and only encoded again
+	// when a save needs them. An entire file goes through WriteWorldFile() (a temporary file that replaces the save once
+	// it is complete), an interrupted append leaves a record the loaders ignore. The autosaves don't cache the distance
+	// field, it isn't part of the snapshots.
+	//
+	// Keeping the previous snapshot costs the chunks the world wrote to since, they are copied on write.
+
+	class WorldAutosaver
+	{
+	public :
+
+		~WorldAutosaver();
+
+		void Start(const std::string& world_name, float interval_seconds);
+
+		// Waits for the save in flight, if any
+		void Stop();
+
+		// Once per frame, after World::PublishSnapshot() : hands the snapshot to the worker every interval, unless the
+		// previous save is still being written. Lazily loaded worlds (World::IsLoading()) aren't saved until they're
+		// complete, their snapshots are missing chunks
+		void Update(World* world);
+
+		// Hands the snapshot to the worker right away, returns false if a save is already in flight
+		bool Request(World* world);
+
+		// Blocks until the save in flight is written, SaveWorld() has to wait for it (both write the same file and layout)
+		void Wait();
+
+		bool IsSaving();
+		inline bool IsRunning() const noexcept { return m_Worker.joinable(); }
+		inline void SetInterval(float interval_seconds) noexcept { m_Interval = interval_seconds; }
+
+		// Written by the worker, read it when no save is in flight (Wait())
+		inline const WorldAutosaverStats& GetStats() const noexcept { return m_Stats; }
+
+	private :
+
+		struct Job
+		{
+			std::shared_ptr<const WorldSnapshot> Snapshot;
+			std::vector<std::string> BlockNames;
+			std::vector<uint16_t> EmissiveBlocks;
+			WorldFileLayout* Layout = nullptr; // Of the world, nothing else touches it until the save is written
+		};
+
+		void WorkerThread();
+		void Save(Job& job);
+
+		// Encodes the chunk and rebuilds its summary if it is stale
+		const std::vector<uint8_t>& GetEncodedChunk(const WorldSnapshot& snapshot, int index);
+
+		std::string m_Name;
+		float m_Interval = 60.0f;
+		Blocks::Timer m_Timer; // Since the last request
+
+		std::thread m_Worker;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobCondition;
+		std::condition_variable m_DoneCondition;
+		std::unique_ptr<Job> m_Job; // Waiting for the worker
+		bool m_Saving = false; // Queued or being written
+		bool m_Stop = false;
+
+		// Worker only
+		std::shared_ptr<const WorldSnapshot> m_Saved;
+		std::vector<std::vector<uint8_t>> m_Encoded;
+		std::vector<uint8_t> m_Stale; // The encoded copy and the summary of the chunk are older than m_Saved
+		ChunkSummary m_Summary;
+		WorldAutosaverStats m_Stats;
+	};
+}
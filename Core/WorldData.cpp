@@ -0,0 +1,710 @@
+#include "WorldData.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+
+#include "ParallelFor.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static uint8_t GetBitsForPaletteSize(size_t size)
+{
+	if (size <= 1) { return 0; }
+	if (size <= 2) { return 1; }
+	if (size <= 4) { return 2; }
+	if (size <= 16) { return 4; }
+	if (size <= 256) { return 8; }
+	return 16;
+}
+
+VoxelRT::Block VoxelRT::VoxelChunk::SetBlock(int idx, Block block)
+{
+	const uint32_t current = GetPaletteIndex(idx);
+	const Block previous = m_Palette[current];
+
+	if (previous.block == block.block)
+	{
+		return previous;
+	}
+
+	// Find the palette entry for this block, or reuse an empty one
+	int target = -1;
+	int free_slot = -1;
+
+	for (int i = 0; i < (int)m_Palette.size(); i++)
+	{
+		if (m_RefCounts[i] > 0 && m_Palette[i].block == block.block)
+		{
+			target = i;
+			break;
+		}
+
+		if (m_RefCounts[i] == 0 && free_slot < 0)
+		{
+			free_slot = i;
+		}
+	}
+
+	if (target < 0)
+	{
+		if (free_slot >= 0)
+		{
+			target = free_slot;
+			m_Palette[target] = block;
+		}
+
+		else
+		{
+			target = (int)m_Palette.size();
+			m_Palette.push_back(block);
+			m_RefCounts.push_back(0);
+
+			uint8_t bits = GetBitsForPaletteSize(m_Palette.size());
+
+			if (bits != m_BitsPerIndex)
+			{
+				Repack(bits);
+			}
+		}
+	}
+
+	m_RefCounts[current]--;
+	m_RefCounts[target]++;
+
+	if (m_RefCounts[target] == CHUNK_VOLUME)
+	{
+		Fill(block);
+		return previous;
+	}
+
+	SetPaletteIndex(idx, target);
+	return previous;
+}
+
+void VoxelRT::VoxelChunk::Fill(Block block)
+{
+	m_Palette.clear();
+	m_RefCounts.clear();
+	m_Indices.clear();
+	m_Indices.shrink_to_fit();
+	m_Palette.push_back(block);
+	m_RefCounts.push_back(CHUNK_VOLUME);
+	m_BitsPerIndex = 0;
+}
+
+void VoxelRT::VoxelChunk::Repack(uint8_t bits)
+{
+	std::vector<uint64_t> old_indices = std::move(m_Indices);
+	const uint8_t old_bits = m_BitsPerIndex;
+
+	m_Indices.assign((CHUNK_VOLUME * bits + 63) / 64, 0);
+	m_BitsPerIndex = bits;
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		uint32_t v = 0;
+
+		if (old_bits > 0)
+		{
+			const uint32_t bit = i * old_bits;
+			v = (uint32_t)((old_indices[bit >> 6] >> (bit & 63)) & ((1ull << old_bits) - 1));
+		}
+
+		SetPaletteIndex(i, v);
+	}
+}
+
+void VoxelRT::VoxelChunk::Compact()
+{
+	if (m_BitsPerIndex == 0)
+	{
+		return;
+	}
+
+	// Build the remap table, dropping entries that are no longer referenced
+	std::vector<uint32_t> remap(m_Palette.size(), 0);
+	std::vector<Block> palette;
+	std::vector<uint16_t> refcounts;
+
+	for (int i = 0; i < (int)m_Palette.size(); i++)
+	{
+		if (m_RefCounts[i] > 0)
+		{
+			remap[i] = (uint32_t)palette.size();
+			palette.push_back(m_Palette[i]);
+			refcounts.push_back(m_RefCounts[i]);
+		}
+	}
+
+	if (palette.size() == m_Palette.size())
+	{
+		return;
+	}
+
+	if (palette.size() == 1)
+	{
+		Fill(palette[0]);
+		return;
+	}
+
+	std::vector<uint32_t> indices(CHUNK_VOLUME);
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		indices[i] = remap[GetPaletteIndex(i)];
+	}
+
+	m_Palette = std::move(palette);
+	m_RefCounts = std::move(refcounts);
+	m_BitsPerIndex = GetBitsForPaletteSize(m_Palette.size());
+	m_Indices.assign((CHUNK_VOLUME * m_BitsPerIndex + 63) / 64, 0);
+	m_Indices.shrink_to_fit();
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		SetPaletteIndex(i, indices[i]);
+	}
+}
+
+void VoxelRT::VoxelChunk::Assign(const std::vector<Block>& palette, const uint16_t* indices)
+{
+	if (palette.size() <= 1)
+	{
+		Fill(palette.empty() ? Block{ 0 } : palette[0]);
+		return;
+	}
+
+	m_Palette = palette;
+	m_RefCounts.assign(palette.size(), 0);
+	m_BitsPerIndex = GetBitsForPaletteSize(palette.size());
+	m_Indices.assign((CHUNK_VOLUME * m_BitsPerIndex + 63) / 64, 0);
+
+	for (int i = 0; i < CHUNK_VOLUME; i++)
+	{
+		m_RefCounts[indices[i]]++;
+		SetPaletteIndex(i, indices[i]);
+	}
+
+	Compact();
+}
+
+// Gathers every other bit of the word (bits 0, 2, 4...) into its low 32 bits
+static uint64_t CompactEvenBits(uint64_t v)
+{
+	v &= 0x5555555555555555ull;
+	v = (v | (v >> 1)) & 0x3333333333333333ull;
+	v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+	v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+	v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+	return (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+}
+
+// Bit k of the result is set if the 2 bit field k of the word has a value whose flag is set
+static uint64_t Match2BitFields(uint64_t word, const uint8_t* flags)
+{
+	uint64_t Match = 0;
+
+	for (uint64_t v = 0; v < 4; v++)
+	{
+		if (flags[v])
+		{
+			const uint64_t x = word ^ (v * 0x5555555555555555ull);
+			Match |= ~(x | (x >> 1)) & 0x5555555555555555ull;
+		}
+	}
+
+	return CompactEvenBits(Match);
+}
+
+void VoxelRT::VoxelChunk::GetPaletteMask(const uint8_t* flags, uint64_t* mask) const noexcept
+{
+	const int Words = CHUNK_VOLUME / 64;
+
+	if (m_BitsPerIndex == 0)
+	{
+		std::fill(mask, mask + Words, flags[0] ? ~0ull : 0ull);
+		return;
+	}
+
+	// The packed indices already are a mask, or close to one
+	if (m_BitsPerIndex == 1)
+	{
+		const uint64_t Zero = flags[0] ? ~0ull : 0ull;
+		const uint64_t One = flags[1] ? ~0ull : 0ull;
+
+		for (int w = 0; w < Words; w++)
+		{
+			mask[w] = (~m_Indices[w] & Zero) | (m_Indices[w] & One);
+		}
+
+		return;
+	}
+
+	if (m_BitsPerIndex == 2)
+	{
+		for (int w = 0; w < Words; w++)
+		{
+			mask[w] = Match2BitFields(m_Indices[w * 2], flags) | (Match2BitFields(m_Indices[w * 2 + 1], flags) << 32);
+		}
+
+		return;
+	}
+
+#ifdef __AVX2__
+	// 4 bits : the flags of the 16 entries fit in a shuffle table, 64 voxels (32 bytes) per iteration
+	if (m_BitsPerIndex == 4)
+	{
+		const __m256i Table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)flags));
+		const __m256i Nibble = _mm256_set1_epi8(0x0F);
+
+		for (int w = 0; w < Words; w++)
+		{
+			const __m256i v = _mm256_loadu_si256((const __m256i*)(m_Indices.data() + w * 4));
+			const __m256i Even = _mm256_shuffle_epi8(Table, _mm256_and_si256(v, Nibble));
+			const __m256i Odd = _mm256_shuffle_epi8(Table, _mm256_and_si256(_mm256_srli_epi16(v, 4), Nibble));
+
+			// Voxels 0-15 and 32-47, then 16-31 and 48-63
+			const __m256i Low = _mm256_unpacklo_epi8(Even, Odd);
+			const __m256i High = _mm256_unpackhi_epi8(Even, Odd);
+			const uint32_t First = (uint32_t)_mm256_movemask_epi8(_mm256_permute2x128_si256(Low, High, 0x20));
+			const uint32_t Second = (uint32_t)_mm256_movemask_epi8(_mm256_permute2x128_si256(Low, High, 0x31));
+			mask[w] = (uint64_t)First | ((uint64_t)Second << 32);
+		}
+
+		return;
+	}
+
+	// 8 bits : compares against the entries that are set, or the ones that aren't if there are fewer of them (the
+	// solid mask only has to compare against air), 32 voxels per compare
+	if (m_BitsPerIndex == 8)
+	{
+		uint8_t Set[8], Clear[8];
+		int SetCount = 0, ClearCount = 0;
+
+		for (int i = 0; i < (int)m_Palette.size(); i++)
+		{
+			if (flags[i] && SetCount < 8) { Set[SetCount] = (uint8_t)i; }
+			if (!flags[i] && ClearCount < 8) { Clear[ClearCount] = (uint8_t)i; }
+			SetCount += flags[i] ? 1 : 0;
+			ClearCount += flags[i] ? 0 : 1;
+		}
+
+		if (SetCount <= 8 || ClearCount <= 8)
+		{
+			const bool Invert = SetCount > ClearCount;
+			const uint8_t* Values = Invert ? Clear : Set;
+			const int Count = Invert ? ClearCount : SetCount;
+			const uint8_t* Bytes = (const uint8_t*)m_Indices.data();
+
+			for (int w = 0; w < Words; w++)
+			{
+				const __m256i a = _mm256_loadu_si256((const __m256i*)(Bytes + w * 64));
+				const __m256i b = _mm256_loadu_si256((const __m256i*)(Bytes + w * 64 + 32));
+				__m256i MatchA = _mm256_setzero_si256();
+				__m256i MatchB = _mm256_setzero_si256();
+
+				for (int k = 0; k < Count; k++)
+				{
+					const __m256i Value = _mm256_set1_epi8((char)Values[k]);
+					MatchA = _mm256_or_si256(MatchA, _mm256_cmpeq_epi8(a, Value));
+					MatchB = _mm256_or_si256(MatchB, _mm256_cmpeq_epi8(b, Value));
+				}
+
+				const uint64_t Match = (uint64_t)(uint32_t)_mm256_movemask_epi8(MatchA) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(MatchB) << 32);
+				mask[w] = Invert ? ~Match : Match;
+			}
+
+			return;
+		}
+	}
+#endif
+
+	for (int w = 0; w < Words; w++)
+	{
+		uint64_t Word = 0;
+
+		for (int i = 0; i < 64; i++)
+		{
+			Word |= (uint64_t)(flags[GetPaletteIndex(w * 64 + i)] & 1) << i;
+		}
+
+		mask[w] = Word;
+	}
+}
+
+size_t VoxelRT::VoxelChunk::GetMemoryUsage() const noexcept
+{
+	return sizeof(VoxelChunk) +
+		m_Palette.capacity() * sizeof(Block) +
+		m_RefCounts.capacity() * sizeof(uint16_t) +
+		m_Indices.capacity() * sizeof(uint64_t);
+}
+
+VoxelRT::WorldData::WorldData(const glm::ivec3& dimensions)
+{
+	Resize(dimensions);
+}
+
+void VoxelRT::WorldData::Resize(const glm::ivec3& dimensions)
+{
+	if (dimensions.x <= 0 || dimensions.y <= 0 || dimensions.z <= 0 ||
+		dimensions.x % CHUNK_SIZE != 0 || dimensions.y % CHUNK_SIZE != 0 || dimensions.z % CHUNK_SIZE != 0)
+	{
+		throw "WorldData::Resize() -> World dimensions have to be positive multiples of the chunk size!";
+	}
+
+	m_Dimensions = dimensions;
+	m_Origin = glm::ivec3(0);
+	m_ChunksX = dimensions.x / CHUNK_SIZE;
+	m_ChunksY = dimensions.y / CHUNK_SIZE;
+	m_ChunksZ = dimensions.z / CHUNK_SIZE;
+	m_Chunks.assign(m_ChunksX * m_ChunksY * m_ChunksZ, std::make_shared<VoxelChunk>());
+	m_Chunks.shrink_to_fit();
+
+	// Versions never go back, a snapshot of the world before the resize mustn't match any chunk of the new one
+	const uint32_t Version = m_ChunkVersions.empty() ? 0 : *std::max_element(m_ChunkVersions.begin(), m_ChunkVersions.end()) + 1;
+	m_ChunkVersions.assign(m_Chunks.size(), Version);
+	m_ChunkVersions.shrink_to_fit();
+	m_Occupancy.Resize(dimensions);
+	m_Summary.Resize((int)m_Chunks.size());
+	m_States.Resize(dimensions);
+}
+
+void VoxelRT::WorldData::SetChunk(int index, VoxelChunk chunk, std::vector<uint32_t> states)
+{
+	const glm::ivec3 Origin = GetChunkPosition(index);
+
+	// The occupancy words of a brick are in the same order as the voxels of a chunk, the solid mask is copied as is
+	// and gives the summary its layers
+	const bool Uniform = chunk.IsUniform();
+	uint64_t Solid[CHUNK_VOLUME / 64];
+
+	if (Uniform)
+	{
+		m_Occupancy.FillBrick(Origin.x, Origin.y, Origin.z, chunk.GetUniformBlock().block != 0);
+	}
+
+	else
+	{
+		chunk.GetVoxelMask([](Block block) { return block.block != 0; }, Solid);
+		m_Occupancy.SetBrick(Origin.x, Origin.y, Origin.z, Solid);
+	}
+
+	if (!states.empty() || !m_States.IsEmpty())
+	{
+		m_States.SetChunkEntries(index, std::move(states));
+	}
+
+	m_Chunks[index] = std::make_shared<VoxelChunk>(std::move(chunk));
+	m_ChunkVersions[index]++;
+
+	if (Uniform)
+	{
+		m_Summary.Rebuild(index, *m_Chunks[index]);
+	}
+
+	else
+	{
+		m_Summary.Rebuild(index, *m_Chunks[index], Solid);
+	}
+}
+
+void VoxelRT::WorldData::ShiftChunks(const glm::ivec3& delta)
+{
+	const glm::ivec3 Chunks = glm::ivec3(m_ChunksX, m_ChunksY, m_ChunksZ);
+	std::vector<std::shared_ptr<VoxelChunk>> Shifted(m_Chunks.size(), std::make_shared<VoxelChunk>());
+	std::vector<uint32_t> Versions(m_ChunkVersions.size());
+
+	// The air chunks get a version no chunk had before
+	const uint32_t NewVersion = *std::max_element(m_ChunkVersions.begin(), m_ChunkVersions.end()) + 1;
+
+	for (int z = 0; z < m_ChunksZ; z++)
+	{
+		for (int y = 0; y < m_ChunksY; y++)
+		{
+			for (int x = 0; x < m_ChunksX; x++)
+			{
+				const glm::ivec3 Source = glm::ivec3(x, y, z) + delta;
+				const int Index = GetChunkIndex(x, y, z);
+
+				if (glm::any(glm::lessThan(Source, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(Source, Chunks)))
+				{
+					Versions[Index] = NewVersion;
+					continue;
+				}
+
+				const int SourceIndex = GetChunkIndex(Source.x, Source.y, Source.z);
+				Shifted[Index] = std::move(m_Chunks[SourceIndex]);
+				Versions[Index] = m_ChunkVersions[SourceIndex];
+			}
+		}
+	}
+
+	m_Chunks = std::move(Shifted);
+	m_ChunkVersions = std::move(Versions);
+	m_Occupancy.ShiftBricks(delta);
+	m_Summary.Shift(Chunks, delta);
+	m_States.ShiftChunks(delta);
+	m_Origin += delta * CHUNK_SIZE;
+}
+
+void VoxelRT::WorldData::Clear()
+{
+	m_Chunks.assign(m_Chunks.size(), std::make_shared<VoxelChunk>());
+
+	for (auto& e : m_ChunkVersions)
+	{
+		e++;
+	}
+
+	m_Occupancy.Clear();
+	m_Summary.Clear();
+	m_States.Clear();
+}
+
+void VoxelRT::WorldData::Compact()
+{
+	for (int i = 0; i < (int)m_Chunks.size(); i++)
+	{
+		// Uniform chunks are as compact as they get (and most of them are shared)
+		if (!m_Chunks[i]->IsUniform())
+		{
+			GetWritableChunk(i).Compact();
+		}
+	}
+}
+
+void VoxelRT::WorldData::FillBox(const glm::ivec3& min, const glm::ivec3& max, Block block, BlockState state)
+{
+	const glm::ivec3 Min = glm::max(min, glm::ivec3(0));
+	const glm::ivec3 Max = glm::min(max, m_Dimensions);
+
+	if (glm::any(glm::greaterThanEqual(Min, Max)))
+	{
+		return;
+	}
+
+	const glm::ivec3 FirstChunk = Min / CHUNK_SIZE;
+	const glm::ivec3 LastChunk = (Max - 1) / CHUNK_SIZE;
+
+	for (int cz = FirstChunk.z; cz <= LastChunk.z; cz++)
+	{
+		for (int cy = FirstChunk.y; cy <= LastChunk.y; cy++)
+		{
+			for (int cx = FirstChunk.x; cx <= LastChunk.x; cx++)
+			{
+				const glm::ivec3 ChunkMin = glm::ivec3(cx, cy, cz) * CHUNK_SIZE;
+				const glm::ivec3 Lo = glm::max(Min, ChunkMin);
+				const glm::ivec3 Hi = glm::min(Max, ChunkMin + glm::ivec3(CHUNK_SIZE));
+
+				if (Lo == ChunkMin && Hi == ChunkMin + glm::ivec3(CHUNK_SIZE))
+				{
+					const int cidx = cx + cy * m_ChunksX + cz * m_ChunksX * m_ChunksY;
+					m_Chunks[cidx] = std::make_shared<VoxelChunk>();
+					m_Chunks[cidx]->Fill(block);
+					m_ChunkVersions[cidx]++;
+					m_Occupancy.FillBrick(ChunkMin.x, ChunkMin.y, ChunkMin.z, block.block != 0);
+					m_Summary.Rebuild(cidx, *m_Chunks[cidx]);
+
+					if (state != 0 || !m_States.IsEmpty())
+					{
+						m_States.FillChunk(m_States.GetChunkIndex(ChunkMin.x, ChunkMin.y, ChunkMin.z), state);
+					}
+
+					continue;
+				}
+
+				for (int z = Lo.z; z < Hi.z; z++)
+				{
+					for (int y = Lo.y; y < Hi.y; y++)
+					{
+						for (int x = Lo.x; x < Hi.x; x++)
+						{
+							SetBlock(x, y, z, block);
+
+							if (state != 0)
+							{
+								m_States.Set(x, y, z, state);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void VoxelRT::WorldData::SetEmissiveBlocks(const std::vector<uint16_t>& ids)
+{
+	if (m_Summary.SetEmissiveBlocks(ids))
+	{
+		RebuildSummary();
+	}
+}
+
+void VoxelRT::WorldData::RebuildSummary()
+{
+	// The summary of a chunk only depends on the chunk
+	ParallelFor((int)m_Chunks.size(), std::max(1, (int)std::thread::hardware_concurrency()), [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+		{
+			m_Summary.Rebuild(i, *m_Chunks[i]);
+		}
+	});
+}
+
+bool VoxelRT::WorldData::ReadSummary(FILE* file)
+{
+	if (m_Summary.Read(file))
+	{
+		return true;
+	}
+
+	RebuildSummary();
+	return false;
+}
+
+void VoxelRT::WorldData::GetLights(const glm::ivec3& min, const glm::ivec3& max, std::vector<glm::ivec3>& lights) const
+{
+	const glm::ivec3 Min = glm::max(min, glm::ivec3(0));
+	const glm::ivec3 Max = glm::min(max, m_Dimensions);
+
+	if (glm::any(glm::greaterThanEqual(Min, Max)))
+	{
+		return;
+	}
+
+	const glm::ivec3 FirstChunk = Min / CHUNK_SIZE;
+	const glm::ivec3 LastChunk = (Max - 1) / CHUNK_SIZE;
+
+	for (int cz = FirstChunk.z; cz <= LastChunk.z; cz++)
+	{
+		for (int cy = FirstChunk.y; cy <= LastChunk.y; cy++)
+		{
+			for (int cx = FirstChunk.x; cx <= LastChunk.x; cx++)
+			{
+				const glm::ivec3 ChunkMin = glm::ivec3(cx, cy, cz) * CHUNK_SIZE;
+
+				for (uint16_t e : m_Summary.GetLights(GetChunkIndex(cx, cy, cz)))
+				{
+					const glm::ivec3 p = ChunkMin + ChunkSummary::GetLocalPosition(e);
+
+					if (glm::all(glm::greaterThanEqual(p, Min)) && glm::all(glm::lessThan(p, Max)))
+					{
+						lights.push_back(p);
+					}
+				}
+			}
+		}
+	}
+}
+
+int VoxelRT::WorldData::GetHighestSolid(int x, int z) const noexcept
+{
+	for (int cy = m_ChunksY - 1; cy >= 0; cy--)
+	{
+		int Lowest = 0, Highest = 0;
+
+		if (!m_Summary.GetSolidLayers(GetChunkIndex(x >> 4, cy, z >> 4), Lowest, Highest))
+		{
+			continue;
+		}
+
+		for (int y = cy * CHUNK_SIZE + Highest; y >= cy * CHUNK_SIZE + Lowest; y--)
+		{
+			if (IsSolid(x, y, z))
+			{
+				return y;
+			}
+		}
+	}
+
+	return -1;
+}
+
+template <typename T>
+static void ReadRegionImpl(const VoxelRT::WorldData& data, const glm::ivec3& origin, const glm::ivec3& size, T* output)
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			T* row = output + (y * size.x) + ((size_t)z * size.x * size.y);
+
+			for (int x = 0; x < size.x; x++)
+			{
+				row[x] = (T)data.GetBlock(origin.x + x, origin.y + y, origin.z + z).block;
+			}
+		}
+	}
+}
+
+template <typename T>
+static void WriteRegionImpl(VoxelRT::WorldData& data, const glm::ivec3& origin, const glm::ivec3& size, const T* input)
+{
+	for (int z = 0; z < size.z; z++)
+	{
+		for (int y = 0; y < size.y; y++)
+		{
+			const T* row = input + (y * size.x) + ((size_t)z * size.x * size.y);
+
+			for (int x = 0; x < size.x; x++)
+			{
+				data.SetBlock(origin.x + x, origin.y + y, origin.z + z, { (uint16_t)row[x] });
+			}
+		}
+	}
+}
+
+void VoxelRT::WorldData::ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint16_t* output) const
+{
+	ReadRegionImpl(*this, origin, size, output);
+}
+
+void VoxelRT::WorldData::ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const
+{
+	ReadRegionImpl(*this, origin, size, output);
+}
+
+void VoxelRT::WorldData::WriteRegion(const glm::ivec3& origin, const glm::ivec3& size, const uint16_t* input)
+{
+	WriteRegionImpl(*this, origin, size, input);
+}
+
+void VoxelRT::WorldData::WriteRegion(const glm::ivec3& origin, const glm::ivec3& size, const uint8_t* input)
+{
+	WriteRegionImpl(*this, origin, size, input);
+}
+
+size_t VoxelRT::WorldData::GetMemoryUsage() const noexcept
+{
+	size_t total = sizeof(WorldData) + m_Chunks.capacity() * sizeof(std::shared_ptr<VoxelChunk>);
+
+	// The chunks that are shared by several parts of the world (the air chunks of a new world) count once
+	std::unordered_set<const VoxelChunk*> Shared;
+
+	for (auto& e : m_Chunks)
+	{
+		if (e.use_count() == 1 || Shared.insert(e.get()).second)
+		{
+			total += e->GetMemoryUsage();
+		}
+	}
+
+	return total + m_ChunkVersions.capacity() * sizeof(uint32_t) + m_Occupancy.GetMemoryUsage() + m_Summary.GetMemoryUsage() + m_States.GetMemoryUsage();
+}
+
+int VoxelRT::WorldData::GetUniformChunkCount() const noexcept
+{
+	int count = 0;
+
+	for (auto& e : m_Chunks)
+	{
+		count += (int)e->IsUniform();
+	}
+
+	return count;
+}
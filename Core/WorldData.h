@@ -0,0 +1,315 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstring>
+#include <glm/glm.hpp>
+
+#include "Block.h"
+#include "Macros.h"
+#include "VoxelIndexing.h"
+#include "OccupancyMask.h"
+#include "VoxelStates.h"
+#include "ChunkSummary.h"
+
+namespace VoxelRT
+{
+	// Sparse chunked voxel storage
+	// The world is split into 16^3 chunks. A chunk that only contains a single block type (air, solid stone etc)
+	// collapses to a single palette entry, everything else stores a small palette and bit packed (1/2/4/8/16 bit) indices into it.
+	// Block ids are 16 bit but a chunk rarely has more than 16 distinct blocks, so most chunks stay at 4 bits per voxel or less.
+	// Voxels inside a chunk are stored in morton order (see VoxelIndexing.h)
+	//
+	// Chunks are reference counted and copied on write : a snapshot (see WorldSnapshot.h) only takes a reference to
+	// every chunk, the world copies a chunk the first time it writes to it while a snapshot still holds it. All the air
+	// chunks of a new world are the same chunk until they are written to.
+
+	const int CHUNK_SIZE = BRICK_SIZE;
+	const int CHUNK_VOLUME = BRICK_VOLUME;
+
+	class VoxelChunk
+	{
+	public :
+
+		VoxelChunk()
+		{
+			m_Palette.push_back({ 0 });
+			m_RefCounts.push_back(CHUNK_VOLUME);
+			m_BitsPerIndex = 0;
+		}
+
+		inline Block GetBlock(int idx) const noexcept
+		{
+			return m_Palette[GetPaletteIndex(idx)];
+		}
+
+		// Returns the block that was there
+		Block SetBlock(int idx, Block block);
+
+		// Fills the entire chunk with one block type
+		void Fill(Block block);
+
+		// Removes unused palette entries and shrinks the index width if possible
+		void Compact();
+
+		// Replaces the voxels, indices are CHUNK_VOLUME palette indices in morton order (for the save format, see
+		// ChunkCodec.h). Palette entries that no voxel uses are dropped
+		void Assign(const std::vector<Block>& palette, const uint16_t* indices);
+
+		// Raw palette access, the palette can have entries that no voxel uses anymore until the chunk is compacted
+		inline const std::vector<Block>& GetPalette() const noexcept { return m_Palette; }
+
+		inline uint32_t GetPaletteIndex(int idx) const noexcept
+		{
+			if (m_BitsPerIndex == 0) { return 0; }
+
+			const uint32_t bit = idx * m_BitsPerIndex;
+			const uint64_t mask = (1ull << m_BitsPerIndex) - 1;
+			return (uint32_t)((m_Indices[bit >> 6] >> (bit & 63)) & mask);
+		}
+
+		// The palette doubles as a histogram of the chunk : f(block, voxel count) for every block type in it
+		template <typename F>
+		void ForEachBlockType(F&& f) const
+		{
+			for (int i = 0; i < (int)m_Palette.size(); i++)
+			{
+				if (m_RefCounts[i] > 0)
+				{
+					f(m_Palette[i], (int)m_RefCounts[i]);
+				}
+			}
+		}
+
+		// 1 bit per voxel mask of the voxels whose block passes f(block), CHUNK_VOLUME / 64 words in morton order (the
+		// layout of the OccupancyMask words of a brick). f is called once per palette entry instead of once per voxel
+		template <typename F>
+		void GetVoxelMask(F&& f, uint64_t* mask) const
+		{
+			uint8_t Flags[256] = {};
+			const bool Wide = m_Palette.size() > 256;
+			std::vector<uint8_t> WideFlags(Wide ? m_Palette.size() : 0);
+
+			for (int i = 0; i < (int)m_Palette.size(); i++)
+			{
+				(Wide ? WideFlags[i] : Flags[i]) = f(m_Palette[i]) ? 0xFF : 0;
+			}
+
+			GetPaletteMask(Wide ? WideFlags.data() : Flags, mask);
+		}
+
+		inline bool IsUniform() const noexcept { return m_BitsPerIndex == 0; }
+		inline Block GetUniformBlock() const noexcept { return m_Palette[0]; }
+		size_t GetMemoryUsage() const noexcept;
+
+	private :
+
+		inline void SetPaletteIndex(int idx, uint32_t v) noexcept
+		{
+			const uint32_t bit = idx * m_BitsPerIndex;
+			const uint64_t mask = (1ull << m_BitsPerIndex) - 1;
+			uint64_t& word = m_Indices[bit >> 6];
+			word = (word & ~(mask << (bit & 63))) | ((uint64_t)v << (bit & 63));
+		}
+
+		void Repack(uint8_t bits);
+
+		// flags has a byte per palette entry (0xFF or 0), at least 256 of them for the chunks with 8 bit indices or less
+		void GetPaletteMask(const uint8_t* flags, uint64_t* mask) const noexcept;
+
+		std::vector<Block> m_Palette;
+		std::vector<uint16_t> m_RefCounts; // Number of voxels that reference each palette entry
+		std::vector<uint64_t> m_Indices;
+		uint8_t m_BitsPerIndex = 0; // 0 -> uniform chunk
+	};
+
+	class WorldData
+	{
+	public :
+
+		WorldData(const glm::ivec3& dimensions = glm::ivec3(DEFAULT_WORLD_SIZE_X, DEFAULT_WORLD_SIZE_Y, DEFAULT_WORLD_SIZE_Z));
+
+		inline Block GetBlock(int x, int y, int z) const noexcept
+		{
+			const int cidx = (x >> 4) + (y >> 4) * m_ChunksX + (z >> 4) * m_ChunksX * m_ChunksY;
+			return m_Chunks[cidx]->GetBlock(VoxelIndexing::GetBrickLocalIndex(x, y, z));
+		}
+
+		// Writes a stateless block, the state of the voxel (if it had one) is removed
+		inline void SetBlock(int x, int y, int z, Block block)
+		{
+			const int cidx = (x >> 4) + (y >> 4) * m_ChunksX + (z >> 4) * m_ChunksX * m_ChunksY;
+			const Block Previous = GetWritableChunk(cidx).SetBlock(VoxelIndexing::GetBrickLocalIndex(x, y, z), block);
+			m_ChunkVersions[cidx]++;
+
+			if (Previous.block != block.block)
+			{
+				m_Summary.Update(cidx, x, y, z, Previous.block, block.block);
+			}
+
+			m_Occupancy.Set(x, y, z, block.block != 0);
+
+			if (!m_States.IsEmpty())
+			{
+				m_States.Set(x, y, z, 0);
+			}
+		}
+
+		inline void SetBlock(int x, int y, int z, Block block, BlockState state)
+		{
+			SetBlock(x, y, z, block);
+			m_States.Set(x, y, z, state);
+		}
+
+		// Fills the box (max exclusive, clamped to the world) with one block and state
+		// Chunks the box covers entirely collapse to a uniform chunk without touching their voxels one by one
+		void FillBox(const glm::ivec3& min, const glm::ivec3& max, Block block, BlockState state = 0);
+
+		// Replaces an entire chunk (and the states of its voxels, sorted state table entries), for chunks that were built
+		// off the main thread (see ChunkStreamer.h)
+		// Chunks in different occupancy regions (OccupancyMask::REGION_SIZE) can be set from different threads as long as
+		// the world has no states, loading sets slices of regions in parallel
+		void SetChunk(int index, VoxelChunk chunk, std::vector<uint32_t> states = {});
+
+		// Moves the window the world is a part of by delta chunks : chunk p takes the blocks, states and version of chunk
+		// p + delta and the chunks that come from outside of the window are air. Nothing is regenerated, see World::ShiftWindow()
+		void ShiftChunks(const glm::ivec3& delta);
+
+		// Position of voxel 0 in the unbounded world, the window moves by whole chunks (only a streamed world moves)
+		inline const glm::ivec3& GetOrigin() const noexcept { return m_Origin; }
+
+		// The chunk containing the voxel
+		inline const VoxelChunk& GetChunk(int x, int y, int z) const noexcept
+		{
+			return *m_Chunks[(x >> 4) + (y >> 4) * m_ChunksX + (z >> 4) * m_ChunksX * m_ChunksY];
+		}
+
+		// Chunks are indexed x + y * X + z * X * Y (same as the state table)
+		inline const VoxelChunk& GetChunk(int index) const noexcept { return *m_Chunks[index]; }
+
+		// A reference to the chunk as it is now, the world never writes to it again (it writes to a copy instead)
+		inline std::shared_ptr<const VoxelChunk> ShareChunk(int index) const noexcept { return m_Chunks[index]; }
+
+		// Number of chunks that had to be copied because a snapshot still held them when they were written to
+		inline size_t GetCopyOnWriteCount() const noexcept { return m_CopyOnWriteCount; }
+
+		inline int GetChunkIndex(int chunk_x, int chunk_y, int chunk_z) const noexcept
+		{
+			return chunk_x + chunk_y * m_ChunksX + chunk_z * m_ChunksX * m_ChunksY;
+		}
+
+		// Position of the first voxel of the chunk
+		inline glm::ivec3 GetChunkPosition(int index) const noexcept
+		{
+			return glm::ivec3(index % m_ChunksX, (index / m_ChunksX) % m_ChunksY, index / (m_ChunksX * m_ChunksY)) * CHUNK_SIZE;
+		}
+
+		// Incremented every time a block or state of the chunk is written, snapshots (see WorldSnapshot.h) only copy the
+		// states of the chunks whose version changed since the previous one
+		inline uint32_t GetChunkVersion(int index) const noexcept { return m_ChunkVersions[index]; }
+
+		// Per voxel states (see VoxelStates.h), most voxels don't have one (0)
+		inline BlockState GetState(int x, int y, int z) const { return m_States.Get(x, y, z); }
+		inline void SetState(int x, int y, int z, BlockState state)
+		{
+			m_States.Set(x, y, z, state);
+			m_ChunkVersions[(x >> 4) + (y >> 4) * m_ChunksX + (z >> 4) * m_ChunksX * m_ChunksY]++;
+		}
+
+		inline const VoxelStateTable& GetStates() const noexcept { return m_States; }
+
+		// Cheaper than GetBlock() when only "solid or air" is needed
+		inline bool IsSolid(int x, int y, int z) const noexcept
+		{
+			return m_Occupancy.IsSolid(x, y, z);
+		}
+
+		inline const OccupancyMask& GetOccupancy() const noexcept { return m_Occupancy; }
+
+		// Per chunk solid layers and emissive voxels (see ChunkSummary.h)
+		inline const ChunkSummary& GetSummary() const noexcept { return m_Summary; }
+
+		// Sets the blocks that are lights (the emissive blocks of the block database) and rebuilds the lights of the
+		// summary if they changed
+		void SetEmissiveBlocks(const std::vector<uint16_t>& ids);
+
+		// Recomputes the summary of every chunk from the voxels, chunk level for the uniform ones
+		// The chunks are split between hardware_concurrency() threads
+		void RebuildSummary();
+
+		// Reads a summary written by ChunkSummary::Write() for the current blocks, the summary is rebuilt if the
+		// section doesn't match the world (returns false then)
+		bool ReadSummary(FILE* file);
+
+		// Appends the emissive voxels inside of the box (max exclusive), only the chunks with lights are visited
+		void GetLights(const glm::ivec3& min, const glm::ivec3& max, std::vector<glm::ivec3>& lights) const;
+
+		// Highest solid voxel of the column, -1 if there is none
+		// Walks the chunks of the column from the top and only looks at the voxels of the highest non empty one
+		int GetHighestSolid(int x, int z) const noexcept;
+
+		// Dimensions have to be multiples of CHUNK_SIZE, resizing clears the world and moves it back to the origin
+		void Resize(const glm::ivec3& dimensions);
+		inline const glm::ivec3& GetDimensions() const noexcept { return m_Dimensions; }
+
+		inline bool InBounds(int x, int y, int z) const noexcept
+		{
+			return x >= 0 && y >= 0 && z >= 0 && x < m_Dimensions.x && y < m_Dimensions.y && z < m_Dimensions.z;
+		}
+
+		// Resets every chunk to air
+		void Clear();
+
+		// Compacts all the chunk palettes (call after bulk writes like generation or loading)
+		void Compact();
+
+		// Copies a box of voxels to/from a linear (x + y * size.x + z * size.x * size.y) buffer
+		// Used for gpu uploads and the raw save format
+		void ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint16_t* output) const;
+		void WriteRegion(const glm::ivec3& origin, const glm::ivec3& size, const uint16_t* input);
+
+		// 8 bit versions, for the 8 bit gpu copies (every id fits in a byte) and the pre version 3 save files
+		// Ids above 255 are truncated
+		void ReadRegion(const glm::ivec3& origin, const glm::ivec3& size, uint8_t* output) const;
+		void WriteRegion(const glm::ivec3& origin, const glm::ivec3& size, const uint8_t* input);
+
+		// Memory used by the voxel data (including the states and the summary), in bytes
+		size_t GetMemoryUsage() const noexcept;
+		int GetUniformChunkCount() const noexcept;
+		int GetChunkCount() const noexcept { return (int)m_Chunks.size(); }
+
+	private :
+
+		inline VoxelChunk& GetWritableChunk(int index)
+		{
+			if (m_Chunks[index].use_count() > 1)
+			{
+				m_Chunks[index] = std::make_shared<VoxelChunk>(*m_Chunks[index]);
+				m_CopyOnWriteCount++;
+			}
+
+			else
+			{
+				// use_count() is a relaxed load, seeing 1 doesn't order the reads of the snapshot that just dropped the
+				// chunk (on the autosaver or another worker) before the writes that follow
+				std::atomic_thread_fence(std::memory_order_acquire);
+			}
+
+			return *m_Chunks[index];
+		}
+
+		std::vector<std::shared_ptr<VoxelChunk>> m_Chunks;
+		std::vector<uint32_t> m_ChunkVersions;
+		size_t m_CopyOnWriteCount = 0;
+		OccupancyMask m_Occupancy;
+		ChunkSummary m_Summary;
+		VoxelStateTable m_States;
+		glm::ivec3 m_Dimensions = glm::ivec3(0);
+		glm::ivec3 m_Origin = glm::ivec3(0);
+		int m_ChunksX = 0;
+		int m_ChunksY = 0;
+		int m_ChunksZ = 0;
+	};
+}
@@ -0,0 +1,330 @@
+#include "WorldEdit.h"
+
+#include "VolumetricFloodFill.h"
+
+VoxelRT::WorldEdit::~WorldEdit()
+{
+	if (IsPending() || m_Recording)
+	{
+		Commit();
+	}
+}
+
+bool VoxelRT::WorldEdit::Clamp(glm::ivec3& min, glm::ivec3& max) const
+{
+	min = glm::max(min, glm::ivec3(0));
+	max = glm::min(max, m_World->GetDimensions());
+	return glm::all(glm::lessThan(min, max));
+}
+
+VoxelRT::VoxelClipboard VoxelRT::WorldEdit::BeginRecord(const glm::ivec3& min, const glm::ivec3& max)
+{
+	// Every operation starts here, a lazily loaded world needs the chunks before they're written
+	m_World->LoadRegion(min, max);
+
+	EditJournal& Journal = m_World->GetJournal();
+
+	if (!Journal.IsRecording())
+	{
+		return VoxelClipboard();
+	}
+
+	if (!m_Recording)
+	{
+		Journal.BeginTransaction();
+		m_Recording = true;
+	}
+
+	return Copy(min, max);
+}
+
+void VoxelRT::WorldEdit::EndRecord(const VoxelClipboard& before, const glm::ivec3& min, const glm::ivec3& max)
+{
+	EditJournal& Journal = m_World->GetJournal();
+
+	if (!Journal.IsRecording() || before.Blocks.empty())
+	{
+		return;
+	}
+
+	const VoxelClipboard After = Copy(min, max);
+	const glm::ivec3& Dimensions = m_World->GetDimensions();
+
+	// Both state lists are sorted by index, walk them along with the voxels
+	auto OldState = before.States.begin();
+	auto NewState = After.States.begin();
+	uint32_t i = 0;
+
+	for (int z = min.z; z < max.z; z++)
+	{
+		for (int y = min.y; y < max.y; y++)
+		{
+			for (int x = min.x; x < max.x; x++, i++)
+			{
+				BlockState Old = 0, New = 0;
+
+				if (OldState != before.States.end() && OldState->first == i) { Old = OldState->second; ++OldState; }
+				if (NewState != After.States.end() && NewState->first == i) { New = NewState->second; ++NewState; }
+
+				Journal.Record(EditJournal::GetIndex(glm::ivec3(x, y, z), Dimensions), { before.Blocks[i] }, Old, { After.Blocks[i] }, New);
+			}
+		}
+	}
+}
+
+void VoxelRT::WorldEdit::FillBox(const glm::ivec3& min, const glm::ivec3& max, Block block, BlockState state)
+{
+	glm::ivec3 Min = min, Max = max;
+
+	if (!Clamp(Min, Max))
+	{
+		return;
+	}
+
+	const VoxelClipboard Before = BeginRecord(Min, Max);
+	m_World->m_WorldData.FillBox(Min, Max, block, state);
+	EndRecord(Before, Min, Max);
+	m_Touched.Add(Min, Max);
+}
+
+void VoxelRT::WorldEdit::FillSphere(const glm::vec3& center, float radius, Block block, BlockState state)
+{
+	glm::ivec3 Min = glm::ivec3(glm::floor(center - radius));
+	glm::ivec3 Max = glm::ivec3(glm::floor(center + radius)) + 1;
+
+	if (radius < 0.0f || !Clamp(Min, Max))
+	{
+		return;
+	}
+
+	WorldData& Data = m_World->m_WorldData;
+	const float RadiusSquared = radius * radius;
+	const VoxelClipboard Before = BeginRecord(Min, Max);
+
+	auto Inside = [&](const glm::ivec3& p)
+	{
+		const glm::vec3 d = glm::vec3(p) + 0.5f - center;
+		return glm::dot(d, d) <= RadiusSquared;
+	};
+
+	const glm::ivec3 FirstChunk = Min / CHUNK_SIZE;
+	const glm::ivec3 LastChunk = (Max - 1) / CHUNK_SIZE;
+
+	for (int cz = FirstChunk.z; cz <= LastChunk.z; cz++)
+	{
+		for (int cy = FirstChunk.y; cy <= LastChunk.y; cy++)
+		{
+			for (int cx = FirstChunk.x; cx <= LastChunk.x; cx++)
+			{
+				const glm::ivec3 ChunkMin = glm::ivec3(cx, cy, cz) * CHUNK_SIZE;
+				const glm::ivec3 ChunkMax = ChunkMin + glm::ivec3(CHUNK_SIZE);
+
+				// The sphere is convex, if the voxels on all 8 corners are inside then the whole chunk is
+				bool Covered = true;
+
+				for (int i = 0; i < 8 && Covered; i++)
+				{
+					Covered = Inside(glm::ivec3(i & 1 ? ChunkMax.x - 1 : ChunkMin.x, i & 2 ? ChunkMax.y - 1 : ChunkMin.y, i & 4 ? ChunkMax.z - 1 : ChunkMin.z));
+				}
+
+				if (Covered)
+				{
+					Data.FillBox(ChunkMin, ChunkMax, block, state);
+					continue;
+				}
+
+				const glm::ivec3 Lo = glm::max(Min, ChunkMin);
+				const glm::ivec3 Hi = glm::min(Max, ChunkMax);
+
+				for (int z = Lo.z; z < Hi.z; z++)
+				{
+					for (int y = Lo.y; y < Hi.y; y++)
+					{
+						for (int x = Lo.x; x < Hi.x; x++)
+						{
+							if (Inside(glm::ivec3(x, y, z)))
+							{
+								Data.SetBlock(x, y, z, block, state);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	EndRecord(Before, Min, Max);
+	m_Touched.Add(Min, Max);
+}
+
+void VoxelRT::WorldEdit::Replace(const glm::ivec3& min, const glm::ivec3& max, Block from, Block to)
+{
+	glm::ivec3 Min = min, Max = max;
+
+	if (!Clamp(Min, Max) || from.block == to.block)
+	{
+		return;
+	}
+
+	WorldData& Data = m_World->m_WorldData;
+	const VoxelClipboard Before = BeginRecord(Min, Max);
+	const glm::ivec3 FirstChunk = Min / CHUNK_SIZE;
+	const glm::ivec3 LastChunk = (Max - 1) / CHUNK_SIZE;
+
+	for (int cz = FirstChunk.z; cz <= LastChunk.z; cz++)
+	{
+		for (int cy = FirstChunk.y; cy <= LastChunk.y; cy++)
+		{
+			for (int cx = FirstChunk.x; cx <= LastChunk.x; cx++)
+			{
+				const glm::ivec3 ChunkMin = glm::ivec3(cx, cy, cz) * CHUNK_SIZE;
+				const glm::ivec3 Lo = glm::max(Min, ChunkMin);
+				const glm::ivec3 Hi = glm::min(Max, ChunkMin + glm::ivec3(CHUNK_SIZE));
+				const VoxelChunk& Chunk = Data.GetChunk(ChunkMin.x, ChunkMin.y, ChunkMin.z);
+
+				// Uniform chunks either don't contain the block at all or are made of it entirely
+				if (Chunk.IsUniform())
+				{
+					if (Chunk.GetUniformBlock().block == from.block)
+					{
+						Data.FillBox(Lo, Hi, to);
+					}
+
+					continue;
+				}
+
+				for (int z = Lo.z; z < Hi.z; z++)
+				{
+					for (int y = Lo.y; y < Hi.y; y++)
+					{
+						for (int x = Lo.x; x < Hi.x; x++)
+						{
+							if (Data.GetBlock(x, y, z).block == from.block)
+							{
+								Data.SetBlock(x, y, z, to);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	EndRecord(Before, Min, Max);
+	m_Touched.Add(Min, Max);
+}
+
+VoxelRT::VoxelClipboard VoxelRT::WorldEdit::Copy(const glm::ivec3& min, const glm::ivec3& max) const
+{
+	VoxelClipboard Clipboard;
+	glm::ivec3 Min = min, Max = max;
+
+	if (!Clamp(Min, Max))
+	{
+		return Clipboard;
+	}
+
+	m_World->LoadRegion(Min, Max);
+
+	const WorldData& Data = m_World->m_WorldData;
+	Clipboard.Size = Max - Min;
+	Clipboard.Blocks.resize((size_t)Clipboard.Size.x * Clipboard.Size.y * Clipboard.Size.z);
+	Data.ReadRegion(Min, Clipboard.Size, Clipboard.Blocks.data());
+
+	if (Data.GetStates().IsEmpty())
+	{
+		return Clipboard;
+	}
+
+	uint32_t i = 0;
+
+	for (int z = Min.z; z < Max.z; z++)
+	{
+		for (int y = Min.y; y < Max.y; y++)
+		{
+			for (int x = Min.x; x < Max.x; x++, i++)
+			{
+				const BlockState State = Data.GetState(x, y, z);
+
+				if (State != 0)
+				{
+					Clipboard.States.push_back({ i, State });
+				}
+			}
+		}
+	}
+
+	return Clipboard;
+}
+
+void VoxelRT::WorldEdit::Paste(const VoxelClipboard& clipboard, const glm::ivec3& origin, bool skip_air)
+{
+	glm::ivec3 Min = origin, Max = origin + clipboard.Size;
+
+	if (!Clamp(Min, Max))
+	{
+		return;
+	}
+
+	WorldData& Data = m_World->m_WorldData;
+	const VoxelClipboard Before = BeginRecord(Min, Max);
+
+	// The states are in index order, which is the order the voxels are visited in
+	auto State = clipboard.States.begin();
+
+	for (int z = Min.z; z < Max.z; z++)
+	{
+		for (int y = Min.y; y < Max.y; y++)
+		{
+			for (int x = Min.x; x < Max.x; x++)
+			{
+				const glm::ivec3 Local = glm::ivec3(x, y, z) - origin;
+				const uint32_t i = (uint32_t)(Local.x + Local.y * clipboard.Size.x + Local.z * clipboard.Size.x * clipboard.Size.y);
+
+				while (State != clipboard.States.end() && State->first < i)
+				{
+					++State;
+				}
+
+				const uint16_t ID = clipboard.Blocks[i];
+
+				if (ID == 0 && skip_air)
+				{
+					continue;
+				}
+
+				Data.SetBlock(x, y, z, { ID }, State != clipboard.States.end() && State->first == i ? State->second : 0);
+			}
+		}
+	}
+
+	EndRecord(Before, Min, Max);
+	m_Touched.Add(Min, Max);
+}
+
+void VoxelRT::WorldEdit::Commit()
+{
+	if (m_Recording)
+	{
+		m_World->GetJournal().EndTransaction();
+		m_Recording = false;
+	}
+
+	if (!IsPending())
+	{
+		return;
+	}
+
+	const std::vector<DirtyBox>& Boxes = m_Touched.GetBoxes();
+
+	m_World->UpdateLightList(Boxes);
+
+	for (const DirtyBox& box : Boxes)
+	{
+		Volumetrics::RelightRegion(box.Min, box.Max);
+		m_World->MarkDirty(box.Min, box.Max);
+	}
+
+	m_World->FlushEdits();
+	m_Touched.Clear();
+}
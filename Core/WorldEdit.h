@@ -0,0 +1,78 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "World.h"
+#include "DirtyRegion.h"
+
+namespace VoxelRT
+{
+	// A box of voxels copied out of the world, with the states of its stateful voxels
+	struct VoxelClipboard
+	{
+		glm::ivec3 Size = glm::ivec3(0);
+		std::vector<uint16_t> Blocks; // x + y * size.x + z * size.x * size.y
+		std::vector<std::pair<uint32_t, BlockState>> States; // (index into Blocks, state)
+	};
+
+	// Transactional bulk edits (scripted builds, tools, pastes)
+	// The operations write the voxel data directly and only record the boxes they touch. Commit() then does the work
+	// World::SetBlock() and World::Raycast() do per block once for the entire edit : the light chunk lists are rebuilt
+	// for the touched boxes, the light volume is recomputed around them in a single flood fill and the dirty boxes are
+	// flushed (one distance field update, one upload per box).
+	//
+	//	WorldEdit Edit(world);
+	//	Edit.FillBox(glm::ivec3(0), glm::ivec3(64), Block{ 1 });
+	//	Edit.Commit();
+	//
+	// An edit that's still pending when it's destroyed is committed.
+	// If the world's journal is enabled the whole edit is recorded as a single undoable transaction.
+
+	class WorldEdit
+	{
+	public :
+
+		WorldEdit(World* world) : m_World(world) {}
+		~WorldEdit();
+
+		WorldEdit(const WorldEdit&) = delete;
+		WorldEdit& operator=(const WorldEdit&) = delete;
+
+		// Boxes are max exclusive and clamped to the world
+		void FillBox(const glm::ivec3& min, const glm::ivec3& max, Block block, BlockState state = 0);
+
+		// Every voxel whose center is within radius of center
+		void FillSphere(const glm::vec3& center, float radius, Block block, BlockState state = 0);
+
+		// Replaces the voxels of type from inside the box, the replaced voxels lose their state
+		void Replace(const glm::ivec3& min, const glm::ivec3& max, Block from, Block to);
+
+		// Reads the current (including uncommitted) voxels
+		VoxelClipboard Copy(const glm::ivec3& min, const glm::ivec3& max) const;
+
+		// Writes the clipboard with its minimum corner at origin, skip_air keeps the voxels under air voxels of the clipboard
+		void Paste(const VoxelClipboard& clipboard, const glm::ivec3& origin, bool skip_air = false);
+
+		// Relights, flushes and forgets the touched boxes, the edit can be reused afterwards
+		void Commit();
+
+		inline bool IsPending() const noexcept { return !m_Touched.IsEmpty(); }
+		inline const std::vector<DirtyBox>& GetTouchedBoxes() const noexcept { return m_Touched.GetBoxes(); }
+
+	private :
+
+		// Clamps the box to the world, returns false if nothing is left
+		bool Clamp(glm::ivec3& min, glm::ivec3& max) const;
+
+		// Journal recording : the box an operation writes is copied before the operation and diffed against the result
+		VoxelClipboard BeginRecord(const glm::ivec3& min, const glm::ivec3& max);
+		void EndRecord(const VoxelClipboard& before, const glm::ivec3& min, const glm::ivec3& max);
+
+		World* m_World;
+		DirtyRegion m_Touched;
+		bool m_Recording = false; // Inside of a journal transaction
+	};
+}
@@ -2,12 +2,660 @@
 
 #include <sstream>
 #include <filesystem>
+#include <cstddef>
+#include <thread>
+#include <unordered_map>
 
 #include "VolumetricFloodFill.h"
+#include "BlockDatabase.h"
+#include "ChunkCodec.h"
+#include "ParallelFor.h"
+#include "Utils/Timer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace VoxelRT
 {
-	bool SaveWorld(World* world, const std::string& world_name)
+	static const size_t WORLD_FILE_HEADER_SIZE_V1 = offsetof(WorldFileHeader, Flags);
+
+	static int GetCodecThreadCount()
+	{
+		return std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	int SeekTo(FILE* file, uint64_t offset, int origin)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, (int64_t)offset, origin);
+#else
+		return fseeko(file, (off_t)offset, origin);
+#endif
+	}
+
+	uint64_t TellPosition(FILE* file)
+	{
+#ifdef _WIN32
+		const int64_t Position = _ftelli64(file);
+#else
+		const int64_t Position = (int64_t)ftello(file);
+#endif
+
+		return Position < 0 ? UINT64_MAX : (uint64_t)Position;
+	}
+
+	static const char WORLD_FILE_RECORD_MAGIC[4] = { 'V', 'X', 'L', 'G' };
+
+	// FNV-1a, tells the records that a crash or a full disk cut short apart from the complete ones
+	static uint32_t HashRecord(const uint8_t* data, size_t size)
+	{
+		uint32_t Hash = 2166136261u;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			Hash = (Hash ^ data[i]) * 16777619u;
+		}
+
+		return Hash;
+	}
+
+	template <typename T>
+	static void AppendBytes(std::vector<uint8_t>& output, const T* data, size_t count)
+	{
+		const uint8_t* Bytes = (const uint8_t*)data;
+		output.insert(output.end(), Bytes, Bytes + count * sizeof(T));
+	}
+
+	// Flushes the file and waits for it to reach the disk, false if anything written to it failed
+	static bool FlushToDisk(FILE* file)
+	{
+		bool Written = fflush(file) == 0 && !ferror(file);
+
+#ifdef _WIN32
+		Written = Written && _commit(_fileno(file)) == 0;
+#else
+		Written = Written && fsync(fileno(file)) == 0;
+#endif
+
+		return Written;
+	}
+
+	// Block table of a version 4 file : the name of every block id the chunks use
+	std::vector<uint8_t> WriteWorldFileBlockTable(const std::vector<uint8_t>& used, const std::vector<std::string>& names)
+	{
+		std::vector<uint8_t> Table(sizeof(uint32_t));
+		uint32_t Count = 0;
+
+		for (int id = 1; id < (int)used.size() && id < 65536; id++)
+		{
+			if (!used[id])
+			{
+				continue;
+			}
+
+			std::string Name = id < (int)names.size() ? names[id] : "???";
+			Name.resize(std::min(Name.size(), (size_t)255));
+
+			Table.push_back((uint8_t)(id & 0xFF));
+			Table.push_back((uint8_t)(id >> 8));
+			Table.push_back((uint8_t)Name.size());
+			Table.insert(Table.end(), Name.begin(), Name.end());
+			Count++;
+		}
+
+		memcpy(Table.data(), &Count, sizeof(uint32_t));
+		return Table;
+	}
+
+	void GetWorldFileBlockNames(std::vector<std::string>& names)
+	{
+		names.resize(BlockDatabase::GetBlockDataTableSize());
+
+		for (int id = 0; id < (int)names.size(); id++)
+		{
+			names[id] = BlockDatabase::GetBlockName((uint16_t)id);
+		}
+	}
+
+	// Maps the ids of the file to the ids the same block names have in the current block database
+	// Names the database doesn't know keep their id. A remap that was already read is added to (the tables of the log)
+	// same_ids is cleared if one of the names isn't the one its id has in the database
+	static bool ReadBlockTable(FILE* file, std::vector<uint16_t>& remap, bool& same_ids)
+	{
+		uint32_t Count = 0;
+
+		if (fread(&Count, sizeof(uint32_t), 1, file) != 1 || Count > 65535)
+		{
+			return false;
+		}
+
+		// GetBlockID() would insert the names it doesn't know
+		std::unordered_map<std::string, uint16_t> CurrentIDs;
+
+		for (int id = 1; id < BlockDatabase::GetBlockDataTableSize(); id++)
+		{
+			const std::string Name = BlockDatabase::GetBlockName((uint16_t)id);
+
+			if (Name != "???")
+			{
+				CurrentIDs.emplace(Name, (uint16_t)id);
+			}
+		}
+
+		if (remap.size() != 65536)
+		{
+			remap.resize(65536);
+
+			for (int i = 0; i < 65536; i++)
+			{
+				remap[i] = (uint16_t)i;
+			}
+		}
+
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			uint16_t ID = 0;
+			uint8_t Length = 0;
+			std::string Name;
+
+			if (fread(&ID, sizeof(uint16_t), 1, file) != 1 || fread(&Length, sizeof(uint8_t), 1, file) != 1)
+			{
+				return false;
+			}
+
+			Name.resize(Length);
+
+			if (Length > 0 && fread(&Name[0], 1, Length, file) != Length)
+			{
+				return false;
+			}
+
+			auto it = CurrentIDs.find(Name);
+
+			if (it != CurrentIDs.end())
+			{
+				remap[ID] = it->second;
+			}
+
+			same_ids = same_ids && BlockDatabase::GetBlockName(ID) == Name;
+		}
+
+		return true;
+	}
+
+	static void WriteChunks(const std::vector<uint8_t>& table, const std::vector<std::vector<uint8_t>>& encoded, FILE* file,
+		std::vector<uint64_t>& Offsets, std::vector<uint32_t>& Sizes)
+	{
+		const int ChunkCount = (int)encoded.size();
+		fwrite(table.data(), 1, table.size(), file);
+
+		// Absolute offsets so that a chunk can be read without going through the ones before it
+		Offsets.resize(ChunkCount);
+		Sizes.resize(ChunkCount);
+		uint64_t Offset = sizeof(WorldFileHeader) + table.size() + sizeof(uint32_t) + (uint64_t)ChunkCount * (sizeof(uint64_t) + sizeof(uint32_t));
+
+		for (int i = 0; i < ChunkCount; i++)
+		{
+			Offsets[i] = Offset;
+			Sizes[i] = (uint32_t)encoded[i].size();
+			Offset += Sizes[i];
+		}
+
+		const uint32_t Count = (uint32_t)ChunkCount;
+		fwrite(&Count, sizeof(uint32_t), 1, file);
+		fwrite(Offsets.data(), sizeof(uint64_t), ChunkCount, file);
+		fwrite(Sizes.data(), sizeof(uint32_t), ChunkCount, file);
+
+		for (int i = 0; i < ChunkCount; i++)
+		{
+			fwrite(encoded[i].data(), 1, encoded[i].size(), file);
+		}
+	}
+
+	// Returns false if the file can't be read past the chunks, chunks that can't be decoded are left empty
+	bool ReadWorldFileChunkIndex(FILE* file, int chunk_count, WorldFileChunkIndex& index)
+	{
+		uint32_t Count = 0;
+
+		if (!ReadBlockTable(file, index.Remap, index.SameIDs) || fread(&Count, sizeof(uint32_t), 1, file) != 1 || Count != (uint32_t)chunk_count)
+		{
+			return false;
+		}
+
+		index.Offsets.resize(chunk_count);
+		index.Sizes.resize(chunk_count);
+
+		if (fread(index.Offsets.data(), sizeof(uint64_t), chunk_count, file) != (size_t)chunk_count ||
+			fread(index.Sizes.data(), sizeof(uint32_t), chunk_count, file) != (size_t)chunk_count)
+		{
+			return false;
+		}
+
+		// SaveWorld() writes the chunks back to back right after the index
+		index.End = TellPosition(file);
+
+		if (index.End == UINT64_MAX)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < chunk_count; i++)
+		{
+			if (index.Offsets[i] != index.End)
+			{
+				return false;
+			}
+
+			index.End += index.Sizes[i];
+		}
+
+		return true;
+	}
+
+	// Returns false if the file can't be read past the chunks, chunks that can't be decoded are left empty
+	static bool ReadChunks(World* world, FILE* file, WorldFileChunkIndex& Index)
+	{
+		WorldData& Data = world->m_WorldData;
+		const int ChunkCount = Data.GetChunkCount();
+
+		if (!ReadWorldFileChunkIndex(file, ChunkCount, Index))
+		{
+			return false;
+		}
+
+		// Read at once
+		const uint64_t Start = ChunkCount > 0 ? Index.Offsets[0] : Index.End;
+		const uint64_t Total = Index.End - Start;
+		const std::vector<uint64_t>& Offsets = Index.Offsets;
+		const std::vector<uint32_t>& Sizes = Index.Sizes;
+		const std::vector<uint16_t>& Remap = Index.Remap;
+
+		std::vector<uint8_t> Payload(Total);
+
+		if (fread(Payload.data(), 1, Payload.size(), file) != Payload.size())
+		{
+			return false;
+		}
+
+		// Every thread decodes and sets the chunks of whole occupancy regions, along z (see WorldData::SetChunk())
+		const glm::ivec3 Dimensions = Data.GetDimensions();
+		const int ChunksPerSlice = (Dimensions.x / CHUNK_SIZE) * (Dimensions.y / CHUNK_SIZE) * (OccupancyMask::REGION_SIZE / CHUNK_SIZE);
+		const int SliceCount = (ChunkCount + ChunksPerSlice - 1) / ChunksPerSlice;
+		std::vector<uint8_t> Valid(ChunkCount, 0);
+
+		ParallelFor(SliceCount, GetCodecThreadCount(), [&](int begin, int end) {
+			for (int i = begin * ChunksPerSlice; i < std::min(end * ChunksPerSlice, ChunkCount); i++)
+			{
+				VoxelChunk Chunk;
+				Valid[i] = ChunkCodec::Decode(Payload.data() + (Offsets[i] - Start), Sizes[i], Remap, Chunk);
+
+				// The world was just cleared
+				if (Valid[i] && !(Chunk.IsUniform() && Chunk.GetUniformBlock().block == 0))
+				{
+					Data.SetChunk(i, std::move(Chunk));
+				}
+			}
+		});
+
+		const int Corrupted = (int)std::count(Valid.begin(), Valid.end(), 0);
+
+		if (Corrupted > 0)
+		{
+			std::cout << "\n\n" << Corrupted << " CORRUPTED CHUNKS IN WORLD FILE, THEY WERE LEFT EMPTY" << "\n\n";
+		}
+
+		return true;
+	}
+
+	// The chunks of the log replace the ones ReadChunks() read, with their states and summaries
+	static void ReadLogChunks(World* world, FILE* file, const WorldFileChunkIndex& index)
+	{
+		WorldData& Data = world->m_WorldData;
+		std::vector<uint8_t> Encoded;
+		int Corrupted = 0;
+
+		for (size_t k = 0; k < index.LogChunks.size(); k++)
+		{
+			const int Chunk = index.LogChunks[k];
+			VoxelChunk Decoded;
+			Encoded.resize(index.Sizes[Chunk]);
+
+			if (SeekTo(file, index.Offsets[Chunk]) != 0 || fread(Encoded.data(), 1, Encoded.size(), file) != Encoded.size() ||
+				!ChunkCodec::Decode(Encoded.data(), Encoded.size(), index.Remap, Decoded))
+			{
+				Decoded = VoxelChunk();
+				Corrupted++;
+			}
+
+			Data.SetChunk(Chunk, std::move(Decoded), index.LogStates[k]);
+		}
+
+		if (Corrupted > 0)
+		{
+			std::cout << "\n\n" << Corrupted << " CORRUPTED CHUNKS IN WORLD FILE, THEY WERE LEFT EMPTY" << "\n\n";
+		}
+
+		// The cached distance field is the one of the chunks the log replaced
+		if (!index.LogChunks.empty())
+		{
+			world->GetDistanceField().SetValid(false);
+		}
+	}
+
+	// Version 0 to 3 : the raw x + y * X + z * X * Y block array
+	static void ReadRawBlocks(World* world, FILE* file, bool wide_blocks)
+	{
+		const glm::ivec3& Dimensions = world->GetDimensions();
+		const glm::ivec3 SlabSize = glm::ivec3(Dimensions.x, Dimensions.y, CHUNK_SIZE);
+		std::vector<uint16_t> Slab(SlabSize.x * SlabSize.y * SlabSize.z);
+		std::vector<uint8_t> NarrowSlab(wide_blocks ? 0 : Slab.size());
+
+		for (int z_base = 0; z_base < Dimensions.z; z_base += CHUNK_SIZE)
+		{
+			if (wide_blocks)
+			{
+				if (fread(Slab.data(), sizeof(uint16_t), Slab.size(), file) != Slab.size())
+				{
+					break;
+				}
+			}
+
+			else
+			{
+				if (fread(NarrowSlab.data(), sizeof(uint8_t), NarrowSlab.size(), file) != NarrowSlab.size())
+				{
+					break;
+				}
+
+				std::copy(NarrowSlab.begin(), NarrowSlab.end(), Slab.begin());
+			}
+
+			world->m_WorldData.WriteRegion(glm::ivec3(0, 0, z_base), SlabSize, Slab.data());
+		}
+
+		world->m_WorldData.Compact();
+	}
+
+	bool ReadWorldFileHeader(FILE* file, WorldFileHeader& header)
+	{
+		header = WorldFileHeader();
+
+		if (fread(&header, WORLD_FILE_HEADER_SIZE_V1, 1, file) == 1 && memcmp(header.Magic, "VXRT", 4) == 0)
+		{
+			if (header.Version < 1 || header.Version > 4)
+			{
+				std::cout << "\n\n" << "UNSUPPORTED WORLD FILE VERSION : " << header.Version << "\n\n";
+				return false;
+			}
+
+			header.Flags = 0;
+
+			if (header.Version >= 2 && fread(&header.Flags, sizeof(uint32_t), 1, file) != 1)
+			{
+				std::cout << "\n\n" << "INVALID WORLD FILE HEADER" << "\n\n";
+				return false;
+			}
+		}
+
+		else
+		{
+			// Legacy headerless file
+			fseek(file, 0, SEEK_SET);
+			header.Version = 0;
+			header.Flags = 0;
+			header.SizeX = DEFAULT_WORLD_SIZE_X;
+			header.SizeY = DEFAULT_WORLD_SIZE_Y;
+			header.SizeZ = DEFAULT_WORLD_SIZE_Z;
+		}
+
+		if (header.SizeX <= 0 || header.SizeY <= 0 || header.SizeZ <= 0 ||
+			header.SizeX % CHUNK_SIZE != 0 || header.SizeY % CHUNK_SIZE != 0 || header.SizeZ % CHUNK_SIZE != 0)
+		{
+			std::cout << "\n\n" << "INVALID WORLD DIMENSIONS IN WORLD FILE" << "\n\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ReadWorldFileSections(World* world, FILE* file, uint32_t flags)
+	{
+		const glm::ivec3& Dimensions = world->GetDimensions();
+
+		if (flags & WORLD_FILE_HAS_DISTANCE_FIELD)
+		{
+			DistanceField& Field = world->GetDistanceField();
+			Field.SetValid(fread(Field.GetData(), 1, Field.GetVolume(), file) == Field.GetVolume());
+
+			if (!Field.IsValid())
+			{
+				std::cout << "\n\n" << "CACHED DISTANCE FIELD IS TRUNCATED, IT WILL BE REGENERATED" << "\n\n";
+			}
+		}
+
+		if (flags & WORLD_FILE_HAS_VOXEL_STATES)
+		{
+			uint32_t Count = 0;
+			std::vector<uint32_t> Indices;
+			std::vector<uint8_t> Values;
+
+			if (fread(&Count, sizeof(uint32_t), 1, file) == 1)
+			{
+				Indices.resize(Count);
+				Values.resize(Count);
+			}
+
+			if (fread(Indices.data(), sizeof(uint32_t), Count, file) != Count || fread(Values.data(), sizeof(uint8_t), Count, file) != Count)
+			{
+				std::cout << "\n\n" << "VOXEL STATES ARE TRUNCATED, THEY WERE IGNORED" << "\n\n";
+				Count = 0;
+			}
+
+			const size_t Volume = (size_t)Dimensions.x * Dimensions.y * Dimensions.z;
+
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				if (Indices[i] >= Volume)
+				{
+					continue;
+				}
+
+				size_t idx = Indices[i];
+				int z = (int)(idx / ((size_t)Dimensions.x * Dimensions.y));
+				idx -= (size_t)z * Dimensions.x * Dimensions.y;
+				world->m_WorldData.SetState((int)(idx % Dimensions.x), (int)(idx / Dimensions.x), z, Values[i]);
+			}
+		}
+
+		if (!(flags & WORLD_FILE_HAS_CHUNK_SUMMARY))
+		{
+			return false;
+		}
+
+		if (!world->m_WorldData.ReadSummary(file))
+		{
+			std::cout << "\n\n" << "CHUNK SUMMARIES DON'T MATCH THE BLOCK DATABASE OR ARE TRUNCATED, THEY WERE REBUILT" << "\n\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool IgnoreIncompleteRecord()
+	{
+		std::cout << "\n\n" << "THE LAST SAVE APPENDED TO THE WORLD FILE IS INCOMPLETE, ITS CHUNKS WERE IGNORED" << "\n\n";
+		return false;
+	}
+
+	bool ReadWorldFileLog(FILE* file, WorldFileChunkIndex& index)
+	{
+		const uint32_t ChunkCount = (uint32_t)index.Offsets.size();
+		uint64_t Position = TellPosition(file);
+		const uint64_t FileSize = SeekTo(file, 0, SEEK_END) == 0 ? TellPosition(file) : UINT64_MAX;
+
+		// SetWorldFileLayout() doesn't append to a file whose log end isn't known
+		if (Position == UINT64_MAX || FileSize == UINT64_MAX)
+		{
+			index.LogEnd = UINT64_MAX;
+			return IgnoreIncompleteRecord();
+		}
+
+		// Chunk -> its slot in LogChunks, a chunk can be in several records
+		std::unordered_map<int, size_t> Slots;
+		std::vector<uint8_t> Payload;
+		index.LogEnd = Position;
+
+		while (Position < FileSize)
+		{
+			char Magic[4];
+			uint32_t Size = 0;
+			uint32_t Hash = 0;
+
+			if (SeekTo(file, Position) != 0 || fread(Magic, 1, 4, file) != 4 || fread(&Size, sizeof(uint32_t), 1, file) != 1 ||
+				memcmp(Magic, WORLD_FILE_RECORD_MAGIC, 4) != 0 || Position + 12 + Size > FileSize)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			Payload.resize(Size);
+
+			if (fread(Payload.data(), 1, Size, file) != Size || fread(&Hash, sizeof(uint32_t), 1, file) != 1 ||
+				HashRecord(Payload.data(), Size) != Hash)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			// The record is complete, it is read again through the file for the block table
+			const uint64_t PayloadStart = Position + 8;
+			uint32_t Count = 0;
+
+			if (SeekTo(file, PayloadStart) != 0 || !ReadBlockTable(file, index.Remap, index.SameIDs) || fread(&Count, sizeof(uint32_t), 1, file) != 1 || Count > ChunkCount)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			std::vector<uint32_t> Chunks(Count);
+			std::vector<uint32_t> Sizes(Count);
+			std::vector<uint32_t> StateCounts(Count);
+
+			if (fread(Chunks.data(), sizeof(uint32_t), Count, file) != Count || fread(Sizes.data(), sizeof(uint32_t), Count, file) != Count ||
+				fread(StateCounts.data(), sizeof(uint32_t), Count, file) != Count)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			uint64_t Offset = TellPosition(file);
+			uint64_t End = Offset;
+
+			if (Offset == UINT64_MAX)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			for (uint32_t k = 0; k < Count; k++)
+			{
+				End += (uint64_t)Sizes[k] + (uint64_t)StateCounts[k] * sizeof(uint32_t);
+
+				if (Chunks[k] >= ChunkCount)
+				{
+					return IgnoreIncompleteRecord();
+				}
+			}
+
+			if (End != PayloadStart + Size)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			uint64_t StatesStart = Offset;
+
+			for (uint32_t k = 0; k < Count; k++)
+			{
+				StatesStart += Sizes[k];
+			}
+
+			// The states follow the chunks
+			if (SeekTo(file, StatesStart) != 0)
+			{
+				return IgnoreIncompleteRecord();
+			}
+
+			for (uint32_t k = 0; k < Count; k++)
+			{
+				const int Chunk = (int)Chunks[k];
+				auto Slot = Slots.emplace(Chunk, index.LogChunks.size());
+
+				if (Slot.second)
+				{
+					index.LogChunks.push_back(Chunk);
+					index.LogStates.emplace_back();
+				}
+
+				index.Garbage += index.Sizes[Chunk];
+				index.Offsets[Chunk] = Offset;
+				index.Sizes[Chunk] = Sizes[k];
+				Offset += Sizes[k];
+
+				std::vector<uint32_t>& States = index.LogStates[Slot.first->second];
+				States.resize(StateCounts[k]);
+
+				if (fread(States.data(), sizeof(uint32_t), States.size(), file) != States.size())
+				{
+					return IgnoreIncompleteRecord();
+				}
+			}
+
+			Position = PayloadStart + Size + sizeof(uint32_t);
+			index.LogEnd = Position;
+		}
+
+		return true;
+	}
+
+	void SetWorldFileLayout(World* world, const std::string& world_name, uint32_t flags, const WorldFileChunkIndex& index)
+	{
+		WorldFileLayout& Layout = world->GetFileLayout();
+		Layout.Clear();
+
+		const std::string Path = "Saves/" + world_name;
+		std::error_code Error;
+		const uintmax_t FileSize = std::filesystem::file_size(Path, Error);
+
+		// Older files, the ones whose block ids aren't the ones of the database anymore and the ones that end with an
+		// incomplete record are written again by the next save
+		if (!(flags & WORLD_FILE_HAS_LOG) || !index.SameIDs || Error || FileSize != index.LogEnd)
+		{
+			return;
+		}
+
+		const std::filesystem::file_time_type WriteTime = std::filesystem::last_write_time(Path, Error);
+
+		if (Error)
+		{
+			return;
+		}
+
+		const WorldData& Data = world->m_WorldData;
+		Layout.Name = world_name;
+		Layout.Dimensions = Data.GetDimensions();
+		Layout.Origin = Data.GetOrigin();
+		Layout.Offsets = index.Offsets;
+		Layout.Sizes = index.Sizes;
+		Layout.Versions.resize(Data.GetChunkCount());
+		Layout.Size = index.LogEnd;
+		Layout.Garbage = index.Garbage;
+		Layout.WriteTime = WriteTime;
+
+		for (int i = 0; i < Data.GetChunkCount(); i++)
+		{
+			Layout.Versions[i] = Data.GetChunkVersion(i);
+		}
+	}
+
+	bool WriteWorldFile(const std::string& world_name, const WorldFileContents& contents, WorldFileLayout* layout)
 	{
 		if (!std::filesystem::exists("Saves/"))
 		{
@@ -15,26 +663,399 @@ namespace VoxelRT
 			std::filesystem::create_directories("Saves/");
 		}
 
-		std::string world_file_name = "Saves/" + (world_name);
-		FILE* world_file = NULL;
+		const std::string Path = "Saves/" + world_name;
+		const std::string TemporaryPath = Path + ".tmp";
+		FILE* File = fopen(TemporaryPath.c_str(), "wb");
 
-		world_file = fopen(world_file_name.c_str(), "wb+");
+		if (!File)
+		{
+			return false;
+		}
 
-		if (world_file)
+		const glm::ivec3& Dimensions = contents.Dimensions;
+
+		WorldFileHeader Header;
+		Header.SizeX = Dimensions.x;
+		Header.SizeY = Dimensions.y;
+		Header.SizeZ = Dimensions.z;
+		Header.Flags = contents.DistanceField ? WORLD_FILE_HAS_DISTANCE_FIELD : 0;
+		Header.Flags |= contents.StateIndices.empty() ? 0 : WORLD_FILE_HAS_VOXEL_STATES;
+		Header.Flags |= WORLD_FILE_HAS_CHUNK_SUMMARY | WORLD_FILE_HAS_LOG;
+		fwrite(&Header, sizeof(WorldFileHeader), 1, File);
+
+		std::vector<uint64_t> Offsets;
+		std::vector<uint32_t> Sizes;
+		WriteChunks(contents.BlockTable, *contents.Chunks, File, Offsets, Sizes);
+
+		if (contents.DistanceField)
 		{
-			std::cout << "\n\n" << "SUCCESSFULLY SAVED WORLD" << "\n\n";
-			fwrite(world->m_WorldData.data(), sizeof(Block), WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z, world_file);
-			fclose(world_file);
+			fwrite(contents.DistanceField, 1, (size_t)Dimensions.x * Dimensions.y * Dimensions.z, File);
+		}
 
-			return true;
+		if (Header.Flags & WORLD_FILE_HAS_VOXEL_STATES)
+		{
+			const uint32_t Count = (uint32_t)contents.StateIndices.size();
+			fwrite(&Count, sizeof(uint32_t), 1, File);
+			fwrite(contents.StateIndices.data(), sizeof(uint32_t), Count, File);
+			fwrite(contents.StateValues.data(), sizeof(uint8_t), Count, File);
 		}
 
-		else
+		contents.Summary->Write(File);
+
+		// The previous save is only replaced by a complete file that reached the disk
+		bool Written = FlushToDisk(File);
+		Written = (fclose(File) == 0) && Written;
+		std::error_code Error;
+
+		if (Written)
+		{
+			std::filesystem::rename(TemporaryPath, Path, Error);
+		}
+
+		if (!Written || Error)
+		{
+			std::filesystem::remove(TemporaryPath, Error);
+			return false;
+		}
+
+		if (layout)
+		{
+			layout->Clear();
+
+			const uintmax_t FileSize = std::filesystem::file_size(Path, Error);
+			const std::filesystem::file_time_type WriteTime = std::filesystem::last_write_time(Path, Error);
+
+			// The next save writes the file again
+			if (Error)
+			{
+				return true;
+			}
+
+			layout->Name = world_name;
+			layout->Dimensions = Dimensions;
+			layout->Offsets = std::move(Offsets);
+			layout->Sizes = std::move(Sizes);
+			layout->Size = (uint64_t)FileSize;
+			layout->WriteTime = WriteTime;
+		}
+
+		return true;
+	}
+
+	uint64_t WorldFileRecord::GetSize() const
+	{
+		uint64_t Size = 12 + BlockTable.size() + sizeof(uint32_t) + Chunks.size() * 3 * sizeof(uint32_t);
+
+		for (size_t k = 0; k < Chunks.size(); k++)
+		{
+			Size += Encoded[k]->size() + (States[k] ? States[k]->size() * sizeof(uint32_t) : 0);
+		}
+
+		return Size;
+	}
+
+	bool CanAppendToWorldFile(const WorldFileLayout& layout, const std::string& world_name, const glm::ivec3& dimensions, const glm::ivec3& origin)
+	{
+		if (!layout.IsValid() || layout.Name != world_name || layout.Dimensions != dimensions || layout.Origin != origin)
+		{
+			return false;
+		}
+
+		const std::string Path = "Saves/" + world_name;
+		std::error_code Error;
+		const uintmax_t FileSize = std::filesystem::file_size(Path, Error);
+
+		if (Error || FileSize != layout.Size)
+		{
+			return false;
+		}
+
+		const std::filesystem::file_time_type WriteTime = std::filesystem::last_write_time(Path, Error);
+		return !Error && WriteTime == layout.WriteTime;
+	}
+
+	bool AppendWorldFile(const WorldFileRecord& record, WorldFileLayout& layout)
+	{
+		const uint32_t Count = (uint32_t)record.Chunks.size();
+		std::vector<uint8_t> Record;
+		Record.reserve((size_t)record.GetSize());
+
+		// The payload size is filled in once it is known
+		AppendBytes(Record, WORLD_FILE_RECORD_MAGIC, 4);
+		AppendBytes(Record, &Count, 1);
+		AppendBytes(Record, record.BlockTable.data(), record.BlockTable.size());
+		AppendBytes(Record, &Count, 1);
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			const uint32_t Chunk = (uint32_t)record.Chunks[k];
+			AppendBytes(Record, &Chunk, 1);
+		}
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			const uint32_t Size = (uint32_t)record.Encoded[k]->size();
+			AppendBytes(Record, &Size, 1);
+		}
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			const uint32_t StateCount = record.States[k] ? (uint32_t)record.States[k]->size() : 0;
+			AppendBytes(Record, &StateCount, 1);
+		}
+
+		const uint64_t ChunksStart = Record.size();
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			AppendBytes(Record, record.Encoded[k]->data(), record.Encoded[k]->size());
+		}
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			if (record.States[k])
+			{
+				AppendBytes(Record, record.States[k]->data(), record.States[k]->size());
+			}
+		}
+
+		const uint32_t PayloadSize = (uint32_t)(Record.size() - 8);
+		const uint32_t Hash = HashRecord(Record.data() + 8, PayloadSize);
+		memcpy(Record.data() + 4, &PayloadSize, sizeof(uint32_t));
+		AppendBytes(Record, &Hash, 1);
+
+		const std::string Path = "Saves/" + layout.Name;
+		FILE* File = fopen(Path.c_str(), "ab");
+
+		if (!File)
+		{
+			return false;
+		}
+
+		// The record has to start where the layout's offsets end, it is also where the file is cut back to if it fails
+		const uint64_t Start = SeekTo(File, 0, SEEK_END) == 0 ? TellPosition(File) : UINT64_MAX;
+
+		if (Start != layout.Size)
+		{
+			fclose(File);
+			layout.Clear();
+			return false;
+		}
+
+		bool Written = fwrite(Record.data(), 1, Record.size(), File) == Record.size();
+		Written = FlushToDisk(File) && Written;
+		Written = (fclose(File) == 0) && Written;
+		std::error_code Error;
+
+		// Readers would ignore an incomplete record but the next one would be appended after it
+		if (!Written)
+		{
+			std::filesystem::resize_file(Path, Start, Error);
+			return false;
+		}
+
+		uint64_t Offset = layout.Size + ChunksStart;
+
+		for (uint32_t k = 0; k < Count; k++)
+		{
+			const int Chunk = record.Chunks[k];
+			layout.Garbage += layout.Sizes[Chunk];
+			layout.Offsets[Chunk] = Offset;
+			layout.Sizes[Chunk] = (uint32_t)record.Encoded[k]->size();
+			layout.Versions[Chunk] = record.Versions[k];
+			Offset += layout.Sizes[Chunk];
+		}
+
+		layout.Size += Record.size();
+		layout.WriteTime = std::filesystem::last_write_time(Path, Error);
+
+		// The next save writes the file again
+		if (Error)
+		{
+			layout.Clear();
+		}
+
+		return true;
+	}
+
+	// Flags the ids of the blocks the chunk uses, for WriteWorldFileBlockTable()
+	static void FlagUsedBlocks(const WorldSnapshot& snapshot, int chunk, std::vector<uint8_t>& used)
+	{
+		snapshot.GetChunk(chunk).ForEachBlockType([&](Block block, int) {
+			used[block.block] = 1;
+		});
+	}
+
+	int AppendWorldFileChanges(const WorldSnapshot& snapshot, const std::string& world_name, const std::vector<std::string>& block_names,
+		WorldFileLayout& layout, const WorldFileChunkEncoder& encode)
+	{
+		if (!CanAppendToWorldFile(layout, world_name, snapshot.GetDimensions(), snapshot.GetOrigin()))
+		{
+			return -1;
+		}
+
+		WorldFileRecord Record;
+		uint64_t Replaced = 0;
+
+		for (int i = 0; i < snapshot.GetChunkCount(); i++)
+		{
+			if (snapshot.GetChunkVersion(i) != layout.Versions[i])
+			{
+				Record.Chunks.push_back(i);
+				Record.States.push_back(snapshot.GetChunkStates(i));
+				Record.Versions.push_back(snapshot.GetChunkVersion(i));
+				Replaced += layout.Sizes[i];
+			}
+		}
+
+		if (Record.Chunks.empty())
+		{
+			return 0;
+		}
+
+		std::vector<uint8_t> Used(65536, 0);
+		encode(Record.Chunks, Record.Encoded);
+
+		for (int Chunk : Record.Chunks)
+		{
+			FlagUsedBlocks(snapshot, Chunk, Used);
+		}
+
+		Record.BlockTable = WriteWorldFileBlockTable(Used, block_names);
+
+		// Too much garbage after all (or the record couldn't be appended) : the file is written again
+		if (layout.NeedsCompaction(Replaced, Record.GetSize()) || !AppendWorldFile(Record, layout))
+		{
+			return -1;
+		}
+
+		return (int)Record.Chunks.size();
+	}
+
+	void GetWorldFileContents(const WorldSnapshot& snapshot, const std::vector<std::string>& block_names, WorldFileContents& contents)
+	{
+		const glm::ivec3& Dimensions = snapshot.GetDimensions();
+		std::vector<uint8_t> Used(65536, 0);
+		contents.Dimensions = Dimensions;
+
+		for (int i = 0; i < snapshot.GetChunkCount(); i++)
+		{
+			FlagUsedBlocks(snapshot, i, Used);
+
+			const std::vector<uint32_t>* States = snapshot.GetChunkStates(i);
+
+			if (!States)
+			{
+				continue;
+			}
+
+			const glm::ivec3 Min = snapshot.GetChunkPosition(i);
+
+			for (uint32_t Entry : *States)
+			{
+				const glm::ivec3 p = Min + VoxelIndexing::GetBrickLocalPosition(VoxelStateTable::GetEntryIndex(Entry));
+				contents.StateIndices.push_back((uint32_t)p.x + (uint32_t)p.y * Dimensions.x + (uint32_t)p.z * Dimensions.x * Dimensions.y);
+				contents.StateValues.push_back(VoxelStateTable::GetEntryState(Entry));
+			}
+		}
+
+		contents.BlockTable = WriteWorldFileBlockTable(Used, block_names);
+	}
+
+	void SetWorldFileVersions(const WorldSnapshot& snapshot, WorldFileLayout& layout)
+	{
+		layout.Origin = snapshot.GetOrigin();
+		layout.Versions.resize(snapshot.GetChunkCount());
+
+		for (int i = 0; i < snapshot.GetChunkCount(); i++)
+		{
+			layout.Versions[i] = snapshot.GetChunkVersion(i);
+		}
+	}
+
+	bool SaveWorld(World* world, const std::string& world_name, bool save_distance_field)
+	{
+		// A lazily loaded world reads the rest of its chunks (and unmaps its file) before it is written
+		world->LoadRegion(glm::ivec3(0), world->GetDimensions());
+
+		// Edits that weren't flushed yet aren't in the distance field
+		world->FlushEdits();
+
+		// The frame publishes one already, this only costs something if the world was written to since
+		world->PublishSnapshot();
+
+		const std::shared_ptr<const WorldSnapshot> Snapshot = world->AcquireSnapshot();
+		const int ChunkCount = Snapshot->GetChunkCount();
+		WorldFileLayout& Layout = world->GetFileLayout();
+
+		std::vector<std::string> Names;
+		GetWorldFileBlockNames(Names);
+
+		// Only cache a distance field that matches the blocks, the chunks of a record would make it stale
+		const bool CacheDistanceField = save_distance_field && world->GetDistanceField().IsValid();
+
+		if (!CacheDistanceField)
+		{
+			std::vector<std::vector<uint8_t>> Encoded;
+
+			const int Appended = AppendWorldFileChanges(*Snapshot, world_name, Names, Layout, [&](const std::vector<int>& chunks, std::vector<const std::vector<uint8_t>*>& encoded) {
+				Encoded.resize(chunks.size());
+
+				ParallelFor((int)chunks.size(), GetCodecThreadCount(), [&](int begin, int end) {
+					for (int k = begin; k < end; k++)
+					{
+						ChunkCodec::Encode(Snapshot->GetChunk(chunks[k]), Encoded[k]);
+					}
+				});
+
+				for (const std::vector<uint8_t>& Chunk : Encoded)
+				{
+					encoded.push_back(&Chunk);
+				}
+			});
+
+			if (Appended == 0)
+			{
+				std::cout << "\n\n" << "WORLD IS ALREADY SAVED" << "\n\n";
+				return true;
+			}
+
+			if (Appended > 0)
+			{
+				std::cout << "\n\n" << "SUCCESSFULLY SAVED WORLD (" << Appended << " CHUNKS APPENDED)" << "\n\n";
+				return true;
+			}
+		}
+
+		std::vector<std::vector<uint8_t>> Encoded(ChunkCount);
+
+		ParallelFor(ChunkCount, GetCodecThreadCount(), [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				ChunkCodec::Encode(Snapshot->GetChunk(i), Encoded[i]);
+			}
+		});
+
+		WorldFileContents Contents;
+		GetWorldFileContents(*Snapshot, Names, Contents);
+		Contents.Chunks = &Encoded;
+		Contents.Summary = &world->m_WorldData.GetSummary();
+
+		if (CacheDistanceField)
+		{
+			Contents.DistanceField = world->GetDistanceField().GetVector().data();
+		}
+
+		if (!WriteWorldFile(world_name, Contents, &Layout))
 		{
 			std::cout << "\n\n" << "COULD NOT SAVE WORLD" << "\n\n";
+			return false;
 		}
 
-		return false;
+		SetWorldFileVersions(*Snapshot, Layout);
+
+		std::cout << "\n\n" << "SUCCESSFULLY SAVED WORLD" << "\n\n";
+		return true;
 	}
 
 	bool LoadWorld(World* world, const std::string& world_name, std::vector<glm::ivec3>& LightLocations)
@@ -47,29 +1068,56 @@ namespace VoxelRT
 		if (world_file)
 		{
 			std::cout << "\n\n" << "SUCCESSFULLY OPENED WORLD FILE" << "\n\n";
-			fread(world->m_WorldData.data(), sizeof(Block), WORLD_SIZE_X * WORLD_SIZE_Y * WORLD_SIZE_Z, world_file);
-			
-			auto& data_arr = world->m_WorldData;
 
-			for (int i = 0; i < data_arr.size(); i++) {
+			Blocks::Timer LoadTimer;
+			LoadTimer.Start();
+
+			WorldFileHeader Header;
+
+			if (!ReadWorldFileHeader(world_file, Header))
+			{
+				fclose(world_file);
+				return false;
+			}
+
+			const glm::ivec3 Dimensions = glm::ivec3(Header.SizeX, Header.SizeY, Header.SizeZ);
+
+			// Resizing also clears the world
+			world->Resize(Dimensions);
 
-				uint8_t block_at = data_arr.at(i).block;
+			WorldFileChunkIndex Index;
 
-				if (BlockDatabase::GetBlockEmissiveTexture(block_at) >= 0)
+			if (Header.Version >= 4)
+			{
+				if (!ReadChunks(world, world_file, Index))
 				{
-					int idx = i;
-					int z = idx / (WORLD_SIZE_X * WORLD_SIZE_Y);
-					idx -= (z * WORLD_SIZE_X * WORLD_SIZE_Y);
-					int y = idx / WORLD_SIZE_X;
-					int x = idx % WORLD_SIZE_X;
-
-					glm::ivec3 Loc = glm::ivec3(x, y, z);
-					LightLocations.push_back(Loc);
+					std::cout << "\n\n" << "WORLD FILE IS TRUNCATED OR INVALID" << "\n\n";
+					fclose(world_file);
+					return false;
 				}
 			}
+
+			else
+			{
+				ReadRawBlocks(world, world_file, Header.Version >= 3);
+			}
+
+			ReadWorldFileSections(world, world_file, Header.Flags);
+
+			if (Header.Version >= 4 && (Header.Flags & WORLD_FILE_HAS_LOG))
+			{
+				ReadWorldFileLog(world_file, Index);
+				ReadLogChunks(world, world_file, Index);
+			}
+
+			SetWorldFileLayout(world, world_name, Header.Flags, Index);
+
+			// The lights come from the chunk summaries instead of going through every voxel
+			world->m_WorldData.GetLights(glm::ivec3(0), Dimensions, LightLocations);
 			
 			fclose(world_file);
-			std::cout << "\n\n" << "SUCCESSFULLY PARSED AND READ WORLD FILE" << "\n\n";
+			std::cout << "\n\n" << "SUCCESSFULLY PARSED AND READ WORLD FILE (" << Dimensions.x << "x" << Dimensions.y << "x" << Dimensions.z
+				<< ", " << LoadTimer.End() << " ms)" << "\n\n";
 
 			return true;
 		}
@@ -2,11 +2,152 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <functional>
 #include "World.h"
 
 namespace VoxelRT
 {
-	bool SaveWorld(World* world, const std::string& world_name);
+	// Save file flags (version 2+)
+	const uint32_t WORLD_FILE_HAS_DISTANCE_FIELD = 1; // The distance field follows the blocks, x + y * X + z * X * Y
+	const uint32_t WORLD_FILE_HAS_VOXEL_STATES = 2; // uint32 count, count uint32 voxel indices (same layout), count uint8 states
+	const uint32_t WORLD_FILE_HAS_CHUNK_SUMMARY = 4; // The chunk summaries (see ChunkSummary::Write())
+	const uint32_t WORLD_FILE_HAS_LOG = 8; // Version 4, the records of the saves that appended chunks follow the other sections
+
+	// Written at the start of every save file, followed by the blocks and then the sections of the flags, in order
+	// Files without a header are from before the world size was configurable and are always 384x128x384
+	// Version 1 headers end before Flags
+	// Versions 0 to 3 store the raw x + y * X + z * X * Y block array, 16 bit (little endian) blocks since version 3 and
+	// 8 bit before
+	// Version 4 stores every chunk on its own (see ChunkCodec.h) :
+	//  - the block table : uint32 count, then for every block id the chunks use its uint16 id, uint8 name length and
+	//    name, so that the file still loads after blocks were added to or removed from the database
+	//  - uint32 chunk count (x + y * CX + z * CX * CY order), uint64 absolute file offset of every chunk, uint32 encoded
+	//    size of every chunk
+	//  - the encoded chunks, back to back
+	// Version 4 files with WORLD_FILE_HAS_LOG end with the records of the saves that only appended the chunks written to
+	// since the previous save (see WorldFileLayout.h), until the end of the file. A record is :
+	//  - char[4] "VXLG", uint32 size of the payload
+	//  - the payload : the block table of its chunks, uint32 chunk count N, N uint32 chunk indices, N uint32 encoded sizes,
+	//    N uint32 state counts, the encoded chunks back to back and then the state table entries of every chunk
+	//  - uint32 FNV-1a hash of the payload
+	// A chunk of a record replaces the copies of the same chunk that come before it, along with its states. A record that
+	// is truncated or doesn't match its hash (an interrupted save) ends the log. The chunk summaries and the cached
+	// distance field describe the chunks before the log, the loaders rebuild the summaries of the chunks of the log and
+	// drop the distance field if the log has any.
+	struct WorldFileHeader
+	{
+		char Magic[4] = { 'V', 'X', 'R', 'T' };
+		uint32_t Version = 4;
+		int32_t SizeX = 0;
+		int32_t SizeY = 0;
+		int32_t SizeZ = 0;
+		uint32_t Flags = 0;
+	};
+
+	// Version 4 chunk index, Remap maps the block ids of the file to the ones of the block database (see ChunkCodec::Decode())
+	struct WorldFileChunkIndex
+	{
+		std::vector<uint16_t> Remap;
+		std::vector<uint64_t> Offsets;
+		std::vector<uint32_t> Sizes;
+		uint64_t End = 0; // Offset of the first section after the chunks
+
+		// Filled in by ReadWorldFileLog(), the offsets and sizes of the chunks of the log point into it
+		std::vector<int> LogChunks; // In no particular order
+		std::vector<std::vector<uint32_t>> LogStates; // State table entries of every chunk of LogChunks
+		uint64_t LogEnd = 0; // End of the last complete record
+		uint64_t Garbage = 0; // Bytes of the chunk copies the log replaced
+		bool SameIDs = true; // Every block of the file has the id it has in the block database, records can be appended
+	};
+
+	// fseek() and ftell() with 64 bit offsets, long is 32 bit on windows and the files grow past 2 GB through the appended
+	// records. SeekTo() returns 0 on success like fseek(), TellPosition() returns UINT64_MAX if the position isn't known
+	int SeekTo(FILE* file, uint64_t offset, int origin = SEEK_SET);
+	uint64_t TellPosition(FILE* file);
+
+	// The steps of LoadWorld(), for loaders that read the chunks some other way (see LazyWorldLoader.h)
+	// ReadWorldFileHeader() also accepts headerless files and checks the version and the dimensions
+	// ReadWorldFileChunkIndex() reads the block table and the index and checks that the chunks are back to back after it
+	// ReadWorldFileSections() reads the sections of the flags, the file has to be at the end of the blocks. Returns false if
+	// the chunk summaries were missing or invalid and had to be rebuilt from the blocks
+	// ReadWorldFileLog() reads the records of a WORLD_FILE_HAS_LOG file into the index, the file has to be at the end of
+	// the sections. Returns false if the last record is incomplete (it is ignored). The cached distance field has to be
+	// dropped if the log has chunks
+	bool ReadWorldFileHeader(FILE* file, WorldFileHeader& header);
+	bool ReadWorldFileChunkIndex(FILE* file, int chunk_count, WorldFileChunkIndex& index);
+	bool ReadWorldFileSections(World* world, FILE* file, uint32_t flags);
+	bool ReadWorldFileLog(FILE* file, WorldFileChunkIndex& index);
+
+	// Describes the file the world was just loaded from (its index read up to the end of the log) in the world's layout, so
+	// that the next save can append to it. The layout stays cleared if it can't be appended to
+	void SetWorldFileLayout(World* world, const std::string& world_name, uint32_t flags, const WorldFileChunkIndex& index);
+
+	// A version 4 file put together without the World, for the writers that run on other threads (see WorldAutosaver.h)
+	struct WorldFileContents
+	{
+		glm::ivec3 Dimensions = glm::ivec3(0);
+		std::vector<uint8_t> BlockTable; // WriteWorldFileBlockTable()
+		const std::vector<std::vector<uint8_t>>* Chunks = nullptr; // ChunkCodec::Encode() of every chunk
+		const uint8_t* DistanceField = nullptr; // Optional, x + y * X + z * X * Y
+		std::vector<uint32_t> StateIndices; // x + y * X + z * X * Y
+		std::vector<uint8_t> StateValues;
+		const ChunkSummary* Summary = nullptr;
+	};
+
+	// used has a flag for every block id (the ids the chunks use), names is indexed by block id (GetWorldFileBlockNames())
+	// The names are copied from the block database on the main thread, it isn't safe to read from other threads
+	std::vector<uint8_t> WriteWorldFileBlockTable(const std::vector<uint8_t>& used, const std::vector<std::string>& names);
+	void GetWorldFileBlockNames(std::vector<std::string>& names);
+
+	// Writes Saves/<world_name>.tmp and renames it over the save once it is complete and flushed to the disk, a crash or
+	// a full disk leaves the previous save as it was. Only one writer per world at a time
+	// layout gets the chunks of the new file, everything but the versions and the origin of the chunks
+	bool WriteWorldFile(const std::string& world_name, const WorldFileContents& contents, WorldFileLayout* layout = nullptr);
+
+	// The chunks a save appends to the file instead of writing it again
+	struct WorldFileRecord
+	{
+		std::vector<uint8_t> BlockTable; // WriteWorldFileBlockTable() of the blocks of these chunks
+		std::vector<int> Chunks;
+		std::vector<const std::vector<uint8_t>*> Encoded; // ChunkCodec::Encode() of every chunk
+		std::vector<const std::vector<uint32_t>*> States; // Null if the chunk has none
+		std::vector<uint32_t> Versions;
+
+		// Bytes the record adds to the file
+		uint64_t GetSize() const;
+	};
+
+	// Whether the layout still describes Saves/<world_name> as it is on the disk (nothing else wrote to it since) and
+	// the world it is about to get chunks from has the same dimensions and origin
+	bool CanAppendToWorldFile(const WorldFileLayout& layout, const std::string& world_name, const glm::ivec3& dimensions, const glm::ivec3& origin);
+
+	// Appends the record (flushed to the disk) and points the layout to its chunks. A record that couldn't be written
+	// entirely is truncated away and the layout is left as it was
+	bool AppendWorldFile(const WorldFileRecord& record, WorldFileLayout& layout);
+
+	// The steps SaveWorld() and the autosaves (see WorldAutosaver.h) share, both save a snapshot of the world
+	// AppendWorldFileChanges() appends the chunks whose version isn't the one of the layout as a record, unless the file
+	// can't be appended to (CanAppendToWorldFile()) or would have too much garbage. encode(chunks, encoded) gets the
+	// ChunkCodec::Encode() of each of the chunks, it is only called if they are about to be appended. Returns the number
+	// of chunks appended (0 : the file is up to date), -1 if the file has to be written entirely
+	// GetWorldFileContents() fills the dimensions, the block table and the states of the contents, the caller adds the
+	// encoded chunks, the summary and the distance field. SetWorldFileVersions() tells the layout that the file
+	// WriteWorldFile() just wrote has the chunks of the snapshot
+	typedef std::function<void(const std::vector<int>& chunks, std::vector<const std::vector<uint8_t>*>& encoded)> WorldFileChunkEncoder;
+
+	int AppendWorldFileChanges(const WorldSnapshot& snapshot, const std::string& world_name, const std::vector<std::string>& block_names,
+		WorldFileLayout& layout, const WorldFileChunkEncoder& encode);
+	void GetWorldFileContents(const WorldSnapshot& snapshot, const std::vector<std::string>& block_names, WorldFileContents& contents);
+	void SetWorldFileVersions(const WorldSnapshot& snapshot, WorldFileLayout& layout);
+
+	// Appends the chunks written to since the file was loaded or saved if the world has a layout for it, writes it again
+	// from scratch otherwise or once it has too much garbage (WORLD_FILE_MAX_GARBAGE)
+	// save_distance_field caches the distance field in the file so that it doesn't have to be generated when loading, it
+	// is only cached by a save that writes the entire file
+	bool SaveWorld(World* world, const std::string& world_name, bool save_distance_field = false);
 	bool LoadWorld(World* world, const std::string& world_name, std::vector<glm::ivec3>& LightLocations);
 	bool FilenameValid(const std::string& name);
 	bool DirectoryValid(const std::string& name);
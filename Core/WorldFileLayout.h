@@ -0,0 +1,50 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace VoxelRT
+{
+	// Garbage (chunk copies a record replaced) a save file can have before the next save writes it again from scratch
+	// instead of appending to it, as a fraction of the file size
+	const float WORLD_FILE_MAX_GARBAGE = 0.25f;
+
+	// Where the chunks of a save file are (see the log records in WorldFileHandler.h) and which version of every chunk
+	// of the world they hold, so that saving only appends the chunks whose version changed since. The world keeps the
+	// one of the file it was loaded from or last saved to (World::GetFileLayout()), the saves fill it in.
+	//
+	// A file that something else wrote to since (its size or modification time changed) is written again from scratch.
+
+	struct WorldFileLayout
+	{
+		std::string Name; // Saves/<Name>, empty if the world has no file that can be appended to
+		glm::ivec3 Dimensions = glm::ivec3(0);
+		glm::ivec3 Origin = glm::ivec3(0); // WorldData::GetOrigin() of the world the chunks were saved from
+
+		std::vector<uint64_t> Offsets; // Of the latest copy of every chunk
+		std::vector<uint32_t> Sizes;
+		std::vector<uint32_t> Versions; // WorldData::GetChunkVersion() of the chunks in the file
+
+		uint64_t Size = 0; // End of the last record, where the next one goes
+		uint64_t Garbage = 0; // Bytes of chunk copies that a later record replaced
+		std::filesystem::file_time_type WriteTime;
+
+		inline bool IsValid() const noexcept { return !Name.empty(); }
+
+		// Whether appending chunks that replace replaced bytes of the file and add appended bytes to it would leave more
+		// garbage than WORLD_FILE_MAX_GARBAGE allows
+		inline bool NeedsCompaction(uint64_t replaced, uint64_t appended) const noexcept
+		{
+			return (double)(Garbage + replaced) > (double)(Size + appended) * WORLD_FILE_MAX_GARBAGE;
+		}
+
+		inline void Clear()
+		{
+			*this = WorldFileLayout();
+		}
+	};
+}
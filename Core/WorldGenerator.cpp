@@ -4,28 +4,29 @@
 
 #include "Utils/Random.h"
 
-static uint8_t GRASS_ID = 16;
-static uint8_t STONE_ID = 32;
-static uint8_t DIRT_ID = 48;
-static uint8_t SAND_ID = 64;
-static uint8_t OAK_ID = 128;
-static uint8_t LEAF_ID = 129;
-static uint8_t CACTUS_ID = 129;
-static uint8_t COBBLE_ID = 129;
+static uint16_t GRASS_ID = 16;
+static uint16_t STONE_ID = 32;
+static uint16_t DIRT_ID = 48;
+static uint16_t SAND_ID = 64;
+static uint16_t OAK_ID = 128;
+static uint16_t LEAF_ID = 129;
+static uint16_t CACTUS_ID = 129;
+static uint16_t COBBLE_ID = 129;
 typedef int Biome;
 
 static std::random_device rand_dev;
 static std::mt19937 gen;
 static std::uniform_int_distribution<int> dist;
+static glm::ivec3 WorldSize; // Dimensions of the world being generated
 
 int random_int() {
 	return dist(gen);
 }
 
 bool validpos(glm::ivec3 C) {
-	if ((C.x >= 0 && C.x < WORLD_SIZE_X &&
-		C.y >= 0 && C.y < WORLD_SIZE_Y &&
-		C.z >= 0 && C.z < WORLD_SIZE_Z)) {
+	if ((C.x >= 0 && C.x < WorldSize.x &&
+		C.y >= 0 && C.y < WorldSize.y &&
+		C.z >= 0 && C.z < WorldSize.z)) {
 		return true;
 	}
 	return false;
@@ -48,12 +49,14 @@ Biome GetBiome(float chunk_noise)
 
 void SetVerticalBlocks(VoxelRT::World* world, int x, int z, int y_level, int biome, bool swapstone)
 {
+	y_level = std::min(y_level, WorldSize.y);
+
 	for (int y = 0; y < y_level; y++)
 	{
 		if (biome == 1) {
 			if (y >= y_level - 1)
 			{
-				uint8_t sid = !swapstone ? 1 : (rand() % 8 <= 2 ? COBBLE_ID : STONE_ID);
+				uint16_t sid = !swapstone ? 1 : (rand() % 8 <= 2 ? COBBLE_ID : STONE_ID);
 				world->SetBlock(x, y, z, { swapstone?sid:GRASS_ID });
 			}
 
@@ -90,14 +93,14 @@ void SetVerticalBlocks(VoxelRT::World* world, int x, int z, int y_level, int bio
 
 void GenerateCactii(VoxelRT::World* world, int x, int y, int z) {
 	glm::vec3 OriginTree = glm::vec3(x, y + ((rand()%5) + 2), z);
-	for (int i = 0; i < 6; i++) {
+	for (int i = 0; i < 6 && validpos(glm::ivec3(x, y + i, z)); i++) {
 		world->SetBlock(x, y + i, z, { CACTUS_ID });
 	}
 }
 
 void GenerateTree(VoxelRT::World* world, int x, int y, int z) {
 	glm::vec3 OriginTree = glm::vec3(x, y + 8, z);
-	for (int i = 0; i < 6; i++) {
+	for (int i = 0; i < 6 && validpos(glm::ivec3(x, y + i, z)); i++) {
 		world->SetBlock(x, y+i, z, { OAK_ID });
 	}
 
@@ -208,6 +211,7 @@ void GenerateTree(VoxelRT::World* world, int x, int y, int z) {
 void VoxelRT::GenerateWorld(World* world, bool gen_type, bool gen_structures)
 {
 	std::vector<glm::ivec2> StructureCoords;
+	WorldSize = world->GetDimensions();
 
 	int STRUCTURE_FREQ = 624;
 	gen = std::mt19937(rand_dev());
@@ -239,9 +243,9 @@ void VoxelRT::GenerateWorld(World* world, bool gen_type, bool gen_structures)
 		StoneRando.SetFrequency(0.06f);
 		StoneRando.SetFractalOctaves(16);
 
-		for (int x = 0; x < WORLD_SIZE_X; x++)
+		for (int x = 0; x < WorldSize.x; x++)
 		{
-			for (int z = 0; z < WORLD_SIZE_Z; z++)
+			for (int z = 0; z < WorldSize.z; z++)
 			{
 				float real_x = x;
 				float real_z = z;
@@ -299,9 +303,9 @@ void VoxelRT::GenerateWorld(World* world, bool gen_type, bool gen_structures)
 
 	else
 	{
-		for (int x = 0; x < WORLD_SIZE_X; x++)
+		for (int x = 0; x < WorldSize.x; x++)
 		{
-			for (int z = 0; z < WORLD_SIZE_Z; z++)
+			for (int z = 0; z < WorldSize.z; z++)
 			{
 				float real_x = x;
 				float real_z = z;
@@ -310,4 +314,6 @@ void VoxelRT::GenerateWorld(World* world, bool gen_type, bool gen_structures)
 			}
 		}
 	}
+
+	world->m_WorldData.Compact();
 }
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "WorldSnapshot.h"
+
+#include <unordered_set>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+
+std::shared_ptr<const VoxelRT::WorldSnapshot> VoxelRT::WorldSnapshot::Create(const WorldData& data, const WorldSnapshot* previous, uint64_t epoch)
+{
+	const glm::ivec3& Dimensions = data.GetDimensions();
+	const int ChunkCount = data.GetChunkCount();
+
+	if (previous && (previous->m_Dimensions != Dimensions || previous->m_Origin != data.GetOrigin()))
+	{
+		previous = nullptr;
+	}
+
+	std::shared_ptr<WorldSnapshot> Snapshot = std::make_shared<WorldSnapshot>();
+	Snapshot->m_Dimensions = Dimensions;
+	Snapshot->m_Origin = data.GetOrigin();
+	Snapshot->m_ChunksX = Dimensions.x / CHUNK_SIZE;
+	Snapshot->m_ChunksXY = Snapshot->m_ChunksX * (Dimensions.y / CHUNK_SIZE);
+	Snapshot->m_Epoch = epoch;
+	Snapshot->m_Chunks.resize(ChunkCount);
+	Snapshot->m_States.resize(ChunkCount);
+	Snapshot->m_Versions.resize(ChunkCount);
+
+	for (int i = 0; i < ChunkCount; i++)
+	{
+		const uint32_t Version = data.GetChunkVersion(i);
+		Snapshot->m_Chunks[i] = data.ShareChunk(i);
+		Snapshot->m_Versions[i] = Version;
+
+		if (previous && previous->m_Versions[i] == Version)
+		{
+			Snapshot->m_States[i] = previous->m_States[i];
+			continue;
+		}
+
+		const std::vector<uint32_t>* States = data.GetStates().GetChunkEntries(i);
+
+		if (States && !States->empty())
+		{
+			Snapshot->m_States[i] = std::make_shared<const std::vector<uint32_t>>(*States);
+			Snapshot->m_CopiedChunks++;
+		}
+	}
+
+	return Snapshot;
+}
+
+bool VoxelRT::WorldSnapshot::IsCurrent(const WorldData& data) const noexcept
+{
+	if (data.GetDimensions() != m_Dimensions || data.GetOrigin() != m_Origin)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < (int)m_Versions.size(); i++)
+	{
+		if (m_Versions[i] != data.GetChunkVersion(i))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void VoxelRT::WorldSnapshot::GetChangedChunks(const WorldSnapshot& older, std::vector<int>& chunks) const
+{
+	chunks.clear();
+	const bool Moved = older.m_Dimensions != m_Dimensions || older.m_Origin != m_Origin;
+
+	for (int i = 0; i < (int)m_Chunks.size(); i++)
+	{
+		// A chunk that wasn't written to is still the same chunk, written chunks got a new version
+		if (Moved || older.m_Chunks[i] != m_Chunks[i] || older.m_Versions[i] != m_Versions[i])
+		{
+			chunks.push_back(i);
+		}
+	}
+}
+
+size_t VoxelRT::WorldSnapshot::GetMemoryUsage() const noexcept
+{
+	size_t Total = sizeof(WorldSnapshot) + m_Chunks.capacity() * sizeof(std::shared_ptr<const VoxelChunk>) +
+		m_States.capacity() * sizeof(std::shared_ptr<const std::vector<uint32_t>>) + m_Versions.capacity() * sizeof(uint32_t);
+	std::unordered_set<const VoxelChunk*> Counted;
+
+	for (int i = 0; i < (int)m_Chunks.size(); i++)
+	{
+		if (Counted.insert(m_Chunks[i].get()).second)
+		{
+			Total += m_Chunks[i]->GetMemoryUsage();
+		}
+
+		Total += m_States[i] ? m_States[i]->capacity() * sizeof(uint32_t) : 0;
+	}
+
+	return Total;
+}
+
+size_t VoxelRT::WorldSnapshot::GetExclusiveMemoryUsage(const WorldData& data) const noexcept
+{
+	size_t Total = sizeof(WorldSnapshot) + m_Chunks.capacity() * sizeof(std::shared_ptr<const VoxelChunk>) +
+		m_States.capacity() * sizeof(std::shared_ptr<const std::vector<uint32_t>>) + m_Versions.capacity() * sizeof(uint32_t);
+	const bool SameWindow = data.GetDimensions() == m_Dimensions;
+	std::unordered_set<const VoxelChunk*> Counted;
+
+	for (int i = 0; i < (int)m_Chunks.size(); i++)
+	{
+		// Chunks that moved within a streamed window are still shared, this only looks at the same index
+		if ((!SameWindow || &data.GetChunk(i) != m_Chunks[i].get()) && Counted.insert(m_Chunks[i].get()).second)
+		{
+			Total += m_Chunks[i]->GetMemoryUsage();
+		}
+
+		Total += m_States[i] ? m_States[i]->capacity() * sizeof(uint32_t) : 0;
+	}
+
+	return Total;
+}
+
+#ifdef VOXEL_RT_SNAPSHOT_DEBUG
+// FNV-1a of every block and state of a WorldData or a WorldSnapshot
+template <typename T>
+static uint64_t HashVoxels(const T& voxels, const glm::ivec3& dimensions)
+{
+	uint64_t Hash = 1469598103934665603ull;
+
+	for (int z = 0; z < dimensions.z; z++)
+	{
+		for (int y = 0; y < dimensions.y; y++)
+		{
+			for (int x = 0; x < dimensions.x; x++)
+			{
+				Hash = (Hash ^ (voxels.GetBlock(x, y, z).block | ((uint64_t)voxels.GetState(x, y, z) << 16))) * 1099511628211ull;
+			}
+		}
+	}
+
+	return Hash;
+}
+
+bool VoxelRT::WorldSnapshot::RunStressTest(float duration_seconds, int reader_count)
+{
+	const glm::ivec3 Dimensions = glm::ivec3(96, 64, 96);
+	WorldData Data(Dimensions);
+	Data.FillBox(glm::ivec3(0), glm::ivec3(Dimensions.x, 20, Dimensions.z), { 1 });
+
+	std::shared_ptr<const WorldSnapshot> Published;
+	uint64_t Epoch = 0;
+	std::mutex ExpectedMutex;
+	std::unordered_map<uint64_t, uint64_t> Expected; // Hash of the world when each epoch was published
+
+	auto Publish = [&]()
+	{
+		const uint64_t Hash = HashVoxels(Data, Dimensions);
+		std::shared_ptr<const WorldSnapshot> Previous = std::atomic_load(&Published);
+
+		if (Previous && Previous->IsCurrent(Data))
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(ExpectedMutex);
+			Expected[++Epoch] = Hash;
+		}
+
+		std::atomic_store(&Published, Create(Data, Previous.get(), Epoch));
+	};
+
+	Publish();
+
+	std::atomic<bool> Stop(false);
+	std::atomic<size_t> Checks(0), WrongHashes(0), Changed(0), Backwards(0);
+	std::vector<std::thread> Readers;
+
+	for (int i = 0; i < reader_count; i++)
+	{
+		Readers.emplace_back([&]()
+		{
+			uint64_t LastEpoch = 0;
+
+			while (!Stop)
+			{
+				std::shared_ptr<const WorldSnapshot> Snapshot = std::atomic_load(&Published);
+				Backwards += Snapshot->GetEpoch() < LastEpoch ? 1 : 0;
+				LastEpoch = Snapshot->GetEpoch();
+
+				const uint64_t Hash = HashVoxels(*Snapshot, Dimensions);
+				std::this_thread::yield();
+
+				// The writer kept going in the meantime
+				Changed += HashVoxels(*Snapshot, Dimensions) != Hash ? 1 : 0;
+
+				uint64_t ExpectedHash = 0;
+
+				{
+					std::lock_guard<std::mutex> Lock(ExpectedMutex);
+					ExpectedHash = Expected.at(Snapshot->GetEpoch());
+				}
+
+				WrongHashes += ExpectedHash != Hash ? 1 : 0;
+				Checks++;
+			}
+		});
+	}
+
+	std::mt19937 Random(14);
+	size_t Edits = 0;
+	const auto Start = std::chrono::steady_clock::now();
+
+	while (std::chrono::duration<float>(std::chrono::steady_clock::now() - Start).count() < duration_seconds)
+	{
+		const int Count = 1 + Random() % 200;
+
+		for (int i = 0; i < Count; i++, Edits++)
+		{
+			const glm::ivec3 p = glm::ivec3(Random() % Dimensions.x, Random() % Dimensions.y, Random() % Dimensions.z);
+
+			switch (Random() % 5)
+			{
+				case 0 :
+				case 1 : Data.SetBlock(p.x, p.y, p.z, { (uint16_t)(Random() % 8) }); break;
+				case 2 : Data.SetBlock(p.x, p.y, p.z, { 7 }, (BlockState)(1 + Random() % 200)); break;
+				case 3 : Data.SetState(p.x, p.y, p.z, (BlockState)(Random() % 3)); break;
+				case 4 :
+				{
+					if (Random() % 20 == 0)
+					{
+						const glm::ivec3 Min = p - 8;
+						Data.FillBox(Min, Min + glm::ivec3(4 + Random() % 30), { (uint16_t)(Random() % 4) }, (BlockState)(Random() % 2));
+					}
+
+					break;
+				}
+			}
+		}
+
+		Publish();
+	}
+
+	Stop = true;
+
+	for (std::thread& Reader : Readers)
+	{
+		Reader.join();
+	}
+
+	const bool Passed = WrongHashes == 0 && Changed == 0 && Backwards == 0;
+
+	std::cout << "\n\n" << "SNAPSHOT STRESS TEST " << (Passed ? "PASSED" : "FAILED") << " (" << Edits << " edits, " << Epoch << " snapshots, "
+		<< Checks << " reader checks, " << WrongHashes << " wrong hashes, " << Changed << " changed while held, "
+		<< Backwards << " epochs went back)" << "\n\n";
+
+	return Passed;
+}
+
+#endif
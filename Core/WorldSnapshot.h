@@ -0,0 +1,115 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "WorldData.h"
+
+namespace VoxelRT
+{
+	// Immutable copy of the blocks and states of a WorldData, for reading the world from other threads
+	// (lighting, saving, physics, meshing...) while the main thread keeps editing it.
+	//
+	// Snapshots are built on the main thread, between edits (World::PublishSnapshot()). A snapshot only takes a
+	// reference to every chunk of the world, the world copies a chunk the next time it writes to it (see WorldData.h),
+	// so taking one costs a pointer per chunk and the memory it adds is the chunks written since. The state entries of
+	// a chunk are copied if its version (WorldData::GetChunkVersion()) changed since the previous snapshot and shared
+	// with it otherwise. Snapshots and their chunks are reference counted, an old snapshot (and the chunks only it uses)
+	// is freed once the last reader lets go of it.
+
+	class WorldSnapshot
+	{
+	public :
+
+		// previous can be null, states are only shared with it if it has the same dimensions and origin
+		static std::shared_ptr<const WorldSnapshot> Create(const WorldData& data, const WorldSnapshot* previous, uint64_t epoch);
+
+		// Whether the world data still matches the snapshot (no chunk was written to since)
+		bool IsCurrent(const WorldData& data) const noexcept;
+
+		inline Block GetBlock(int x, int y, int z) const noexcept
+		{
+			return m_Chunks[GetChunkIndex(x, y, z)]->GetBlock(VoxelIndexing::GetBrickLocalIndex(x, y, z));
+		}
+
+		inline bool IsSolid(int x, int y, int z) const noexcept
+		{
+			return GetBlock(x, y, z).block != 0;
+		}
+
+		inline BlockState GetState(int x, int y, int z) const noexcept
+		{
+			const std::vector<uint32_t>* States = m_States[GetChunkIndex(x, y, z)].get();
+			return States ? VoxelStateTable::FindState(*States, VoxelIndexing::GetBrickLocalIndex(x, y, z)) : 0;
+		}
+
+		// Chunks are indexed like the ones of the world (WorldData::GetChunk())
+		inline const VoxelChunk& GetChunk(int index) const noexcept { return *m_Chunks[index]; }
+		inline int GetChunkCount() const noexcept { return (int)m_Chunks.size(); }
+		inline uint32_t GetChunkVersion(int index) const noexcept { return m_Versions[index]; }
+
+		// Same as WorldData::GetChunkPosition()
+		inline glm::ivec3 GetChunkPosition(int index) const noexcept
+		{
+			return glm::ivec3(index % m_ChunksX, (index % m_ChunksXY) / m_ChunksX, index / m_ChunksXY) * CHUNK_SIZE;
+		}
+
+		// Sorted state entries of the chunk, null if none of its voxels has a state
+		inline const std::vector<uint32_t>* GetChunkStates(int index) const noexcept { return m_States[index].get(); }
+
+		// Chunks whose blocks or states differ from the ones of an older snapshot of the same world, every chunk if the
+		// world was resized or moved in between. Compares references and versions, not voxels
+		void GetChangedChunks(const WorldSnapshot& older, std::vector<int>& chunks) const;
+
+		inline bool InBounds(int x, int y, int z) const noexcept
+		{
+			return x >= 0 && y >= 0 && z >= 0 && x < m_Dimensions.x && y < m_Dimensions.y && z < m_Dimensions.z;
+		}
+
+		inline const glm::ivec3& GetDimensions() const noexcept { return m_Dimensions; }
+
+		// WorldData::GetOrigin() of the world when the snapshot was taken
+		inline const glm::ivec3& GetOrigin() const noexcept { return m_Origin; }
+
+		// Publication number, increases with every snapshot of a world
+		inline uint64_t GetEpoch() const noexcept { return m_Epoch; }
+
+		// Number of chunks whose states this snapshot had to copy (the blocks are never copied)
+		inline int GetCopiedChunkCount() const noexcept { return m_CopiedChunks; }
+
+		// Bytes used by the chunks, shared chunks included
+		size_t GetMemoryUsage() const noexcept;
+
+		// Bytes used by the chunks the world doesn't share anymore, what keeping the snapshot around costs
+		size_t GetExclusiveMemoryUsage(const WorldData& data) const noexcept;
+
+		// Checks the guarantees above : reader_count threads hash entire snapshots while the calling thread edits a
+		// world of its own at random (blocks, states and box fills) and publishes it every few edits the way
+		// World::PublishSnapshot() does. Every snapshot has to hash the same as the world did when it was published, not
+		// change while it is held and epochs never go back. Prints the mismatches and the totals, returns false if there
+		// was any. Blocks the calling thread for duration_seconds, only built with VOXEL_RT_SNAPSHOT_DEBUG defined
+#ifdef VOXEL_RT_SNAPSHOT_DEBUG
+		static bool RunStressTest(float duration_seconds, int reader_count = 3);
+#endif
+
+	private :
+
+		inline int GetChunkIndex(int x, int y, int z) const noexcept
+		{
+			return (x >> BRICK_SHIFT) + (y >> BRICK_SHIFT) * m_ChunksX + (z >> BRICK_SHIFT) * m_ChunksXY;
+		}
+
+		std::vector<std::shared_ptr<const VoxelChunk>> m_Chunks;
+		std::vector<std::shared_ptr<const std::vector<uint32_t>>> m_States; // Same entries as the state table
+		std::vector<uint32_t> m_Versions;
+		glm::ivec3 m_Dimensions = glm::ivec3(0);
+		glm::ivec3 m_Origin = glm::ivec3(0);
+		int m_ChunksX = 0;
+		int m_ChunksXY = 0;
+		uint64_t m_Epoch = 0;
+		int m_CopiedChunks = 0;
+	};
+}